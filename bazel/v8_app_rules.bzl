@@ -17,6 +17,9 @@ def _default_args():
                       "@platforms//os:android": [
                           "V8APP_ANDROID",
                       ],
+                      "@platforms//os:linux": [
+                          "V8APP_LINUX",
+                      ],
                       "//conditions:default": [],
                   }) +
                   select({
@@ -29,7 +32,7 @@ def _default_args():
                       "//conditions:default": [],
                   }) +
                   selects.with_or({
-                      ("@platforms//cpu:x86_64", "@platforms//cpu:arm64"): ["PLATFOEM_64"],
+                      ("@platforms//cpu:x86_64", "@platforms//cpu:arm64"): ["PLATFORM_64"],
                       ("@platforms//cpu:x86_32", "@platforms//cpu:armv7"): ["PLATFORM_32"],
                       "//conditions:default": [],
                   }) +
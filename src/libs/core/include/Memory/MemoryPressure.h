@@ -0,0 +1,84 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _MEMORY_PRESSURE_H__
+#define _MEMORY_PRESSURE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace v8App
+{
+    namespace Memory
+    {
+        // matches v8::MemoryPressureLevel
+        enum class MemoryPressureLevel
+        {
+            kNone,
+            kModerate,
+            kCritical
+        };
+
+        using ReclaimCallback = std::function<void(MemoryPressureLevel)>;
+        using ReclaimCallbackId = uint64_t;
+        constexpr ReclaimCallbackId kInvalidReclaimCallbackId = 0;
+
+        /**
+         * Registry of callbacks subsystems use to give back memory they can rebuild, like caches and idle
+         * threads, when the process is running low. NotifyMemoryPressure calls every callback on the calling
+         * thread so a callback should only drop what it can safely from any thread and post anything else
+         * to the thread that owns it. A callback can unregister itself or others while it's being called but
+         * must not wait on another thread that's registering or unregistering.
+         */
+        class MemoryPressure
+        {
+        public:
+            static ReclaimCallbackId RegisterReclaimCallback(std::string inName, ReclaimCallback inCallback);
+            // once it returns the callback isn't running and won't be called again
+            static bool UnregisterReclaimCallback(ReclaimCallbackId inId);
+
+            static void NotifyMemoryPressure(MemoryPressureLevel inLevel);
+            // the level passed to the last call to NotifyMemoryPressure
+            static MemoryPressureLevel GetLastLevel() { return s_LastLevel; }
+            static size_t GetNumberOfCallbacks();
+
+        private:
+            struct CallbackInfo
+            {
+                std::string m_Name;
+                ReclaimCallback m_Callback;
+            };
+
+            // recursive so callbacks can unregister while they're being called
+            static std::recursive_mutex s_Lock;
+            static std::map<ReclaimCallbackId, CallbackInfo> s_Callbacks;
+            static ReclaimCallbackId s_NextId;
+            static std::atomic<MemoryPressureLevel> s_LastLevel;
+        };
+
+        /**
+         * Registers a reclaim callback for it's lifetime
+         */
+        class ScopedReclaimCallback
+        {
+        public:
+            ScopedReclaimCallback(std::string inName, ReclaimCallback inCallback);
+            ~ScopedReclaimCallback();
+
+            ScopedReclaimCallback(const ScopedReclaimCallback &) = delete;
+            ScopedReclaimCallback &operator=(const ScopedReclaimCallback &) = delete;
+
+            ReclaimCallbackId GetId() const { return m_Id; }
+
+        private:
+            ReclaimCallbackId m_Id;
+        };
+    } // namespace Memory
+} // namespace v8App
+
+#endif //_MEMORY_PRESSURE_H__
@@ -0,0 +1,128 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef __T_LOCK_FREE_QUEUE_H_
+#define __T_LOCK_FREE_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace v8App
+{
+    namespace Queues
+    {
+        /**
+         * What the lock free queue does with an item when the ring is full
+         */
+        enum class QueueFullPolicy : uint8_t
+        {
+            // item goes into a mutex protected overflow queue that is drained once the ring is empty
+            kSpill,
+            // the pushing thread waits till a consumer frees up a slot
+            kBlock
+        };
+
+        /**
+         * Implements a lock free bounded multi producer multi consumer queue.
+         * Each slot in the ring carries a sequence number that tells producers and consumers
+         * whether it's their turn at the slot so the fast path is a single CAS on the
+         * enqueue or dequeue position. The capacity is rounded up to a power of 2.
+         * Has the same PushItem/GetNextItem/Terminate surface as TThreadSafeQueue.
+         */
+        template <class QueueType>
+        class TLockFreeQueue
+        {
+        public:
+            static constexpr size_t kDefaultCapacity = 1024;
+
+            explicit TLockFreeQueue(size_t inCapacity = kDefaultCapacity, QueueFullPolicy inPolicy = QueueFullPolicy::kSpill);
+            virtual ~TLockFreeQueue();
+
+            TLockFreeQueue(const TLockFreeQueue &) = delete;
+            TLockFreeQueue &operator=(const TLockFreeQueue &) = delete;
+
+            /**
+             * Adds an item to the queue. If the ring is full the item is handled according
+             * to the queue's full policy.
+             */
+            virtual void PushItem(QueueType inItem);
+            /**
+             * Adds all the items to the queue claiming as many slots as it can with a single CAS.
+             * Items that don't fit are handled according to the queue's full policy.
+             */
+            virtual void PushItems(std::vector<QueueType> inItems);
+            /**
+             * Gets the next item it could be that no item is returned as another thread may have
+             * already fetched the item
+             */
+            virtual std::optional<QueueType> GetNextItem();
+
+            /**
+             * Check to see if there may be an item in the queue to get
+             */
+            virtual bool MayHaveItems();
+
+            /**
+             * Set the queue to a teminating state preventing any additional items to be added.
+             * Any threads blocked waiting for a slot are released and their items dropped
+             */
+            virtual void Terminate();
+
+            size_t GetCapacity() const { return m_Mask + 1; }
+            QueueFullPolicy GetFullPolicy() const { return m_Policy; }
+
+        protected:
+            /**
+             * Tries to push the item into the ring. On failure the item is left untouched
+             */
+            bool TryPushItem(QueueType &inItem);
+            /**
+             * Tries to claim a run of slots for the items starting at inStart and fills them.
+             * Returns how many items were pushed.
+             */
+            size_t TryPushItems(std::vector<QueueType> &inItems, size_t inStart);
+            /**
+             * Waits for a consumer to free up a slot. Returns false if the queue is terminated.
+             */
+            bool WaitForSlot(std::function<bool()> inTryPush);
+            /**
+             * Tries to pop an item from the ring.
+             */
+            std::optional<QueueType> TryGetNextItem();
+
+            struct Cell
+            {
+                std::atomic<size_t> m_Sequence;
+                std::optional<QueueType> m_Item;
+            };
+
+            // keep the positions on their own cache lines so producers and consumers don't false share
+            static constexpr size_t kCacheLineSize = 64;
+
+            alignas(kCacheLineSize) std::atomic<size_t> m_EnqueuePos{0};
+            alignas(kCacheLineSize) std::atomic<size_t> m_DequeuePos{0};
+            alignas(kCacheLineSize) std::unique_ptr<Cell[]> m_Cells;
+            size_t m_Mask;
+            QueueFullPolicy m_Policy;
+            std::atomic_bool m_Terminated{false};
+
+            // Overflow for the kSpill policy
+            std::mutex m_SpillLock;
+            std::deque<QueueType> m_Spill;
+            std::atomic<size_t> m_SpillCount{0};
+
+            // Bumped on every pop so that kBlock producers can wait on it
+            std::atomic<uint32_t> m_PopCounter{0};
+            std::atomic<uint32_t> m_BlockedPushers{0};
+        };
+    } // namespace Queues
+} // namespace v8App
+
+#include "TLockFreeQueue.hpp"
+#endif //__T_LOCK_FREE_QUEUE_H_
@@ -0,0 +1,296 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+// #include "TLockFreeQueue.h"
+
+#include <bit>
+#include <thread>
+
+namespace v8App
+{
+    namespace Queues
+    {
+        template <class QueueType>
+        TLockFreeQueue<QueueType>::TLockFreeQueue(size_t inCapacity, QueueFullPolicy inPolicy) : m_Policy(inPolicy)
+        {
+            size_t capacity = std::bit_ceil(std::max(inCapacity, size_t(2)));
+            m_Mask = capacity - 1;
+            m_Cells = std::make_unique<Cell[]>(capacity);
+            for (size_t idx = 0; idx < capacity; idx++)
+            {
+                m_Cells[idx].m_Sequence.store(idx, std::memory_order_relaxed);
+            }
+        }
+
+        template <class QueueType>
+        TLockFreeQueue<QueueType>::~TLockFreeQueue()
+        {
+            Terminate();
+        }
+
+        template <class QueueType>
+        void TLockFreeQueue<QueueType>::PushItem(QueueType inItem)
+        {
+            if (m_Terminated)
+            {
+                return;
+            }
+
+            if (m_Policy == QueueFullPolicy::kSpill)
+            {
+                // once we've started spilling keep spilling till it's drained so items stay in order
+                if (m_SpillCount.load() == 0 && TryPushItem(inItem))
+                {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(m_SpillLock);
+                m_Spill.push_back(std::move(inItem));
+                m_SpillCount++;
+                return;
+            }
+
+            while (TryPushItem(inItem) == false)
+            {
+                if (WaitForSlot([this, &inItem]()
+                                { return TryPushItem(inItem); }))
+                {
+                    return;
+                }
+                if (m_Terminated)
+                {
+                    return;
+                }
+            }
+        }
+
+        template <class QueueType>
+        void TLockFreeQueue<QueueType>::PushItems(std::vector<QueueType> inItems)
+        {
+            if (m_Terminated || inItems.empty())
+            {
+                return;
+            }
+
+            if (m_Policy == QueueFullPolicy::kSpill)
+            {
+                size_t pushed = 0;
+                if (m_SpillCount.load() == 0)
+                {
+                    pushed = TryPushItems(inItems, 0);
+                }
+                if (pushed == inItems.size())
+                {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(m_SpillLock);
+                for (size_t idx = pushed; idx < inItems.size(); idx++)
+                {
+                    m_Spill.push_back(std::move(inItems[idx]));
+                }
+                m_SpillCount += inItems.size() - pushed;
+                return;
+            }
+
+            size_t pushed = 0;
+            while (pushed < inItems.size())
+            {
+                size_t count = TryPushItems(inItems, pushed);
+                if (count != 0)
+                {
+                    pushed += count;
+                    continue;
+                }
+                if (WaitForSlot([this, &inItems, &pushed]()
+                                {
+                    pushed += TryPushItems(inItems, pushed);
+                    return pushed == inItems.size(); }))
+                {
+                    return;
+                }
+                if (m_Terminated)
+                {
+                    return;
+                }
+            }
+        }
+
+        template <class QueueType>
+        bool TLockFreeQueue<QueueType>::WaitForSlot(std::function<bool()> inTryPush)
+        {
+            if (m_Terminated)
+            {
+                return false;
+            }
+            uint32_t popCount = m_PopCounter.load();
+            m_BlockedPushers++;
+            // check again now we're registered in case a slot was freed before we started waiting
+            if (inTryPush())
+            {
+                m_BlockedPushers--;
+                return true;
+            }
+            m_PopCounter.wait(popCount);
+            m_BlockedPushers--;
+            return false;
+        }
+
+        template <class QueueType>
+        std::optional<QueueType> TLockFreeQueue<QueueType>::GetNextItem()
+        {
+            if (m_Terminated)
+            {
+                return {};
+            }
+
+            std::optional<QueueType> item = TryGetNextItem();
+            if (item.has_value() == false && m_SpillCount.load() != 0)
+            {
+                std::lock_guard<std::mutex> lock(m_SpillLock);
+                if (m_Spill.empty() == false)
+                {
+                    item = std::move(m_Spill.front());
+                    m_Spill.pop_front();
+                    m_SpillCount--;
+                }
+            }
+
+            if (item.has_value() && m_Policy == QueueFullPolicy::kBlock)
+            {
+                m_PopCounter++;
+                if (m_BlockedPushers.load() != 0)
+                {
+                    m_PopCounter.notify_one();
+                }
+            }
+            return item;
+        }
+
+        template <class QueueType>
+        bool TLockFreeQueue<QueueType>::MayHaveItems()
+        {
+            return m_EnqueuePos.load(std::memory_order_relaxed) != m_DequeuePos.load(std::memory_order_relaxed) ||
+                   m_SpillCount.load(std::memory_order_relaxed) != 0;
+        }
+
+        template <class QueueType>
+        void TLockFreeQueue<QueueType>::Terminate()
+        {
+            m_Terminated = true;
+            // release anyone blocked waiting for a slot
+            m_PopCounter++;
+            m_PopCounter.notify_all();
+        }
+
+        template <class QueueType>
+        bool TLockFreeQueue<QueueType>::TryPushItem(QueueType &inItem)
+        {
+            size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true)
+            {
+                cell = &m_Cells[pos & m_Mask];
+                size_t sequence = cell->m_Sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    // slot is free for this position so try and claim it
+                    if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // the consumers haven't freed the slot yet so we're full
+                    return false;
+                }
+                else
+                {
+                    pos = m_EnqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            cell->m_Item.emplace(std::move(inItem));
+            cell->m_Sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        template <class QueueType>
+        size_t TLockFreeQueue<QueueType>::TryPushItems(std::vector<QueueType> &inItems, size_t inStart)
+        {
+            size_t count = std::min(inItems.size() - inStart, m_Mask + 1);
+            size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+            while (count != 0)
+            {
+                // if the last slot of the run is free for this lap then the consumers have claimed every
+                // slot before it so we can take the whole run with one CAS
+                Cell &last = m_Cells[(pos + count - 1) & m_Mask];
+                size_t sequence = last.m_Sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + count - 1);
+                if (diff == 0)
+                {
+                    if (m_EnqueuePos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // not enough room for the whole run so try a shorter one
+                    count /= 2;
+                }
+                else
+                {
+                    pos = m_EnqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            for (size_t idx = 0; idx < count; idx++)
+            {
+                Cell &cell = m_Cells[(pos + idx) & m_Mask];
+                // a consumer may have claimed the slot but not finished moving the item out yet
+                while (cell.m_Sequence.load(std::memory_order_acquire) != pos + idx)
+                {
+                    std::this_thread::yield();
+                }
+                cell.m_Item.emplace(std::move(inItems[inStart + idx]));
+                cell.m_Sequence.store(pos + idx + 1, std::memory_order_release);
+            }
+            return count;
+        }
+
+        template <class QueueType>
+        std::optional<QueueType> TLockFreeQueue<QueueType>::TryGetNextItem()
+        {
+            size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true)
+            {
+                cell = &m_Cells[pos & m_Mask];
+                size_t sequence = cell->m_Sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (m_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // the producer hasn't filled the slot yet so we're empty
+                    return {};
+                }
+                else
+                {
+                    pos = m_DequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+            std::optional<QueueType> item = std::move(cell->m_Item);
+            cell->m_Item.reset();
+            // mark the slot free for the producer one lap ahead
+            cell->m_Sequence.store(pos + m_Mask + 1, std::memory_order_release);
+            return item;
+        }
+    } // namespace Queues
+} // namespace v8App
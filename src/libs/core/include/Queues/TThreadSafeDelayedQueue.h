@@ -7,24 +7,28 @@
 
 #include <queue>
 #include <mutex>
-#include <map>
+#include <optional>
 #include <functional>
 
 #include "TThreadSafeQueue.h"
+#include "TTimingWheel.h"
 
 namespace v8App
 {
     namespace Queues
     {
-        using DelayedJobsReadyDelegate = std::function<void()>;
+        // called with the number of items that just became ready
+        using DelayedJobsReadyDelegate = std::function<void(size_t)>;
 
         /**
          * Implements a thread safe delayed queue.
          * The queue needs to be ticked periodically by calling MayHaveItems aso that
          * so that the delyed items can be checked and moved to the main queue once
-         * their delay has expired.
+         * their delay has expired. GetNextDeadline can be used to sleep until exactly
+         * when the next tick is needed rather then polling.
          * Each of the operations Push, Get and MayHave all check the delayed items
          * to see if they can moved to the main queue for work.
+         * The delayed items are kept in a hierarchical timing wheel.
         */
         template <class QueueType>
         class TThreadSafeDelayedQueue : public TThreadSafeQueue<QueueType>
@@ -44,9 +48,14 @@ namespace v8App
 
             /**
              * Push an item onto the queue with a delay and checks to see if any delayed items are 
-             * ready and if moves them to the main queue
+             * ready and if moves them to the main queue. Returns an id that can be passed to CancelItem
+             * or kInvalidTimerId if the queue has been terminated.
             */
-            virtual void PushItemDelayed(double inDelaySeconds, QueueType inItem);
+            virtual TimerId PushItemDelayed(double inDelaySeconds, QueueType inItem);
+            /**
+             * Push all the items onto the queue with the same delay under a single lock
+            */
+            virtual void PushItemsDelayed(double inDelaySeconds, std::vector<QueueType> inItems);
             /**
              * Gets the next item it could be that no item is returned as another thread may have 
              * already fetched the item. This also checks if any delayed item is ready and moves
@@ -60,6 +69,17 @@ namespace v8App
             */
             virtual bool MayHaveItems() override;
 
+            /**
+             * Removes a delayed item that hasn't come due yet destroying it straight away. Returns false
+             * if the item has already been moved to the main queue or canceled.
+             */
+            bool CancelItem(TimerId inId);
+
+            /**
+             * Gets the deadline of the next delayed item to come due if there are any
+             */
+            std::optional<double> GetNextDeadline();
+
             /**
              * A callback to let someone know that items are ready to be fetched
             */
@@ -76,7 +96,7 @@ namespace v8App
 
             DelayedJobsReadyDelegate m_DelayedJobsReady;
             std::mutex m_DelayedLock;
-            std::multimap<double, QueueType> m_DelayedQueue;
+            TTimingWheel<QueueType> m_DelayedQueue;
         };
     } // namespace Queues
 } // namespace v8App
@@ -23,13 +23,39 @@ namespace v8App
             std::lock_guard<std::mutex> lock(this->m_QueueLock);
             std::deque<QueueType> empty;
             std::swap(this->m_Queue, empty);
-            std::multimap<double, QueueType> emptyDelated;
-            std::swap(this->m_DelayedQueue, emptyDelated);
+            this->m_DelayedQueue.Clear();
             this->m_Terminated = true;
         }
 
         template <class QueueType>
-        void TThreadSafeDelayedQueue<QueueType>::PushItemDelayed(double inDelaySeconds, QueueType inItem)
+        TimerId TThreadSafeDelayedQueue<QueueType>::PushItemDelayed(double inDelaySeconds, QueueType inItem)
+        {
+            DCHECK_GE(inDelaySeconds, 0.0);
+            std::lock_guard lock(this->m_DelayedLock);
+            if (this->m_Terminated)
+            {
+                return kInvalidTimerId;
+            }
+
+            double now = Time::MonotonicallyIncreasingTimeSeconds();
+            // turn the wheel to now first so the new item is placed relative to the current time
+            std::vector<QueueType> readyItems;
+            this->m_DelayedQueue.Advance(now, readyItems);
+            TimerId id = this->m_DelayedQueue.Insert(now + inDelaySeconds, std::move(inItem));
+            if (readyItems.empty() == false)
+            {
+                size_t numReady = readyItems.size();
+                TThreadSafeQueue<QueueType>::PushItems(std::move(readyItems));
+                if (m_DelayedJobsReady)
+                {
+                    m_DelayedJobsReady(numReady);
+                }
+            }
+            return id;
+        }
+
+        template <class QueueType>
+        void TThreadSafeDelayedQueue<QueueType>::PushItemsDelayed(double inDelaySeconds, std::vector<QueueType> inItems)
         {
             DCHECK_GE(inDelaySeconds, 0.0);
             std::lock_guard lock(this->m_DelayedLock);
@@ -38,8 +64,22 @@ namespace v8App
                 return;
             }
 
-            double deadline = Time::MonotonicallyIncreasingTimeSeconds() + inDelaySeconds;
-            this->m_DelayedQueue.emplace(deadline, std::move(inItem));
+            double now = Time::MonotonicallyIncreasingTimeSeconds();
+            std::vector<QueueType> readyItems;
+            this->m_DelayedQueue.Advance(now, readyItems);
+            for (QueueType &item : inItems)
+            {
+                this->m_DelayedQueue.Insert(now + inDelaySeconds, std::move(item));
+            }
+            if (readyItems.empty() == false)
+            {
+                size_t numReady = readyItems.size();
+                TThreadSafeQueue<QueueType>::PushItems(std::move(readyItems));
+                if (m_DelayedJobsReady)
+                {
+                    m_DelayedJobsReady(numReady);
+                }
+            }
         }
 
         template <class QueueType>
@@ -56,6 +96,25 @@ namespace v8App
             return TThreadSafeQueue<QueueType>::MayHaveItems();
         }
 
+        template <class QueueType>
+        bool TThreadSafeDelayedQueue<QueueType>::CancelItem(TimerId inId)
+        {
+            std::optional<QueueType> item;
+            {
+                std::lock_guard<std::mutex> lock(this->m_DelayedLock);
+                item = this->m_DelayedQueue.Remove(inId);
+            }
+            // the item is destroyed outside the lock in case it's destructor uses the queue
+            return item.has_value();
+        }
+
+        template <class QueueType>
+        std::optional<double> TThreadSafeDelayedQueue<QueueType>::GetNextDeadline()
+        {
+            std::lock_guard<std::mutex> lock(this->m_DelayedLock);
+            return this->m_DelayedQueue.GetNextDeadline();
+        }
+
         template <class QueueType>
         void TThreadSafeDelayedQueue<QueueType>::ProcessDelayedQueue()
         {
@@ -65,24 +124,18 @@ namespace v8App
                 return;
             }
             // Move any items that have hit their dealyed time and push them onto the main queu
-            if (this->m_DelayedQueue.empty() == false)
+            if (this->m_DelayedQueue.IsEmpty() == false)
             {
-                double now = Time::MonotonicallyIncreasingTimeSeconds();
-                QueueType item;
-                auto it = this->m_DelayedQueue.begin();
-                bool jobsReady = false;
-                while (it != this->m_DelayedQueue.end() && it->first <= now)
-                {
-                    jobsReady = true;
-                    item = std::move(it->second);
-                    this->m_DelayedQueue.erase(it);
-                    TThreadSafeQueue<QueueType>::PushItem(std::move(item));
-                    // since we modified the map we need the iterator
-                    it = this->m_DelayedQueue.begin();
-                }
-                if(jobsReady && m_DelayedJobsReady)
+                std::vector<QueueType> readyItems;
+                this->m_DelayedQueue.Advance(Time::MonotonicallyIncreasingTimeSeconds(), readyItems);
+                if (readyItems.empty() == false)
                 {
-                    m_DelayedJobsReady();
+                    size_t numReady = readyItems.size();
+                    TThreadSafeQueue<QueueType>::PushItems(std::move(readyItems));
+                    if (m_DelayedJobsReady)
+                    {
+                        m_DelayedJobsReady(numReady);
+                    }
                 }
             }
         }
@@ -9,6 +9,7 @@
 #include <memory>
 #include <optional>
 #include <mutex>
+#include <vector>
 
 namespace v8App
 {
@@ -37,6 +38,10 @@ namespace v8App
              * Adds an item to the queue
              */
             virtual void PushItem(QueueType inItem);
+            /**
+             * Adds all the items to the queue under a single lock
+             */
+            virtual void PushItems(std::vector<QueueType> inItems);
             /**
              * Gets the next item it could be that no item is returned as another thread may have 
              * already fetched the item
@@ -46,7 +51,11 @@ namespace v8App
             /**
              * Check to see if there may be an item in the queue to get
             */
-            virtual bool MayHaveItems() { return m_Queue.size() != 0;}
+            virtual bool MayHaveItems()
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                return m_Queue.empty() == false;
+            }
 
             /**
              * Set the queue to a teminating state preventing any additional items to be added
@@ -26,6 +26,20 @@ namespace v8App {
             m_Queue.push_back(std::move(inTask));
         }
 
+        template<class QueueType>
+        void TThreadSafeQueue<QueueType>::PushItems(std::vector<QueueType> inItems)
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            if(m_Terminated)
+            {
+                return;
+            }
+            for(QueueType &item : inItems)
+            {
+                m_Queue.push_back(std::move(item));
+            }
+        }
+
         template<class QueueType>
         std::optional<QueueType> TThreadSafeQueue<QueueType>::GetNextItem()
         {
@@ -0,0 +1,141 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef __T_TIMING_WHEEL_H_
+#define __T_TIMING_WHEEL_H_
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace v8App
+{
+    namespace Queues
+    {
+        /**
+         * Id returned when an item is added to the timing wheel that can be used to cancel it
+         */
+        using TimerId = uint64_t;
+        constexpr TimerId kInvalidTimerId = 0;
+
+        /**
+         * Implements a hierarchical timing wheel for delayed items.
+         * The wheel has kNumLevels levels of kSlotsPerLevel slots. Level 0 slots are one tick wide,
+         * each level above covers kSlotsPerLevel times the range of the one below it. Items are
+         * put into the level that covers their deadline and are cascaded down as the wheel turns
+         * so inserting and canceling are O(1). Items further out than the wheel covers are parked
+         * in the top level and re-placed whenever that slot cascades.
+         *
+         * The wheel is not thread safe, the owner is expected to lock around it.
+         */
+        template <class ItemType>
+        class TTimingWheel
+        {
+        public:
+            static constexpr int kNumLevels = 4;
+            static constexpr int kSlotBits = 8;
+            static constexpr size_t kSlotsPerLevel = 1 << kSlotBits;
+            static constexpr uint64_t kSlotMask = kSlotsPerLevel - 1;
+            // default tick is a millisecond
+            static constexpr uint32_t kDefaultTicksPerSecond = 1000;
+
+            explicit TTimingWheel(uint32_t inTicksPerSecond = kDefaultTicksPerSecond);
+            ~TTimingWheel();
+
+            TTimingWheel(const TTimingWheel &) = delete;
+            TTimingWheel &operator=(const TTimingWheel &) = delete;
+
+            TTimingWheel(TTimingWheel &&inWheel);
+            TTimingWheel &operator=(TTimingWheel &&inWheel);
+
+            /**
+             * Adds an item that expires at the deadline. The deadline is in seconds on the same clock
+             * that's passed to Advance. Items at or before the wheel's current time are returned by the
+             * next call to Advance.
+             */
+            TimerId Insert(double inDeadline, ItemType inItem);
+            /**
+             * Removes the item from the wheel destroying it. Returns false if the item wasn't in the wheel
+             * because it had already expired or been canceled.
+             */
+            bool Cancel(TimerId inId);
+            /**
+             * Removes the item from the wheel handing it back so the caller can destroy it outside
+             * of any lock. Returns nothing if the item wasn't in the wheel.
+             */
+            std::optional<ItemType> Remove(TimerId inId);
+            /**
+             * Turns the wheel up to the passed time, appending every expired item to outExpired
+             * ordered by deadline and then the order they were inserted.
+             */
+            void Advance(double inNow, std::vector<ItemType> &outExpired);
+            /**
+             * Returns when the earliest item in the wheel expires if there is one. That's it's deadline
+             * rounded up to the wheel's tick, so an Advance to the returned time or later releases it.
+             */
+            std::optional<double> GetNextDeadline() const;
+
+            size_t GetSize() const { return m_Nodes.size(); }
+            bool IsEmpty() const { return m_Nodes.empty(); }
+            uint32_t GetTicksPerSecond() const { return m_TicksPerSecond; }
+
+            /**
+             * Removes and destroys all items in the wheel
+             */
+            void Clear();
+
+        protected:
+            struct Node
+            {
+                TimerId m_Id;
+                uint64_t m_Tick;
+                double m_Deadline;
+                ItemType m_Item;
+                Node *m_Prev = nullptr;
+                Node *m_Next = nullptr;
+                // -1 when the node is on the expired list
+                int m_Level = -1;
+                size_t m_Slot = 0;
+            };
+
+            struct NodeList
+            {
+                Node *m_Head = nullptr;
+                Node *m_Tail = nullptr;
+            };
+
+            // deadlines round up and now rounds down so an item never expires before it's deadline
+            uint64_t DeadlineToTick(double inDeadline) const;
+            uint64_t NowToTick(double inNow) const;
+            void PlaceNode(Node *inNode);
+            void LinkNode(NodeList &inList, Node *inNode);
+            void UnlinkNode(NodeList &inList, Node *inNode);
+            NodeList &GetNodeList(Node *inNode);
+            void CascadeLevel(int inLevel, uint64_t inTick);
+            void ExpireList(NodeList &inList, std::vector<Node *> &outExpired);
+            uint64_t FindEarliestTick() const;
+            // the first time on the clock that Advance turns into the tick
+            double TickToTime(uint64_t inTick) const;
+
+            uint32_t m_TicksPerSecond;
+            uint64_t m_CurrentTick = 0;
+            TimerId m_NextId = kInvalidTimerId + 1;
+
+            std::array<std::array<NodeList, kSlotsPerLevel>, kNumLevels> m_Levels;
+            std::array<size_t, kNumLevels> m_LevelCounts{};
+            // items that were inserted at or before the current tick
+            NodeList m_Expired;
+            std::unordered_map<TimerId, Node *> m_Nodes;
+
+            // cache of the earliest tick in the wheel, it's only searched for again once the item that set it leaves
+            mutable uint64_t m_EarliestTick = 0;
+            mutable bool m_EarliestValid = false;
+        };
+    } // namespace Queues
+} // namespace v8App
+
+#include "TTimingWheel.hpp"
+#endif //__T_TIMING_WHEEL_H_
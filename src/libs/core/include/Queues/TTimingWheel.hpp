@@ -0,0 +1,388 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+// #include "TTimingWheel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace v8App
+{
+    namespace Queues
+    {
+        template <class ItemType>
+        TTimingWheel<ItemType>::TTimingWheel(uint32_t inTicksPerSecond) : m_TicksPerSecond(std::max(inTicksPerSecond, uint32_t(1)))
+        {
+        }
+
+        template <class ItemType>
+        TTimingWheel<ItemType>::~TTimingWheel()
+        {
+            Clear();
+        }
+
+        template <class ItemType>
+        TTimingWheel<ItemType>::TTimingWheel(TTimingWheel &&inWheel)
+        {
+            *this = std::move(inWheel);
+        }
+
+        template <class ItemType>
+        TTimingWheel<ItemType> &TTimingWheel<ItemType>::operator=(TTimingWheel &&inWheel)
+        {
+            if (this == &inWheel)
+            {
+                return *this;
+            }
+            Clear();
+            m_TicksPerSecond = inWheel.m_TicksPerSecond;
+            m_CurrentTick = inWheel.m_CurrentTick;
+            m_NextId = inWheel.m_NextId;
+            m_Levels = inWheel.m_Levels;
+            m_LevelCounts = inWheel.m_LevelCounts;
+            m_Expired = inWheel.m_Expired;
+            m_Nodes = std::move(inWheel.m_Nodes);
+            m_EarliestTick = inWheel.m_EarliestTick;
+            m_EarliestValid = inWheel.m_EarliestValid;
+
+            // the nodes now belong to us so reset the other wheel
+            inWheel.m_Levels = {};
+            inWheel.m_LevelCounts = {};
+            inWheel.m_Expired = NodeList();
+            inWheel.m_Nodes.clear();
+            inWheel.m_EarliestValid = false;
+            return *this;
+        }
+
+        template <class ItemType>
+        TimerId TTimingWheel<ItemType>::Insert(double inDeadline, ItemType inItem)
+        {
+            Node *node = new Node{m_NextId++, DeadlineToTick(inDeadline), inDeadline, std::move(inItem)};
+            if (m_Nodes.empty())
+            {
+                m_EarliestTick = node->m_Tick;
+                m_EarliestValid = true;
+            }
+            else if (m_EarliestValid && node->m_Tick < m_EarliestTick)
+            {
+                m_EarliestTick = node->m_Tick;
+            }
+            m_Nodes.emplace(node->m_Id, node);
+            PlaceNode(node);
+            return node->m_Id;
+        }
+
+        template <class ItemType>
+        bool TTimingWheel<ItemType>::Cancel(TimerId inId)
+        {
+            return Remove(inId).has_value();
+        }
+
+        template <class ItemType>
+        std::optional<ItemType> TTimingWheel<ItemType>::Remove(TimerId inId)
+        {
+            auto it = m_Nodes.find(inId);
+            if (it == m_Nodes.end())
+            {
+                return {};
+            }
+            Node *node = it->second;
+            UnlinkNode(GetNodeList(node), node);
+            if (node->m_Level != -1)
+            {
+                m_LevelCounts[node->m_Level]--;
+            }
+            if (node->m_Tick == m_EarliestTick)
+            {
+                m_EarliestValid = false;
+            }
+            m_Nodes.erase(it);
+            std::optional<ItemType> item(std::move(node->m_Item));
+            delete node;
+            return item;
+        }
+
+        template <class ItemType>
+        void TTimingWheel<ItemType>::Advance(double inNow, std::vector<ItemType> &outExpired)
+        {
+            std::vector<Node *> expired;
+            ExpireList(m_Expired, expired);
+
+            uint64_t nowTick = NowToTick(inNow);
+            while (m_CurrentTick < nowTick)
+            {
+                if (m_Nodes.size() == expired.size())
+                {
+                    // nothing left in the wheel so just jump to now
+                    m_CurrentTick = nowTick;
+                    break;
+                }
+                // skip straight to the next tick that can do anything. If the lower levels are empty that's the
+                // next boundary of the lowest level that has items, since that's when it cascades.
+                int level = 0;
+                while (level < kNumLevels - 1 && m_LevelCounts[level] == 0)
+                {
+                    level++;
+                }
+                uint64_t span = uint64_t(1) << (kSlotBits * level);
+                uint64_t nextTick = (m_CurrentTick / span + 1) * span;
+                if (nextTick > nowTick)
+                {
+                    m_CurrentTick = nowTick;
+                    break;
+                }
+                m_CurrentTick = nextTick;
+
+                // cascade the highest level first so items it drops into the lower levels get cascaded as well
+                for (int cascade = kNumLevels - 1; cascade > 0; cascade--)
+                {
+                    uint64_t cascadeSpan = uint64_t(1) << (kSlotBits * cascade);
+                    if (m_CurrentTick % cascadeSpan == 0)
+                    {
+                        CascadeLevel(cascade, m_CurrentTick);
+                    }
+                }
+                ExpireList(m_Levels[0][m_CurrentTick & kSlotMask], expired);
+                // anything the cascade placed at the current tick
+                ExpireList(m_Expired, expired);
+            }
+
+            std::stable_sort(expired.begin(), expired.end(), [](const Node *inA, const Node *inB)
+                             {
+                if (inA->m_Deadline != inB->m_Deadline)
+                {
+                    return inA->m_Deadline < inB->m_Deadline;
+                }
+                return inA->m_Id < inB->m_Id; });
+            if (expired.empty() == false)
+            {
+                m_EarliestValid = false;
+            }
+            for (Node *node : expired)
+            {
+                outExpired.push_back(std::move(node->m_Item));
+                m_Nodes.erase(node->m_Id);
+                delete node;
+            }
+        }
+
+        template <class ItemType>
+        std::optional<double> TTimingWheel<ItemType>::GetNextDeadline() const
+        {
+            if (m_Nodes.empty())
+            {
+                return {};
+            }
+            if (m_EarliestValid == false)
+            {
+                m_EarliestTick = FindEarliestTick();
+                m_EarliestValid = true;
+            }
+            return TickToTime(m_EarliestTick);
+        }
+
+        template <class ItemType>
+        void TTimingWheel<ItemType>::Clear()
+        {
+            for (auto &it : m_Nodes)
+            {
+                delete it.second;
+            }
+            m_Nodes.clear();
+            m_Levels = {};
+            m_LevelCounts = {};
+            m_Expired = NodeList();
+            m_EarliestValid = false;
+        }
+
+        template <class ItemType>
+        uint64_t TTimingWheel<ItemType>::DeadlineToTick(double inDeadline) const
+        {
+            if (inDeadline <= 0)
+            {
+                return 0;
+            }
+            return static_cast<uint64_t>(std::ceil(inDeadline * m_TicksPerSecond));
+        }
+
+        template <class ItemType>
+        uint64_t TTimingWheel<ItemType>::NowToTick(double inNow) const
+        {
+            if (inNow <= 0)
+            {
+                return 0;
+            }
+            return static_cast<uint64_t>(std::floor(inNow * m_TicksPerSecond));
+        }
+
+        template <class ItemType>
+        void TTimingWheel<ItemType>::PlaceNode(Node *inNode)
+        {
+            if (inNode->m_Tick <= m_CurrentTick)
+            {
+                inNode->m_Level = -1;
+                LinkNode(m_Expired, inNode);
+                return;
+            }
+
+            uint64_t delta = inNode->m_Tick - m_CurrentTick;
+            uint64_t tick = inNode->m_Tick;
+            int level = 0;
+            while (level < kNumLevels - 1 && delta >= (uint64_t(1) << (kSlotBits * (level + 1))))
+            {
+                level++;
+            }
+            uint64_t maxDelta = uint64_t(1) << (kSlotBits * kNumLevels);
+            if (delta >= maxDelta)
+            {
+                // further out than the wheel covers so park it in the furthest slot, it's re-placed when that cascades
+                tick = m_CurrentTick + maxDelta - 1;
+            }
+            inNode->m_Level = level;
+            inNode->m_Slot = (tick >> (kSlotBits * level)) & kSlotMask;
+            LinkNode(m_Levels[level][inNode->m_Slot], inNode);
+            m_LevelCounts[level]++;
+        }
+
+        template <class ItemType>
+        void TTimingWheel<ItemType>::LinkNode(NodeList &inList, Node *inNode)
+        {
+            inNode->m_Next = nullptr;
+            inNode->m_Prev = inList.m_Tail;
+            if (inList.m_Tail != nullptr)
+            {
+                inList.m_Tail->m_Next = inNode;
+            }
+            else
+            {
+                inList.m_Head = inNode;
+            }
+            inList.m_Tail = inNode;
+        }
+
+        template <class ItemType>
+        void TTimingWheel<ItemType>::UnlinkNode(NodeList &inList, Node *inNode)
+        {
+            if (inNode->m_Prev != nullptr)
+            {
+                inNode->m_Prev->m_Next = inNode->m_Next;
+            }
+            else
+            {
+                inList.m_Head = inNode->m_Next;
+            }
+            if (inNode->m_Next != nullptr)
+            {
+                inNode->m_Next->m_Prev = inNode->m_Prev;
+            }
+            else
+            {
+                inList.m_Tail = inNode->m_Prev;
+            }
+            inNode->m_Prev = nullptr;
+            inNode->m_Next = nullptr;
+        }
+
+        template <class ItemType>
+        typename TTimingWheel<ItemType>::NodeList &TTimingWheel<ItemType>::GetNodeList(Node *inNode)
+        {
+            if (inNode->m_Level == -1)
+            {
+                return m_Expired;
+            }
+            return m_Levels[inNode->m_Level][inNode->m_Slot];
+        }
+
+        template <class ItemType>
+        void TTimingWheel<ItemType>::CascadeLevel(int inLevel, uint64_t inTick)
+        {
+            size_t slot = (inTick >> (kSlotBits * inLevel)) & kSlotMask;
+            NodeList list = m_Levels[inLevel][slot];
+            m_Levels[inLevel][slot] = NodeList();
+
+            Node *node = list.m_Head;
+            while (node != nullptr)
+            {
+                Node *next = node->m_Next;
+                m_LevelCounts[inLevel]--;
+                PlaceNode(node);
+                node = next;
+            }
+        }
+
+        template <class ItemType>
+        void TTimingWheel<ItemType>::ExpireList(NodeList &inList, std::vector<Node *> &outExpired)
+        {
+            Node *node = inList.m_Head;
+            while (node != nullptr)
+            {
+                Node *next = node->m_Next;
+                if (node->m_Level != -1)
+                {
+                    m_LevelCounts[node->m_Level]--;
+                }
+                node->m_Prev = nullptr;
+                node->m_Next = nullptr;
+                outExpired.push_back(node);
+                node = next;
+            }
+            inList = NodeList();
+        }
+
+        template <class ItemType>
+        uint64_t TTimingWheel<ItemType>::FindEarliestTick() const
+        {
+            // anything on the expired list is already due
+            if (m_Expired.m_Head != nullptr)
+            {
+                return m_Expired.m_Head->m_Tick;
+            }
+
+            uint64_t earliest = UINT64_MAX;
+            for (int level = 0; level < kNumLevels; level++)
+            {
+                if (m_LevelCounts[level] == 0)
+                {
+                    continue;
+                }
+                // the first non empty slot after the current one holds the level's earliest items
+                uint64_t current = (m_CurrentTick >> (kSlotBits * level)) & kSlotMask;
+                for (size_t offset = 1; offset <= kSlotsPerLevel; offset++)
+                {
+                    const NodeList &list = m_Levels[level][(current + offset) & kSlotMask];
+                    if (list.m_Head == nullptr)
+                    {
+                        continue;
+                    }
+                    if (level == 0)
+                    {
+                        // a level 0 slot is a single tick
+                        earliest = std::min(earliest, list.m_Head->m_Tick);
+                        break;
+                    }
+                    for (Node *node = list.m_Head; node != nullptr; node = node->m_Next)
+                    {
+                        earliest = std::min(earliest, node->m_Tick);
+                    }
+                    break;
+                }
+            }
+            return earliest;
+        }
+
+        template <class ItemType>
+        double TTimingWheel<ItemType>::TickToTime(uint64_t inTick) const
+        {
+            double time = static_cast<double>(inTick) / m_TicksPerSecond;
+            // the division can land just under the boundary which Advance would floor to the tick before
+            while (NowToTick(time) < inTick)
+            {
+                time = std::nextafter(time, std::numeric_limits<double>::infinity());
+            }
+            return time;
+        }
+    } // namespace Queues
+} // namespace v8App
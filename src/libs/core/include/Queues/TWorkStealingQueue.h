@@ -0,0 +1,74 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef __T_WORK_STEALING_QUEUE_H_
+#define __T_WORK_STEALING_QUEUE_H_
+
+#include <deque>
+#include <optional>
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+namespace v8App
+{
+    namespace Queues
+    {
+        /**
+         * Implements a per worker deque used by the thread pools for work stealing.
+         * The owning worker pushes and pops from the back of the deque so it works on the
+         * most recently posted (cache hot) item while other workers steal from the front.
+         * Each deque has it's own lock so owners and thieves only contend when they hit the
+         * same deque.
+         */
+        template <class QueueType>
+        class TWorkStealingQueue
+        {
+        public:
+            TWorkStealingQueue();
+            virtual ~TWorkStealingQueue();
+
+            TWorkStealingQueue(const TWorkStealingQueue &) = delete;
+            TWorkStealingQueue &operator=(const TWorkStealingQueue &) = delete;
+
+            /**
+             * Pushes an item onto the owner's end of the queue
+             */
+            void PushItem(QueueType inItem);
+            /**
+             * Pushes all the items onto the owner's end of the queue under a single lock
+             */
+            void PushItems(std::vector<QueueType> inItems);
+            /**
+             * Pops the most recently pushed item off the owner's end of the queue
+             */
+            std::optional<QueueType> GetNextItem();
+            /**
+             * Takes the oldest item from the queue. Called by other workers when they run dry
+             */
+            std::optional<QueueType> StealItem();
+
+            /**
+             * Check to see if there may be an item in the queue. Doesn't take the lock so
+             * the answer may be stale by the time it's acted on.
+             */
+            bool MayHaveItems() const { return m_Size.load(std::memory_order_relaxed) != 0; }
+            size_t GetSize() const { return m_Size.load(std::memory_order_relaxed); }
+
+            /**
+             * Set the queue to a teminating state preventing any additional items to be added
+             */
+            void Terminate();
+
+        protected:
+            bool m_Terminated = false;
+            std::mutex m_QueueLock;
+            std::deque<QueueType> m_Queue;
+            std::atomic<size_t> m_Size{0};
+        };
+    } // namespace Queues
+} // namespace v8App
+
+#include "TWorkStealingQueue.hpp"
+#endif //__T_WORK_STEALING_QUEUE_H_
@@ -0,0 +1,88 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+// #include "TWorkStealingQueue.h"
+
+namespace v8App
+{
+    namespace Queues
+    {
+        template <class QueueType>
+        TWorkStealingQueue<QueueType>::TWorkStealingQueue()
+        {
+        }
+
+        template <class QueueType>
+        TWorkStealingQueue<QueueType>::~TWorkStealingQueue()
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            std::deque<QueueType> empty;
+            std::swap(m_Queue, empty);
+            m_Size = 0;
+        }
+
+        template <class QueueType>
+        void TWorkStealingQueue<QueueType>::PushItem(QueueType inItem)
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            if (m_Terminated)
+            {
+                return;
+            }
+            m_Queue.push_back(std::move(inItem));
+            m_Size.store(m_Queue.size(), std::memory_order_relaxed);
+        }
+
+        template <class QueueType>
+        void TWorkStealingQueue<QueueType>::PushItems(std::vector<QueueType> inItems)
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            if (m_Terminated)
+            {
+                return;
+            }
+            for (QueueType &item : inItems)
+            {
+                m_Queue.push_back(std::move(item));
+            }
+            m_Size.store(m_Queue.size(), std::memory_order_relaxed);
+        }
+
+        template <class QueueType>
+        std::optional<QueueType> TWorkStealingQueue<QueueType>::GetNextItem()
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            if (m_Terminated || m_Queue.empty())
+            {
+                return {};
+            }
+            QueueType temp = std::move(m_Queue.back());
+            m_Queue.pop_back();
+            m_Size.store(m_Queue.size(), std::memory_order_relaxed);
+            return temp;
+        }
+
+        template <class QueueType>
+        std::optional<QueueType> TWorkStealingQueue<QueueType>::StealItem()
+        {
+            // don't wait on the owner if it's busy with the deque, the thief will just try the next one
+            std::unique_lock<std::mutex> lock(m_QueueLock, std::try_to_lock);
+            if (lock.owns_lock() == false || m_Terminated || m_Queue.empty())
+            {
+                return {};
+            }
+            QueueType temp = std::move(m_Queue.front());
+            m_Queue.pop_front();
+            m_Size.store(m_Queue.size(), std::memory_order_relaxed);
+            return temp;
+        }
+
+        template <class QueueType>
+        void TWorkStealingQueue<QueueType>::Terminate()
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            m_Terminated = true;
+        }
+    } // namespace Queues
+} // namespace v8App
@@ -0,0 +1,52 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _CPU_TOPOLOGY_H__
+#define _CPU_TOPOLOGY_H__
+
+#include <string>
+#include <vector>
+
+namespace v8App
+{
+    namespace Threads
+    {
+        /**
+         * Describes the cpus the process is allowed to run on and how they are grouped.
+         * Each group lists logical cpu numbers in ascending order.
+         */
+        struct CpuTopology
+        {
+            // the logical cpus the process can be scheduled on
+            std::vector<int> m_LogicalCpus;
+            // logical cpus grouped by the physical core they run on, more than one per group means SMT
+            std::vector<std::vector<int>> m_PhysicalCores;
+            // logical cpus grouped by the last level cache they share
+            std::vector<std::vector<int>> m_CacheDomains;
+            // logical cpus grouped by numa node
+            std::vector<std::vector<int>> m_NumaNodes;
+
+            int GetNumberOfLogicalCores() const { return static_cast<int>(m_LogicalCpus.size()); }
+            int GetNumberOfPhysicalCores() const { return static_cast<int>(m_PhysicalCores.size()); }
+        };
+
+        /**
+         * Returns the topology of the machine. It's queried the first time it's called and cached
+         * after that.
+         */
+        const CpuTopology &GetCpuTopology();
+        /**
+         * Queries the topology from the system. On platforms where we can't query it every logical
+         * cpu is treated as it's own physical core in a single cache and numa domain.
+         */
+        CpuTopology QueryCpuTopology();
+
+        /**
+         * Parses a linux style cpu list like 0-3,8,10-11 into the cpu numbers. Malformed entries are skipped.
+         */
+        std::vector<int> ParseCpuList(const std::string &inList);
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_CPU_TOPOLOGY_H__
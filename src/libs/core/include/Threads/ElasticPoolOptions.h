@@ -0,0 +1,32 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _ELASTIC_POOL_OPTIONS_H__
+#define _ELASTIC_POOL_OPTIONS_H__
+
+namespace v8App
+{
+    namespace Threads
+    {
+        /**
+         * Settings for a thread pool that grows and shrinks it's workers with the load.
+         * The pool starts with m_MinWorkers and adds a worker when a task waited longer than
+         * m_TargetLatency to start, or when there is a backlog and no task started for a whole
+         * m_TargetLatency because the workers are stuck in long or blocking tasks. Workers that
+         * sit idle for m_IdleTimeout are retired down to m_MinWorkers.
+         */
+        struct ElasticPoolOptions
+        {
+            int m_MinWorkers = 1;
+            // -1 uses the number of hardware cores. Can be more than the cores since workers may be blocked
+            int m_MaxWorkers = -1;
+            // seconds
+            double m_TargetLatency = 0.05;
+            // seconds
+            double m_IdleTimeout = 30.0;
+        };
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_ELASTIC_POOL_OPTIONS_H__
@@ -0,0 +1,62 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _PARALLEL_ALGORITHMS_H__
+#define _PARALLEL_ALGORITHMS_H__
+
+#include <cstddef>
+#include <functional>
+
+#include "Threads/ThreadPoolQueue.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        // number of chunks each thread gets when the grain size is picked automatically so uneven work balances out
+        constexpr size_t kParallelChunksPerThread = 4;
+        // ranges smaller than this are just sorted on the calling thread
+        constexpr size_t kParallelSortMinSize = 2048;
+
+        /**
+         * Runs inChunkFunc once for each chunk in [0, inNumChunks) spreading the chunks over the pool's
+         * workers and the calling thread. The calling thread always takes part and only waits on chunks
+         * another thread has already started, so it's safe to call from inside a pool task, nested calls
+         * can't deadlock waiting on workers that are busy. If a chunk throws the remaining chunks are
+         * skipped and the first exception is rethrown on the calling thread.
+         */
+        void RunParallelChunks(ThreadPoolQueue &inPool, size_t inNumChunks, const std::function<void(size_t)> &inChunkFunc);
+
+        /**
+         * Picks the number of items per chunk for inCount items. A grain size of 0 picks one
+         * that gives each thread in the pool kParallelChunksPerThread chunks.
+         */
+        size_t GetParallelGrainSize(ThreadPoolQueue &inPool, size_t inCount, size_t inGrainSize = 0);
+
+        /**
+         * Calls inFunc(index) for every index in [inBegin, inEnd) in parallel
+         */
+        template <typename Func>
+        void ParallelFor(ThreadPoolQueue &inPool, size_t inBegin, size_t inEnd, Func &&inFunc, size_t inGrainSize = 0);
+
+        /**
+         * Maps every index in [inBegin, inEnd) with inMap(index) and combines the results with
+         * inReduce(T, T) starting from inIdentity. Chunks are combined in index order so the
+         * reduce only needs to be associative.
+         */
+        template <typename T, typename Map, typename Reduce>
+        T ParallelReduce(ThreadPoolQueue &inPool, size_t inBegin, size_t inEnd, T inIdentity, Map &&inMap, Reduce &&inReduce,
+                         size_t inGrainSize = 0);
+
+        /**
+         * Sorts the range by sorting chunks in parallel and then merging neighbouring runs in parallel.
+         * Like std::sort the sort isn't stable.
+         */
+        template <typename RandomIt, typename Compare = std::less<>>
+        void ParallelSort(ThreadPoolQueue &inPool, RandomIt inFirst, RandomIt inLast, Compare inCompare = Compare());
+    } // namespace Threads
+} // namespace v8App
+
+#include "ParallelAlgorithms.hpp"
+#endif //_PARALLEL_ALGORITHMS_H__
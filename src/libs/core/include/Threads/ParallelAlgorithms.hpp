@@ -0,0 +1,109 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+// #include "ParallelAlgorithms.h"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <vector>
+
+namespace v8App
+{
+    namespace Threads
+    {
+        template <typename Func>
+        void ParallelFor(ThreadPoolQueue &inPool, size_t inBegin, size_t inEnd, Func &&inFunc, size_t inGrainSize)
+        {
+            if (inEnd <= inBegin)
+            {
+                return;
+            }
+            size_t count = inEnd - inBegin;
+            size_t grain = GetParallelGrainSize(inPool, count, inGrainSize);
+            size_t numChunks = (count + grain - 1) / grain;
+            RunParallelChunks(inPool, numChunks, [&](size_t inChunk)
+                              {
+                size_t start = inBegin + inChunk * grain;
+                size_t end = std::min(inEnd, start + grain);
+                for (size_t x = start; x < end; x++)
+                {
+                    inFunc(x);
+                } });
+        }
+
+        template <typename T, typename Map, typename Reduce>
+        T ParallelReduce(ThreadPoolQueue &inPool, size_t inBegin, size_t inEnd, T inIdentity, Map &&inMap, Reduce &&inReduce,
+                         size_t inGrainSize)
+        {
+            if (inEnd <= inBegin)
+            {
+                return inIdentity;
+            }
+            size_t count = inEnd - inBegin;
+            size_t grain = GetParallelGrainSize(inPool, count, inGrainSize);
+            size_t numChunks = (count + grain - 1) / grain;
+
+            // each chunk writes it's own slot so there's no sharing between threads
+            std::vector<std::optional<T>> partials(numChunks);
+            RunParallelChunks(inPool, numChunks, [&](size_t inChunk)
+                              {
+                size_t start = inBegin + inChunk * grain;
+                size_t end = std::min(inEnd, start + grain);
+                T partial = inMap(start);
+                for (size_t x = start + 1; x < end; x++)
+                {
+                    partial = inReduce(std::move(partial), inMap(x));
+                }
+                partials[inChunk].emplace(std::move(partial)); });
+
+            T result = std::move(inIdentity);
+            for (auto &partial : partials)
+            {
+                result = inReduce(std::move(result), std::move(partial.value()));
+            }
+            return result;
+        }
+
+        template <typename RandomIt, typename Compare>
+        void ParallelSort(ThreadPoolQueue &inPool, RandomIt inFirst, RandomIt inLast, Compare inCompare)
+        {
+            size_t count = static_cast<size_t>(std::distance(inFirst, inLast));
+            if (count < kParallelSortMinSize)
+            {
+                std::sort(inFirst, inLast, inCompare);
+                return;
+            }
+            // one run per thread, the merges can only use half as many threads each round
+            size_t numRuns = std::min(static_cast<size_t>(inPool.GetNumberOfWorkers() + 1), count / (kParallelSortMinSize / 2));
+            numRuns = std::max(numRuns, size_t(1));
+            size_t runSize = (count + numRuns - 1) / numRuns;
+            numRuns = (count + runSize - 1) / runSize;
+
+            auto runStart = [&](size_t inRun)
+            {
+                return inFirst + static_cast<std::ptrdiff_t>(std::min(count, inRun * runSize));
+            };
+
+            RunParallelChunks(inPool, numRuns, [&](size_t inRun)
+                              { std::sort(runStart(inRun), runStart(inRun + 1), inCompare); });
+
+            // merge neighbouring runs doubling the run width each round
+            for (size_t width = 1; width < numRuns; width *= 2)
+            {
+                size_t numMerges = (numRuns + 2 * width - 1) / (2 * width);
+                RunParallelChunks(inPool, numMerges, [&](size_t inMerge)
+                                  {
+                    size_t left = inMerge * 2 * width;
+                    size_t middle = left + width;
+                    if (middle >= numRuns)
+                    {
+                        return;
+                    }
+                    size_t right = std::min(numRuns, middle + width);
+                    std::inplace_merge(runStart(left), runStart(middle), runStart(right), inCompare); });
+            }
+        }
+    } // namespace Threads
+} // namespace v8App
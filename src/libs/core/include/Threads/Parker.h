@@ -0,0 +1,72 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _PARKER_H__
+#define _PARKER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace v8App
+{
+    namespace Threads
+    {
+        // number of times a thread checks for an unpark before going to sleep
+        constexpr int kDefaultParkSpinCount = 64;
+
+        /**
+         * Lets idle threads sleep till there is work for them and wakes exactly as many of them as
+         * there is work for. On linux it's a futex so unparking doesn't need a lock, elsewhere it falls
+         * back to a mutex and condition variable.
+         *
+         * To park a thread calls PrepareToPark, checks for work one last time and then either calls
+         * CancelPark if it found some or Park with the token. An Unpark that comes after PrepareToPark
+         * is never lost even if the thread hasn't gone to sleep yet.
+         */
+        class Parker
+        {
+        public:
+            using ParkToken = uint32_t;
+
+            explicit Parker(int inSpinCount = kDefaultParkSpinCount);
+
+            Parker(const Parker &) = delete;
+            Parker &operator=(const Parker &) = delete;
+
+            ParkToken PrepareToPark();
+            void CancelPark();
+            // sleeps till unparked, spinning a little first
+            void Park(ParkToken inToken);
+            // sleeps till unparked or the timeout passes. Returns false if it timed out
+            bool ParkFor(ParkToken inToken, double inSeconds);
+
+            // wakes up to inCount parked threads, does nothing if none are parked
+            void Unpark(size_t inCount);
+            void UnparkAll();
+
+            // threads that have prepared to park or are parked
+            int GetParkedCount() const { return m_Parked.load(std::memory_order_relaxed); }
+            int GetSpinCount() const { return m_SpinCount; }
+
+        private:
+            // spins waiting for the epoch to move on from the token, returns true if it did
+            bool Spin(ParkToken inToken);
+            bool Sleep(ParkToken inToken, double inSeconds);
+            void Wake(size_t inCount);
+
+            // bumped on every unpark, parked threads sleep till it changes
+            std::atomic<uint32_t> m_Epoch{0};
+            std::atomic_int m_Parked{0};
+            int m_SpinCount;
+#if !defined(V8APP_LINUX)
+            std::mutex m_Lock;
+            std::condition_variable m_Waiter;
+#endif
+        };
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_PARKER_H__
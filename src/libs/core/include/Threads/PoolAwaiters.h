@@ -0,0 +1,49 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _POOL_AWAITERS_H__
+#define _POOL_AWAITERS_H__
+
+#include <coroutine>
+
+#include "Threads/ThreadPoolQueue.h"
+#include "Threads/ThreadPoolDelayedQueue.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        /**
+         * Awaiter that resumes the coroutine on one of a pool's worker threads.
+         * co_await returns false if the pool wouldn't take the task because it's exiting,
+         * in which case the coroutine carries on on the thread it was on.
+         * A coroutine that is suspended on a pool that's terminated before it runs is never resumed.
+         */
+        class ThreadPoolAwaiter
+        {
+        public:
+            explicit ThreadPoolAwaiter(ThreadPoolQueue *inPool) : m_Pool(inPool) {}
+            ThreadPoolAwaiter(ThreadPoolDelayedQueue *inPool, double inDelay) : m_DelayedPool(inPool), m_Delay(inDelay) {}
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> inHandle);
+            bool await_resume() const noexcept { return m_Scheduled; }
+
+        private:
+            ThreadPoolQueue *m_Pool = nullptr;
+            ThreadPoolDelayedQueue *m_DelayedPool = nullptr;
+            // seconds to wait before resuming, only used for the delayed pool
+            double m_Delay = 0;
+            bool m_Scheduled = false;
+        };
+
+        // co_await to move the coroutine onto the pool
+        ThreadPoolAwaiter ScheduleOn(ThreadPoolQueue &inPool);
+        ThreadPoolAwaiter ScheduleOn(ThreadPoolDelayedQueue &inPool);
+        // co_await to resume the coroutine on the pool after inDelay seconds without blocking a thread
+        ThreadPoolAwaiter Delay(ThreadPoolDelayedQueue &inPool, double inDelay);
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_POOL_AWAITERS_H__
@@ -0,0 +1,141 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _POOL_METRICS_H__
+#define _POOL_METRICS_H__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace v8App
+{
+    namespace Threads
+    {
+        /**
+         * Point in time copy of a LatencyHistogram
+         */
+        struct HistogramSnapshot
+        {
+            static constexpr size_t kNumBuckets = 40;
+
+            uint64_t m_Count = 0;
+            int64_t m_SumNanoseconds = 0;
+            int64_t m_MaxNanoseconds = 0;
+            // bucket x counts samples in [2^x, 2^(x+1)) nanoseconds, bucket 0 also has anything under a nanosecond
+            std::array<uint64_t, kNumBuckets> m_Buckets{};
+
+            double GetMeanNanoseconds() const;
+            /**
+             * Returns the upper bound of the bucket the percentile (0 - 100) falls in, capped at the max seen
+             */
+            int64_t GetPercentileNanoseconds(double inPercentile) const;
+            void Merge(const HistogramSnapshot &inOther);
+        };
+
+        /**
+         * Log2 bucketed histogram of durations. Recording is a few relaxed atomic adds so it can be used
+         * on the hot path. Meant to be written by one thread at a time but read from any thread.
+         */
+        class LatencyHistogram
+        {
+        public:
+            void Record(int64_t inNanoseconds);
+            HistogramSnapshot GetSnapshot() const;
+
+            static size_t GetBucketIndex(int64_t inNanoseconds);
+
+        private:
+            std::atomic<uint64_t> m_Count{0};
+            std::atomic<int64_t> m_Sum{0};
+            std::atomic<int64_t> m_Max{0};
+            std::array<std::atomic<uint64_t>, HistogramSnapshot::kNumBuckets> m_Buckets{};
+        };
+
+        struct WorkerMetricsSnapshot
+        {
+            uint64_t m_TasksRun = 0;
+            int64_t m_BusyNanoseconds = 0;
+            int64_t m_IdleNanoseconds = 0;
+
+            // fraction of the worker's time spent running tasks
+            double GetBusyRatio() const;
+        };
+
+        struct PoolMetricsSnapshot
+        {
+            uint64_t m_Posted = 0;
+            uint64_t m_DelayedPosted = 0;
+            // delayed tasks canceled before they came due
+            uint64_t m_DelayedCanceled = 0;
+            uint64_t m_Started = 0;
+            double m_UptimeSeconds = 0;
+            // time from a task being posted to a worker starting it
+            HistogramSnapshot m_WaitTime;
+            HistogramSnapshot m_RunTime;
+            // how long after it's deadline a delayed task started
+            HistogramSnapshot m_DelayedLateness;
+            std::vector<WorkerMetricsSnapshot> m_Workers;
+
+            // tasks posted that haven't started yet, includes delayed tasks that aren't due yet
+            uint64_t GetQueueDepth() const;
+            // average tasks posted per second since the pool was created
+            double GetEnqueueRate() const;
+
+            void Dump(std::ostream &inStream) const;
+            std::string ToString() const;
+        };
+
+        /**
+         * Scheduling metrics for a thread pool. The posting counters are shared while the timings are
+         * kept per worker so workers never contend with each other recording them. Use GetSnapshot
+         * to read them from any thread.
+         */
+        class PoolMetrics
+        {
+        public:
+            explicit PoolMetrics(int inNumberOfWorkers);
+
+            PoolMetrics(const PoolMetrics &) = delete;
+            PoolMetrics &operator=(const PoolMetrics &) = delete;
+
+            void RecordPosted(size_t inCount) { m_Posted.fetch_add(inCount, std::memory_order_relaxed); }
+            void RecordDelayedPosted(size_t inCount) { m_DelayedPosted.fetch_add(inCount, std::memory_order_relaxed); }
+            void RecordDelayedCanceled(size_t inCount) { m_DelayedCanceled.fetch_add(inCount, std::memory_order_relaxed); }
+            /**
+             * Records a worker starting a task. inReadyTime is when the task was posted or for delayed
+             * tasks when it was due.
+             */
+            void RecordStarted(int inWorkerIndex, int64_t inReadyTime, bool inDelayed, int64_t inNow);
+            void RecordRun(int inWorkerIndex, int64_t inRunNanoseconds);
+            void RecordIdle(int inWorkerIndex, int64_t inIdleNanoseconds);
+
+            PoolMetricsSnapshot GetSnapshot() const;
+
+        private:
+            // each worker's counters on their own cache line
+            struct alignas(64) WorkerMetrics
+            {
+                std::atomic<uint64_t> m_TasksRun{0};
+                std::atomic<int64_t> m_BusyNanoseconds{0};
+                std::atomic<int64_t> m_IdleNanoseconds{0};
+                LatencyHistogram m_WaitTime;
+                LatencyHistogram m_RunTime;
+                LatencyHistogram m_DelayedLateness;
+            };
+
+            std::atomic<uint64_t> m_Posted{0};
+            std::atomic<uint64_t> m_DelayedPosted{0};
+            std::atomic<uint64_t> m_DelayedCanceled{0};
+            int64_t m_CreatedTime;
+            std::vector<std::unique_ptr<WorkerMetrics>> m_Workers;
+        };
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_POOL_METRICS_H__
@@ -0,0 +1,58 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _SCOPED_BLOCKING_CALL_H__
+#define _SCOPED_BLOCKING_CALL_H__
+
+namespace v8App
+{
+    namespace Threads
+    {
+        enum class BlockingType
+        {
+            // the call might block, like a read that's probably cached
+            kMayBlock,
+            // the call will block, like waiting on the disk or the network
+            kWillBlock
+        };
+
+        /**
+         * Implemented by a thread pool that wants to know when one of it's workers is about to block so
+         * it can bring in another worker to keep the cpu busy till it's done. The pool registers itself
+         * on each of it's worker threads with SetBlockingObserverForCurrentThread.
+         */
+        class IBlockingObserver
+        {
+        public:
+            virtual ~IBlockingObserver() = default;
+
+            virtual void BlockingStarted(BlockingType inType) = 0;
+            virtual void BlockingEnded() = 0;
+        };
+
+        void SetBlockingObserverForCurrentThread(IBlockingObserver *inObserver);
+        IBlockingObserver *GetBlockingObserverForCurrentThread();
+
+        /**
+         * Marks a region of code that blocks. Tells the observer of the thread, if there is one, when the
+         * region starts and ends. Nested regions are folded into the outermost one. Does nothing on a
+         * thread that isn't a pool worker.
+         */
+        class ScopedBlockingCall
+        {
+        public:
+            explicit ScopedBlockingCall(BlockingType inType);
+            ~ScopedBlockingCall();
+
+            ScopedBlockingCall(const ScopedBlockingCall &) = delete;
+            ScopedBlockingCall &operator=(const ScopedBlockingCall &) = delete;
+
+        private:
+            // null if the region is nested or the thread has no observer
+            IBlockingObserver *m_Observer = nullptr;
+        };
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_SCOPED_BLOCKING_CALL_H__
@@ -0,0 +1,72 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _SEQUENCED_TASK_RUNNER_H__
+#define _SEQUENCED_TASK_RUNNER_H__
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "Threads/ThreadPoolQueue.h"
+#include "Threads/ThreadPoolTasks.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        // number of tasks a sequence runs before giving the worker back to the pool
+        constexpr size_t kDefaultSequenceBatchSize = 8;
+
+        /**
+         * A strand on a ThreadPoolQueue. Tasks posted to the runner run one at a time in the order
+         * they were posted but on whichever of the pool's workers is free, so any number of runners
+         * can share the pool's threads. Only one drain task per runner is ever queued on the pool
+         * and it runs at most inBatchSize tasks before reposting itself so a busy sequence doesn't
+         * starve the others.
+         *
+         * Tasks already posted still run if the runner is destroyed first. The pool must outlive them.
+         */
+        class SequencedTaskRunner
+        {
+        public:
+            explicit SequencedTaskRunner(ThreadPoolQueue &inPool, size_t inBatchSize = kDefaultSequenceBatchSize);
+            ~SequencedTaskRunner() = default;
+
+            SequencedTaskRunner(const SequencedTaskRunner &) = delete;
+            SequencedTaskRunner &operator=(const SequencedTaskRunner &) = delete;
+
+            // Adds a task to the end of the sequence, returns false if the pool wouldn't take it
+            bool PostTask(ThreadPoolTaskUniquePtr inTask);
+            // returns true if called from one of this sequence's tasks
+            bool RunsTasksInCurrentSequence() const;
+            // number of tasks waiting to run, not counting one that's running
+            size_t GetPendingCount() const;
+            size_t GetBatchSize() const { return m_State->m_BatchSize; }
+
+        protected:
+            struct SequenceState
+            {
+                ThreadPoolQueue *m_Pool;
+                size_t m_BatchSize;
+                mutable std::mutex m_Lock;
+                std::deque<ThreadPoolTaskUniquePtr> m_Tasks;
+                // a drain task is queued or running on the pool
+                bool m_Scheduled = false;
+            };
+            using SequenceStateSharedPtr = std::shared_ptr<SequenceState>;
+
+            /**
+             * Posts a task to the pool that drains the sequence, returns false if the pool is exiting.
+             * inToBack puts it behind the pool's other waiting tasks even when posted from a worker
+             */
+            static bool ScheduleDrain(SequenceStateSharedPtr inState, bool inToBack = false);
+            static void Drain(SequenceStateSharedPtr inState);
+
+            SequenceStateSharedPtr m_State;
+        };
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_SEQUENCED_TASK_RUNNER_H__
@@ -0,0 +1,138 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef __T_TASK_H_
+#define __T_TASK_H_
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace v8App
+{
+    namespace Threads
+    {
+        template <typename T>
+        class TTask;
+
+        /**
+         * Parts of the promise shared by all the task types. When the coroutine finishes it
+         * resumes whoever co_awaited it rather than returning to the thread that ran it.
+         */
+        class TaskPromiseBase
+        {
+        public:
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> inHandle) noexcept;
+                void await_resume() noexcept {}
+            };
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void unhandled_exception() { m_Exception = std::current_exception(); }
+
+            void SetContinuation(std::coroutine_handle<> inContinuation) { m_Continuation = inContinuation; }
+            std::coroutine_handle<> GetContinuation() const { return m_Continuation; }
+
+        protected:
+            std::coroutine_handle<> m_Continuation;
+            std::exception_ptr m_Exception;
+        };
+
+        template <typename T>
+        class TTaskPromise : public TaskPromiseBase
+        {
+        public:
+            TTask<T> get_return_object() noexcept;
+
+            template <typename Value>
+            void return_value(Value &&inValue) { m_Value.emplace(std::forward<Value>(inValue)); }
+
+            T GetResult();
+
+        protected:
+            std::optional<T> m_Value;
+        };
+
+        template <>
+        class TTaskPromise<void> : public TaskPromiseBase
+        {
+        public:
+            TTask<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void GetResult();
+        };
+
+        /**
+         * A lazily started coroutine. The body doesn't run till the task is co_awaited, waited on
+         * with SyncWait or handed off with Detach. Use co_await ScheduleOn(pool) or Delay(pool, seconds)
+         * inside the body to hop onto the thread pools without blocking a thread while waiting.
+         * The result or any exception thrown by the body is handed to whoever awaits it.
+         */
+        template <typename T = void>
+        class TTask
+        {
+        public:
+            using promise_type = TTaskPromise<T>;
+            using Handle = std::coroutine_handle<promise_type>;
+
+            TTask() = default;
+            explicit TTask(Handle inHandle) : m_Handle(inHandle) {}
+            ~TTask();
+
+            TTask(const TTask &) = delete;
+            TTask &operator=(const TTask &) = delete;
+
+            TTask(TTask &&inTask) noexcept : m_Handle(std::exchange(inTask.m_Handle, nullptr)) {}
+            TTask &operator=(TTask &&inTask) noexcept;
+
+            bool IsValid() const { return m_Handle != nullptr; }
+            bool IsDone() const { return m_Handle == nullptr || m_Handle.done(); }
+
+            class Awaiter
+            {
+            public:
+                explicit Awaiter(Handle inHandle) : m_Handle(inHandle) {}
+                bool await_ready() const noexcept { return m_Handle == nullptr || m_Handle.done(); }
+                // starts the task and has it resume us when it's done
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> inAwaiting) noexcept;
+                // throws std::logic_error if the task is empty or was moved from
+                T await_resume();
+
+            private:
+                Handle m_Handle;
+            };
+
+            Awaiter operator co_await() const & noexcept { return Awaiter(m_Handle); }
+            Awaiter operator co_await() const && noexcept { return Awaiter(m_Handle); }
+
+        private:
+            Handle m_Handle = nullptr;
+        };
+
+        /**
+         * Runs the task and blocks the calling thread till it's finished, returning it's result.
+         * Meant for the edges of the app like tests and main, not for use on a pool thread.
+         */
+        template <typename T>
+        T SyncWait(TTask<T> inTask);
+
+        /**
+         * Starts the task and lets it run to completion on it's own. The task's frame is freed
+         * when it finishes. Any exception it throws is logged.
+         */
+        template <typename T>
+        void Detach(TTask<T> inTask);
+    } // namespace Threads
+} // namespace v8App
+
+#include "TTask.hpp"
+#endif //__T_TASK_H_
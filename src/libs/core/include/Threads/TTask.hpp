@@ -0,0 +1,233 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+// #include "TTask.h"
+
+#include <condition_variable>
+#include <mutex>
+
+#include "Logging/LogMacros.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        template <typename Promise>
+        std::coroutine_handle<> TaskPromiseBase::FinalAwaiter::await_suspend(std::coroutine_handle<Promise> inHandle) noexcept
+        {
+            // symmetric transfer to the awaiting coroutine so long chains don't grow the stack
+            std::coroutine_handle<> continuation = inHandle.promise().GetContinuation();
+            if (continuation)
+            {
+                return continuation;
+            }
+            return std::noop_coroutine();
+        }
+
+        template <typename T>
+        TTask<T> TTaskPromise<T>::get_return_object() noexcept
+        {
+            return TTask<T>(std::coroutine_handle<TTaskPromise<T>>::from_promise(*this));
+        }
+
+        template <typename T>
+        T TTaskPromise<T>::GetResult()
+        {
+            if (m_Exception)
+            {
+                std::rethrow_exception(m_Exception);
+            }
+            return std::move(m_Value.value());
+        }
+
+        inline TTask<void> TTaskPromise<void>::get_return_object() noexcept
+        {
+            return TTask<void>(std::coroutine_handle<TTaskPromise<void>>::from_promise(*this));
+        }
+
+        inline void TTaskPromise<void>::GetResult()
+        {
+            if (m_Exception)
+            {
+                std::rethrow_exception(m_Exception);
+            }
+        }
+
+        template <typename T>
+        TTask<T>::~TTask()
+        {
+            if (m_Handle)
+            {
+                m_Handle.destroy();
+            }
+        }
+
+        template <typename T>
+        TTask<T> &TTask<T>::operator=(TTask &&inTask) noexcept
+        {
+            if (this != &inTask)
+            {
+                if (m_Handle)
+                {
+                    m_Handle.destroy();
+                }
+                m_Handle = std::exchange(inTask.m_Handle, nullptr);
+            }
+            return *this;
+        }
+
+        template <typename T>
+        std::coroutine_handle<> TTask<T>::Awaiter::await_suspend(std::coroutine_handle<> inAwaiting) noexcept
+        {
+            m_Handle.promise().SetContinuation(inAwaiting);
+            return m_Handle;
+        }
+
+        template <typename T>
+        T TTask<T>::Awaiter::await_resume()
+        {
+            // await_ready let an empty task through so there's no result to hand back
+            if (m_Handle == nullptr)
+            {
+                throw std::logic_error("co_await on an empty TTask");
+            }
+            return m_Handle.promise().GetResult();
+        }
+
+        /**
+         * Coroutine types used to drive a TTask from outside of a coroutine
+         */
+        namespace TaskDriver
+        {
+            struct SyncWaitState
+            {
+                std::mutex m_Lock;
+                std::condition_variable m_Waiter;
+                bool m_Done = false;
+                std::exception_ptr m_Exception;
+            };
+
+            class SyncWaitTask
+            {
+            public:
+                struct promise_type
+                {
+                    SyncWaitState *m_State = nullptr;
+
+                    SyncWaitTask get_return_object() noexcept
+                    {
+                        return SyncWaitTask(std::coroutine_handle<promise_type>::from_promise(*this));
+                    }
+                    std::suspend_always initial_suspend() noexcept { return {}; }
+                    auto final_suspend() noexcept
+                    {
+                        struct Signal
+                        {
+                            bool await_ready() noexcept { return false; }
+                            void await_suspend(std::coroutine_handle<promise_type> inHandle) noexcept
+                            {
+                                SyncWaitState *state = inHandle.promise().m_State;
+                                // notify under the lock so the waiter can't return and free the state under us
+                                std::lock_guard<std::mutex> lock(state->m_Lock);
+                                state->m_Done = true;
+                                state->m_Waiter.notify_one();
+                            }
+                            void await_resume() noexcept {}
+                        };
+                        return Signal{};
+                    }
+                    void return_void() noexcept {}
+                    void unhandled_exception() { m_State->m_Exception = std::current_exception(); }
+                };
+
+                explicit SyncWaitTask(std::coroutine_handle<promise_type> inHandle) : m_Handle(inHandle) {}
+                ~SyncWaitTask()
+                {
+                    if (m_Handle)
+                    {
+                        m_Handle.destroy();
+                    }
+                }
+                SyncWaitTask(const SyncWaitTask &) = delete;
+                SyncWaitTask &operator=(const SyncWaitTask &) = delete;
+
+                void Wait()
+                {
+                    SyncWaitState state;
+                    m_Handle.promise().m_State = &state;
+                    m_Handle.resume();
+                    std::unique_lock<std::mutex> lock(state.m_Lock);
+                    state.m_Waiter.wait(lock, [&state]()
+                                        { return state.m_Done; });
+                    if (state.m_Exception)
+                    {
+                        std::rethrow_exception(state.m_Exception);
+                    }
+                }
+
+            private:
+                std::coroutine_handle<promise_type> m_Handle;
+            };
+
+            class DetachedTask
+            {
+            public:
+                struct promise_type
+                {
+                    DetachedTask get_return_object() noexcept { return DetachedTask(); }
+                    std::suspend_never initial_suspend() noexcept { return {}; }
+                    // frees the frame as soon as it's done
+                    std::suspend_never final_suspend() noexcept { return {}; }
+                    void return_void() noexcept {}
+                    void unhandled_exception() noexcept
+                    {
+                        Log::LogMessage msg;
+                        msg.emplace(Log::MsgKey::Msg, "Detached task exited with an exception");
+                        LOG_ERROR(msg);
+                    }
+                };
+            };
+
+            template <typename T>
+            SyncWaitTask MakeSyncWaitTask(TTask<T> &inTask, std::optional<T> &outResult)
+            {
+                outResult.emplace(co_await inTask);
+            }
+
+            inline SyncWaitTask MakeSyncWaitTask(TTask<void> &inTask)
+            {
+                co_await inTask;
+            }
+
+            template <typename T>
+            DetachedTask MakeDetachedTask(TTask<T> inTask)
+            {
+                co_await inTask;
+            }
+        } // namespace TaskDriver
+
+        template <typename T>
+        T SyncWait(TTask<T> inTask)
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                TaskDriver::SyncWaitTask waiter = TaskDriver::MakeSyncWaitTask(inTask);
+                waiter.Wait();
+            }
+            else
+            {
+                std::optional<T> result;
+                TaskDriver::SyncWaitTask waiter = TaskDriver::MakeSyncWaitTask(inTask, result);
+                waiter.Wait();
+                return std::move(result.value());
+            }
+        }
+
+        template <typename T>
+        void Detach(TTask<T> inTask)
+        {
+            TaskDriver::MakeDetachedTask(std::move(inTask));
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,91 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef __T_TASK_NODE_POOL_H_
+#define __T_TASK_NODE_POOL_H_
+
+#include <cstddef>
+#include <mutex>
+
+namespace v8App
+{
+    namespace Threads
+    {
+        /**
+         * Recycles fixed size blocks of memory for task objects so posting a task doesn't
+         * have to go to the heap. Each thread keeps it's own free list so the common case
+         * takes no locks. Since tasks are usually created on one thread and freed on a worker
+         * the free lists drift, so once a thread caches too many blocks it hands a batch over
+         * to a shared list that threads refill from when they run dry.
+         */
+        template <size_t NodeSize>
+        class TTaskNodePool
+        {
+        public:
+            // max number of blocks a thread will hold on to before handing a batch to the shared list
+            static constexpr size_t kMaxThreadCachedNodes = 256;
+            // number of blocks moved between a thread and the shared list at a time
+            static constexpr size_t kTransferBatchSize = 64;
+            // max number of blocks the shared list holds before they are released to the heap
+            static constexpr size_t kMaxSharedNodes = 4096;
+
+            /**
+             * Gets a block for an object of inSize. Sizes other than NodeSize go to the heap
+             */
+            static void *Allocate(size_t inSize);
+            /**
+             * Returns a block that was gotten from Allocate
+             */
+            static void Free(void *inPtr, size_t inSize);
+
+            /**
+             * Number of free blocks cached by the calling thread
+             */
+            static size_t GetThreadCachedCount();
+            /**
+             * Number of free blocks in the shared list
+             */
+            static size_t GetSharedCachedCount();
+
+        protected:
+            struct FreeNode
+            {
+                FreeNode *m_Next;
+            };
+
+            struct FreeList
+            {
+                FreeNode *m_Head = nullptr;
+                size_t m_Count = 0;
+
+                void Push(FreeNode *inNode);
+                FreeNode *Pop();
+            };
+
+            struct ThreadCache : public FreeList
+            {
+                // hands the blocks back to the shared list when the thread exits
+                ~ThreadCache();
+            };
+            // trivially destructable so it can be checked after the cache has been destroyed
+            static thread_local bool s_ThreadCacheDestroyed;
+
+            struct SharedList : public FreeList
+            {
+                std::mutex m_Lock;
+            };
+
+            static_assert(NodeSize >= sizeof(FreeNode), "Node size is too small to hold the free list link");
+
+            // returns nullptr once the thread's cache has been destroyed at thread exit
+            static ThreadCache *GetThreadCache();
+            static SharedList &GetSharedList();
+            // moves up to inCount blocks from one list to the other
+            static void Transfer(FreeList &inFrom, FreeList &inTo, size_t inCount);
+        };
+    } // namespace Threads
+} // namespace v8App
+
+#include "TTaskNodePool.hpp"
+#endif //__T_TASK_NODE_POOL_H_
@@ -0,0 +1,156 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+// #include "TTaskNodePool.h"
+
+#include <new>
+
+namespace v8App
+{
+    namespace Threads
+    {
+        template <size_t NodeSize>
+        void *TTaskNodePool<NodeSize>::Allocate(size_t inSize)
+        {
+            if (inSize != NodeSize)
+            {
+                return ::operator new(inSize);
+            }
+            ThreadCache *cache = GetThreadCache();
+            if (cache == nullptr)
+            {
+                return ::operator new(NodeSize);
+            }
+            if (cache->m_Head == nullptr)
+            {
+                SharedList &shared = GetSharedList();
+                std::lock_guard<std::mutex> lock(shared.m_Lock);
+                Transfer(shared, *cache, kTransferBatchSize);
+            }
+            FreeNode *node = cache->Pop();
+            if (node == nullptr)
+            {
+                return ::operator new(NodeSize);
+            }
+            return node;
+        }
+
+        template <size_t NodeSize>
+        void TTaskNodePool<NodeSize>::Free(void *inPtr, size_t inSize)
+        {
+            if (inPtr == nullptr)
+            {
+                return;
+            }
+            if (inSize != NodeSize)
+            {
+                ::operator delete(inPtr);
+                return;
+            }
+            ThreadCache *cache = GetThreadCache();
+            if (cache == nullptr)
+            {
+                ::operator delete(inPtr);
+                return;
+            }
+            cache->Push(static_cast<FreeNode *>(inPtr));
+            if (cache->m_Count <= kMaxThreadCachedNodes)
+            {
+                return;
+            }
+
+            SharedList &shared = GetSharedList();
+            std::lock_guard<std::mutex> lock(shared.m_Lock);
+            Transfer(*cache, shared, kTransferBatchSize);
+            while (shared.m_Count > kMaxSharedNodes)
+            {
+                ::operator delete(shared.Pop());
+            }
+        }
+
+        template <size_t NodeSize>
+        size_t TTaskNodePool<NodeSize>::GetThreadCachedCount()
+        {
+            ThreadCache *cache = GetThreadCache();
+            return cache == nullptr ? 0 : cache->m_Count;
+        }
+
+        template <size_t NodeSize>
+        size_t TTaskNodePool<NodeSize>::GetSharedCachedCount()
+        {
+            SharedList &shared = GetSharedList();
+            std::lock_guard<std::mutex> lock(shared.m_Lock);
+            return shared.m_Count;
+        }
+
+        template <size_t NodeSize>
+        void TTaskNodePool<NodeSize>::FreeList::Push(FreeNode *inNode)
+        {
+            inNode->m_Next = m_Head;
+            m_Head = inNode;
+            m_Count++;
+        }
+
+        template <size_t NodeSize>
+        typename TTaskNodePool<NodeSize>::FreeNode *TTaskNodePool<NodeSize>::FreeList::Pop()
+        {
+            FreeNode *node = m_Head;
+            if (node != nullptr)
+            {
+                m_Head = node->m_Next;
+                m_Count--;
+            }
+            return node;
+        }
+
+        template <size_t NodeSize>
+        thread_local bool TTaskNodePool<NodeSize>::s_ThreadCacheDestroyed = false;
+
+        template <size_t NodeSize>
+        TTaskNodePool<NodeSize>::ThreadCache::~ThreadCache()
+        {
+            s_ThreadCacheDestroyed = true;
+            SharedList &shared = GetSharedList();
+            std::lock_guard<std::mutex> lock(shared.m_Lock);
+            Transfer(*this, shared, this->m_Count);
+            while (shared.m_Count > kMaxSharedNodes)
+            {
+                ::operator delete(shared.Pop());
+            }
+        }
+
+        template <size_t NodeSize>
+        typename TTaskNodePool<NodeSize>::ThreadCache *TTaskNodePool<NodeSize>::GetThreadCache()
+        {
+            if (s_ThreadCacheDestroyed)
+            {
+                return nullptr;
+            }
+            static thread_local ThreadCache s_Cache;
+            return &s_Cache;
+        }
+
+        template <size_t NodeSize>
+        typename TTaskNodePool<NodeSize>::SharedList &TTaskNodePool<NodeSize>::GetSharedList()
+        {
+            // never destroyed so threads exiting during shutdown can still hand back their blocks
+            static SharedList *s_Shared = new SharedList();
+            return *s_Shared;
+        }
+
+        template <size_t NodeSize>
+        void TTaskNodePool<NodeSize>::Transfer(FreeList &inFrom, FreeList &inTo, size_t inCount)
+        {
+            for (size_t x = 0; x < inCount; x++)
+            {
+                FreeNode *node = inFrom.Pop();
+                if (node == nullptr)
+                {
+                    break;
+                }
+                inTo.Push(node);
+            }
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -11,10 +11,12 @@
 #include <vector>
 #include <atomic>
 #include <future>
+#include <optional>
 
 #include "Queues/TThreadSafeDelayedQueue.h"
 #include "Threads/ThreadPoolTasks.h"
-#include "Threads/Threads.h"
+#include "Threads/Parker.h"
+#include "Threads/ThreadPoolWorkers.h"
 
 namespace v8App
 {
@@ -22,67 +24,68 @@ namespace v8App
     {
         /**
          * ThreadPoolQueue Implements a queue that has a thread pool that runs all the tasks posted 
-         * to it and can have delyaed tasks posted to it
+         * to it and can have delyaed tasks posted to it.
+         * Like ThreadPoolQueue tasks posted from the pool's workers go into the worker's own deque
+         * and idle workers steal from each other. Tasks are never run while holding the pool lock.
+         * A dedicated timer thread sleeps until the next delayed task's deadline and then moves
+         * the ready tasks to the main queue waking the workers.
+         * When created with ElasticPoolOptions the pool adds and retires workers with the load.
          */
-        class ThreadPoolDelayedQueue
+        class ThreadPoolDelayedQueue : public ThreadPoolWorkers
         {
         public:
             ThreadPoolDelayedQueue(int inNumberOfWorkers = -1, ThreadPriority inPriority = ThreadPriority::kBestEffort);
+            explicit ThreadPoolDelayedQueue(const ElasticPoolOptions &inOptions, ThreadPriority inPriority = ThreadPriority::kBestEffort);
             ~ThreadPoolDelayedQueue();
 
             // Add a task to the worker queue
             bool PostTask(ThreadPoolTaskUniquePtr inTask);
             bool PostDelayedTask(double inDelay, ThreadPoolTaskUniquePtr inTask);
+            // Add a batch of tasks with a single enqueue waking only as many workers as needed
+            bool PostTasks(std::vector<ThreadPoolTaskUniquePtr> inTasks);
+            bool PostDelayedTasks(double inDelay, std::vector<ThreadPoolTaskUniquePtr> inTasks);
+            // Add a delayed task returning an id that can cancel it or kInvalidTimerId if it wasn't posted
+            Queues::TimerId PostCancelableDelayedTask(double inDelay, ThreadPoolTaskUniquePtr inTask);
+            // Removes a delayed task that isn't due yet destroying it, returns false if it's already due or canceled
+            bool CancelDelayedTask(Queues::TimerId inId);
 
-            // gets the number of worker threads the pool has available
-            int GetNumberOfWorkers() { return m_NumWorkers; }
-
-            // pool id is passed when cheking in case a new pool was created after the task was run.
-            bool IsExiting() { return m_Exiting; }
-            ThreadPriority GetPriority() const { return m_Priority; }
-
-            void Terminate();
-            bool SetPaused(bool inPaused) { return m_Paused.exchange(inPaused); }
+            bool SetPaused(bool inPaused);
 
         protected:
-            class ThreadPoolThread : public Thread
-            {
-            public:
-                ThreadPoolThread(std::string inName, ThreadPriority inPriority, ThreadPoolDelayedQueue *inPool, bool inPumper) : Thread(inName, inPriority), m_Pool(inPool), m_Pumper(inPumper) {}
-
-            protected:
-                virtual void RunImpl() override
-                {
-                    if (m_Pumper)
-                    {
-                        m_Pool->PumpQueue();
-                    }
-                    else
-                    {
-                        m_Pool->ProcessTasks();
-                    }
-                }
-
-            protected:
-                ThreadPoolDelayedQueue *m_Pool;
-                bool m_Pumper;
-            };
-
+            // creates the worker deques and starts the workers and the timer
+            void Initialize();
             // queue calls this when delayed tasks are ready to be run
-            void DelayedJobsReady();
-            // pumps the queue to process the delayed tasks.
-            void PumpQueue();
+            void DelayedJobsReady(size_t inCount);
             // Hnadles removing a task form the queue and running it.
-            void ProcessTasks();
+            void ProcessTasks(int inWorkerIndex) override;
+            // Sleeps till the next delayed task is due and ticks the queue to move it to the main queue
+            void RunTimer() override;
+            // Wakes the timer if the new deadline is before the one it's currently sleeping till
+            void RescheduleTimer(double inDeadline);
+            // Returns the index of the worker if called from one of this pool's threads otherwise -1
+            int GetCurrentWorkerIndex();
+            // wakes up to inCount parked workers
+            void WakeWorkers(size_t inCount);
+
+            int GetParkedCount() override { return m_Parker.GetParkedCount(); }
+            bool HasBacklog() override;
+            void WakeAllWorkers() override { m_Parker.UnparkAll(); }
+            void WakeTimer() override;
+            std::optional<ThreadPoolTaskUniquePtr> PopInjectedTask() override { return m_Queue.GetNextItem(); }
+            // only the worker posts to it's deque so once empty it stays empty
+            bool WorkerHasQueuedTasks(int inWorkerIndex) override { return m_WorkerQueues[inWorkerIndex]->MayHaveItems(); }
 
-            int m_NumWorkers = 0;
-            std::mutex m_QueueLock;
-            std::atomic_bool m_Exiting{false};
             std::atomic_bool m_Paused{false};
-            std::condition_variable m_QueueWaiter;
+            // injection queue for tasks posted from outside of the pool and for delayed tasks
             Queues::TThreadSafeDelayedQueue<ThreadPoolTaskUniquePtr> m_Queue;
-            std::vector<std::unique_ptr<Thread>> m_Workers;
-            ThreadPriority m_Priority;
+            // idle workers sleep here and posts wake only as many as they have tasks for
+            Parker m_Parker;
+
+            std::mutex m_TimerLock;
+            std::condition_variable m_TimerWaiter;
+            // the deadline the timer is sleeping till, infinity when it's waiting for a delayed task to be posted
+            double m_TimerDeadline;
+            bool m_TimerRescheduled = false;
         };
     } // namespace Threads
 } // namespace v8App
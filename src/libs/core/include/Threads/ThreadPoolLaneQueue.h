@@ -0,0 +1,147 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _THREAD_POOL_LANE_QUEUE_H__
+#define _THREAD_POOL_LANE_QUEUE_H__
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "Queues/TTimingWheel.h"
+#include "Threads/ScopedBlockingCall.h"
+#include "Threads/ThreadPoolTasks.h"
+#include "Threads/ThreadPoolWorkers.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        /**
+         * A single pool of workers shared by every task priority. Each ThreadPriority from kBestEffort up
+         * gets it's own lane, kDefault tasks go in the user visible lane. Workers take from the highest priority lane that has work, so high priority work is served
+         * first and can use any idle worker. A task is promoted a lane for each aging threshold it's waited
+         * so the low lanes can't be starved, it only gets ahead of a higher lane's task once it's waited a
+         * threshold longer for each lane between them so high priority work still goes first under load.
+         * Each lane can be capped to
+         * a number of workers so low priority work can't take over the whole pool.
+         * Tasks are never run while holding the pool lock.
+         * When created with ElasticPoolOptions a worker is added whenever a task is posted and no
+         * worker is idle, and workers idle for the idle timeout are retired. The timer thread starts the
+         * new workers so posting never waits on a thread being created.
+         * A task that blocks inside a ScopedBlockingCall doesn't count against the pool or it's lane, a
+         * compensating worker is brought in to run other tasks and the pool drops back once it's done.
+         */
+        class ThreadPoolLaneQueue : public ThreadPoolWorkers, public IBlockingObserver
+        {
+        public:
+            static constexpr size_t kNumLanes = static_cast<size_t>(ThreadPriority::kMaxPriority) - static_cast<size_t>(ThreadPriority::kBestEffort) + 1;
+            // seconds a task waits for each lane it's promoted
+            static constexpr double kDefaultAgingThreshold = 0.1;
+
+            ThreadPoolLaneQueue(int inNumberOfWorkers = -1, ThreadPriority inPriority = ThreadPriority::kUserVisible);
+            explicit ThreadPoolLaneQueue(const ElasticPoolOptions &inOptions, ThreadPriority inPriority = ThreadPriority::kUserVisible);
+            ~ThreadPoolLaneQueue();
+
+            // Add a task to the lane
+            bool PostTask(ThreadPriority inLane, ThreadPoolTaskUniquePtr inTask);
+            bool PostDelayedTask(ThreadPriority inLane, double inDelay, ThreadPoolTaskUniquePtr inTask);
+            // Add a batch of tasks to the lane waking only as many workers as needed
+            bool PostTasks(ThreadPriority inLane, std::vector<ThreadPoolTaskUniquePtr> inTasks);
+            // Add a delayed task returning an id that can cancel it or kInvalidTimerId if it wasn't posted
+            Queues::TimerId PostCancelableDelayedTask(ThreadPriority inLane, double inDelay, ThreadPoolTaskUniquePtr inTask);
+            // Removes a delayed task that isn't due yet destroying it, returns false if it's already due or canceled
+            bool CancelDelayedTask(Queues::TimerId inId);
+
+            /**
+             * Sets the most workers that can run the lane's tasks at once. By default the best effort
+             * lane gets half the workers and the other lanes can use all of them.
+             */
+            void SetLaneConcurrency(ThreadPriority inLane, int inMaxConcurrency);
+            int GetLaneConcurrency(ThreadPriority inLane);
+            // 0 turns aging off
+            void SetAgingThreshold(double inSeconds);
+            double GetAgingThreshold();
+            // number of tasks waiting to run in the lane, not counting delayed tasks that aren't due
+            size_t GetLaneQueuedCount(ThreadPriority inLane);
+            // number of the lane's tasks running right now
+            int GetLaneRunningCount(ThreadPriority inLane);
+
+            bool SetPaused(bool inPaused);
+
+            // number of workers inside a blocking call right now
+            int GetNumberOfBlockedWorkers();
+
+            // IBlockingObserver, called on the blocking worker
+            void BlockingStarted(BlockingType inType) override;
+            void BlockingEnded() override;
+
+        protected:
+            struct LaneTask
+            {
+                ThreadPoolTaskUniquePtr m_Task;
+                // when the task was ready to run in seconds, used for aging
+                double m_ReadyTime;
+            };
+
+            struct Lane
+            {
+                std::deque<LaneTask> m_Tasks;
+                int m_Running = 0;
+                int m_MaxConcurrency = 0;
+            };
+
+            struct DelayedTask
+            {
+                size_t m_Lane;
+                ThreadPoolTaskUniquePtr m_Task;
+            };
+
+            // sets up the lanes and starts the workers and the timer
+            void Initialize();
+            // wakes parked workers or for an elastic pool has the timer add workers for inCount new tasks
+            void WakeWorkers(size_t inCount);
+            // Hnadles removing a task form the lanes and running it.
+            void ProcessTasks(int inWorkerIndex) override;
+            // Sleeps till the next delayed task is due and moves it to it's lane
+            void RunTimer() override;
+            // picks the lane to take the next task from, -1 if nothing can run. Must hold m_QueueLock
+            int PickLane(double inNow);
+            // if any lane has a task and room to run it. Must hold m_QueueLock
+            bool HasRunnableLane();
+            // most workers that can be running, the max plus one for each blocked worker. Must hold m_QueueLock
+            int GetWorkerCapacity() override;
+            // the lane the priority's tasks go in
+            size_t GetLaneIndex(ThreadPriority inLane);
+
+            int GetParkedCount() override { return m_ParkedWorkers; }
+            bool HasBacklog() override;
+            void WakeAllWorkers() override { m_QueueWaiter.notify_all(); }
+            void WakeTimer() override;
+            void ClearQueues() override;
+
+            std::atomic_bool m_Paused{false};
+            std::condition_variable m_QueueWaiter;
+            std::array<Lane, kNumLanes> m_Lanes;
+            double m_AgingThreshold = kDefaultAgingThreshold;
+            // only changed under m_QueueLock
+            std::atomic_int m_ParkedWorkers{0};
+            // workers inside a blocking call, guarded by m_QueueLock
+            int m_BlockedWorkers = 0;
+
+            // delayed tasks guarded by m_QueueLock
+            Queues::TTimingWheel<DelayedTask> m_Delayed;
+            std::condition_variable m_TimerWaiter;
+            // set when the timer has to look at the deadlines or the wanted workers again, guarded by m_QueueLock
+            bool m_TimerRescheduled = false;
+            // workers the timer has been asked to start, guarded by m_QueueLock
+            int m_WantedWorkers = 0;
+        };
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_THREAD_POOL_LANE_QUEUE_H__
@@ -5,68 +5,71 @@
 #ifndef _THREAD_POOL_QUEUE_H__
 #define _THREAD_POOL_QUEUE_H__
 
-#include <mutex>
-#include <condition_variable>
 #include <functional>
 #include <vector>
 #include <atomic>
 #include <future>
+#include <optional>
 
-#include "Queues/TThreadSafeQueue.h"
-#include "Threads/Threads.h"
+#include "Queues/TLockFreeQueue.h"
+#include "Threads/Parker.h"
 #include "Threads/ThreadPoolTasks.h"
+#include "Threads/ThreadPoolWorkers.h"
 
 namespace v8App
 {
     namespace Threads
     {
         /**
-         * ThreadPoolQueue Implements a queue that has a thread pool that runs all the tasks posted to it
+         * ThreadPoolQueue Implements a queue that has a thread pool that runs all the tasks posted to it.
+         * Tasks posted from outside the pool go into a shared injection queue while tasks posted from
+         * one of the pool's workers go into that worker's own deque. A worker that runs dry takes from
+         * the injection queue and then steals from the other workers before parking.
+         * Tasks are never run while holding the pool lock.
+         * When created with ElasticPoolOptions the pool adds and retires workers with the load.
          */
-        class ThreadPoolQueue
+        class ThreadPoolQueue : public ThreadPoolWorkers
         {
         public:
             ThreadPoolQueue(int inNumberOfWorkers = -1, ThreadPriority inPriority = ThreadPriority::kBestEffort);
+            explicit ThreadPoolQueue(const ElasticPoolOptions &inOptions, ThreadPriority inPriority = ThreadPriority::kBestEffort);
             ~ThreadPoolQueue();
 
             // Add a task to the worker queue
             bool PostTask(ThreadPoolTaskUniquePtr inTask);
-
-            // gets the number of worker threads the pool has available
-            int GetNumberOfWorkers() { return m_NumWorkers; }
-
-            // pool id is passed when cheking in case a new pool was created after the task was run.
-            bool IsExiting() { return m_Exiting; }
-            ThreadPriority GetPriority() const { return m_Priority; }
-
-            void Terminate();
+            /**
+             * Adds a task to the injection queue even when called from one of the pool's workers so it
+             * runs after the tasks already waiting instead of next on the worker's own deque
+             */
+            bool PostTaskToBack(ThreadPoolTaskUniquePtr inTask);
+            // Add a batch of tasks to the worker queue with a single enqueue waking only as many workers as needed
+            bool PostTasks(std::vector<ThreadPoolTaskUniquePtr> inTasks);
 
         protected:
-            class ThreadPoolThread : public Thread
-            {
-            public:
-                ThreadPoolThread(std::string inName, ThreadPriority inPriority, ThreadPoolQueue *inPool) : Thread(inName, inPriority), m_Pool(inPool) {}
-
-            protected:
-                virtual void RunImpl() override
-                {
-                    m_Pool->ProcessTasks();
-                }
-
-            protected:
-                ThreadPoolQueue *m_Pool;
-            };
+            // creates the worker deques and starts the workers
+            void Initialize();
+            // inToBack skips the worker's deque
+            bool PostTaskImpl(ThreadPoolTaskUniquePtr inTask, bool inToBack);
 
             // Hnadles removing a task form the queue and running it.
-            void ProcessTasks();
+            void ProcessTasks(int inWorkerIndex) override;
+            // Returns the index of the worker if called from one of this pool's threads otherwise -1
+            int GetCurrentWorkerIndex();
+            // wakes up to inCount parked workers
+            void WakeWorkers(size_t inCount);
+
+            int GetParkedCount() override { return m_Parker.GetParkedCount(); }
+            bool HasBacklog() override;
+            void WakeAllWorkers() override { m_Parker.UnparkAll(); }
+            std::optional<ThreadPoolTaskUniquePtr> PopInjectedTask() override { return m_Queue.GetNextItem(); }
+            // only the worker posts to it's deque so once empty it stays empty
+            bool WorkerHasQueuedTasks(int inWorkerIndex) override { return m_WorkerQueues[inWorkerIndex]->MayHaveItems(); }
 
-            int m_NumWorkers = 0;
-            std::mutex m_QueueLock;
-            std::atomic_bool m_Exiting{false};
-            std::condition_variable m_QueueWaiter;
-            Queues::TThreadSafeQueue<ThreadPoolTaskUniquePtr> m_Queue;
-            std::vector<std::unique_ptr<Thread>> m_Workers;
-            ThreadPriority m_Priority;
+            // injection queue for tasks posted from outside of the pool, lock free so posting
+            // threads don't contend on a mutex. Spills if a burst fills the ring.
+            Queues::TLockFreeQueue<ThreadPoolTaskUniquePtr> m_Queue;
+            // idle workers sleep here and posts wake only as many as they have tasks for
+            Parker m_Parker;
         };
     } // namespace Threads
 } // namespace v8App
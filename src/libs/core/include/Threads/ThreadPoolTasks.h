@@ -12,8 +12,13 @@
 #include <thread>
 #include <atomic>
 #include <future>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
 
 #include "Queues/TThreadSafeQueue.h"
+#include "Threads/TTaskNodePool.h"
 
 namespace v8App
 {
@@ -28,10 +33,38 @@ namespace v8App
              * The actual code to run for the task
             */
             virtual void Run() = 0;
+
+            /**
+             * Stamped by the pools when the task is posted for their metrics. The ready time is in
+             * nanoseconds on Time::NowNanoseconds and for delayed tasks is the deadline the timer was
+             * given, which is on the same clock unless a test time is set.
+             */
+            void SetReadyTime(int64_t inReadyTime, bool inDelayed = false)
+            {
+                m_ReadyTime = inReadyTime;
+                m_Delayed = inDelayed;
+            }
+            int64_t GetReadyTime() const { return m_ReadyTime; }
+            bool IsDelayed() const { return m_Delayed; }
+
+        private:
+            int64_t m_ReadyTime = 0;
+            bool m_Delayed = false;
         };
 
-        // Class that can take a callable and run it. Allows passing lambdas, std::packaged_tasks
-        class CallableThreadTask : public IThreadPoolTask
+        /**
+         * Default number of bytes a CallableThreadTask can hold inline for the callable and it's captures
+         */
+        constexpr size_t kDefaultTaskInlineSize = 64;
+
+        /**
+         * Class that can take a callable and run it. Allows passing lambdas, std::packaged_tasks
+         * Callables that fit in InlineSize bytes are stored in the task itself, larger ones go to
+         * the heap. The task objects are allocated from a per thread recycling pool so posting a
+         * small lambda doesn't touch the heap.
+         */
+        template <size_t InlineSize>
+        class TCallableThreadTask : public IThreadPoolTask
         {
         public:
             struct ImplBase
@@ -50,18 +83,45 @@ namespace v8App
                 void Run() { m_Func(); }
             };
 
-            CallableThreadTask() = delete;
+            template <typename Callable>
+            static constexpr bool kFitsInline = sizeof(Impl<Callable>) <= InlineSize &&
+                                                alignof(Impl<Callable>) <= alignof(std::max_align_t);
+
+            TCallableThreadTask() = delete;
+            TCallableThreadTask(const TCallableThreadTask &) = delete;
+            TCallableThreadTask &operator=(const TCallableThreadTask &) = delete;
 
             template <typename Callable>
-            explicit CallableThreadTask(Callable inLambda)
+            explicit TCallableThreadTask(Callable inLambda)
             {
-                m_Func = std::make_unique<Impl<Callable>>(std::forward<Callable>(inLambda));
+                if constexpr (kFitsInline<Callable>)
+                {
+                    m_Func = new (m_Storage) Impl<Callable>(std::move(inLambda));
+                    m_Inline = true;
+                }
+                else
+                {
+                    m_Func = new Impl<Callable>(std::move(inLambda));
+                }
             }
 
             template <typename Callable, typename... Args>
-            CallableThreadTask(Callable &&inFunc, Args &&...args)
+            TCallableThreadTask(Callable &&inFunc, Args &&...args)
+                : TCallableThreadTask([func = std::forward<Callable>(inFunc), boundArgs = std::make_tuple(std::forward<Args>(args)...)]() mutable
+                                      { std::apply(func, boundArgs); })
+            {
+            }
+
+            ~TCallableThreadTask()
             {
-                m_Func = std::make_unique<Impl<Callable>>(std::forward<Callable>(std::bind(inFunc, args...)));
+                if (IsInline())
+                {
+                    m_Func->~ImplBase();
+                }
+                else
+                {
+                    delete m_Func;
+                }
             }
 
             void Run() override
@@ -69,10 +129,39 @@ namespace v8App
                 m_Func->Run();
             }
 
+            /**
+             * Returns if the callable is stored in the task rather than on the heap
+             */
+            bool IsInline() const
+            {
+                return m_Inline;
+            }
+
+            static void *operator new(size_t inSize)
+            {
+                return TTaskNodePool<sizeof(TCallableThreadTask)>::Allocate(inSize);
+            }
+
+            static void operator delete(void *inPtr, size_t inSize)
+            {
+                TTaskNodePool<sizeof(TCallableThreadTask)>::Free(inPtr, inSize);
+            }
+
         private:
-            std::unique_ptr<ImplBase> m_Func;
+            alignas(std::max_align_t) unsigned char m_Storage[InlineSize];
+            ImplBase *m_Func;
+            bool m_Inline = false;
         };
 
+        using CallableThreadTask = TCallableThreadTask<kDefaultTaskInlineSize>;
+
+        /**
+         * The pool the task objects are recycled through
+         */
+        template <size_t InlineSize>
+        using TCallableTaskNodePool = TTaskNodePool<sizeof(TCallableThreadTask<InlineSize>)>;
+        using CallableTaskNodePool = TCallableTaskNodePool<kDefaultTaskInlineSize>;
+
         using ThreadPoolTaskUniquePtr = std::unique_ptr<IThreadPoolTask>;
     } // namespace Threads
 } // namespace v8App
@@ -0,0 +1,193 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _THREAD_POOL_WORKERS_H__
+#define _THREAD_POOL_WORKERS_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Memory/MemoryPressure.h"
+#include "Queues/TWorkStealingQueue.h"
+#include "Threads/ElasticPoolOptions.h"
+#include "Threads/PoolMetrics.h"
+#include "Threads/ThreadPoolTasks.h"
+#include "Threads/Threads.h"
+#include "Time/Clock.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        /**
+         * The worker threads shared by the thread pools. It starts the workers, grows an elastic pool
+         * when tasks wait too long or a backlog stops making progress, retires and trims idle workers
+         * and records the pool's metrics. The pools built on it only decide how tasks are queued, handed
+         * to the workers and how idle workers are parked and woken.
+         */
+        class ThreadPoolWorkers
+        {
+        public:
+            // gets the number of worker threads the pool has available, for an elastic pool the most it can grow to
+            int GetNumberOfWorkers() { return m_NumWorkers; }
+            // gets the number of worker threads currently running
+            int GetNumberOfActiveWorkers() { return m_ActiveWorkers; }
+            bool IsElastic() const { return m_Elastic; }
+            /**
+             * Asks the parked workers over the min of an elastic pool to retire, returns how many were asked.
+             * Called when memory runs low to give back their stacks.
+             */
+            int TrimIdleWorkers();
+
+            bool IsExiting() { return m_Exiting; }
+            // the os priority the workers run at
+            ThreadPriority GetPriority() const { return m_Priority; }
+            // gets a snapshot of the pool's scheduling metrics
+            PoolMetricsSnapshot GetMetrics() const { return m_Metrics->GetSnapshot(); }
+
+            void Terminate();
+
+        protected:
+            // inName prefixes the pool's thread names
+            ThreadPoolWorkers(int inNumberOfWorkers, ThreadPriority inPriority, std::string inName);
+            ThreadPoolWorkers(const ElasticPoolOptions &inOptions, ThreadPriority inPriority, std::string inName);
+            virtual ~ThreadPoolWorkers() = default;
+
+            ThreadPoolWorkers(const ThreadPoolWorkers &) = delete;
+            ThreadPoolWorkers &operator=(const ThreadPoolWorkers &) = delete;
+
+            class ThreadPoolThread : public Thread
+            {
+            public:
+                ThreadPoolThread(std::string inName, ThreadPriority inPriority, ThreadPoolWorkers *inPool, int inWorkerIndex)
+                    : Thread(inName, inPriority), m_Pool(inPool), m_WorkerIndex(inWorkerIndex) {}
+
+            protected:
+                virtual void RunImpl() override
+                {
+                    if (m_WorkerIndex == kTimerThreadIndex)
+                    {
+                        m_Pool->RunTimer();
+                    }
+                    else if (m_WorkerIndex == kMonitorThreadIndex)
+                    {
+                        m_Pool->RunMonitor();
+                    }
+                    else
+                    {
+                        m_Pool->ProcessTasks(m_WorkerIndex);
+                    }
+                }
+
+            protected:
+                ThreadPoolWorkers *m_Pool;
+                int m_WorkerIndex;
+            };
+
+            static constexpr int kTimerThreadIndex = -1;
+            static constexpr int kMonitorThreadIndex = -2;
+            // a worker takes from the injection queue after this many tasks in a row from it's own deque
+            static constexpr int kInjectionCheckInterval = 31;
+
+            using WorkerQueue = Queues::TWorkStealingQueue<ThreadPoolTaskUniquePtr>;
+
+            /**
+             * Creates inNumSlots worker slots and starts the pool's workers along with the monitor and
+             * memory pressure trimming of an elastic pool. Called at the end of the pool's constructor
+             * once it's queues are ready for the workers.
+             */
+            void StartWorkers(int inNumSlots);
+            // starts the thread that calls RunTimer, it's woken by WakeTimer when the time jumps
+            void StartTimer();
+            // starts a worker in a free slot if the pool is under it's capacity
+            bool AddWorker();
+            // adds a worker if a task waited too long to start and no worker is idle
+            void MaybeAddWorker(int64_t inNow);
+            // checks for a backlog that isn't making progress and adds workers for an elastic pool
+            void RunMonitor();
+            // retires an idle worker of an elastic pool if it's above the min, returns true if it should exit
+            bool RetireWorker(int inWorkerIndex);
+            // frees the worker's slot as it exits. Must hold m_QueueLock
+            void ReleaseSlot(int inWorkerIndex);
+            // takes one of the requests made by TrimIdleWorkers, returns false if there aren't any
+            bool TakeTrimRequest();
+            // runs the task recording it's metrics, ioIdleStart is when the worker last went idle
+            void RunTask(int inWorkerIndex, ThreadPoolTaskUniquePtr inTask, int64_t &ioIdleStart);
+            // creates a deque for each worker, called before the workers start since they steal from each other
+            void CreateWorkerQueues();
+            /**
+             * Finds the next task for the worker checking it's own deque, the injection queue and then
+             * the other workers. Every kInjectionCheckInterval tasks from it's own deque the injection
+             * queue is checked first so a task that keeps posting more can't starve the ones posted from
+             * outside the pool.
+             */
+            std::optional<ThreadPoolTaskUniquePtr> FindTask(int inWorkerIndex);
+
+            // runs the worker's loop till the pool exits or the worker retires
+            virtual void ProcessTasks(int inWorkerIndex) = 0;
+            // runs the timer thread's loop if the pool started one
+            virtual void RunTimer() {}
+            // number of workers parked waiting for work
+            virtual int GetParkedCount() = 0;
+            // if there are tasks waiting that a worker could run
+            virtual bool HasBacklog() = 0;
+            // wakes every parked worker
+            virtual void WakeAllWorkers() = 0;
+            // wakes the timer to work out it's deadline again or see the pool is exiting
+            virtual void WakeTimer() {}
+            // takes a task from the pool's injection queue for FindTask
+            virtual std::optional<ThreadPoolTaskUniquePtr> PopInjectedTask() { return {}; }
+            // drops any tasks left once all the threads are joined
+            virtual void ClearQueues();
+            // if the worker has tasks only it can run so it can't retire yet. Must hold m_QueueLock
+            virtual bool WorkerHasQueuedTasks([[maybe_unused]] int inWorkerIndex) { return false; }
+            // most workers that can be running at once. Must hold m_QueueLock
+            virtual int GetWorkerCapacity() { return m_NumWorkers; }
+
+            std::string m_Name;
+            int m_NumWorkers = 0;
+            // worker slots, more than the workers if the pool brings in extra workers
+            int m_NumSlots = 0;
+            std::mutex m_QueueLock;
+            std::atomic_bool m_Exiting{false};
+            // indexed by the worker slot, slots of an elastic pool that aren't running can be null
+            std::vector<std::unique_ptr<Thread>> m_Workers;
+            ThreadPriority m_Priority;
+
+            bool m_Elastic = false;
+            ElasticPoolOptions m_Options;
+            std::atomic_int m_ActiveWorkers{0};
+            // which slots have a running worker, guarded by m_QueueLock
+            std::vector<bool> m_SlotActive;
+            // held while starting and joining worker threads
+            std::mutex m_ScaleLock;
+            std::atomic<int64_t> m_LastScaleUpTime{0};
+            std::atomic<uint64_t> m_TasksStarted{0};
+            std::unique_ptr<Thread> m_Monitor;
+            std::mutex m_MonitorLock;
+            std::condition_variable m_MonitorWaiter;
+            std::unique_ptr<Thread> m_Timer;
+            std::unique_ptr<Time::ScopedClockChangedCallback> m_ClockChangedCallback;
+            std::unique_ptr<PoolMetrics> m_Metrics;
+            // number of parked workers TrimIdleWorkers asked to retire
+            std::atomic_int m_TrimRequests{0};
+            // trims the idle workers of an elastic pool under critical memory pressure
+            std::unique_ptr<Memory::ScopedReclaimCallback> m_ReclaimCallback;
+
+            // per worker deques for tasks posted from the pool's own workers, empty if the pool doesn't use them
+            std::vector<std::unique_ptr<WorkerQueue>> m_WorkerQueues;
+            // number of tasks sitting in the worker deques
+            std::atomic_int m_WorkerQueuedTasks{0};
+            // tasks each worker has taken from it's own deque in a row, only touched by that worker
+            std::vector<int> m_LocalPops;
+        };
+    } // namespace Threads
+} // namespace v8App
+
+#endif //_THREAD_POOL_WORKERS_H__
@@ -8,6 +8,7 @@
 #include <thread>
 #include <string>
 #include <mutex>
+#include <vector>
 
 namespace v8App
 {
@@ -29,6 +30,21 @@ namespace v8App
          * The max size of a therad name
         */
         constexpr int kMaxThreadName = 63;
+#if defined(V8APP_LINUX)
+        /**
+         * Linux limits the native thread name to 15 characters so it gets truncated when set
+         */
+        constexpr int kMaxLinuxThreadName = 15;
+
+        /**
+         * The nice values the priorities map to on linux. kBestEffort also runs under SCHED_BATCH.
+         * Raising the priority above the default needs CAP_SYS_NICE so without it kUserBlocking
+         * runs at the default nice value.
+         */
+        constexpr int kLinuxBestEffortNice = 10;
+        constexpr int kLinuxUserVisibleNice = 0;
+        constexpr int kLinuxUserBlockingNice = -8;
+#endif
 
         /**
          * class to implement a thread. To implment the logic for the thread 
@@ -50,22 +66,44 @@ namespace v8App
             int GetNativePriority();
             std::string GetNativeName();
 
+            /**
+             * Pins the thread to the passed logical cpus. If the thread is running it's applied right away
+             * otherwise it's applied when the thread starts. An empty list lets the thread run on any cpu.
+             * Returns false if the platform doesn't support affinity or setting it failed.
+             */
+            bool SetAffinity(std::vector<int> inCpus);
+            std::vector<int> GetAffinity() { return m_Affinity; }
+            /**
+             * Returns the cpus the os says the thread can run on. Empty if the thread isn't running
+             * or the platform doesn't support affinity.
+             */
+            std::vector<int> GetNativeAffinity();
+
             void Join();
 
         protected:
             virtual void RunImpl() = 0;
             void SetThreadPriority();
             void SetThreadName();
+            bool ApplyAffinity();
 
             std::string m_Name;
             ThreadPriority m_Priority;
             std::unique_ptr<std::thread> m_Thread;
             bool m_Running = false;
             std::mutex m_Lock;
+            std::vector<int> m_Affinity;
+#if defined(V8APP_LINUX)
+            // the kernel's thread id which is needed to get and set the nice value
+            int m_NativeThreadId = -1;
+#endif
         };
 
         /**
-         * Gets the systems number of harware cores
+         * Gets the number of cores the thread pools should use by default. This is the number of logical
+         * cores the process is allowed to run on less one for the main thread with a min of 1. Logical
+         * rather than physical cores since the pool mostly runs v8's gc and compile jobs which stall on
+         * memory and gain from the smt siblings, it's also how v8 sizes it's own default platform's pool.
         */
         int GetHardwareCores();
     } // namespace Threads
@@ -0,0 +1,97 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _V8APP_CLOCK_H_
+#define _V8APP_CLOCK_H_
+
+#include <cstdint>
+#include <functional>
+
+namespace v8App
+{
+    namespace Time
+    {
+        /**
+         * Interface for the source of monotonic time used by the app. The value is in nanoseconds
+         * from an arbitrary point and must never go backwards.
+         */
+        class IClock
+        {
+        public:
+            virtual ~IClock() = default;
+            virtual int64_t NowNanoseconds() = 0;
+        };
+
+        /**
+         * The default clock built on std::chrono::steady_clock so it's not affected by
+         * changes to the wall clock.
+         */
+        class SteadyClock : public IClock
+        {
+        public:
+            virtual int64_t NowNanoseconds() override;
+        };
+
+        /**
+         * Replaces the clock used for the monotonic time. Passing nullptr restores the steady clock.
+         * The clock isn't owned so it has to outlive any use of it.
+         */
+        void SetClock(IClock *inClock);
+        /**
+         * Returns the clock that was set or nullptr when the steady clock is being used.
+         */
+        IClock *GetClock();
+
+        /**
+         * Gets the current monotonic time in nanoseconds from the installed clock
+         */
+        int64_t NowNanoseconds();
+
+        /**
+         * Returns the time this thread last cached with RefreshCachedNowNanoseconds. Meant for hot loops
+         * that check the time per item and can live with it being slightly stale. If the thread hasn't
+         * cached a time yet it is refreshed.
+         */
+        int64_t CachedNowNanoseconds();
+        /**
+         * Reads the clock and caches it for this thread returning the new time.
+         */
+        int64_t RefreshCachedNowNanoseconds();
+
+        using ClockChangedCallback = std::function<void()>;
+        using ClockChangedCallbackId = size_t;
+        constexpr ClockChangedCallbackId kInvalidClockChangedCallbackId = 0;
+
+        /**
+         * Registers a callback for when the time jumps, when a clock is set or the test time is moved.
+         * Code sleeping till a deadline uses it to wake up and work out it's deadline again. It's called
+         * on the thread that changed the time so it should only signal the sleeper.
+         */
+        ClockChangedCallbackId AddClockChangedCallback(ClockChangedCallback inCallback);
+        /**
+         * Removes the callback, waiting out a call to it on another thread so it's owner can go away
+         * once this returns.
+         */
+        bool RemoveClockChangedCallback(ClockChangedCallbackId inId);
+        // calls the clock changed callbacks
+        void NotifyClockChanged();
+
+        /**
+         * Holds a clock changed callback for it's lifetime
+         */
+        class ScopedClockChangedCallback
+        {
+        public:
+            explicit ScopedClockChangedCallback(ClockChangedCallback inCallback);
+            ~ScopedClockChangedCallback();
+
+            ScopedClockChangedCallback(const ScopedClockChangedCallback &) = delete;
+            ScopedClockChangedCallback &operator=(const ScopedClockChangedCallback &) = delete;
+
+        private:
+            ClockChangedCallbackId m_Id;
+        };
+    } // namespace Time
+} // namespace v8App
+#endif //_V8APP_CLOCK_H_
@@ -7,6 +7,9 @@
 #define _V8APP_TIME_H_
 
 #include <chrono>
+#include <cstdint>
+
+#include "Time/Clock.h"
 
 #ifdef UNIT_TESTING
 #include "TestTime.h"
@@ -15,8 +18,12 @@ namespace v8App
 {
     namespace Time
     {
+        constexpr double kNanosecondsPerSecond = 1e9;
+        constexpr double kNanosecondsPerMillisecond = 1e6;
+
         /**
-         * Gets the time in an increasing in in seconds since the empoch
+         * Gets the monotonic time in seconds with nanosecond resolution. The time is from an arbitrary
+         * point so is only useful for measuring intervals and deadlines.
          */
         inline double MonotonicallyIncreasingTimeSeconds()
         {
@@ -26,12 +33,12 @@ namespace v8App
                 return TestTime::TestTimeSeconds::Get();
             }
 #endif
-            uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-            return now;
+            return NowNanoseconds() / kNanosecondsPerSecond;
         }
 
         /**
-         * Gets the time in an increasing in in milliseconds since the empoch
+         * Gets the monotonic time in milliseconds with nanosecond resolution. The time is from an
+         * arbitrary point so is only useful for measuring intervals and deadlines.
          */
         inline double MonotonicallyIncreasingTimeMilliSeconds()
         {
@@ -41,9 +48,51 @@ namespace v8App
                 return TestTime::TestTimeMilliSeconds::Get();
             }
 #endif
-            uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-            return now;
+            return NowNanoseconds() / kNanosecondsPerMillisecond;
+        }
+
+        /**
+         * Gets this thread's cached monotonic time in seconds. See CachedNowNanoseconds
+         */
+        inline double CachedTimeSeconds()
+        {
+#ifdef UNIT_TESTING
+            if (TestTime::TestTimeSeconds::IsEnabled())
+            {
+                return TestTime::TestTimeSeconds::Get();
+            }
+#endif
+            return CachedNowNanoseconds() / kNanosecondsPerSecond;
+        }
+
+        /**
+         * Refreshes this thread's cached monotonic time and returns it in seconds
+         */
+        inline double RefreshCachedTimeSeconds()
+        {
+#ifdef UNIT_TESTING
+            if (TestTime::TestTimeSeconds::IsEnabled())
+            {
+                return TestTime::TestTimeSeconds::Get();
+            }
+#endif
+            return RefreshCachedNowNanoseconds() / kNanosecondsPerSecond;
+        }
+
+        /**
+         * Gets the wall clock time in milliseconds since the epoch. Unlike the monotonic time
+         * this can jump if the system time is changed.
+         */
+        inline double CurrentWallClockTimeMilliSeconds()
+        {
+#ifdef UNIT_TESTING
+            if (TestTime::TestTimeMilliSeconds::IsEnabled())
+            {
+                return TestTime::TestTimeMilliSeconds::Get();
+            }
+#endif
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() / kNanosecondsPerMillisecond;
         }
     } // namespace Time
 } // namespace v8App
-#endif
\ No newline at end of file
+#endif
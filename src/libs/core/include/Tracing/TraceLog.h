@@ -0,0 +1,209 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _TRACE_LOG_H__
+#define _TRACE_LOG_H__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace v8App
+{
+    namespace Tracing
+    {
+        // matches v8's kEnabledForRecording_CategoryGroupEnabledFlags
+        constexpr uint8_t kCategoryEnabledForRecording = 1 << 0;
+        // most category groups that can be registered, after that the disabled group is handed out
+        constexpr size_t kMaxCategoryGroups = 256;
+        // most events a thread's ring buffer grows to before the oldest are overwritten
+        constexpr size_t kDefaultTraceBufferEvents = 16384;
+        // the buffers of exited threads kept for their events, past this the oldest are dropped
+        constexpr size_t kMaxExitedTraceBuffers = 64;
+        constexpr int kMaxTraceArgs = 2;
+        // categories with this prefix are only recorded when named, "*" doesn't enable them
+        constexpr const char *kDisabledByDefaultPrefix = "disabled-by-default-";
+
+        // the trace event phases, the same chars as the chrome trace event format
+        constexpr char kPhaseBegin = 'B';
+        constexpr char kPhaseEnd = 'E';
+        constexpr char kPhaseComplete = 'X';
+        constexpr char kPhaseInstant = 'I';
+        constexpr char kPhaseCounter = 'C';
+        constexpr char kPhaseMetadata = 'M';
+
+        // matches v8's TRACE_EVENT_FLAG_COPY, the name points at memory that won't outlive the call
+        constexpr uint32_t kTraceFlagCopy = 1 << 0;
+        // matches v8's TRACE_EVENT_FLAG_HAS_ID
+        constexpr uint32_t kTraceFlagHasId = 1 << 1;
+
+        enum class TraceArgType : uint8_t
+        {
+            kNone,
+            kBool,
+            kUInt,
+            kInt,
+            kDouble,
+            kPointer,
+            kString,
+            // already formated json like v8's convertable args
+            kJSON
+        };
+
+        struct TraceArg
+        {
+            const char *m_Name = nullptr;
+            TraceArgType m_Type = TraceArgType::kNone;
+            // the bits of the bool, int, double or pointer
+            uint64_t m_Value = 0;
+            std::string m_String;
+            // holds the name when it has to be copied
+            std::string m_CopiedName;
+
+            const char *GetName() const { return m_CopiedName.empty() ? m_Name : m_CopiedName.c_str(); }
+        };
+
+        struct TraceEvent
+        {
+            char m_Phase = kPhaseInstant;
+            uint16_t m_CategoryIndex = 0;
+            const char *m_Name = nullptr;
+            const char *m_Scope = nullptr;
+            uint64_t m_Id = 0;
+            uint32_t m_Flags = 0;
+            // nanoseconds on the monotonic clock
+            int64_t m_Timestamp = 0;
+            // nanoseconds for complete events, -1 till it's set
+            int64_t m_Duration = -1;
+            int m_NumArgs = 0;
+            std::array<TraceArg, kMaxTraceArgs> m_Args;
+            std::string m_CopiedName;
+
+            const char *GetName() const { return m_CopiedName.empty() ? m_Name : m_CopiedName.c_str(); }
+        };
+
+        /**
+         * The events recorded on one thread, oldest first
+         */
+        struct TraceThreadEvents
+        {
+            uint32_t m_ThreadId = 0;
+            std::string m_ThreadName;
+            std::vector<TraceEvent> m_Events;
+        };
+
+        using TraceStateListener = std::function<void(bool)>;
+        using TraceStateListenerId = uint64_t;
+
+        /**
+         * Process wide trace event recorder shared by v8's trace events and our own TRACE_SCOPE
+         * macros so they end up on one timeline. Each thread records into it's own ring buffer without
+         * taking a lock. The buffer grows as events are recorded and once it's at the buffer size the
+         * oldest events are overwritten. A thread's events are kept after it exits. Category groups are
+         * comma separated lists of categories like v8's and are enabled if any of their categories is.
+         * The flag for a group is at a fixed address so a call site can cache it and just check it.
+         */
+        class TraceLog
+        {
+        public:
+            /**
+             * Starts recording the categories, "*" enables everything but the disabled by default ones,
+             * a trailing * matches a prefix and a leading - excludes a category.
+             */
+            static void StartTracing(std::vector<std::string> inCategories = {"*"});
+            static void StopTracing();
+            static bool IsTracing() { return s_Recording; }
+
+            // change the categories while tracing
+            static void EnableCategory(const std::string &inCategory);
+            static void DisableCategory(const std::string &inCategory);
+            static bool IsCategoryGroupEnabled(const char *inCategoryGroup);
+
+            /**
+             * Returns the enabled flag for the category group registering it if needed. The pointer
+             * stays valid for the life of the process.
+             */
+            static const uint8_t *GetCategoryGroupEnabled(const char *inCategoryGroup);
+            // the index events store the category group as, 0 if the flag isn't one of ours
+            static uint16_t GetCategoryGroupIndex(const uint8_t *inCategoryFlag);
+            static const char *GetCategoryGroupName(const uint8_t *inCategoryFlag);
+            static const char *GetCategoryGroupName(uint16_t inCategoryIndex);
+
+            /**
+             * Records an event on the calling thread, returns a handle to set the duration of a
+             * complete event with or 0 if it wasn't recorded. The name, scope and arg names have to
+             * outlive the trace unless kTraceFlagCopy is set.
+             */
+            static uint64_t AddTraceEvent(char inPhase, const uint8_t *inCategoryFlag, const char *inName, const char *inScope,
+                                          uint64_t inId, uint32_t inFlags, int64_t inTimestamp, int inNumArgs = 0, const TraceArg *inArgs = nullptr);
+            /**
+             * Sets the duration of a complete event recorded on this thread. If it ends while the events
+             * are being copied or tracing is stopped it's set before they're next copied.
+             */
+            static void UpdateTraceEventDuration(uint64_t inHandle, int64_t inEndTimestamp);
+
+            /**
+             * Copies out the recorded events. Recording is paused while they're copied.
+             */
+            static std::vector<TraceThreadEvents> GetEvents();
+            // drops the recorded events and the buffers of threads that have exited
+            static void Clear();
+            // events each thread's buffer can grow to, used for threads that haven't recorded yet
+            static void SetBufferSize(size_t inEvents);
+            static size_t GetBufferSize() { return s_BufferSize; }
+
+            // called with true when tracing starts and false when it stops
+            static TraceStateListenerId AddStateListener(TraceStateListener inListener);
+            static void RemoveStateListener(TraceStateListenerId inId);
+
+            static uint32_t GetProcessId();
+            static uint32_t GetCurrentThreadId();
+
+        protected:
+            class TraceBuffer;
+            using TraceBufferSharedPtr = std::shared_ptr<TraceBuffer>;
+            // holds the thread's buffer and hands it back to the log when the thread exits
+            struct ThreadBufferRef;
+
+            // Must hold s_Lock
+            static void UpdateCategoryFlags();
+            // Must hold s_Lock
+            static bool IsCategoryGroupEnabledLocked(const std::string &inCategoryGroup);
+            // stops new events and waits for the ones being written, returns if recording was on
+            static bool PauseRecording();
+            static TraceBuffer *GetThreadBuffer();
+            // called as the buffer's thread exits
+            static void ReleaseThreadBuffer(const TraceBufferSharedPtr &inBuffer);
+            static void NotifyStateListeners(bool inTracing);
+
+            static std::mutex s_Lock;
+            static std::atomic_bool s_Recording;
+            static std::atomic_size_t s_BufferSize;
+            static std::set<std::string> s_EnabledCategories;
+            static std::set<std::string> s_ExcludedCategories;
+
+            // the flags v8 and the macros check, index 0 is the always disabled group
+            static std::array<uint8_t, kMaxCategoryGroups> s_CategoryFlags;
+            static std::array<std::string, kMaxCategoryGroups> s_CategoryNames;
+            static std::atomic_size_t s_NumCategories;
+
+            static std::vector<TraceBufferSharedPtr> s_Buffers;
+            static uint32_t s_NextBufferId;
+            static thread_local ThreadBufferRef s_ThreadBufferRef;
+
+            static std::mutex s_ListenerLock;
+            static std::map<TraceStateListenerId, TraceStateListener> s_Listeners;
+            static TraceStateListenerId s_NextListenerId;
+        };
+    } // namespace Tracing
+} // namespace v8App
+
+#endif //_TRACE_LOG_H__
@@ -0,0 +1,67 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _TRACE_MACROS_H__
+#define _TRACE_MACROS_H__
+
+#include "Time/Clock.h"
+#include "Tracing/TraceLog.h"
+
+namespace v8App
+{
+    namespace Tracing
+    {
+        /**
+         * Records a complete event covering it's lifetime if the category group is enabled when it's
+         * created. Use the TRACE_SCOPE macro rather than creating one directly.
+         */
+        class ScopedTrace
+        {
+        public:
+            ScopedTrace(const uint8_t *inCategoryFlag, const char *inName)
+            {
+                if (*inCategoryFlag & kCategoryEnabledForRecording)
+                {
+                    m_Handle = TraceLog::AddTraceEvent(kPhaseComplete, inCategoryFlag, inName, nullptr, 0, 0, Time::NowNanoseconds());
+                }
+            }
+            ~ScopedTrace()
+            {
+                if (m_Handle != 0)
+                {
+                    TraceLog::UpdateTraceEventDuration(m_Handle, Time::NowNanoseconds());
+                }
+            }
+
+            ScopedTrace(const ScopedTrace &) = delete;
+            ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+        private:
+            uint64_t m_Handle = 0;
+        };
+    } // namespace Tracing
+} // namespace v8App
+
+#define TRACE_INTERNAL_CONCAT2(a, b) a##b
+#define TRACE_INTERNAL_CONCAT(a, b) TRACE_INTERNAL_CONCAT2(a, b)
+#define TRACE_INTERNAL_NAME(name) TRACE_INTERNAL_CONCAT(name, __LINE__)
+
+// the category and name have to be string literals, the category's flag is looked up once per call site
+#define TRACE_SCOPE(category, name)                                                                                          \
+    static const uint8_t *TRACE_INTERNAL_NAME(v8AppTraceCategory) = v8App::Tracing::TraceLog::GetCategoryGroupEnabled(category); \
+    v8App::Tracing::ScopedTrace TRACE_INTERNAL_NAME(v8AppTraceScope)(TRACE_INTERNAL_NAME(v8AppTraceCategory), name)
+
+// records an instant event
+#define TRACE_INSTANT(category, name)                                                                                                   \
+    do                                                                                                                                  \
+    {                                                                                                                                   \
+        static const uint8_t *v8AppTraceCategory = v8App::Tracing::TraceLog::GetCategoryGroupEnabled(category);                         \
+        if (*v8AppTraceCategory & v8App::Tracing::kCategoryEnabledForRecording)                                                         \
+        {                                                                                                                               \
+            v8App::Tracing::TraceLog::AddTraceEvent(v8App::Tracing::kPhaseInstant, v8AppTraceCategory, name, nullptr, 0, 0,             \
+                                                    v8App::Time::NowNanoseconds());                                                     \
+        }                                                                                                                               \
+    } while (0)
+
+#endif //_TRACE_MACROS_H__
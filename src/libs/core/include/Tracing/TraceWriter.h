@@ -0,0 +1,42 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _TRACE_WRITER_H__
+#define _TRACE_WRITER_H__
+
+#include <filesystem>
+#include <ostream>
+#include <vector>
+
+#include "Tracing/TraceLog.h"
+
+namespace v8App
+{
+    namespace Tracing
+    {
+        /**
+         * Writes recorded trace events out in formats the chrome and perfetto trace viewers load.
+         * The file versions flush what the TraceLog has recorded so far.
+         */
+        class TraceWriter
+        {
+        public:
+            /**
+             * Writes the chrome trace event json format that chrome://tracing and ui.perfetto.dev load.
+             * Every phase is written.
+             */
+            static bool WriteChromeJSON(std::ostream &inStream, const std::vector<TraceThreadEvents> &inEvents);
+            static bool WriteChromeJSONFile(const std::filesystem::path &inFilePath);
+
+            /**
+             * Writes a perfetto protobuf trace with a track per thread. Only the slice and instant
+             * phases have a track event equivalent, the others are skipped.
+             */
+            static bool WritePerfetto(std::ostream &inStream, const std::vector<TraceThreadEvents> &inEvents);
+            static bool WritePerfettoFile(const std::filesystem::path &inFilePath);
+        };
+    } // namespace Tracing
+} // namespace v8App
+
+#endif //_TRACE_WRITER_H__
@@ -0,0 +1,77 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "Memory/MemoryPressure.h"
+
+namespace v8App
+{
+    namespace Memory
+    {
+        std::recursive_mutex MemoryPressure::s_Lock;
+        std::map<ReclaimCallbackId, MemoryPressure::CallbackInfo> MemoryPressure::s_Callbacks;
+        ReclaimCallbackId MemoryPressure::s_NextId = kInvalidReclaimCallbackId + 1;
+        std::atomic<MemoryPressureLevel> MemoryPressure::s_LastLevel{MemoryPressureLevel::kNone};
+
+        ReclaimCallbackId MemoryPressure::RegisterReclaimCallback(std::string inName, ReclaimCallback inCallback)
+        {
+            if (inCallback == nullptr)
+            {
+                return kInvalidReclaimCallbackId;
+            }
+            std::lock_guard<std::recursive_mutex> lock(s_Lock);
+            ReclaimCallbackId id = s_NextId++;
+            s_Callbacks.emplace(id, CallbackInfo{std::move(inName), std::move(inCallback)});
+            return id;
+        }
+
+        bool MemoryPressure::UnregisterReclaimCallback(ReclaimCallbackId inId)
+        {
+            // waits out a notify on another thread so the callback's owner can go away once we return
+            std::lock_guard<std::recursive_mutex> lock(s_Lock);
+            return s_Callbacks.erase(inId) != 0;
+        }
+
+        void MemoryPressure::NotifyMemoryPressure(MemoryPressureLevel inLevel)
+        {
+            s_LastLevel = inLevel;
+            std::lock_guard<std::recursive_mutex> lock(s_Lock);
+            // the callbacks can unregister so walk the ids and skip any that went away
+            std::vector<ReclaimCallbackId> ids;
+            ids.reserve(s_Callbacks.size());
+            for (const auto &it : s_Callbacks)
+            {
+                ids.push_back(it.first);
+            }
+            for (ReclaimCallbackId id : ids)
+            {
+                auto it = s_Callbacks.find(id);
+                if (it == s_Callbacks.end())
+                {
+                    continue;
+                }
+                // copied since the callback may unregister itself
+                ReclaimCallback callback = it->second.m_Callback;
+                callback(inLevel);
+            }
+        }
+
+        size_t MemoryPressure::GetNumberOfCallbacks()
+        {
+            std::lock_guard<std::recursive_mutex> lock(s_Lock);
+            return s_Callbacks.size();
+        }
+
+        ScopedReclaimCallback::ScopedReclaimCallback(std::string inName, ReclaimCallback inCallback)
+            : m_Id(MemoryPressure::RegisterReclaimCallback(std::move(inName), std::move(inCallback)))
+        {
+        }
+
+        ScopedReclaimCallback::~ScopedReclaimCallback()
+        {
+            MemoryPressure::UnregisterReclaimCallback(m_Id);
+        }
+    } // namespace Memory
+} // namespace v8App
@@ -0,0 +1,194 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#if defined(V8APP_LINUX)
+#include <sched.h>
+#endif
+
+#include "Threads/CpuTopology.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+#if defined(V8APP_LINUX)
+        namespace
+        {
+            const std::filesystem::path kSysCpuPath("/sys/devices/system/cpu");
+            const std::filesystem::path kSysNodePath("/sys/devices/system/node");
+
+            std::string ReadSysFile(const std::filesystem::path &inPath)
+            {
+                std::ifstream file(inPath);
+                std::string contents;
+                std::getline(file, contents);
+                return contents;
+            }
+
+            // Groups the allowed cpus by the list returned for each cpu dropping any cpus we're not allowed on
+            std::vector<std::vector<int>> GroupCpus(const std::vector<int> &inCpus, const std::vector<int> &inAllowed,
+                                                    std::function<std::vector<int>(int)> inGetGroup)
+            {
+                std::set<std::vector<int>> groups;
+                for (int cpu : inCpus)
+                {
+                    std::vector<int> group = inGetGroup(cpu);
+                    std::vector<int> allowedGroup;
+                    for (int member : group)
+                    {
+                        if (std::binary_search(inAllowed.begin(), inAllowed.end(), member))
+                        {
+                            allowedGroup.push_back(member);
+                        }
+                    }
+                    if (allowedGroup.empty())
+                    {
+                        allowedGroup.push_back(cpu);
+                    }
+                    groups.insert(std::move(allowedGroup));
+                }
+                return std::vector<std::vector<int>>(groups.begin(), groups.end());
+            }
+
+            std::vector<int> GetLastLevelCacheCpus(int inCpu)
+            {
+                std::filesystem::path cachePath = kSysCpuPath / ("cpu" + std::to_string(inCpu)) / "cache";
+                std::error_code error;
+                int highestLevel = -1;
+                std::vector<int> cpus;
+                for (auto &entry : std::filesystem::directory_iterator(cachePath, error))
+                {
+                    if (entry.path().filename().string().rfind("index", 0) != 0)
+                    {
+                        continue;
+                    }
+                    std::string level = ReadSysFile(entry.path() / "level");
+                    if (level.empty())
+                    {
+                        continue;
+                    }
+                    int levelNum = std::atoi(level.c_str());
+                    if (levelNum > highestLevel)
+                    {
+                        highestLevel = levelNum;
+                        cpus = ParseCpuList(ReadSysFile(entry.path() / "shared_cpu_list"));
+                    }
+                }
+                return cpus;
+            }
+        } // namespace
+#endif
+
+        const CpuTopology &GetCpuTopology()
+        {
+            static const CpuTopology s_Topology = QueryCpuTopology();
+            return s_Topology;
+        }
+
+        CpuTopology QueryCpuTopology()
+        {
+            CpuTopology topology;
+#if defined(V8APP_LINUX)
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+            {
+                for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                {
+                    if (CPU_ISSET(cpu, &cpuSet))
+                    {
+                        topology.m_LogicalCpus.push_back(cpu);
+                    }
+                }
+            }
+            if (topology.m_LogicalCpus.empty() == false)
+            {
+                const std::vector<int> &allowed = topology.m_LogicalCpus;
+                topology.m_PhysicalCores = GroupCpus(allowed, allowed, [](int inCpu)
+                                                     { return ParseCpuList(ReadSysFile(kSysCpuPath / ("cpu" + std::to_string(inCpu)) / "topology" / "thread_siblings_list")); });
+                topology.m_CacheDomains = GroupCpus(allowed, allowed, GetLastLevelCacheCpus);
+
+                std::error_code error;
+                for (auto &entry : std::filesystem::directory_iterator(kSysNodePath, error))
+                {
+                    std::string name = entry.path().filename().string();
+                    if (name.rfind("node", 0) != 0 || name.size() == 4 || std::isdigit(name[4]) == false)
+                    {
+                        continue;
+                    }
+                    std::vector<int> nodeCpus;
+                    for (int cpu : ParseCpuList(ReadSysFile(entry.path() / "cpulist")))
+                    {
+                        if (std::binary_search(allowed.begin(), allowed.end(), cpu))
+                        {
+                            nodeCpus.push_back(cpu);
+                        }
+                    }
+                    if (nodeCpus.empty() == false)
+                    {
+                        topology.m_NumaNodes.push_back(std::move(nodeCpus));
+                    }
+                }
+                std::sort(topology.m_NumaNodes.begin(), topology.m_NumaNodes.end());
+                if (topology.m_NumaNodes.empty())
+                {
+                    topology.m_NumaNodes.push_back(allowed);
+                }
+                return topology;
+            }
+#endif
+            int cores = std::max(1U, std::thread::hardware_concurrency());
+            for (int cpu = 0; cpu < cores; cpu++)
+            {
+                topology.m_LogicalCpus.push_back(cpu);
+                topology.m_PhysicalCores.push_back({cpu});
+            }
+            topology.m_CacheDomains.push_back(topology.m_LogicalCpus);
+            topology.m_NumaNodes.push_back(topology.m_LogicalCpus);
+            return topology;
+        }
+
+        std::vector<int> ParseCpuList(const std::string &inList)
+        {
+            std::vector<int> cpus;
+            std::stringstream stream(inList);
+            std::string range;
+            while (std::getline(stream, range, ','))
+            {
+                if (range.empty() || std::isdigit(range[0]) == false)
+                {
+                    continue;
+                }
+                size_t dash = range.find('-');
+                int first = std::atoi(range.c_str());
+                int last = first;
+                if (dash != std::string::npos)
+                {
+                    if (dash + 1 >= range.size() || std::isdigit(range[dash + 1]) == false)
+                    {
+                        continue;
+                    }
+                    last = std::atoi(range.c_str() + dash + 1);
+                }
+                for (int cpu = first; cpu <= last; cpu++)
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+            std::sort(cpus.begin(), cpus.end());
+            cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+            return cpus;
+        }
+    } // namespace Threads
+} // namespace v8App
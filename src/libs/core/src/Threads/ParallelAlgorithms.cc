@@ -0,0 +1,127 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#include "Threads/ParallelAlgorithms.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        namespace
+        {
+            /**
+             * State shared between the caller and the helper tasks. Helpers that start after every chunk
+             * has been claimed just exit, so it's kept alive by them rather than the caller's stack.
+             */
+            struct ParallelChunkState
+            {
+                ParallelChunkState(size_t inNumChunks, const std::function<void(size_t)> *inChunkFunc)
+                    : m_NumChunks(inNumChunks), m_ChunkFunc(inChunkFunc) {}
+
+                // claims and runs chunks till there are none left
+                void RunChunks()
+                {
+                    while (true)
+                    {
+                        size_t chunk = m_NextChunk.fetch_add(1);
+                        if (chunk >= m_NumChunks)
+                        {
+                            return;
+                        }
+                        // the func is only touched while a claimed chunk is outstanding, which the caller waits on
+                        if (m_Cancelled == false)
+                        {
+                            try
+                            {
+                                (*m_ChunkFunc)(chunk);
+                            }
+                            catch (...)
+                            {
+                                std::lock_guard<std::mutex> lock(m_Lock);
+                                if (m_Exception == nullptr)
+                                {
+                                    m_Exception = std::current_exception();
+                                }
+                                m_Cancelled = true;
+                            }
+                        }
+                        if (m_CompletedChunks.fetch_add(1) + 1 == m_NumChunks)
+                        {
+                            std::lock_guard<std::mutex> lock(m_Lock);
+                            m_Waiter.notify_all();
+                        }
+                    }
+                }
+
+                void WaitForChunks()
+                {
+                    std::unique_lock<std::mutex> lock(m_Lock);
+                    m_Waiter.wait(lock, [this]()
+                                  { return m_CompletedChunks == m_NumChunks; });
+                }
+
+                const size_t m_NumChunks;
+                const std::function<void(size_t)> *m_ChunkFunc;
+                std::atomic_size_t m_NextChunk{0};
+                std::atomic_size_t m_CompletedChunks{0};
+                std::atomic_bool m_Cancelled{false};
+                std::mutex m_Lock;
+                std::condition_variable m_Waiter;
+                std::exception_ptr m_Exception;
+            };
+        } // namespace
+
+        size_t GetParallelGrainSize(ThreadPoolQueue &inPool, size_t inCount, size_t inGrainSize)
+        {
+            if (inGrainSize > 0)
+            {
+                return inGrainSize;
+            }
+            size_t threads = static_cast<size_t>(inPool.GetNumberOfWorkers()) + 1;
+            return std::max(size_t(1), inCount / (threads * kParallelChunksPerThread));
+        }
+
+        void RunParallelChunks(ThreadPoolQueue &inPool, size_t inNumChunks, const std::function<void(size_t)> &inChunkFunc)
+        {
+            if (inNumChunks == 0)
+            {
+                return;
+            }
+            if (inNumChunks == 1)
+            {
+                inChunkFunc(0);
+                return;
+            }
+
+            std::shared_ptr<ParallelChunkState> state = std::make_shared<ParallelChunkState>(inNumChunks, &inChunkFunc);
+
+            // the caller takes a share so one less helper is needed
+            size_t numHelpers = std::min(inNumChunks - 1, static_cast<size_t>(inPool.GetNumberOfWorkers()));
+            std::vector<ThreadPoolTaskUniquePtr> helpers;
+            helpers.reserve(numHelpers);
+            for (size_t x = 0; x < numHelpers; x++)
+            {
+                helpers.push_back(std::make_unique<CallableThreadTask>([state]()
+                                                                       { state->RunChunks(); }));
+            }
+            // if the pool is exiting the caller just does all the work
+            inPool.PostTasks(std::move(helpers));
+
+            state->RunChunks();
+            // only chunks another thread has claimed and is running can be outstanding here
+            state->WaitForChunks();
+
+            if (state->m_Exception)
+            {
+                std::rethrow_exception(state->m_Exception);
+            }
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,183 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <thread>
+
+#if defined(V8APP_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "Threads/Parker.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        namespace
+        {
+            inline void CpuRelax()
+            {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+                _mm_pause();
+#elif defined(__aarch64__)
+                asm volatile("yield");
+#else
+                std::this_thread::yield();
+#endif
+            }
+        } // namespace
+
+        Parker::Parker(int inSpinCount) : m_SpinCount(inSpinCount < 0 ? 0 : inSpinCount)
+        {
+        }
+
+        Parker::ParkToken Parker::PrepareToPark()
+        {
+            // seq_cst so the caller's last check for work is ordered after we're counted as parked
+            m_Parked.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return m_Epoch.load(std::memory_order_seq_cst);
+        }
+
+        void Parker::CancelPark()
+        {
+            m_Parked.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void Parker::Park(ParkToken inToken)
+        {
+            if (Spin(inToken) == false)
+            {
+                while (m_Epoch.load(std::memory_order_acquire) == inToken)
+                {
+                    Sleep(inToken, -1);
+                }
+            }
+            m_Parked.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        bool Parker::ParkFor(ParkToken inToken, double inSeconds)
+        {
+            bool unparked = Spin(inToken);
+            if (unparked == false)
+            {
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(inSeconds);
+                while (true)
+                {
+                    if (m_Epoch.load(std::memory_order_acquire) != inToken)
+                    {
+                        unparked = true;
+                        break;
+                    }
+                    double remaining = std::chrono::duration<double>(deadline - std::chrono::steady_clock::now()).count();
+                    if (remaining <= 0)
+                    {
+                        break;
+                    }
+                    Sleep(inToken, remaining);
+                }
+            }
+            m_Parked.fetch_sub(1, std::memory_order_relaxed);
+            return unparked;
+        }
+
+        void Parker::Unpark(size_t inCount)
+        {
+            // pairs with PrepareToPark so either we see the parked thread or it sees the caller's work
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (inCount == 0 || m_Parked.load(std::memory_order_seq_cst) == 0)
+            {
+                return;
+            }
+            m_Epoch.fetch_add(1, std::memory_order_release);
+            Wake(inCount);
+        }
+
+        void Parker::UnparkAll()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_Epoch.fetch_add(1, std::memory_order_release);
+            Wake(INT_MAX);
+        }
+
+        bool Parker::Spin(ParkToken inToken)
+        {
+            for (int x = 0; x < m_SpinCount; x++)
+            {
+                if (m_Epoch.load(std::memory_order_acquire) != inToken)
+                {
+                    return true;
+                }
+                CpuRelax();
+            }
+            return false;
+        }
+
+#if defined(V8APP_LINUX)
+        bool Parker::Sleep(ParkToken inToken, double inSeconds)
+        {
+            timespec timeout;
+            timespec *timeoutPtr = nullptr;
+            if (inSeconds >= 0)
+            {
+                double seconds = std::floor(inSeconds);
+                timeout.tv_sec = static_cast<time_t>(seconds);
+                timeout.tv_nsec = static_cast<long>((inSeconds - seconds) * 1e9);
+                timeoutPtr = &timeout;
+            }
+            // returns straight away if the epoch already moved on
+            long result = syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_Epoch), FUTEX_WAIT_PRIVATE, inToken, timeoutPtr, nullptr, 0);
+            return result == 0;
+        }
+
+        void Parker::Wake(size_t inCount)
+        {
+            int count = inCount > static_cast<size_t>(INT_MAX) ? INT_MAX : static_cast<int>(inCount);
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_Epoch), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+        }
+#else
+        bool Parker::Sleep(ParkToken inToken, double inSeconds)
+        {
+            std::unique_lock<std::mutex> lock(m_Lock);
+            auto unparked = [this, inToken]()
+            {
+                return m_Epoch.load(std::memory_order_acquire) != inToken;
+            };
+            if (inSeconds < 0)
+            {
+                m_Waiter.wait(lock, unparked);
+                return true;
+            }
+            return m_Waiter.wait_for(lock, std::chrono::duration<double>(inSeconds), unparked);
+        }
+
+        void Parker::Wake(size_t inCount)
+        {
+            // taking the lock orders the epoch bump with a sleeper checking it
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+            }
+            if (inCount >= static_cast<size_t>(m_Parked.load(std::memory_order_relaxed)))
+            {
+                m_Waiter.notify_all();
+                return;
+            }
+            for (size_t x = 0; x < inCount; x++)
+            {
+                m_Waiter.notify_one();
+            }
+        }
+#endif
+    } // namespace Threads
+} // namespace v8App
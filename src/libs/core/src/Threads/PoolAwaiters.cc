@@ -0,0 +1,55 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include "Threads/PoolAwaiters.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        bool ThreadPoolAwaiter::await_suspend(std::coroutine_handle<> inHandle)
+        {
+            // set before posting since once the task is posted the coroutine may already be
+            // running on the pool and this awaiter lives in it's frame
+            m_Scheduled = true;
+            ThreadPoolTaskUniquePtr task = std::make_unique<CallableThreadTask>([inHandle]()
+                                                                                { inHandle.resume(); });
+            bool posted;
+            if (m_Pool != nullptr)
+            {
+                posted = m_Pool->PostTask(std::move(task));
+            }
+            else if (m_Delay > 0)
+            {
+                posted = m_DelayedPool->PostDelayedTask(m_Delay, std::move(task));
+            }
+            else
+            {
+                posted = m_DelayedPool->PostTask(std::move(task));
+            }
+            if (posted == false)
+            {
+                // the task was never queued so we still own the frame, resume right away
+                m_Scheduled = false;
+                return false;
+            }
+            return true;
+        }
+
+        ThreadPoolAwaiter ScheduleOn(ThreadPoolQueue &inPool)
+        {
+            return ThreadPoolAwaiter(&inPool);
+        }
+
+        ThreadPoolAwaiter ScheduleOn(ThreadPoolDelayedQueue &inPool)
+        {
+            return ThreadPoolAwaiter(&inPool, 0);
+        }
+
+        ThreadPoolAwaiter Delay(ThreadPoolDelayedQueue &inPool, double inDelay)
+        {
+            return ThreadPoolAwaiter(&inPool, inDelay);
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,209 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <bit>
+#include <sstream>
+
+#include "Threads/PoolMetrics.h"
+#include "Time/Clock.h"
+#include "Time/Time.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        double HistogramSnapshot::GetMeanNanoseconds() const
+        {
+            if (m_Count == 0)
+            {
+                return 0;
+            }
+            return static_cast<double>(m_SumNanoseconds) / static_cast<double>(m_Count);
+        }
+
+        int64_t HistogramSnapshot::GetPercentileNanoseconds(double inPercentile) const
+        {
+            if (m_Count == 0)
+            {
+                return 0;
+            }
+            inPercentile = std::clamp(inPercentile, 0.0, 100.0);
+            uint64_t target = std::max(uint64_t(1), static_cast<uint64_t>(inPercentile / 100.0 * static_cast<double>(m_Count) + 0.5));
+            uint64_t seen = 0;
+            for (size_t x = 0; x < kNumBuckets; x++)
+            {
+                seen += m_Buckets[x];
+                if (seen >= target)
+                {
+                    int64_t upper = (int64_t(1) << (x + 1)) - 1;
+                    return std::min(upper, m_MaxNanoseconds);
+                }
+            }
+            return m_MaxNanoseconds;
+        }
+
+        void HistogramSnapshot::Merge(const HistogramSnapshot &inOther)
+        {
+            m_Count += inOther.m_Count;
+            m_SumNanoseconds += inOther.m_SumNanoseconds;
+            m_MaxNanoseconds = std::max(m_MaxNanoseconds, inOther.m_MaxNanoseconds);
+            for (size_t x = 0; x < kNumBuckets; x++)
+            {
+                m_Buckets[x] += inOther.m_Buckets[x];
+            }
+        }
+
+        size_t LatencyHistogram::GetBucketIndex(int64_t inNanoseconds)
+        {
+            if (inNanoseconds <= 1)
+            {
+                return 0;
+            }
+            size_t index = static_cast<size_t>(std::bit_width(static_cast<uint64_t>(inNanoseconds))) - 1;
+            return std::min(index, HistogramSnapshot::kNumBuckets - 1);
+        }
+
+        void LatencyHistogram::Record(int64_t inNanoseconds)
+        {
+            // clocks can be swapped under test so never record a negative duration
+            inNanoseconds = std::max(int64_t(0), inNanoseconds);
+            m_Buckets[GetBucketIndex(inNanoseconds)].fetch_add(1, std::memory_order_relaxed);
+            m_Count.fetch_add(1, std::memory_order_relaxed);
+            m_Sum.fetch_add(inNanoseconds, std::memory_order_relaxed);
+            int64_t max = m_Max.load(std::memory_order_relaxed);
+            while (inNanoseconds > max && m_Max.compare_exchange_weak(max, inNanoseconds, std::memory_order_relaxed) == false)
+            {
+            }
+        }
+
+        HistogramSnapshot LatencyHistogram::GetSnapshot() const
+        {
+            HistogramSnapshot snapshot;
+            snapshot.m_Count = m_Count.load(std::memory_order_relaxed);
+            snapshot.m_SumNanoseconds = m_Sum.load(std::memory_order_relaxed);
+            snapshot.m_MaxNanoseconds = m_Max.load(std::memory_order_relaxed);
+            for (size_t x = 0; x < HistogramSnapshot::kNumBuckets; x++)
+            {
+                snapshot.m_Buckets[x] = m_Buckets[x].load(std::memory_order_relaxed);
+            }
+            return snapshot;
+        }
+
+        double WorkerMetricsSnapshot::GetBusyRatio() const
+        {
+            int64_t total = m_BusyNanoseconds + m_IdleNanoseconds;
+            if (total <= 0)
+            {
+                return 0;
+            }
+            return static_cast<double>(m_BusyNanoseconds) / static_cast<double>(total);
+        }
+
+        uint64_t PoolMetricsSnapshot::GetQueueDepth() const
+        {
+            uint64_t posted = m_Posted + m_DelayedPosted;
+            uint64_t done = m_Started + m_DelayedCanceled;
+            // the counters are read one at a time so a task can be seen starting before it's post
+            return posted > done ? posted - done : 0;
+        }
+
+        double PoolMetricsSnapshot::GetEnqueueRate() const
+        {
+            if (m_UptimeSeconds <= 0)
+            {
+                return 0;
+            }
+            return static_cast<double>(m_Posted + m_DelayedPosted) / m_UptimeSeconds;
+        }
+
+        void PoolMetricsSnapshot::Dump(std::ostream &inStream) const
+        {
+            auto dumpHistogram = [&inStream](const char *inName, const HistogramSnapshot &inHistogram)
+            {
+                inStream << "  " << inName << ": count=" << inHistogram.m_Count
+                         << " mean=" << inHistogram.GetMeanNanoseconds() / Time::kNanosecondsPerMillisecond << "ms"
+                         << " p50=" << static_cast<double>(inHistogram.GetPercentileNanoseconds(50)) / Time::kNanosecondsPerMillisecond << "ms"
+                         << " p99=" << static_cast<double>(inHistogram.GetPercentileNanoseconds(99)) / Time::kNanosecondsPerMillisecond << "ms"
+                         << " max=" << static_cast<double>(inHistogram.m_MaxNanoseconds) / Time::kNanosecondsPerMillisecond << "ms\n";
+            };
+
+            inStream << "Posted: " << m_Posted << " Delayed: " << m_DelayedPosted << " Canceled: " << m_DelayedCanceled << " Started: " << m_Started
+                     << " Depth: " << GetQueueDepth() << " Rate: " << GetEnqueueRate() << "/s\n";
+            dumpHistogram("Wait", m_WaitTime);
+            dumpHistogram("Run", m_RunTime);
+            dumpHistogram("Lateness", m_DelayedLateness);
+            for (size_t x = 0; x < m_Workers.size(); x++)
+            {
+                inStream << "  Worker #" << x << ": tasks=" << m_Workers[x].m_TasksRun
+                         << " busy=" << m_Workers[x].GetBusyRatio() * 100 << "%\n";
+            }
+        }
+
+        std::string PoolMetricsSnapshot::ToString() const
+        {
+            std::ostringstream stream;
+            Dump(stream);
+            return stream.str();
+        }
+
+        PoolMetrics::PoolMetrics(int inNumberOfWorkers) : m_CreatedTime(Time::NowNanoseconds())
+        {
+            for (int x = 0; x < inNumberOfWorkers; x++)
+            {
+                m_Workers.push_back(std::make_unique<WorkerMetrics>());
+            }
+        }
+
+        void PoolMetrics::RecordStarted(int inWorkerIndex, int64_t inReadyTime, bool inDelayed, int64_t inNow)
+        {
+            WorkerMetrics &worker = *m_Workers[inWorkerIndex];
+            if (inDelayed)
+            {
+                worker.m_DelayedLateness.Record(inNow - inReadyTime);
+            }
+            else
+            {
+                worker.m_WaitTime.Record(inNow - inReadyTime);
+            }
+        }
+
+        void PoolMetrics::RecordRun(int inWorkerIndex, int64_t inRunNanoseconds)
+        {
+            WorkerMetrics &worker = *m_Workers[inWorkerIndex];
+            worker.m_TasksRun.fetch_add(1, std::memory_order_relaxed);
+            worker.m_BusyNanoseconds.fetch_add(inRunNanoseconds, std::memory_order_relaxed);
+            worker.m_RunTime.Record(inRunNanoseconds);
+        }
+
+        void PoolMetrics::RecordIdle(int inWorkerIndex, int64_t inIdleNanoseconds)
+        {
+            m_Workers[inWorkerIndex]->m_IdleNanoseconds.fetch_add(inIdleNanoseconds, std::memory_order_relaxed);
+        }
+
+        PoolMetricsSnapshot PoolMetrics::GetSnapshot() const
+        {
+            PoolMetricsSnapshot snapshot;
+            snapshot.m_UptimeSeconds = static_cast<double>(Time::NowNanoseconds() - m_CreatedTime) / Time::kNanosecondsPerSecond;
+            for (auto &worker : m_Workers)
+            {
+                WorkerMetricsSnapshot workerSnapshot;
+                workerSnapshot.m_TasksRun = worker->m_TasksRun.load(std::memory_order_relaxed);
+                workerSnapshot.m_BusyNanoseconds = worker->m_BusyNanoseconds.load(std::memory_order_relaxed);
+                workerSnapshot.m_IdleNanoseconds = worker->m_IdleNanoseconds.load(std::memory_order_relaxed);
+                snapshot.m_Workers.push_back(workerSnapshot);
+
+                snapshot.m_WaitTime.Merge(worker->m_WaitTime.GetSnapshot());
+                snapshot.m_RunTime.Merge(worker->m_RunTime.GetSnapshot());
+                snapshot.m_DelayedLateness.Merge(worker->m_DelayedLateness.GetSnapshot());
+            }
+            snapshot.m_Started = snapshot.m_WaitTime.m_Count + snapshot.m_DelayedLateness.m_Count;
+            snapshot.m_DelayedCanceled = m_DelayedCanceled.load(std::memory_order_relaxed);
+            // read the posts last so they're never behind the starts
+            snapshot.m_Posted = m_Posted.load(std::memory_order_relaxed);
+            snapshot.m_DelayedPosted = m_DelayedPosted.load(std::memory_order_relaxed);
+            return snapshot;
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,45 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include "Threads/ScopedBlockingCall.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        static thread_local IBlockingObserver *s_BlockingObserver = nullptr;
+        static thread_local bool s_InBlockingCall = false;
+
+        void SetBlockingObserverForCurrentThread(IBlockingObserver *inObserver)
+        {
+            s_BlockingObserver = inObserver;
+        }
+
+        IBlockingObserver *GetBlockingObserverForCurrentThread()
+        {
+            return s_BlockingObserver;
+        }
+
+        ScopedBlockingCall::ScopedBlockingCall(BlockingType inType)
+        {
+            if (s_InBlockingCall || s_BlockingObserver == nullptr)
+            {
+                return;
+            }
+            s_InBlockingCall = true;
+            m_Observer = s_BlockingObserver;
+            m_Observer->BlockingStarted(inType);
+        }
+
+        ScopedBlockingCall::~ScopedBlockingCall()
+        {
+            if (m_Observer == nullptr)
+            {
+                return;
+            }
+            m_Observer->BlockingEnded();
+            s_InBlockingCall = false;
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,112 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+
+#include "Threads/SequencedTaskRunner.h"
+#include "Tracing/TraceMacros.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        // The sequence whose task is running on this thread
+        static thread_local const void *s_CurrentSequence = nullptr;
+
+        SequencedTaskRunner::SequencedTaskRunner(ThreadPoolQueue &inPool, size_t inBatchSize)
+            : m_State(std::make_shared<SequenceState>())
+        {
+            m_State->m_Pool = &inPool;
+            m_State->m_BatchSize = std::max<size_t>(1, inBatchSize);
+        }
+
+        bool SequencedTaskRunner::PostTask(ThreadPoolTaskUniquePtr inTask)
+        {
+            if (m_State->m_Pool->IsExiting())
+            {
+                return false;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_State->m_Lock);
+                m_State->m_Tasks.push_back(std::move(inTask));
+                // the drain that's already queued will pick it up
+                if (m_State->m_Scheduled)
+                {
+                    return true;
+                }
+                m_State->m_Scheduled = true;
+            }
+            if (ScheduleDrain(m_State))
+            {
+                return true;
+            }
+            // the pool is exiting so nothing will run the sequence
+            std::lock_guard<std::mutex> lock(m_State->m_Lock);
+            m_State->m_Tasks.clear();
+            m_State->m_Scheduled = false;
+            return false;
+        }
+
+        bool SequencedTaskRunner::RunsTasksInCurrentSequence() const
+        {
+            return s_CurrentSequence == m_State.get();
+        }
+
+        size_t SequencedTaskRunner::GetPendingCount() const
+        {
+            std::lock_guard<std::mutex> lock(m_State->m_Lock);
+            return m_State->m_Tasks.size();
+        }
+
+        bool SequencedTaskRunner::ScheduleDrain(SequenceStateSharedPtr inState, bool inToBack)
+        {
+            ThreadPoolQueue *pool = inState->m_Pool;
+            ThreadPoolTaskUniquePtr task = std::make_unique<CallableThreadTask>([state = std::move(inState)]()
+                                                                                { Drain(state); });
+            return inToBack ? pool->PostTaskToBack(std::move(task)) : pool->PostTask(std::move(task));
+        }
+
+        void SequencedTaskRunner::Drain(SequenceStateSharedPtr inState)
+        {
+            const void *previousSequence = s_CurrentSequence;
+            s_CurrentSequence = inState.get();
+            for (size_t x = 0; x < inState->m_BatchSize; x++)
+            {
+                ThreadPoolTaskUniquePtr task;
+                {
+                    std::lock_guard<std::mutex> lock(inState->m_Lock);
+                    if (inState->m_Tasks.empty())
+                    {
+                        inState->m_Scheduled = false;
+                        s_CurrentSequence = previousSequence;
+                        return;
+                    }
+                    task = std::move(inState->m_Tasks.front());
+                    inState->m_Tasks.pop_front();
+                }
+                // never run with the lock held so the task can post back to the sequence
+                TRACE_SCOPE("v8app.threads", "SequencedTask");
+                task->Run();
+            }
+            s_CurrentSequence = previousSequence;
+
+            {
+                std::lock_guard<std::mutex> lock(inState->m_Lock);
+                if (inState->m_Tasks.empty())
+                {
+                    inState->m_Scheduled = false;
+                    return;
+                }
+            }
+            // more to do so go to the back of the pool's injection queue so other work gets a turn, posting
+            // normally from here would put it on this worker's deque and it would run again straight away
+            if (ScheduleDrain(inState, true) == false)
+            {
+                std::lock_guard<std::mutex> lock(inState->m_Lock);
+                inState->m_Tasks.clear();
+                inState->m_Scheduled = false;
+            }
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -2,46 +2,43 @@
 // Use of this source code is governed by a MIT license that can be
 // found in the LICENSE file.
 
-#include <format>
+#include <chrono>
 #include <iostream>
 #include <functional>
+#include <limits>
+#include <optional>
 
 #include "Threads/ThreadPoolDelayedQueue.h"
 #include "Logging/LogMacros.h"
-#include "Utils/Format.h"
+#include "Time/Clock.h"
+#include "Time/Time.h"
 
 namespace v8App
 {
     namespace Threads
     {
-        ThreadPoolDelayedQueue::ThreadPoolDelayedQueue(int inNumberOfWorkers, ThreadPriority inPriority) : m_Priority(inPriority)
+        // The pool and worker index of the pool worker running on this thread
+        static thread_local ThreadPoolDelayedQueue *s_CurrentPool = nullptr;
+        static thread_local int s_CurrentWorkerIndex = -1;
+
+        ThreadPoolDelayedQueue::ThreadPoolDelayedQueue(int inNumberOfWorkers, ThreadPriority inPriority)
+            : ThreadPoolWorkers(inNumberOfWorkers, inPriority, "DelayedThreadPool"), m_TimerDeadline(std::numeric_limits<double>::infinity())
         {
-            // We want to leave one core for the main thread.
-            int hardwareThreads = GetHardwareCores();
-            if (inNumberOfWorkers < 0)
-            {
-                inNumberOfWorkers = hardwareThreads;
-            }
-            m_Queue.SetDelayedJobsReadyDelegate(std::bind(&ThreadPoolDelayedQueue::DelayedJobsReady, this));
-            m_NumWorkers = std::max(1, std::min(inNumberOfWorkers, hardwareThreads));
-            for (int x = 0; x < m_NumWorkers; x++)
-            {
-                std::string name;
-                if (x == 0)
-                {
-                    name = Utils::format("DelayedThreadPoolPumper #{}", x);
-                    std::unique_ptr<Thread> thread = std::make_unique<ThreadPoolThread>(name, m_Priority, this, true);
-                    thread->Start();
-                    m_Workers.push_back(std::move(thread));
-                }
-                else
-                {
-                    name = Utils::format("DelayedThreadPool #{}", x);
-                    std::unique_ptr<Thread> thread = std::make_unique<ThreadPoolThread>(name, m_Priority, this, false);
-                    thread->Start();
-                    m_Workers.push_back(std::move(thread));
-                }
-            }
+            Initialize();
+        }
+
+        ThreadPoolDelayedQueue::ThreadPoolDelayedQueue(const ElasticPoolOptions &inOptions, ThreadPriority inPriority)
+            : ThreadPoolWorkers(inOptions, inPriority, "DelayedThreadPool"), m_TimerDeadline(std::numeric_limits<double>::infinity())
+        {
+            Initialize();
+        }
+
+        void ThreadPoolDelayedQueue::Initialize()
+        {
+            m_Queue.SetDelayedJobsReadyDelegate(std::bind(&ThreadPoolDelayedQueue::DelayedJobsReady, this, std::placeholders::_1));
+            CreateWorkerQueues();
+            StartWorkers(m_NumWorkers);
+            StartTimer();
         }
 
         ThreadPoolDelayedQueue::~ThreadPoolDelayedQueue()
@@ -57,93 +54,259 @@ namespace v8App
                 return false;
             }
 
-            m_Queue.PushItem(std::move(inTask));
-            m_QueueWaiter.notify_one();
+            inTask->SetReadyTime(Time::NowNanoseconds());
+            // count it before it's visible so it's never seen starting before it's posted
+            m_Metrics->RecordPosted(1);
+            int workerIndex = GetCurrentWorkerIndex();
+            if (workerIndex == -1)
+            {
+                m_Queue.PushItem(std::move(inTask));
+            }
+            else
+            {
+                // count it before it's visible so a parking worker never misses it
+                m_WorkerQueuedTasks++;
+                m_WorkerQueues[workerIndex]->PushItem(std::move(inTask));
+            }
+            WakeWorkers(1);
             return true;
         }
-        bool ThreadPoolDelayedQueue::PostDelayedTask(double inDelay, ThreadPoolTaskUniquePtr inTask)
+
+        bool ThreadPoolDelayedQueue::PostTasks(std::vector<ThreadPoolTaskUniquePtr> inTasks)
         {
             if (m_Exiting)
             {
                 return false;
             }
-            m_Queue.PushItemDelayed(inDelay, std::move(inTask));
-            m_QueueWaiter.notify_one();
+            size_t numTasks = inTasks.size();
+            if (numTasks == 0)
+            {
+                return true;
+            }
+
+            int64_t now = Time::NowNanoseconds();
+            for (auto &task : inTasks)
+            {
+                task->SetReadyTime(now);
+            }
+            m_Metrics->RecordPosted(numTasks);
+
+            int workerIndex = GetCurrentWorkerIndex();
+            if (workerIndex == -1)
+            {
+                m_Queue.PushItems(std::move(inTasks));
+                WakeWorkers(numTasks);
+            }
+            else
+            {
+                // count them before they're visible so a parking worker never misses them
+                m_WorkerQueuedTasks += static_cast<int>(numTasks);
+                m_WorkerQueues[workerIndex]->PushItems(std::move(inTasks));
+                // the posting worker will pick one up itself
+                WakeWorkers(numTasks - 1);
+            }
             return true;
         }
 
-        void ThreadPoolDelayedQueue::Terminate()
+        bool ThreadPoolDelayedQueue::PostDelayedTasks(double inDelay, std::vector<ThreadPoolTaskUniquePtr> inTasks)
         {
             if (m_Exiting)
             {
-                return;
+                return false;
+            }
+            if (inTasks.empty())
+            {
+                return true;
             }
-            // if the m_Exiting hasn't been set yet then set it
-            if (m_Exiting == false)
+            // the metrics' ready time is the deadline so they can't disagree on when the tasks are due
+            double deadline = Time::MonotonicallyIncreasingTimeSeconds() + inDelay;
+            int64_t readyTime = static_cast<int64_t>(deadline * Time::kNanosecondsPerSecond);
+            for (auto &task : inTasks)
             {
-                m_Exiting.exchange(true);
+                task->SetReadyTime(readyTime, true);
             }
-            m_QueueWaiter.notify_all();
-            for (auto &it : m_Workers)
+            m_Metrics->RecordDelayedPosted(inTasks.size());
+            m_Queue.PushItemsDelayed(inDelay, std::move(inTasks));
+            RescheduleTimer(deadline);
+            return true;
+        }
+        bool ThreadPoolDelayedQueue::PostDelayedTask(double inDelay, ThreadPoolTaskUniquePtr inTask)
+        {
+            return PostCancelableDelayedTask(inDelay, std::move(inTask)) != Queues::kInvalidTimerId;
+        }
+
+        Queues::TimerId ThreadPoolDelayedQueue::PostCancelableDelayedTask(double inDelay, ThreadPoolTaskUniquePtr inTask)
+        {
+            if (m_Exiting)
             {
-                it->Join();
+                return Queues::kInvalidTimerId;
             }
-            m_Workers.clear();
+            double deadline = Time::MonotonicallyIncreasingTimeSeconds() + inDelay;
+            inTask->SetReadyTime(static_cast<int64_t>(deadline * Time::kNanosecondsPerSecond), true);
+            m_Metrics->RecordDelayedPosted(1);
+            Queues::TimerId id = m_Queue.PushItemDelayed(inDelay, std::move(inTask));
+            RescheduleTimer(deadline);
+            return id;
         }
 
-        void ThreadPoolDelayedQueue::DelayedJobsReady()
+        bool ThreadPoolDelayedQueue::CancelDelayedTask(Queues::TimerId inId)
         {
-            m_QueueWaiter.notify_all();
+            // the timer may wake up early for it but it just finds the next deadline and goes back to sleep
+            if (m_Queue.CancelItem(inId) == false)
+            {
+                return false;
+            }
+            m_Metrics->RecordDelayedCanceled(1);
+            return true;
         }
 
-        void ThreadPoolDelayedQueue::PumpQueue()
+        void ThreadPoolDelayedQueue::WakeTimer()
         {
-            while (true)
             {
-                std::unique_lock<std::mutex> lock(m_QueueLock);
-                m_QueueWaiter.wait_for(lock, std::chrono::milliseconds(200), [=]()
-                                       { return m_Exiting == true || m_Queue.MayHaveItems(); });
-                if (m_Exiting)
+                std::lock_guard<std::mutex> lock(m_TimerLock);
+                m_TimerRescheduled = true;
+            }
+            m_TimerWaiter.notify_all();
+        }
+
+        bool ThreadPoolDelayedQueue::SetPaused(bool inPaused)
+        {
+            bool previous = m_Paused.exchange(inPaused);
+            if (inPaused == false)
+            {
+                m_Parker.UnparkAll();
+            }
+            return previous;
+        }
+
+        void ThreadPoolDelayedQueue::DelayedJobsReady(size_t inCount)
+        {
+            // only wake as many workers as there are tasks for them
+            WakeWorkers(inCount);
+        }
+
+        void ThreadPoolDelayedQueue::RescheduleTimer(double inDeadline)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_TimerLock);
+                if (inDeadline >= m_TimerDeadline)
                 {
                     return;
                 }
-                if(m_Paused) 
+                m_TimerDeadline = inDeadline;
+                m_TimerRescheduled = true;
+            }
+            m_TimerWaiter.notify_one();
+        }
+
+        void ThreadPoolDelayedQueue::RunTimer()
+        {
+            std::unique_lock<std::mutex> lock(m_TimerLock);
+            while (m_Exiting == false)
+            {
+                std::optional<double> deadline = m_Queue.GetNextDeadline();
+                m_TimerDeadline = deadline.value_or(std::numeric_limits<double>::infinity());
+                m_TimerRescheduled = false;
+                if (deadline.has_value() == false)
                 {
-                    continue;
+                    // nothing delayed so sleep till something is posted
+                    m_TimerWaiter.wait(lock, [this]()
+                                       { return m_TimerRescheduled; });
                 }
-                if (m_Queue.MayHaveItems())
+                else
                 {
-                    std::optional<ThreadPoolTaskUniquePtr> task = m_Queue.GetNextItem();
-                    if (task)
+                    double delay = deadline.value() - Time::MonotonicallyIncreasingTimeSeconds();
+                    if (delay > 0)
                     {
-                        task.value()->Run();
+                        m_TimerWaiter.wait_for(lock, std::chrono::duration<double>(delay), [this]()
+                                               { return m_TimerRescheduled; });
                     }
                 }
+                if (m_Exiting)
+                {
+                    break;
+                }
+                // ticking the queue moves the ready tasks over and calls DelayedJobsReady to wake the workers
+                lock.unlock();
+                m_Queue.MayHaveItems();
+                lock.lock();
             }
         }
 
-        void ThreadPoolDelayedQueue::ProcessTasks()
+        bool ThreadPoolDelayedQueue::HasBacklog()
         {
+            return m_Paused == false && (m_WorkerQueuedTasks > 0 || m_Queue.MayHaveItems());
+        }
+
+        int ThreadPoolDelayedQueue::GetCurrentWorkerIndex()
+        {
+            return s_CurrentPool == this ? s_CurrentWorkerIndex : -1;
+        }
+
+        void ThreadPoolDelayedQueue::WakeWorkers(size_t inCount)
+        {
+            // no lock needed, the parker never loses a wake up that races a worker parking
+            m_Parker.Unpark(inCount);
+        }
+
+        void ThreadPoolDelayedQueue::ProcessTasks(int inWorkerIndex)
+        {
+            s_CurrentPool = this;
+            s_CurrentWorkerIndex = inWorkerIndex;
+            int64_t idleStart = Time::NowNanoseconds();
+
+            auto canRun = [this]()
+            {
+                return m_Exiting == true || (m_Paused == false && (m_WorkerQueuedTasks > 0 || m_Queue.MayHaveItems()));
+            };
+
             while (true)
             {
-                std::unique_lock<std::mutex> lock(m_QueueLock);
-                m_QueueWaiter.wait(lock, [=]()
-                                   { return m_Exiting == true || m_Queue.MayHaveItems(); });
                 if (m_Exiting)
                 {
-                    return;
+                    break;
                 }
 
-                if(m_Paused)
+                if (m_Paused == false)
                 {
+                    std::optional<ThreadPoolTaskUniquePtr> task = FindTask(inWorkerIndex);
+                    if (task)
+                    {
+                        RunTask(inWorkerIndex, std::move(task.value()), idleStart);
+                        continue;
+                    }
+                }
+
+                // nothing to run so park till more work is posted, checking once more after
+                // we're counted as parked so a post that raced us isn't missed
+                Parker::ParkToken token = m_Parker.PrepareToPark();
+                if (canRun())
+                {
+                    m_Parker.CancelPark();
                     continue;
                 }
-                std::optional<ThreadPoolTaskUniquePtr> task = m_Queue.GetNextItem();
-                if (task)
+                if (m_Elastic == false)
                 {
-                    task.value()->Run();
+                    m_Parker.Park(token);
+                }
+                else
+                {
+                    // retire if idle for too long or asked to give back the thread when memory is low
+                    bool unparked = m_Parker.ParkFor(token, m_Options.m_IdleTimeout);
+                    if ((unparked == false || TakeTrimRequest()) && RetireWorker(inWorkerIndex))
+                    {
+                        // we may have been woken for a task so pass it on
+                        if (canRun())
+                        {
+                            WakeWorkers(1);
+                        }
+                        break;
+                    }
                 }
             }
+
+            s_CurrentPool = nullptr;
+            s_CurrentWorkerIndex = -1;
         }
     } // namespace ThreadPool
-} // namespace v8App
\ No newline at end of file
+} // namespace v8App
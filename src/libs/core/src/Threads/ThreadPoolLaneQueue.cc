@@ -0,0 +1,490 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "Threads/ThreadPoolLaneQueue.h"
+#include "Logging/LogMacros.h"
+#include "Time/Clock.h"
+#include "Time/Time.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        // The lane of the task the pool worker on this thread is running, -1 when it's not running one
+        static thread_local int s_CurrentLane = -1;
+
+        ThreadPoolLaneQueue::ThreadPoolLaneQueue(int inNumberOfWorkers, ThreadPriority inPriority)
+            : ThreadPoolWorkers(inNumberOfWorkers, inPriority, "LaneThreadPool")
+        {
+            Initialize();
+        }
+
+        ThreadPoolLaneQueue::ThreadPoolLaneQueue(const ElasticPoolOptions &inOptions, ThreadPriority inPriority)
+            : ThreadPoolWorkers(inOptions, inPriority, "LaneThreadPool")
+        {
+            Initialize();
+        }
+
+        ThreadPoolLaneQueue::~ThreadPoolLaneQueue()
+        {
+            Terminate();
+        }
+
+        void ThreadPoolLaneQueue::Initialize()
+        {
+            for (size_t x = 0; x < kNumLanes; x++)
+            {
+                m_Lanes[x].m_MaxConcurrency = m_NumWorkers;
+            }
+            m_Lanes[GetLaneIndex(ThreadPriority::kBestEffort)].m_MaxConcurrency = std::max(1, m_NumWorkers / 2);
+            // each worker can block and be covered by a compensating worker
+            StartWorkers(m_NumWorkers * 2);
+            StartTimer();
+        }
+
+        bool ThreadPoolLaneQueue::PostTask(ThreadPriority inLane, ThreadPoolTaskUniquePtr inTask)
+        {
+            inTask->SetReadyTime(Time::NowNanoseconds());
+            double now = Time::MonotonicallyIncreasingTimeSeconds();
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                // if we are in the process of exiting then return
+                if (m_Exiting)
+                {
+                    return false;
+                }
+                m_Metrics->RecordPosted(1);
+                m_Lanes[GetLaneIndex(inLane)].m_Tasks.push_back(LaneTask{std::move(inTask), now});
+            }
+            WakeWorkers(1);
+            return true;
+        }
+
+        bool ThreadPoolLaneQueue::PostTasks(ThreadPriority inLane, std::vector<ThreadPoolTaskUniquePtr> inTasks)
+        {
+            size_t numTasks = inTasks.size();
+            int64_t readyTime = Time::NowNanoseconds();
+            double now = Time::MonotonicallyIncreasingTimeSeconds();
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                if (m_Exiting)
+                {
+                    return false;
+                }
+                Lane &lane = m_Lanes[GetLaneIndex(inLane)];
+                for (auto &task : inTasks)
+                {
+                    task->SetReadyTime(readyTime);
+                    lane.m_Tasks.push_back(LaneTask{std::move(task), now});
+                }
+                m_Metrics->RecordPosted(numTasks);
+            }
+            WakeWorkers(numTasks);
+            return true;
+        }
+
+        bool ThreadPoolLaneQueue::PostDelayedTask(ThreadPriority inLane, double inDelay, ThreadPoolTaskUniquePtr inTask)
+        {
+            return PostCancelableDelayedTask(inLane, inDelay, std::move(inTask)) != Queues::kInvalidTimerId;
+        }
+
+        Queues::TimerId ThreadPoolLaneQueue::PostCancelableDelayedTask(ThreadPriority inLane, double inDelay, ThreadPoolTaskUniquePtr inTask)
+        {
+            // the metrics' ready time is the deadline so they can't disagree on when the task is due
+            double deadline = Time::MonotonicallyIncreasingTimeSeconds() + inDelay;
+            inTask->SetReadyTime(static_cast<int64_t>(deadline * Time::kNanosecondsPerSecond), true);
+            bool reschedule;
+            Queues::TimerId id;
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                if (m_Exiting)
+                {
+                    return Queues::kInvalidTimerId;
+                }
+                m_Metrics->RecordDelayedPosted(1);
+                std::optional<double> next = m_Delayed.GetNextDeadline();
+                reschedule = next.has_value() == false || deadline < next.value();
+                id = m_Delayed.Insert(deadline, DelayedTask{GetLaneIndex(inLane), std::move(inTask)});
+                if (reschedule)
+                {
+                    m_TimerRescheduled = true;
+                }
+            }
+            if (reschedule)
+            {
+                m_TimerWaiter.notify_one();
+            }
+            return id;
+        }
+
+        bool ThreadPoolLaneQueue::CancelDelayedTask(Queues::TimerId inId)
+        {
+            std::optional<DelayedTask> canceled;
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                canceled = m_Delayed.Remove(inId);
+            }
+            if (canceled.has_value() == false)
+            {
+                return false;
+            }
+            m_Metrics->RecordDelayedCanceled(1);
+            // the task is destroyed outside the lock in case it's destructor posts to the pool
+            return true;
+        }
+
+        void ThreadPoolLaneQueue::SetLaneConcurrency(ThreadPriority inLane, int inMaxConcurrency)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                m_Lanes[GetLaneIndex(inLane)].m_MaxConcurrency = std::max(1, inMaxConcurrency);
+            }
+            // raising the cap can let parked workers run
+            m_QueueWaiter.notify_all();
+        }
+
+        int ThreadPoolLaneQueue::GetLaneConcurrency(ThreadPriority inLane)
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            return m_Lanes[GetLaneIndex(inLane)].m_MaxConcurrency;
+        }
+
+        void ThreadPoolLaneQueue::SetAgingThreshold(double inSeconds)
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            m_AgingThreshold = std::max(0.0, inSeconds);
+        }
+
+        double ThreadPoolLaneQueue::GetAgingThreshold()
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            return m_AgingThreshold;
+        }
+
+        size_t ThreadPoolLaneQueue::GetLaneQueuedCount(ThreadPriority inLane)
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            return m_Lanes[GetLaneIndex(inLane)].m_Tasks.size();
+        }
+
+        int ThreadPoolLaneQueue::GetLaneRunningCount(ThreadPriority inLane)
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            return m_Lanes[GetLaneIndex(inLane)].m_Running;
+        }
+
+        void ThreadPoolLaneQueue::WakeTimer()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                m_TimerRescheduled = true;
+            }
+            m_TimerWaiter.notify_all();
+        }
+
+        void ThreadPoolLaneQueue::ClearQueues()
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            for (auto &lane : m_Lanes)
+            {
+                lane.m_Tasks.clear();
+            }
+            m_Delayed.Clear();
+        }
+
+        bool ThreadPoolLaneQueue::SetPaused(bool inPaused)
+        {
+            bool previous;
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                previous = m_Paused.exchange(inPaused);
+            }
+            if (inPaused == false)
+            {
+                m_QueueWaiter.notify_all();
+            }
+            return previous;
+        }
+
+        void ThreadPoolLaneQueue::WakeWorkers(size_t inCount)
+        {
+            size_t toWake;
+            bool wakeAll;
+            bool wakeTimer = false;
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                toWake = std::min(inCount, static_cast<size_t>(m_ParkedWorkers));
+                wakeAll = toWake > 0 && toWake == static_cast<size_t>(m_ParkedWorkers);
+                // a fixed pool only grows to cover it's blocked workers
+                if ((m_Elastic || m_BlockedWorkers > 0) && toWake < inCount)
+                {
+                    int room = std::max(0, GetWorkerCapacity() - m_ActiveWorkers);
+                    int wanted = std::min(m_WantedWorkers + static_cast<int>(inCount - toWake), room);
+                    if (wanted > m_WantedWorkers)
+                    {
+                        // starting a thread is slow so it's left to the timer rather than the posting thread
+                        m_WantedWorkers = wanted;
+                        m_TimerRescheduled = true;
+                        wakeTimer = true;
+                    }
+                }
+            }
+            if (wakeAll)
+            {
+                m_QueueWaiter.notify_all();
+            }
+            else
+            {
+                for (size_t x = 0; x < toWake; x++)
+                {
+                    m_QueueWaiter.notify_one();
+                }
+            }
+            if (wakeTimer)
+            {
+                m_TimerWaiter.notify_one();
+            }
+        }
+
+        int ThreadPoolLaneQueue::GetNumberOfBlockedWorkers()
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            return m_BlockedWorkers;
+        }
+
+        int ThreadPoolLaneQueue::GetWorkerCapacity()
+        {
+            return std::min(m_NumSlots, m_NumWorkers + m_BlockedWorkers);
+        }
+
+        void ThreadPoolLaneQueue::BlockingStarted(BlockingType inType)
+        {
+            bool addWorker = false;
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                m_BlockedWorkers++;
+                // a blocked task doesn't hold a place in it's lane's cap
+                if (s_CurrentLane != -1)
+                {
+                    m_Lanes[s_CurrentLane].m_Running--;
+                }
+                if (HasRunnableLane())
+                {
+                    if (m_ParkedWorkers > 0)
+                    {
+                        m_QueueWaiter.notify_one();
+                    }
+                    else
+                    {
+                        // a call that may block is only compensated for when more work is posted
+                        addWorker = inType == BlockingType::kWillBlock;
+                    }
+                }
+            }
+            if (addWorker)
+            {
+                AddWorker();
+            }
+        }
+
+        void ThreadPoolLaneQueue::BlockingEnded()
+        {
+            // the extra worker retires once it or this worker finishes it's task
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            m_BlockedWorkers--;
+            if (s_CurrentLane != -1)
+            {
+                m_Lanes[s_CurrentLane].m_Running++;
+            }
+        }
+
+        size_t ThreadPoolLaneQueue::GetLaneIndex(ThreadPriority inLane)
+        {
+            // kDefault is the os default for a thread rather than a task priority so it's run as user visible
+            if (inLane == ThreadPriority::kDefault)
+            {
+                inLane = ThreadPriority::kUserVisible;
+            }
+            size_t index = static_cast<size_t>(inLane) - static_cast<size_t>(ThreadPriority::kBestEffort);
+            return index < kNumLanes ? index : 0;
+        }
+
+        bool ThreadPoolLaneQueue::HasRunnableLane()
+        {
+            for (auto &lane : m_Lanes)
+            {
+                if (lane.m_Tasks.empty() == false && lane.m_Running < lane.m_MaxConcurrency)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        int ThreadPoolLaneQueue::PickLane(double inNow)
+        {
+            // the front task of each lane is promoted a lane for each aging threshold it's waited, when every
+            // lane is backed up they all age together so the priority order holds and a low lane only gets
+            // ahead once it's waited a threshold longer for each lane it's behind
+            int picked = -1;
+            double best = -1.0;
+            for (size_t x = 0; x < kNumLanes; x++)
+            {
+                Lane &lane = m_Lanes[x];
+                if (lane.m_Tasks.empty() || lane.m_Running >= lane.m_MaxConcurrency)
+                {
+                    continue;
+                }
+                double promoted = 0;
+                if (m_AgingThreshold > 0)
+                {
+                    promoted = std::floor(std::max(0.0, inNow - lane.m_Tasks.front().m_ReadyTime) / m_AgingThreshold);
+                }
+                // ties go to the higher lane
+                double priority = static_cast<double>(x) + promoted;
+                if (priority >= best)
+                {
+                    best = priority;
+                    picked = static_cast<int>(x);
+                }
+            }
+            return picked;
+        }
+
+        bool ThreadPoolLaneQueue::HasBacklog()
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            return m_Paused == false && HasRunnableLane();
+        }
+
+        void ThreadPoolLaneQueue::ProcessTasks(int inWorkerIndex)
+        {
+            auto canRun = [this]()
+            {
+                return m_Exiting == true || m_TrimRequests > 0 || (m_Paused == false && HasRunnableLane());
+            };
+
+            SetBlockingObserverForCurrentThread(this);
+            int64_t idleStart = Time::NowNanoseconds();
+            std::unique_lock<std::mutex> lock(m_QueueLock);
+            while (m_Exiting == false)
+            {
+                int laneIndex = m_Paused ? -1 : PickLane(Time::MonotonicallyIncreasingTimeSeconds());
+                if (laneIndex != -1)
+                {
+                    Lane &lane = m_Lanes[laneIndex];
+                    ThreadPoolTaskUniquePtr task = std::move(lane.m_Tasks.front().m_Task);
+                    lane.m_Tasks.pop_front();
+                    lane.m_Running++;
+                    s_CurrentLane = laneIndex;
+                    lock.unlock();
+
+                    RunTask(inWorkerIndex, std::move(task), idleStart);
+
+                    lock.lock();
+                    lane.m_Running--;
+                    s_CurrentLane = -1;
+                    // the lane may have been at it's cap with workers parked waiting on it
+                    if (lane.m_Tasks.empty() == false && m_ParkedWorkers > 0)
+                    {
+                        m_QueueWaiter.notify_one();
+                    }
+                    // a blocking call ended so the pool is over it's capacity, this worker steps down
+                    if (m_ActiveWorkers > GetWorkerCapacity())
+                    {
+                        ReleaseSlot(inWorkerIndex);
+                        break;
+                    }
+                    continue;
+                }
+
+                // nothing to run so park till more work is posted
+                m_ParkedWorkers++;
+                if (m_Elastic == false)
+                {
+                    m_QueueWaiter.wait(lock, canRun);
+                }
+                else
+                {
+                    bool timedOut = m_QueueWaiter.wait_for(lock, std::chrono::duration<double>(m_Options.m_IdleTimeout), canRun) == false;
+                    bool trimmed = TakeTrimRequest();
+                    if ((timedOut || trimmed) && m_ActiveWorkers > m_Options.m_MinWorkers)
+                    {
+                        // idle for too long or asked to give back memory so retire
+                        m_ParkedWorkers--;
+                        ReleaseSlot(inWorkerIndex);
+                        // pass on a wake we may have taken from a posted task
+                        if (m_Exiting == false && HasRunnableLane() && m_ParkedWorkers > 0)
+                        {
+                            m_QueueWaiter.notify_one();
+                        }
+                        break;
+                    }
+                }
+                m_ParkedWorkers--;
+            }
+            SetBlockingObserverForCurrentThread(nullptr);
+        }
+
+        void ThreadPoolLaneQueue::RunTimer()
+        {
+            std::vector<DelayedTask> ready;
+            std::unique_lock<std::mutex> lock(m_QueueLock);
+            while (m_Exiting == false)
+            {
+                if (m_WantedWorkers > 0)
+                {
+                    int wanted = m_WantedWorkers;
+                    m_WantedWorkers = 0;
+                    lock.unlock();
+                    for (int x = 0; x < wanted; x++)
+                    {
+                        if (AddWorker() == false)
+                        {
+                            break;
+                        }
+                    }
+                    lock.lock();
+                    continue;
+                }
+
+                double now = Time::MonotonicallyIncreasingTimeSeconds();
+                m_Delayed.Advance(now, ready);
+                if (ready.empty() == false)
+                {
+                    for (DelayedTask &delayed : ready)
+                    {
+                        m_Lanes[delayed.m_Lane].m_Tasks.push_back(LaneTask{std::move(delayed.m_Task), now});
+                    }
+                    size_t numReady = ready.size();
+                    ready.clear();
+                    lock.unlock();
+                    WakeWorkers(numReady);
+                    lock.lock();
+                    continue;
+                }
+
+                m_TimerRescheduled = false;
+                std::optional<double> deadline = m_Delayed.GetNextDeadline();
+                if (deadline.has_value() == false)
+                {
+                    // nothing delayed so sleep till something is posted
+                    m_TimerWaiter.wait(lock, [this]()
+                                       { return m_TimerRescheduled || m_Exiting; });
+                    continue;
+                }
+                // the deadline is the tick Advance releases it on so it's only not due yet if the clock went
+                // backwards, in that case still wait a tick so the loop always gives up the lock
+                double delay = std::max(deadline.value() - now, 1.0 / m_Delayed.GetTicksPerSecond());
+                m_TimerWaiter.wait_for(lock, std::chrono::duration<double>(delay), [this]()
+                                       { return m_TimerRescheduled || m_Exiting; });
+            }
+        }
+    } // namespace Threads
+} // namespace v8App
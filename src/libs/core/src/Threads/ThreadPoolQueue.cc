@@ -2,32 +2,35 @@
 // Use of this source code is governed by a MIT license that can be
 // found in the LICENSE file.
 
-#include <format>
-
 #include "Threads/ThreadPoolQueue.h"
 #include "Logging/LogMacros.h"
-#include "Utils/Format.h"
-        
+#include "Time/Clock.h"
+#include "Time/Time.h"
+
 namespace v8App
 {
     namespace Threads
     {
-        ThreadPoolQueue::ThreadPoolQueue(int inNumberOfWorkers, ThreadPriority inPriority) : m_Priority(inPriority)
+        // The pool and worker index of the pool worker running on this thread
+        static thread_local ThreadPoolQueue *s_CurrentPool = nullptr;
+        static thread_local int s_CurrentWorkerIndex = -1;
+
+        ThreadPoolQueue::ThreadPoolQueue(int inNumberOfWorkers, ThreadPriority inPriority)
+            : ThreadPoolWorkers(inNumberOfWorkers, inPriority, "ThreadPool")
         {
-            // We want to leave one core for the main thread.
-            int hardwareThreads = GetHardwareCores();
-            if (inNumberOfWorkers < 0)
-            {
-                inNumberOfWorkers = hardwareThreads;
-            }
-            m_NumWorkers = std::max(1, std::min(inNumberOfWorkers, hardwareThreads));
-            for (int x = 0; x < m_NumWorkers; x++)
-            {
-                std::string name = Utils::format("ThreadPool #{}", x);
-                std::unique_ptr<Thread> thread = std::make_unique<ThreadPoolThread>(name, m_Priority, this);
-                thread->Start();
-                m_Workers.push_back(std::move(thread));
-            }
+            Initialize();
+        }
+
+        ThreadPoolQueue::ThreadPoolQueue(const ElasticPoolOptions &inOptions, ThreadPriority inPriority)
+            : ThreadPoolWorkers(inOptions, inPriority, "ThreadPool")
+        {
+            Initialize();
+        }
+
+        void ThreadPoolQueue::Initialize()
+        {
+            CreateWorkerQueues();
+            StartWorkers(m_NumWorkers);
         }
 
         ThreadPoolQueue::~ThreadPoolQueue()
@@ -36,6 +39,16 @@ namespace v8App
         }
 
         bool ThreadPoolQueue::PostTask(ThreadPoolTaskUniquePtr inTask)
+        {
+            return PostTaskImpl(std::move(inTask), false);
+        }
+
+        bool ThreadPoolQueue::PostTaskToBack(ThreadPoolTaskUniquePtr inTask)
+        {
+            return PostTaskImpl(std::move(inTask), true);
+        }
+
+        bool ThreadPoolQueue::PostTaskImpl(ThreadPoolTaskUniquePtr inTask, bool inToBack)
         {
             // if we are in the process of exiting then return
             if (m_Exiting)
@@ -43,48 +56,126 @@ namespace v8App
                 return false;
             }
 
-            m_Queue.PushItem(std::move(inTask));
-            m_QueueWaiter.notify_one();
+            inTask->SetReadyTime(Time::NowNanoseconds());
+            // count it before it's visible so it's never seen starting before it's posted
+            m_Metrics->RecordPosted(1);
+            int workerIndex = inToBack ? -1 : GetCurrentWorkerIndex();
+            if (workerIndex == -1)
+            {
+                m_Queue.PushItem(std::move(inTask));
+            }
+            else
+            {
+                // count it before it's visible so a parking worker never misses it
+                m_WorkerQueuedTasks++;
+                m_WorkerQueues[workerIndex]->PushItem(std::move(inTask));
+            }
+            WakeWorkers(1);
             return true;
         }
 
-        void ThreadPoolQueue::Terminate()
+        bool ThreadPoolQueue::PostTasks(std::vector<ThreadPoolTaskUniquePtr> inTasks)
         {
             if (m_Exiting)
             {
-                return;
+                return false;
             }
-            // if the m_Exiting hasn't been set yet then set it
-            if (m_Exiting == false)
+            size_t numTasks = inTasks.size();
+            if (numTasks == 0)
             {
-                m_Exiting.exchange(true);
+                return true;
             }
-            m_QueueWaiter.notify_all();
-            for (auto &it : m_Workers)
+
+            int64_t now = Time::NowNanoseconds();
+            for (auto &task : inTasks)
             {
-                it->Join();
+                task->SetReadyTime(now);
             }
-            m_Workers.clear();
+            m_Metrics->RecordPosted(numTasks);
+
+            int workerIndex = GetCurrentWorkerIndex();
+            if (workerIndex == -1)
+            {
+                m_Queue.PushItems(std::move(inTasks));
+                WakeWorkers(numTasks);
+            }
+            else
+            {
+                // count them before they're visible so a parking worker never misses them
+                m_WorkerQueuedTasks += static_cast<int>(numTasks);
+                m_WorkerQueues[workerIndex]->PushItems(std::move(inTasks));
+                // the posting worker will pick one up itself
+                WakeWorkers(numTasks - 1);
+            }
+            return true;
+        }
+
+        bool ThreadPoolQueue::HasBacklog()
+        {
+            return m_WorkerQueuedTasks > 0 || m_Queue.MayHaveItems();
+        }
+
+        int ThreadPoolQueue::GetCurrentWorkerIndex()
+        {
+            return s_CurrentPool == this ? s_CurrentWorkerIndex : -1;
         }
 
-        void ThreadPoolQueue::ProcessTasks()
+        void ThreadPoolQueue::WakeWorkers(size_t inCount)
         {
+            // no lock needed, the parker never loses a wake up that races a worker parking
+            m_Parker.Unpark(inCount);
+        }
+
+        void ThreadPoolQueue::ProcessTasks(int inWorkerIndex)
+        {
+            s_CurrentPool = this;
+            s_CurrentWorkerIndex = inWorkerIndex;
+            int64_t idleStart = Time::NowNanoseconds();
+
             while (true)
             {
-                std::unique_lock<std::mutex> lock(m_QueueLock);
-                m_QueueWaiter.wait(lock, [=]()
-                                   { return m_Exiting == true || m_Queue.MayHaveItems(); });
                 if (m_Exiting)
                 {
-                    return;
+                    break;
                 }
 
-                std::optional<ThreadPoolTaskUniquePtr> task = m_Queue.GetNextItem();
+                std::optional<ThreadPoolTaskUniquePtr> task = FindTask(inWorkerIndex);
                 if (task)
                 {
-                    task.value()->Run();
+                    RunTask(inWorkerIndex, std::move(task.value()), idleStart);
+                    continue;
+                }
+
+                // nothing to run so park till more work is posted, checking once more after
+                // we're counted as parked so a post that raced us isn't missed
+                Parker::ParkToken token = m_Parker.PrepareToPark();
+                if (m_Exiting || m_WorkerQueuedTasks > 0 || m_Queue.MayHaveItems())
+                {
+                    m_Parker.CancelPark();
+                    continue;
+                }
+                if (m_Elastic == false)
+                {
+                    m_Parker.Park(token);
+                }
+                else
+                {
+                    // retire if idle for too long or asked to give back the thread when memory is low
+                    bool unparked = m_Parker.ParkFor(token, m_Options.m_IdleTimeout);
+                    if ((unparked == false || TakeTrimRequest()) && RetireWorker(inWorkerIndex))
+                    {
+                        // we may have been woken for a task so pass it on
+                        if (m_WorkerQueuedTasks > 0 || m_Queue.MayHaveItems())
+                        {
+                            WakeWorkers(1);
+                        }
+                        break;
+                    }
                 }
             }
+
+            s_CurrentPool = nullptr;
+            s_CurrentWorkerIndex = -1;
         }
     } // namespace ThreadPool
-} // namespace v8App
\ No newline at end of file
+} // namespace v8App
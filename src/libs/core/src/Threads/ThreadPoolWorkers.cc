@@ -0,0 +1,330 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+
+#include "Threads/ThreadPoolWorkers.h"
+#include "Time/Clock.h"
+#include "Time/Time.h"
+#include "Tracing/TraceMacros.h"
+#include "Utils/Format.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        ThreadPoolWorkers::ThreadPoolWorkers(int inNumberOfWorkers, ThreadPriority inPriority, std::string inName)
+            : m_Name(std::move(inName)), m_Priority(inPriority)
+        {
+            // We want to leave one core for the main thread.
+            int hardwareThreads = GetHardwareCores();
+            if (inNumberOfWorkers < 0)
+            {
+                inNumberOfWorkers = hardwareThreads;
+            }
+            m_NumWorkers = std::max(1, std::min(inNumberOfWorkers, hardwareThreads));
+        }
+
+        ThreadPoolWorkers::ThreadPoolWorkers(const ElasticPoolOptions &inOptions, ThreadPriority inPriority, std::string inName)
+            : m_Name(std::move(inName)), m_Priority(inPriority), m_Elastic(true), m_Options(inOptions)
+        {
+            if (m_Options.m_MaxWorkers < 0)
+            {
+                m_Options.m_MaxWorkers = GetHardwareCores();
+            }
+            m_Options.m_MaxWorkers = std::max(1, m_Options.m_MaxWorkers);
+            m_Options.m_MinWorkers = std::clamp(m_Options.m_MinWorkers, 1, m_Options.m_MaxWorkers);
+            m_NumWorkers = m_Options.m_MaxWorkers;
+        }
+
+        void ThreadPoolWorkers::StartWorkers(int inNumSlots)
+        {
+            m_NumSlots = std::max(inNumSlots, m_NumWorkers);
+            m_Metrics = std::make_unique<PoolMetrics>(m_NumSlots);
+            m_Workers.resize(m_NumSlots);
+            m_SlotActive.resize(m_NumSlots, false);
+            int startWorkers = m_Elastic ? m_Options.m_MinWorkers : m_NumWorkers;
+            for (int x = 0; x < startWorkers; x++)
+            {
+                AddWorker();
+            }
+            if (m_Elastic == false)
+            {
+                return;
+            }
+
+            m_Monitor = std::make_unique<ThreadPoolThread>(m_Name + "Monitor", m_Priority, this, kMonitorThreadIndex);
+            m_Monitor->Start();
+
+            m_ReclaimCallback = std::make_unique<Memory::ScopedReclaimCallback>(m_Name, [this](Memory::MemoryPressureLevel inLevel)
+                                                                                {
+                if (inLevel == Memory::MemoryPressureLevel::kCritical)
+                {
+                    TrimIdleWorkers();
+                } });
+        }
+
+        void ThreadPoolWorkers::StartTimer()
+        {
+            m_Timer = std::make_unique<ThreadPoolThread>(m_Name + "Timer", m_Priority, this, kTimerThreadIndex);
+            m_Timer->Start();
+            m_ClockChangedCallback = std::make_unique<Time::ScopedClockChangedCallback>([this]()
+                                                                                         { WakeTimer(); });
+        }
+
+        void ThreadPoolWorkers::Terminate()
+        {
+            if (m_Exiting)
+            {
+                return;
+            }
+            // waits out a notify that's in the middle of trimming us
+            m_ReclaimCallback.reset();
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                m_Exiting.exchange(true);
+            }
+            m_ClockChangedCallback.reset();
+            WakeAllWorkers();
+            WakeTimer();
+            {
+                std::lock_guard<std::mutex> lock(m_MonitorLock);
+            }
+            m_MonitorWaiter.notify_all();
+            if (m_Monitor != nullptr)
+            {
+                m_Monitor->Join();
+                m_Monitor.reset();
+            }
+            {
+                std::lock_guard<std::mutex> scaleLock(m_ScaleLock);
+                for (auto &it : m_Workers)
+                {
+                    if (it != nullptr)
+                    {
+                        it->Join();
+                    }
+                }
+                m_Workers.clear();
+            }
+            if (m_Timer != nullptr)
+            {
+                m_Timer->Join();
+                m_Timer.reset();
+            }
+            ClearQueues();
+        }
+
+        bool ThreadPoolWorkers::AddWorker()
+        {
+            // never wait on another scale up, Terminate holds the lock while joining the workers
+            std::unique_lock<std::mutex> scaleLock(m_ScaleLock, std::try_to_lock);
+            if (scaleLock.owns_lock() == false || m_Exiting)
+            {
+                return false;
+            }
+            int slot = -1;
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                if (m_ActiveWorkers >= GetWorkerCapacity())
+                {
+                    return false;
+                }
+                for (int x = 0; x < m_NumSlots; x++)
+                {
+                    if (m_SlotActive[x] == false)
+                    {
+                        slot = x;
+                        break;
+                    }
+                }
+                if (slot == -1)
+                {
+                    return false;
+                }
+                m_SlotActive[slot] = true;
+                m_ActiveWorkers++;
+            }
+            m_LastScaleUpTime = Time::NowNanoseconds();
+            // a retired worker may still be on it's way out
+            if (m_Workers[slot] != nullptr)
+            {
+                m_Workers[slot]->Join();
+            }
+            std::string name = Utils::format("{} #{}", m_Name, slot);
+            m_Workers[slot] = std::make_unique<ThreadPoolThread>(name, m_Priority, this, slot);
+            m_Workers[slot]->Start();
+            return true;
+        }
+
+        void ThreadPoolWorkers::MaybeAddWorker(int64_t inNow)
+        {
+            if (GetParkedCount() > 0 || m_ActiveWorkers >= m_NumWorkers)
+            {
+                return;
+            }
+            // give the last worker added a chance to drain the backlog first
+            int64_t targetLatency = static_cast<int64_t>(m_Options.m_TargetLatency * Time::kNanosecondsPerSecond);
+            if (inNow - m_LastScaleUpTime < targetLatency)
+            {
+                return;
+            }
+            AddWorker();
+        }
+
+        void ThreadPoolWorkers::RunMonitor()
+        {
+            std::unique_lock<std::mutex> lock(m_MonitorLock);
+            uint64_t lastStarted = m_TasksStarted;
+            while (m_Exiting == false)
+            {
+                m_MonitorWaiter.wait_for(lock, std::chrono::duration<double>(m_Options.m_TargetLatency), [this]()
+                                         { return m_Exiting == true; });
+                if (m_Exiting)
+                {
+                    break;
+                }
+                // work is waiting and nothing started for a whole interval so the workers are stuck
+                uint64_t started = m_TasksStarted;
+                if (started == lastStarted && GetParkedCount() == 0 && HasBacklog())
+                {
+                    AddWorker();
+                }
+                lastStarted = started;
+            }
+        }
+
+        bool ThreadPoolWorkers::RetireWorker(int inWorkerIndex)
+        {
+            std::lock_guard<std::mutex> lock(m_QueueLock);
+            if (m_Exiting || m_ActiveWorkers <= m_Options.m_MinWorkers || WorkerHasQueuedTasks(inWorkerIndex))
+            {
+                return false;
+            }
+            ReleaseSlot(inWorkerIndex);
+            return true;
+        }
+
+        void ThreadPoolWorkers::ReleaseSlot(int inWorkerIndex)
+        {
+            m_ActiveWorkers--;
+            m_SlotActive[inWorkerIndex] = false;
+        }
+
+        int ThreadPoolWorkers::TrimIdleWorkers()
+        {
+            if (m_Elastic == false || m_Exiting)
+            {
+                return 0;
+            }
+            int toTrim = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                toTrim = std::max(0, std::min(GetParkedCount(), m_ActiveWorkers - m_Options.m_MinWorkers));
+                m_TrimRequests = toTrim;
+            }
+            if (toTrim > 0)
+            {
+                WakeAllWorkers();
+            }
+            return toTrim;
+        }
+
+        bool ThreadPoolWorkers::TakeTrimRequest()
+        {
+            int requests = m_TrimRequests.load();
+            while (requests > 0)
+            {
+                if (m_TrimRequests.compare_exchange_weak(requests, requests - 1))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void ThreadPoolWorkers::RunTask(int inWorkerIndex, ThreadPoolTaskUniquePtr inTask, int64_t &ioIdleStart)
+        {
+            int64_t start = Time::NowNanoseconds();
+            m_Metrics->RecordIdle(inWorkerIndex, start - ioIdleStart);
+            m_Metrics->RecordStarted(inWorkerIndex, inTask->GetReadyTime(), inTask->IsDelayed(), start);
+            m_TasksStarted.fetch_add(1, std::memory_order_relaxed);
+            if (m_Elastic && start - inTask->GetReadyTime() > static_cast<int64_t>(m_Options.m_TargetLatency * Time::kNanosecondsPerSecond))
+            {
+                MaybeAddWorker(start);
+            }
+            {
+                TRACE_SCOPE("v8app.threads", "ThreadPoolTask");
+                inTask->Run();
+                // destroyed here so anything it's destructor does is counted as part of the task
+                inTask.reset();
+            }
+            ioIdleStart = Time::NowNanoseconds();
+            m_Metrics->RecordRun(inWorkerIndex, ioIdleStart - start);
+        }
+
+        void ThreadPoolWorkers::CreateWorkerQueues()
+        {
+            for (int x = 0; x < m_NumWorkers; x++)
+            {
+                m_WorkerQueues.push_back(std::make_unique<WorkerQueue>());
+            }
+            m_LocalPops.resize(m_NumWorkers, 0);
+        }
+
+        std::optional<ThreadPoolTaskUniquePtr> ThreadPoolWorkers::FindTask(int inWorkerIndex)
+        {
+            std::optional<ThreadPoolTaskUniquePtr> task;
+            int &localPops = m_LocalPops[inWorkerIndex];
+            if (localPops >= kInjectionCheckInterval)
+            {
+                localPops = 0;
+                task = PopInjectedTask();
+                if (task)
+                {
+                    return task;
+                }
+            }
+            task = m_WorkerQueues[inWorkerIndex]->GetNextItem();
+            if (task)
+            {
+                m_WorkerQueuedTasks--;
+                localPops++;
+                return task;
+            }
+            localPops = 0;
+            task = PopInjectedTask();
+            if (task)
+            {
+                return task;
+            }
+            // start with our neighbour so the thieves spread out over the workers
+            for (int x = 1; x < m_NumWorkers; x++)
+            {
+                int victim = (inWorkerIndex + x) % m_NumWorkers;
+                if (m_WorkerQueues[victim]->MayHaveItems() == false)
+                {
+                    continue;
+                }
+                task = m_WorkerQueues[victim]->StealItem();
+                if (task)
+                {
+                    m_WorkerQueuedTasks--;
+                    return task;
+                }
+            }
+            return {};
+        }
+
+        void ThreadPoolWorkers::ClearQueues()
+        {
+            for (auto &it : m_WorkerQueues)
+            {
+                it->Terminate();
+            }
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -12,9 +12,16 @@
 #include <codecvt>
 #elif defined(V8APP_MACOS) || defined(V8APP_IOS)
 #include <pthread.h>
+#elif defined(V8APP_LINUX)
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 
-#include "Threads/Threads.h"
+#include "Threads/CpuTopology.h"
 #include "Logging/LogMacros.h"
 
 namespace v8App
@@ -49,8 +56,17 @@ namespace v8App
                     // it some code that expects it to be set and needs to be set. 
                     std::lock_guard<std::mutex> lock(m_Lock);
                     this->m_Running = true;
+#if defined(V8APP_LINUX)
+                    this->m_NativeThreadId = static_cast<int>(::syscall(SYS_gettid));
+#endif
                     this->SetThreadPriority();
                     this->SetThreadName();
+                    if (this->m_Affinity.empty() == false && this->ApplyAffinity() == false)
+                    {
+                        Log::LogMessage msg;
+                        msg.emplace(Log::MsgKey::Msg, "Failed to set thread affinity");
+                        LOG_WARN(msg);
+                    }
                 }
                 this->RunImpl();
                 this->m_Running = false; });
@@ -77,6 +93,17 @@ namespace v8App
             int priorty;
             pthread_get_qos_class_np(m_Thread->native_handle(), &policy, &priorty);
             return policy;
+#elif defined(V8APP_LINUX)
+            // getpriority can legitimately return -1 so errno is the only way to tell it failed
+            errno = 0;
+            int nice = ::getpriority(PRIO_PROCESS, m_NativeThreadId);
+            if (errno != 0)
+            {
+                return -1;
+            }
+            return nice;
+#else
+            return -1;
 #endif
         }
 
@@ -104,6 +131,13 @@ namespace v8App
                 {
                     return std::string(temp);
                 }
+#elif defined(V8APP_LINUX)
+                char temp[kMaxLinuxThreadName + 1];
+
+                if (pthread_getname_np(m_Thread->native_handle(), temp, sizeof(temp)) == 0)
+                {
+                    return std::string(temp);
+                }
 #endif
             }
             return std::string();
@@ -156,6 +190,51 @@ namespace v8App
                 default:
                     succeeded = true;
                 }
+#elif defined(V8APP_LINUX)
+                sched_param param{};
+                switch (m_Priority)
+                {
+                case ThreadPriority::kBestEffort:
+                    // SCHED_BATCH tells the scheduler the thread isn't interactive
+                    succeeded = pthread_setschedparam(pthread_self(), SCHED_BATCH, &param) == 0 &&
+                                ::setpriority(PRIO_PROCESS, m_NativeThreadId, kLinuxBestEffortNice) == 0;
+                    break;
+                // a thread inherits it's creator's policy so it may be SCHED_BATCH, put it back to the normal one
+                case ThreadPriority::kUserVisible:
+                    succeeded = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) == 0;
+                    if (succeeded && ::setpriority(PRIO_PROCESS, m_NativeThreadId, kLinuxUserVisibleNice) != 0)
+                    {
+                        // the nice is inherited as well and without CAP_SYS_NICE a best effort creator's can't be
+                        // lowered again, so the thread keeps it
+                        succeeded = errno == EACCES || errno == EPERM;
+                        if (succeeded)
+                        {
+                            Log::LogMessage msg;
+                            msg.emplace(Log::MsgKey::Msg, "Not allowed to lower the inherited nice, running the user visible thread at it");
+                            LOG_DEBUG(msg);
+                        }
+                    }
+                    break;
+                case ThreadPriority::kUserBlocking:
+                    succeeded = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) == 0;
+                    if (succeeded && ::setpriority(PRIO_PROCESS, m_NativeThreadId, kLinuxUserBlockingNice) != 0)
+                    {
+                        // without CAP_SYS_NICE we can't go above the default so clamp to it, if the inherited nice
+                        // is above the default that isn't allowed either and the thread keeps it
+                        succeeded = errno == EACCES || errno == EPERM;
+                        if (succeeded)
+                        {
+                            bool atDefault = ::setpriority(PRIO_PROCESS, m_NativeThreadId, kLinuxUserVisibleNice) == 0;
+                            Log::LogMessage msg;
+                            msg.emplace(Log::MsgKey::Msg, atDefault ? "Not allowed to raise the thread priority, running the user blocking thread at the default"
+                                                                    : "Not allowed to raise the thread priority, running the user blocking thread at the inherited nice");
+                            LOG_DEBUG(msg);
+                        }
+                    }
+                    break;
+                default:
+                    succeeded = true;
+                }
 #endif
             }
             if (succeeded == false)
@@ -173,12 +252,75 @@ namespace v8App
             SetThreadDescription(m_Thread->native_handle(), temp.c_str());
 #elif defined(V8APP_MACOS) || defined(V8APP_IOS)
             pthread_setname_np(m_Name.c_str());
+#elif defined(V8APP_LINUX)
+            pthread_setname_np(pthread_self(), m_Name.substr(0, kMaxLinuxThreadName).c_str());
+#endif
+        }
+
+        bool Thread::SetAffinity(std::vector<int> inCpus)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            m_Affinity = std::move(inCpus);
+            if (m_Thread == nullptr || m_Running == false)
+            {
+#if defined(V8APP_LINUX)
+                return true;
+#else
+                return m_Affinity.empty();
+#endif
+            }
+            return ApplyAffinity();
+        }
+
+        std::vector<int> Thread::GetNativeAffinity()
+        {
+            std::vector<int> cpus;
+#if defined(V8APP_LINUX)
+            std::lock_guard<std::mutex> lock(m_Lock);
+            if (m_Thread == nullptr || m_Running == false)
+            {
+                return cpus;
+            }
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            if (pthread_getaffinity_np(m_Thread->native_handle(), sizeof(cpuSet), &cpuSet) == 0)
+            {
+                for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                {
+                    if (CPU_ISSET(cpu, &cpuSet))
+                    {
+                        cpus.push_back(cpu);
+                    }
+                }
+            }
+#endif
+            return cpus;
+        }
+
+        bool Thread::ApplyAffinity()
+        {
+#if defined(V8APP_LINUX)
+            // an empty list resets it to all the cpus the process is allowed on
+            const std::vector<int> &cpus = m_Affinity.empty() ? GetCpuTopology().m_LogicalCpus : m_Affinity;
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            for (int cpu : cpus)
+            {
+                if (cpu < 0 || cpu >= CPU_SETSIZE)
+                {
+                    return false;
+                }
+                CPU_SET(cpu, &cpuSet);
+            }
+            return pthread_setaffinity_np(m_Thread->native_handle(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+            return m_Affinity.empty();
 #endif
         }
 
         int GetHardwareCores()
         {
-            return std::min(1U, std::thread::hardware_concurrency() - 1);
+            return std::max(1, GetCpuTopology().GetNumberOfLogicalCores() - 1);
         }
 
     }
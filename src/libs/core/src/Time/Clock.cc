@@ -0,0 +1,103 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#include "Time/Clock.h"
+
+namespace v8App
+{
+    namespace Time
+    {
+        static std::atomic<IClock *> s_Clock{nullptr};
+        // 0 means the thread hasn't cached the time yet
+        static thread_local int64_t s_CachedNow = 0;
+
+        static std::mutex s_ClockChangedLock;
+        static std::map<ClockChangedCallbackId, ClockChangedCallback> s_ClockChangedCallbacks;
+        static ClockChangedCallbackId s_NextClockChangedId = kInvalidClockChangedCallbackId + 1;
+
+        int64_t SteadyClock::NowNanoseconds()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void SetClock(IClock *inClock)
+        {
+            s_Clock.store(inClock, std::memory_order_release);
+            NotifyClockChanged();
+        }
+
+        IClock *GetClock()
+        {
+            return s_Clock.load(std::memory_order_acquire);
+        }
+
+        int64_t NowNanoseconds()
+        {
+            IClock *clock = s_Clock.load(std::memory_order_acquire);
+            if (clock == nullptr)
+            {
+                // skip the virtual call for the common case
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+            return clock->NowNanoseconds();
+        }
+
+        int64_t CachedNowNanoseconds()
+        {
+            if (s_CachedNow == 0)
+            {
+                return RefreshCachedNowNanoseconds();
+            }
+            return s_CachedNow;
+        }
+
+        int64_t RefreshCachedNowNanoseconds()
+        {
+            s_CachedNow = NowNanoseconds();
+            return s_CachedNow;
+        }
+
+        ClockChangedCallbackId AddClockChangedCallback(ClockChangedCallback inCallback)
+        {
+            if (inCallback == nullptr)
+            {
+                return kInvalidClockChangedCallbackId;
+            }
+            std::lock_guard<std::mutex> lock(s_ClockChangedLock);
+            ClockChangedCallbackId id = s_NextClockChangedId++;
+            s_ClockChangedCallbacks.emplace(id, std::move(inCallback));
+            return id;
+        }
+
+        bool RemoveClockChangedCallback(ClockChangedCallbackId inId)
+        {
+            std::lock_guard<std::mutex> lock(s_ClockChangedLock);
+            return s_ClockChangedCallbacks.erase(inId) != 0;
+        }
+
+        void NotifyClockChanged()
+        {
+            std::lock_guard<std::mutex> lock(s_ClockChangedLock);
+            for (auto &it : s_ClockChangedCallbacks)
+            {
+                it.second();
+            }
+        }
+
+        ScopedClockChangedCallback::ScopedClockChangedCallback(ClockChangedCallback inCallback)
+            : m_Id(AddClockChangedCallback(std::move(inCallback)))
+        {
+        }
+
+        ScopedClockChangedCallback::~ScopedClockChangedCallback()
+        {
+            RemoveClockChangedCallback(m_Id);
+        }
+    } // namespace Time
+} // namespace v8App
@@ -0,0 +1,532 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#if defined(V8APP_LINUX)
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Tracing/TraceLog.h"
+
+namespace v8App
+{
+    namespace Tracing
+    {
+        // the low bits of a handle are the event's sequence number in it's buffer, the high bits the buffer id + 1
+        static constexpr int kHandleBufferShift = 40;
+        static constexpr uint64_t kHandleSequenceMask = (uint64_t(1) << kHandleBufferShift) - 1;
+
+        class TraceLog::TraceBuffer
+        {
+        public:
+            TraceBuffer(uint32_t inId, size_t inCapacity) : m_Id(inId), m_Capacity(inCapacity) {}
+
+            // the event's slot in the ring, the ring grows till it's at the capacity. Only the writer calls it
+            TraceEvent &GetSlot(uint64_t inSequence)
+            {
+                size_t index = static_cast<size_t>(inSequence % m_Capacity);
+                if (index >= m_Events.size())
+                {
+                    m_Events.resize(index + 1);
+                }
+                return m_Events[index];
+            }
+
+            // sets the duration unless the event was overwritten or cleared
+            void SetDuration(uint64_t inSequence, int64_t inEndTimestamp)
+            {
+                uint64_t written = m_Written.load(std::memory_order_relaxed);
+                if (inSequence >= m_First && inSequence < written && written - inSequence <= m_Capacity)
+                {
+                    TraceEvent &event = m_Events[inSequence % m_Capacity];
+                    event.m_Duration = inEndTimestamp - event.m_Timestamp;
+                }
+            }
+
+            // sets the durations of the events that ended while recording was paused. Recording must be paused
+            void SetPendingDurations()
+            {
+                std::lock_guard<std::mutex> lock(m_PendingLock);
+                for (const auto &it : m_PendingEnds)
+                {
+                    SetDuration(it.first, it.second);
+                }
+                m_PendingEnds.clear();
+            }
+
+            uint32_t m_Id;
+            uint32_t m_ThreadId = 0;
+            std::string m_ThreadName;
+            // most events the ring holds
+            size_t m_Capacity;
+            std::vector<TraceEvent> m_Events;
+            // total events written, the ring holds the last m_Capacity of them
+            std::atomic<uint64_t> m_Written{0};
+            // the first event since the buffer was cleared, handles from before it are stale
+            uint64_t m_First = 0;
+            // set while the owning thread is writing so a reader can wait it out
+            std::atomic_bool m_Writing{false};
+            // sequence and end of complete events that ended while recording was paused
+            std::mutex m_PendingLock;
+            std::vector<std::pair<uint64_t, int64_t>> m_PendingEnds;
+            // the thread has exited so only the log holds the buffer. Guarded by s_Lock
+            bool m_Exited = false;
+        };
+
+        struct TraceLog::ThreadBufferRef
+        {
+            ~ThreadBufferRef()
+            {
+                if (m_Buffer != nullptr)
+                {
+                    TraceLog::ReleaseThreadBuffer(m_Buffer);
+                }
+            }
+
+            TraceBufferSharedPtr m_Buffer;
+        };
+
+        std::mutex TraceLog::s_Lock;
+        std::atomic_bool TraceLog::s_Recording{false};
+        std::atomic_size_t TraceLog::s_BufferSize{kDefaultTraceBufferEvents};
+        std::set<std::string> TraceLog::s_EnabledCategories;
+        std::set<std::string> TraceLog::s_ExcludedCategories;
+        std::array<uint8_t, kMaxCategoryGroups> TraceLog::s_CategoryFlags{};
+        std::array<std::string, kMaxCategoryGroups> TraceLog::s_CategoryNames{"__disabled"};
+        std::atomic_size_t TraceLog::s_NumCategories{1};
+        std::vector<TraceLog::TraceBufferSharedPtr> TraceLog::s_Buffers;
+        uint32_t TraceLog::s_NextBufferId = 0;
+        std::mutex TraceLog::s_ListenerLock;
+        std::map<TraceStateListenerId, TraceStateListener> TraceLog::s_Listeners;
+        TraceStateListenerId TraceLog::s_NextListenerId = 1;
+
+        // keeps the buffer alive for the thread, the log holds it as well so it's events outlive the thread
+        thread_local TraceLog::ThreadBufferRef TraceLog::s_ThreadBufferRef;
+        static thread_local void *s_ThreadBuffer = nullptr;
+        // set once the thread's buffer has been released so nothing recorded after it makes a new one
+        static thread_local bool s_ThreadExited = false;
+
+        void TraceLog::StartTracing(std::vector<std::string> inCategories)
+        {
+            {
+                std::lock_guard<std::mutex> lock(s_Lock);
+                s_EnabledCategories.clear();
+                s_ExcludedCategories.clear();
+                for (const std::string &category : inCategories)
+                {
+                    if (category.empty() == false && category[0] == '-')
+                    {
+                        s_ExcludedCategories.insert(category.substr(1));
+                    }
+                    else
+                    {
+                        s_EnabledCategories.insert(category);
+                    }
+                }
+                s_Recording = true;
+                UpdateCategoryFlags();
+            }
+            NotifyStateListeners(true);
+        }
+
+        void TraceLog::StopTracing()
+        {
+            {
+                std::lock_guard<std::mutex> lock(s_Lock);
+                if (s_Recording == false)
+                {
+                    return;
+                }
+                PauseRecording();
+                UpdateCategoryFlags();
+            }
+            NotifyStateListeners(false);
+        }
+
+        void TraceLog::EnableCategory(const std::string &inCategory)
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            s_ExcludedCategories.erase(inCategory);
+            s_EnabledCategories.insert(inCategory);
+            UpdateCategoryFlags();
+        }
+
+        void TraceLog::DisableCategory(const std::string &inCategory)
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            s_EnabledCategories.erase(inCategory);
+            s_ExcludedCategories.insert(inCategory);
+            UpdateCategoryFlags();
+        }
+
+        bool TraceLog::IsCategoryGroupEnabled(const char *inCategoryGroup)
+        {
+            return (*GetCategoryGroupEnabled(inCategoryGroup) & kCategoryEnabledForRecording) != 0;
+        }
+
+        const uint8_t *TraceLog::GetCategoryGroupEnabled(const char *inCategoryGroup)
+        {
+            // the names are only ever added so the ones under the count can be read without the lock
+            size_t numCategories = s_NumCategories.load(std::memory_order_acquire);
+            for (size_t idx = 1; idx < numCategories; idx++)
+            {
+                if (s_CategoryNames[idx] == inCategoryGroup)
+                {
+                    return &s_CategoryFlags[idx];
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(s_Lock);
+            numCategories = s_NumCategories.load(std::memory_order_relaxed);
+            for (size_t idx = 1; idx < numCategories; idx++)
+            {
+                if (s_CategoryNames[idx] == inCategoryGroup)
+                {
+                    return &s_CategoryFlags[idx];
+                }
+            }
+            if (numCategories == kMaxCategoryGroups)
+            {
+                return &s_CategoryFlags[0];
+            }
+            s_CategoryNames[numCategories] = inCategoryGroup;
+            uint8_t flag = IsCategoryGroupEnabledLocked(inCategoryGroup) ? kCategoryEnabledForRecording : 0;
+            std::atomic_ref<uint8_t>(s_CategoryFlags[numCategories]).store(flag, std::memory_order_relaxed);
+            s_NumCategories.store(numCategories + 1, std::memory_order_release);
+            return &s_CategoryFlags[numCategories];
+        }
+
+        uint16_t TraceLog::GetCategoryGroupIndex(const uint8_t *inCategoryFlag)
+        {
+            if (inCategoryFlag < s_CategoryFlags.data() || inCategoryFlag >= s_CategoryFlags.data() + kMaxCategoryGroups)
+            {
+                return 0;
+            }
+            return static_cast<uint16_t>(inCategoryFlag - s_CategoryFlags.data());
+        }
+
+        const char *TraceLog::GetCategoryGroupName(const uint8_t *inCategoryFlag)
+        {
+            return GetCategoryGroupName(GetCategoryGroupIndex(inCategoryFlag));
+        }
+
+        const char *TraceLog::GetCategoryGroupName(uint16_t inCategoryIndex)
+        {
+            if (inCategoryIndex >= s_NumCategories.load(std::memory_order_acquire))
+            {
+                return s_CategoryNames[0].c_str();
+            }
+            return s_CategoryNames[inCategoryIndex].c_str();
+        }
+
+        uint64_t TraceLog::AddTraceEvent(char inPhase, const uint8_t *inCategoryFlag, const char *inName, const char *inScope,
+                                         uint64_t inId, uint32_t inFlags, int64_t inTimestamp, int inNumArgs, const TraceArg *inArgs)
+        {
+            if (s_Recording.load(std::memory_order_relaxed) == false)
+            {
+                return 0;
+            }
+            TraceBuffer *buffer = GetThreadBuffer();
+            if (buffer == nullptr)
+            {
+                return 0;
+            }
+            buffer->m_Writing.store(true);
+            // checked after saying we're writing so a pause either sees us or we see it
+            if (s_Recording.load() == false)
+            {
+                buffer->m_Writing.store(false);
+                return 0;
+            }
+
+            uint64_t sequence = buffer->m_Written.load(std::memory_order_relaxed);
+            TraceEvent &event = buffer->GetSlot(sequence);
+            event.m_Phase = inPhase;
+            event.m_CategoryIndex = GetCategoryGroupIndex(inCategoryFlag);
+            event.m_Scope = inScope;
+            event.m_Id = inId;
+            event.m_Flags = inFlags;
+            event.m_Timestamp = inTimestamp;
+            event.m_Duration = -1;
+            if (inFlags & kTraceFlagCopy)
+            {
+                event.m_Name = nullptr;
+                event.m_CopiedName = inName != nullptr ? inName : "";
+            }
+            else
+            {
+                event.m_Name = inName;
+                event.m_CopiedName.clear();
+            }
+            event.m_NumArgs = std::min(inNumArgs, kMaxTraceArgs);
+            for (int idx = 0; idx < event.m_NumArgs; idx++)
+            {
+                TraceArg &arg = event.m_Args[idx];
+                arg = inArgs[idx];
+                if ((inFlags & kTraceFlagCopy) && arg.m_Name != nullptr)
+                {
+                    arg.m_CopiedName = arg.m_Name;
+                    arg.m_Name = nullptr;
+                }
+            }
+
+            buffer->m_Written.store(sequence + 1, std::memory_order_release);
+            buffer->m_Writing.store(false, std::memory_order_release);
+            return (uint64_t(buffer->m_Id + 1) << kHandleBufferShift) | (sequence & kHandleSequenceMask);
+        }
+
+        void TraceLog::UpdateTraceEventDuration(uint64_t inHandle, int64_t inEndTimestamp)
+        {
+            if (inHandle == 0 || s_ThreadBuffer == nullptr)
+            {
+                return;
+            }
+            TraceBuffer *buffer = static_cast<TraceBuffer *>(s_ThreadBuffer);
+            if ((inHandle >> kHandleBufferShift) != uint64_t(buffer->m_Id + 1))
+            {
+                return;
+            }
+            uint64_t sequence = inHandle & kHandleSequenceMask;
+            buffer->m_Writing.store(true);
+            if (s_Recording.load())
+            {
+                buffer->SetDuration(sequence, inEndTimestamp);
+            }
+            else
+            {
+                // a reader may be copying the events so the end is kept till the next one
+                std::lock_guard<std::mutex> lock(buffer->m_PendingLock);
+                buffer->m_PendingEnds.emplace_back(sequence, inEndTimestamp);
+            }
+            buffer->m_Writing.store(false, std::memory_order_release);
+        }
+
+        std::vector<TraceThreadEvents> TraceLog::GetEvents()
+        {
+            std::vector<TraceThreadEvents> threads;
+            std::lock_guard<std::mutex> lock(s_Lock);
+            bool wasRecording = PauseRecording();
+            for (const TraceBufferSharedPtr &buffer : s_Buffers)
+            {
+                buffer->SetPendingDurations();
+                uint64_t written = buffer->m_Written.load(std::memory_order_acquire);
+                if (written == buffer->m_First)
+                {
+                    continue;
+                }
+                TraceThreadEvents &thread = threads.emplace_back();
+                thread.m_ThreadId = buffer->m_ThreadId;
+                thread.m_ThreadName = buffer->m_ThreadName;
+                size_t capacity = buffer->m_Capacity;
+                uint64_t first = std::max(buffer->m_First, written > capacity ? written - capacity : 0);
+                thread.m_Events.reserve(static_cast<size_t>(written - first));
+                for (uint64_t sequence = first; sequence < written; sequence++)
+                {
+                    thread.m_Events.push_back(buffer->m_Events[sequence % capacity]);
+                }
+            }
+            s_Recording = wasRecording;
+            return threads;
+        }
+
+        void TraceLog::Clear()
+        {
+            std::lock_guard<std::mutex> lock(s_Lock);
+            bool wasRecording = PauseRecording();
+            std::vector<TraceBufferSharedPtr> buffers;
+            for (TraceBufferSharedPtr &buffer : s_Buffers)
+            {
+                if (buffer->m_Exited)
+                {
+                    continue;
+                }
+                // the sequence keeps counting so the handles of cleared events are stale
+                buffer->m_First = buffer->m_Written.load(std::memory_order_relaxed);
+                buffer->m_Events.clear();
+                buffer->m_Events.shrink_to_fit();
+                {
+                    std::lock_guard<std::mutex> pendingLock(buffer->m_PendingLock);
+                    buffer->m_PendingEnds.clear();
+                }
+                buffers.push_back(std::move(buffer));
+            }
+            s_Buffers = std::move(buffers);
+            s_Recording = wasRecording;
+        }
+
+        void TraceLog::SetBufferSize(size_t inEvents)
+        {
+            s_BufferSize = std::max(size_t(1), inEvents);
+        }
+
+        TraceStateListenerId TraceLog::AddStateListener(TraceStateListener inListener)
+        {
+            std::lock_guard<std::mutex> lock(s_ListenerLock);
+            TraceStateListenerId id = s_NextListenerId++;
+            s_Listeners.emplace(id, std::move(inListener));
+            return id;
+        }
+
+        void TraceLog::RemoveStateListener(TraceStateListenerId inId)
+        {
+            std::lock_guard<std::mutex> lock(s_ListenerLock);
+            s_Listeners.erase(inId);
+        }
+
+        uint32_t TraceLog::GetProcessId()
+        {
+#if defined(V8APP_LINUX)
+            return static_cast<uint32_t>(::getpid());
+#else
+            return 1;
+#endif
+        }
+
+        uint32_t TraceLog::GetCurrentThreadId()
+        {
+#if defined(V8APP_LINUX)
+            return static_cast<uint32_t>(::syscall(SYS_gettid));
+#else
+            return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+        }
+
+        void TraceLog::UpdateCategoryFlags()
+        {
+            size_t numCategories = s_NumCategories.load(std::memory_order_relaxed);
+            for (size_t idx = 1; idx < numCategories; idx++)
+            {
+                uint8_t flag = s_Recording && IsCategoryGroupEnabledLocked(s_CategoryNames[idx]) ? kCategoryEnabledForRecording : 0;
+                std::atomic_ref<uint8_t>(s_CategoryFlags[idx]).store(flag, std::memory_order_relaxed);
+            }
+        }
+
+        bool TraceLog::IsCategoryGroupEnabledLocked(const std::string &inCategoryGroup)
+        {
+            size_t start = 0;
+            while (start <= inCategoryGroup.size())
+            {
+                size_t end = inCategoryGroup.find(',', start);
+                if (end == std::string::npos)
+                {
+                    end = inCategoryGroup.size();
+                }
+                std::string category = inCategoryGroup.substr(start, end - start);
+                start = end + 1;
+                if (category.empty() || s_ExcludedCategories.count(category))
+                {
+                    continue;
+                }
+                if (s_EnabledCategories.count(category))
+                {
+                    return true;
+                }
+                if (category.starts_with(kDisabledByDefaultPrefix))
+                {
+                    continue;
+                }
+                for (const std::string &pattern : s_EnabledCategories)
+                {
+                    if (pattern.ends_with('*') && category.starts_with(std::string_view(pattern).substr(0, pattern.size() - 1)))
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        bool TraceLog::PauseRecording()
+        {
+            bool wasRecording = s_Recording.exchange(false);
+            for (const TraceBufferSharedPtr &buffer : s_Buffers)
+            {
+                while (buffer->m_Writing.load())
+                {
+                    std::this_thread::yield();
+                }
+            }
+            return wasRecording;
+        }
+
+        TraceLog::TraceBuffer *TraceLog::GetThreadBuffer()
+        {
+            if (s_ThreadBuffer != nullptr || s_ThreadExited)
+            {
+                return static_cast<TraceBuffer *>(s_ThreadBuffer);
+            }
+            TraceBufferSharedPtr buffer;
+            {
+                std::lock_guard<std::mutex> lock(s_Lock);
+                buffer = std::make_shared<TraceBuffer>(s_NextBufferId++, s_BufferSize);
+                s_Buffers.push_back(buffer);
+            }
+            buffer->m_ThreadId = GetCurrentThreadId();
+#if defined(V8APP_LINUX)
+            char name[64] = {0};
+            if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0)
+            {
+                buffer->m_ThreadName = name;
+            }
+#endif
+            s_ThreadBuffer = buffer.get();
+            s_ThreadBufferRef.m_Buffer = buffer;
+            return buffer.get();
+        }
+
+        void TraceLog::ReleaseThreadBuffer(const TraceBufferSharedPtr &inBuffer)
+        {
+            s_ThreadBuffer = nullptr;
+            s_ThreadExited = true;
+
+            // the thread can't write anymore and holding the lock keeps readers out
+            std::lock_guard<std::mutex> lock(s_Lock);
+            auto it = std::find(s_Buffers.begin(), s_Buffers.end(), inBuffer);
+            if (it == s_Buffers.end())
+            {
+                return;
+            }
+            if (inBuffer->m_Written.load(std::memory_order_relaxed) == inBuffer->m_First)
+            {
+                s_Buffers.erase(it);
+                return;
+            }
+            inBuffer->SetPendingDurations();
+            inBuffer->m_Events.shrink_to_fit();
+            inBuffer->m_Exited = true;
+
+            // threads come and go with the elastic pools so only the latest exited ones are kept
+            size_t exited = std::count_if(s_Buffers.begin(), s_Buffers.end(), [](const TraceBufferSharedPtr &inExited)
+                                          { return inExited->m_Exited; });
+            if (exited > kMaxExitedTraceBuffers)
+            {
+                s_Buffers.erase(std::find_if(s_Buffers.begin(), s_Buffers.end(), [](const TraceBufferSharedPtr &inExited)
+                                             { return inExited->m_Exited; }));
+            }
+        }
+
+        void TraceLog::NotifyStateListeners(bool inTracing)
+        {
+            std::vector<TraceStateListener> listeners;
+            {
+                std::lock_guard<std::mutex> lock(s_ListenerLock);
+                for (const auto &it : s_Listeners)
+                {
+                    listeners.push_back(it.second);
+                }
+            }
+            for (TraceStateListener &listener : listeners)
+            {
+                listener(inTracing);
+            }
+        }
+    } // namespace Tracing
+} // namespace v8App
@@ -0,0 +1,467 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+
+#include "Tracing/TraceWriter.h"
+
+namespace v8App
+{
+    namespace Tracing
+    {
+        namespace
+        {
+            void WriteJSONString(std::ostream &inStream, const char *inString)
+            {
+                inStream << '"';
+                for (const char *c = inString == nullptr ? "" : inString; *c != '\0'; c++)
+                {
+                    switch (*c)
+                    {
+                    case '"':
+                        inStream << "\\\"";
+                        break;
+                    case '\\':
+                        inStream << "\\\\";
+                        break;
+                    case '\n':
+                        inStream << "\\n";
+                        break;
+                    case '\r':
+                        inStream << "\\r";
+                        break;
+                    case '\t':
+                        inStream << "\\t";
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(*c) < 0x20)
+                        {
+                            char escaped[8];
+                            snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                            inStream << escaped;
+                        }
+                        else
+                        {
+                            inStream << *c;
+                        }
+                    }
+                }
+                inStream << '"';
+            }
+
+            // chrome wants microseconds, keep the nanoseconds as the fraction
+            void WriteMicroseconds(std::ostream &inStream, int64_t inNanoseconds)
+            {
+                char buffer[32];
+                snprintf(buffer, sizeof(buffer), "%s%lld.%03lld", inNanoseconds < 0 ? "-" : "",
+                         static_cast<long long>(std::llabs(inNanoseconds) / 1000), static_cast<long long>(std::llabs(inNanoseconds) % 1000));
+                inStream << buffer;
+            }
+
+            std::string FormatPointer(uint64_t inValue)
+            {
+                char buffer[24];
+                snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(inValue));
+                return buffer;
+            }
+
+            void WriteJSONArgValue(std::ostream &inStream, const TraceArg &inArg)
+            {
+                switch (inArg.m_Type)
+                {
+                case TraceArgType::kBool:
+                    inStream << (inArg.m_Value ? "true" : "false");
+                    break;
+                case TraceArgType::kUInt:
+                    inStream << inArg.m_Value;
+                    break;
+                case TraceArgType::kInt:
+                    inStream << static_cast<int64_t>(inArg.m_Value);
+                    break;
+                case TraceArgType::kDouble:
+                {
+                    double value = std::bit_cast<double>(inArg.m_Value);
+                    // json has no nan or infinity so they go as strings like chrome does
+                    if (std::isnan(value))
+                    {
+                        inStream << "\"NaN\"";
+                    }
+                    else if (std::isinf(value))
+                    {
+                        inStream << (value < 0 ? "\"-Infinity\"" : "\"Infinity\"");
+                    }
+                    else
+                    {
+                        char buffer[32];
+                        snprintf(buffer, sizeof(buffer), "%.17g", value);
+                        inStream << buffer;
+                    }
+                    break;
+                }
+                case TraceArgType::kPointer:
+                    WriteJSONString(inStream, FormatPointer(inArg.m_Value).c_str());
+                    break;
+                case TraceArgType::kString:
+                    WriteJSONString(inStream, inArg.m_String.c_str());
+                    break;
+                case TraceArgType::kJSON:
+                    inStream << (inArg.m_String.empty() ? "null" : inArg.m_String);
+                    break;
+                default:
+                    inStream << "null";
+                }
+            }
+
+            void WriteJSONEvent(std::ostream &inStream, uint32_t inProcessId, uint32_t inThreadId, const TraceEvent &inEvent)
+            {
+                inStream << "{\"pid\":" << inProcessId << ",\"tid\":" << inThreadId << ",\"ts\":";
+                WriteMicroseconds(inStream, inEvent.m_Timestamp);
+                inStream << ",\"ph\":\"" << inEvent.m_Phase << "\",\"cat\":";
+                WriteJSONString(inStream, TraceLog::GetCategoryGroupName(inEvent.m_CategoryIndex));
+                inStream << ",\"name\":";
+                WriteJSONString(inStream, inEvent.GetName());
+                if (inEvent.m_Phase == kPhaseComplete)
+                {
+                    // one that never ended is shown as taking no time
+                    inStream << ",\"dur\":";
+                    WriteMicroseconds(inStream, std::max(int64_t(0), inEvent.m_Duration));
+                }
+                if (inEvent.m_Phase == kPhaseInstant)
+                {
+                    inStream << ",\"s\":\"t\"";
+                }
+                if (inEvent.m_Flags & kTraceFlagHasId)
+                {
+                    inStream << ",\"id\":\"" << FormatPointer(inEvent.m_Id) << '"';
+                }
+                if (inEvent.m_Scope != nullptr)
+                {
+                    inStream << ",\"scope\":";
+                    WriteJSONString(inStream, inEvent.m_Scope);
+                }
+                inStream << ",\"args\":{";
+                for (int idx = 0; idx < inEvent.m_NumArgs; idx++)
+                {
+                    if (idx != 0)
+                    {
+                        inStream << ',';
+                    }
+                    WriteJSONString(inStream, inEvent.m_Args[idx].GetName());
+                    inStream << ':';
+                    WriteJSONArgValue(inStream, inEvent.m_Args[idx]);
+                }
+                inStream << "}}";
+            }
+
+            // minimal protobuf wire format encoding, just what the perfetto trace needs
+            enum class WireType : uint32_t
+            {
+                kVarint = 0,
+                kFixed64 = 1,
+                kLengthDelimited = 2
+            };
+
+            void AppendVarint(std::string &inBuffer, uint64_t inValue)
+            {
+                while (inValue >= 0x80)
+                {
+                    inBuffer.push_back(static_cast<char>((inValue & 0x7F) | 0x80));
+                    inValue >>= 7;
+                }
+                inBuffer.push_back(static_cast<char>(inValue));
+            }
+
+            void AppendTag(std::string &inBuffer, uint32_t inField, WireType inType)
+            {
+                AppendVarint(inBuffer, (uint64_t(inField) << 3) | static_cast<uint32_t>(inType));
+            }
+
+            void AppendVarintField(std::string &inBuffer, uint32_t inField, uint64_t inValue)
+            {
+                AppendTag(inBuffer, inField, WireType::kVarint);
+                AppendVarint(inBuffer, inValue);
+            }
+
+            void AppendDoubleField(std::string &inBuffer, uint32_t inField, uint64_t inBits)
+            {
+                AppendTag(inBuffer, inField, WireType::kFixed64);
+                for (int idx = 0; idx < 8; idx++)
+                {
+                    inBuffer.push_back(static_cast<char>((inBits >> (idx * 8)) & 0xFF));
+                }
+            }
+
+            void AppendBytesField(std::string &inBuffer, uint32_t inField, const std::string &inValue)
+            {
+                AppendTag(inBuffer, inField, WireType::kLengthDelimited);
+                AppendVarint(inBuffer, inValue.size());
+                inBuffer.append(inValue);
+            }
+
+            void AppendStringField(std::string &inBuffer, uint32_t inField, const char *inValue)
+            {
+                AppendBytesField(inBuffer, inField, inValue == nullptr ? std::string() : std::string(inValue));
+            }
+
+            // field numbers from perfetto's protos/perfetto/trace
+            constexpr uint32_t kTracePacket = 1;
+            constexpr uint32_t kPacketTimestamp = 8;
+            constexpr uint32_t kPacketSequenceId = 10;
+            constexpr uint32_t kPacketTrackEvent = 11;
+            constexpr uint32_t kPacketClockId = 58;
+            constexpr uint32_t kPacketTrackDescriptor = 60;
+            constexpr uint32_t kTrackUuid = 1;
+            constexpr uint32_t kTrackName = 2;
+            constexpr uint32_t kTrackProcess = 3;
+            constexpr uint32_t kTrackThread = 4;
+            constexpr uint32_t kTrackParentUuid = 5;
+            constexpr uint32_t kProcessPid = 1;
+            constexpr uint32_t kThreadPid = 1;
+            constexpr uint32_t kThreadTid = 2;
+            constexpr uint32_t kThreadName = 5;
+            constexpr uint32_t kEventDebugAnnotation = 4;
+            constexpr uint32_t kEventType = 9;
+            constexpr uint32_t kEventTrackUuid = 11;
+            constexpr uint32_t kEventCategories = 22;
+            constexpr uint32_t kEventName = 23;
+            constexpr uint32_t kAnnotationBool = 2;
+            constexpr uint32_t kAnnotationUInt = 3;
+            constexpr uint32_t kAnnotationInt = 4;
+            constexpr uint32_t kAnnotationDouble = 5;
+            constexpr uint32_t kAnnotationString = 6;
+            constexpr uint32_t kAnnotationPointer = 7;
+            constexpr uint32_t kAnnotationJSON = 9;
+            constexpr uint32_t kAnnotationName = 10;
+
+            constexpr uint64_t kEventTypeSliceBegin = 1;
+            constexpr uint64_t kEventTypeSliceEnd = 2;
+            constexpr uint64_t kEventTypeInstant = 3;
+            // the steady clock is CLOCK_MONOTONIC
+            constexpr uint64_t kBuiltinClockMonotonic = 3;
+            constexpr uint64_t kSequenceId = 1;
+
+            void WritePacket(std::ostream &inStream, const std::string &inPacket)
+            {
+                std::string framed;
+                AppendBytesField(framed, kTracePacket, inPacket);
+                inStream.write(framed.data(), framed.size());
+            }
+
+            std::string EncodeAnnotation(const TraceArg &inArg)
+            {
+                std::string annotation;
+                AppendStringField(annotation, kAnnotationName, inArg.GetName());
+                switch (inArg.m_Type)
+                {
+                case TraceArgType::kBool:
+                    AppendVarintField(annotation, kAnnotationBool, inArg.m_Value ? 1 : 0);
+                    break;
+                case TraceArgType::kUInt:
+                    AppendVarintField(annotation, kAnnotationUInt, inArg.m_Value);
+                    break;
+                case TraceArgType::kInt:
+                    AppendVarintField(annotation, kAnnotationInt, inArg.m_Value);
+                    break;
+                case TraceArgType::kDouble:
+                    AppendDoubleField(annotation, kAnnotationDouble, inArg.m_Value);
+                    break;
+                case TraceArgType::kPointer:
+                    AppendVarintField(annotation, kAnnotationPointer, inArg.m_Value);
+                    break;
+                case TraceArgType::kString:
+                    AppendBytesField(annotation, kAnnotationString, inArg.m_String);
+                    break;
+                case TraceArgType::kJSON:
+                    AppendBytesField(annotation, kAnnotationJSON, inArg.m_String);
+                    break;
+                default:
+                    break;
+                }
+                return annotation;
+            }
+
+            void WriteTrackEvent(std::ostream &inStream, uint64_t inTrackUuid, int64_t inTimestamp, uint64_t inType, const TraceEvent *inEvent)
+            {
+                std::string trackEvent;
+                AppendVarintField(trackEvent, kEventType, inType);
+                AppendVarintField(trackEvent, kEventTrackUuid, inTrackUuid);
+                // ends match the open slice on the track so they don't need the rest
+                if (inType != kEventTypeSliceEnd)
+                {
+                    AppendStringField(trackEvent, kEventCategories, TraceLog::GetCategoryGroupName(inEvent->m_CategoryIndex));
+                    AppendStringField(trackEvent, kEventName, inEvent->GetName());
+                    for (int idx = 0; idx < inEvent->m_NumArgs; idx++)
+                    {
+                        AppendBytesField(trackEvent, kEventDebugAnnotation, EncodeAnnotation(inEvent->m_Args[idx]));
+                    }
+                }
+
+                std::string packet;
+                AppendVarintField(packet, kPacketTimestamp, static_cast<uint64_t>(inTimestamp));
+                AppendVarintField(packet, kPacketClockId, kBuiltinClockMonotonic);
+                AppendVarintField(packet, kPacketSequenceId, kSequenceId);
+                AppendBytesField(packet, kPacketTrackEvent, trackEvent);
+                WritePacket(inStream, packet);
+            }
+
+            void WriteTrackDescriptor(std::ostream &inStream, uint64_t inUuid, uint64_t inParentUuid, uint32_t inProcessId,
+                                      const TraceThreadEvents *inThread)
+            {
+                std::string track;
+                AppendVarintField(track, kTrackUuid, inUuid);
+                if (inThread == nullptr)
+                {
+                    std::string process;
+                    AppendVarintField(process, kProcessPid, inProcessId);
+                    AppendBytesField(track, kTrackProcess, process);
+                }
+                else
+                {
+                    AppendVarintField(track, kTrackParentUuid, inParentUuid);
+                    if (inThread->m_ThreadName.empty() == false)
+                    {
+                        AppendBytesField(track, kTrackName, inThread->m_ThreadName);
+                    }
+                    std::string thread;
+                    AppendVarintField(thread, kThreadPid, inProcessId);
+                    AppendVarintField(thread, kThreadTid, inThread->m_ThreadId);
+                    if (inThread->m_ThreadName.empty() == false)
+                    {
+                        AppendBytesField(thread, kThreadName, inThread->m_ThreadName);
+                    }
+                    AppendBytesField(track, kTrackThread, thread);
+                }
+
+                std::string packet;
+                AppendVarintField(packet, kPacketSequenceId, kSequenceId);
+                AppendBytesField(packet, kPacketTrackDescriptor, track);
+                WritePacket(inStream, packet);
+            }
+
+            struct SliceEdge
+            {
+                int64_t m_Timestamp;
+                uint64_t m_Type;
+                // where the edge goes among others with the same timestamp
+                int64_t m_Order;
+                const TraceEvent *m_Event;
+            };
+        } // namespace
+
+        bool TraceWriter::WriteChromeJSON(std::ostream &inStream, const std::vector<TraceThreadEvents> &inEvents)
+        {
+            uint32_t processId = TraceLog::GetProcessId();
+            inStream << "{\"traceEvents\":[";
+            bool first = true;
+            for (const TraceThreadEvents &thread : inEvents)
+            {
+                if (thread.m_ThreadName.empty() == false)
+                {
+                    inStream << (first ? "" : ",") << "{\"pid\":" << processId << ",\"tid\":" << thread.m_ThreadId
+                             << ",\"ts\":0,\"ph\":\"M\",\"cat\":\"__metadata\",\"name\":\"thread_name\",\"args\":{\"name\":";
+                    WriteJSONString(inStream, thread.m_ThreadName.c_str());
+                    inStream << "}}";
+                    first = false;
+                }
+                for (const TraceEvent &event : thread.m_Events)
+                {
+                    if (first == false)
+                    {
+                        inStream << ',';
+                    }
+                    WriteJSONEvent(inStream, processId, thread.m_ThreadId, event);
+                    first = false;
+                }
+            }
+            inStream << "],\"displayTimeUnit\":\"ns\"}";
+            return inStream.good();
+        }
+
+        bool TraceWriter::WriteChromeJSONFile(const std::filesystem::path &inFilePath)
+        {
+            std::ofstream file(inFilePath, std::ios::out | std::ios::trunc);
+            if (file.is_open() == false)
+            {
+                return false;
+            }
+            return WriteChromeJSON(file, TraceLog::GetEvents());
+        }
+
+        bool TraceWriter::WritePerfetto(std::ostream &inStream, const std::vector<TraceThreadEvents> &inEvents)
+        {
+            uint32_t processId = TraceLog::GetProcessId();
+            uint64_t processUuid = processId;
+            WriteTrackDescriptor(inStream, processUuid, 0, processId, nullptr);
+
+            for (const TraceThreadEvents &thread : inEvents)
+            {
+                uint64_t threadUuid = (uint64_t(processId) << 32) | thread.m_ThreadId;
+                WriteTrackDescriptor(inStream, threadUuid, processUuid, processId, &thread);
+
+                // complete events are split into a begin and end so they have to be put back in time order
+                std::vector<SliceEdge> edges;
+                edges.reserve(thread.m_Events.size() * 2);
+                int64_t sequence = 0;
+                for (const TraceEvent &event : thread.m_Events)
+                {
+                    sequence++;
+                    switch (event.m_Phase)
+                    {
+                    case kPhaseBegin:
+                        edges.push_back({event.m_Timestamp, kEventTypeSliceBegin, sequence, &event});
+                        break;
+                    case kPhaseEnd:
+                        edges.push_back({event.m_Timestamp, kEventTypeSliceEnd, sequence, &event});
+                        break;
+                    case kPhaseComplete:
+                        if (event.m_Duration < 0)
+                        {
+                            // never ended so there's no slice to show
+                            edges.push_back({event.m_Timestamp, kEventTypeInstant, sequence, &event});
+                            break;
+                        }
+                        edges.push_back({event.m_Timestamp, kEventTypeSliceBegin, sequence, &event});
+                        // the inner slice started later so it has to end first
+                        edges.push_back({event.m_Timestamp + event.m_Duration, kEventTypeSliceEnd, -sequence, &event});
+                        break;
+                    case kPhaseInstant:
+                        edges.push_back({event.m_Timestamp, kEventTypeInstant, sequence, &event});
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                std::stable_sort(edges.begin(), edges.end(), [](const SliceEdge &inLeft, const SliceEdge &inRight)
+                                 {
+                                     // at the same time ends go before anything that starts
+                                     int leftRank = inLeft.m_Type == kEventTypeSliceEnd ? 0 : 1;
+                                     int rightRank = inRight.m_Type == kEventTypeSliceEnd ? 0 : 1;
+                                     return std::tie(inLeft.m_Timestamp, leftRank, inLeft.m_Order) <
+                                            std::tie(inRight.m_Timestamp, rightRank, inRight.m_Order); });
+
+                for (const SliceEdge &edge : edges)
+                {
+                    WriteTrackEvent(inStream, threadUuid, edge.m_Timestamp, edge.m_Type, edge.m_Event);
+                }
+            }
+            return inStream.good();
+        }
+
+        bool TraceWriter::WritePerfettoFile(const std::filesystem::path &inFilePath)
+        {
+            std::ofstream file(inFilePath, std::ios::out | std::ios::trunc | std::ios::binary);
+            if (file.is_open() == false)
+            {
+                return false;
+            }
+            return WritePerfetto(file, TraceLog::GetEvents());
+        }
+    } // namespace Tracing
+} // namespace v8App
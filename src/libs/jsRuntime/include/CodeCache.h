@@ -7,8 +7,11 @@
 
 #include <filesystem>
 #include <map>
+#include <memory>
+#include <mutex>
 
 #include "Assets/AppAssetRoots.h"
+#include "Memory/MemoryPressure.h"
 
 #include "V8Types.h"
 #include "JSApp.h"
@@ -30,10 +33,7 @@ namespace v8App
             {
                 ~ScriptCacheInfo()
                 {
-                    if (m_Compiled != nullptr)
-                    {
-                        delete m_Compiled;
-                    }
+                    delete[] m_Compiled;
                     m_Compiled = nullptr;
                     m_CompiledLength = 0;
                 }
@@ -54,6 +54,12 @@ namespace v8App
             V8ScriptSourceUniquePtr LoadScriptFile(std::filesystem::path inFilePath, V8Isolate *inIsolate);
             bool HasCodeCache(std::filesystem::path inFilePath);
             bool SetCodeCache(std::filesystem::path inFilePath, V8ScriptCachedData *inCachedData);
+            /**
+             * Drops the loaded sources and code cache data, they're read back from the files on the next
+             * load. Can be called from any thread, does nothing if the cache is in use at the time.
+             */
+            void PurgeMemory();
+            size_t GetNumberOfCachedScripts();
 
         protected:
             ScriptCacheInfo *GetCachedScript(std::string inFilePath);
@@ -67,8 +73,12 @@ namespace v8App
 
             using ScriptCacheMap = std::map<std::filesystem::path, std::unique_ptr<ScriptCacheInfo>>;
 
+            // guards m_ScriptCache since it can be purged from any thread
+            std::mutex m_CacheLock;
             ScriptCacheMap m_ScriptCache;
             JSAppSharedPtr m_App;
+            // purges the cache under memory pressure
+            std::unique_ptr<Memory::ScopedReclaimCallback> m_ReclaimCallback;
 
             CodeCache(const CodeCache &) = delete;
             CodeCache(CodeCache &&) = delete;
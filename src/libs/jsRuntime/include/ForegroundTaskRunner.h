@@ -5,11 +5,16 @@
 #ifndef _FOREGROUND_TASK_RUNNER_H_
 #define _FOREGROUND_TASK_RUNNER_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <queue>
 #include <mutex>
+#include <optional>
 #include <tuple>
 
 #include "Queues/TThreadSafeQueue.h"
+#include "Time/Clock.h"
 
 #include "NestableQueue.h"
 #include "V8Types.h"
@@ -35,6 +40,9 @@ namespace v8App
             };
 
         public:
+            // called when something is posted so an external run loop can wake up
+            using WakeDelegate = std::function<void()>;
+
             explicit ForegroundTaskRunner();
             ~ForegroundTaskRunner();
 
@@ -43,10 +51,35 @@ namespace v8App
             // get a idle task from the queue
             V8IdleTaskUniquePtr GetNextIdleTask();
 
+            /**
+             * Posts a delayed task returning an id that can cancel it before it's due, for timers like
+             * debounces and retries that are usually canceled. Canceling frees the task straight away.
+             */
+            Queues::TimerId PostCancelableDelayedTask(V8TaskUniquePtr inTask, double inDelaySeconds);
+            Queues::TimerId PostCancelableNonNestableDelayedTask(V8TaskUniquePtr inTask, double inDelaySeconds);
+            // returns false if the task already came due or was canceled
+            bool CancelDelayedTask(Queues::TimerId inId) { return m_Tasks.CancelItem(inId); }
+
             bool MaybeHasTask() { return m_Tasks.MayHaveItems(); }
             bool MaybeHasIdleTask() { return m_IdleTasks.MayHaveItems(); }
+            // the deadline of the next delayed task if there is one
+            std::optional<double> GetNextDelayedDeadline() { return m_Tasks.GetNextDeadline(); }
+
+            /**
+             * Blocks till a task is ready, the next delayed task comes due, Wake is called or inMaxWaitSeconds
+             * pass. A negative wait has no limit. Returns false if it timed out or the runner is terminated.
+             */
+            bool WaitForWork(double inMaxWaitSeconds = -1);
+            // wakes up a thread in WaitForWork, can be called from any thread
+            void Wake();
+            /**
+             * Sets a delegate that's called along with waking WaitForWork, for run loops that wait on something
+             * else like a uv loop. It's called on the posting thread so it should only signal the loop.
+             */
+            void SetWakeDelegate(WakeDelegate inDelegate);
 
             void Terminate();
+            bool IsTerminated() const { return m_Terminated; }
 
             // TaskRunner implementation
         public:
@@ -63,11 +96,25 @@ namespace v8App
             // end TaskRunner implementation
 
         protected:
-            bool m_Terminated = false;
+            // lets a waiting thread know something was posted
+            void NotifyWaiter();
+            // lets a waiting thread know the time jumped so it works out it's wait again
+            void NotifyClockChanged();
+
+            std::atomic_bool m_Terminated{false};
+            std::mutex m_WaitLock;
+            std::condition_variable m_WaitCondition;
+            // set when there's something the waiter needs to look at, guarded by m_WaitLock
+            bool m_WaitSignaled = false;
+            // set when the time jumped while waiting, guarded by m_WaitLock
+            bool m_ClockChanged = false;
+            // guarded by m_WaitLock so it can't be cleared while it's being called
+            WakeDelegate m_WakeDelegate;
 
             NestableQueue m_Tasks;
             Queues::TThreadSafeQueue<V8IdleTaskUniquePtr> m_IdleTasks;
             int m_NestingDepth = 0;
+            std::unique_ptr<Time::ScopedClockChangedCallback> m_ClockChangedCallback;
         };
     } // namespace JSRuntime
 } // namespace v8App
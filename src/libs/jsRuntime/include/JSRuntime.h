@@ -5,15 +5,18 @@
 #ifndef _JS_RUNTIME_H_
 #define _JS_RUNTIME_H_
 
+#include <atomic>
 #include <memory>
 #include <map>
 #include <filesystem>
 
 #include "Containers/NamedIndexes.h"
+#include "Memory/MemoryPressure.h"
 
 #include "ForegroundTaskRunner.h"
 #include "ISnapshotHandleCloser.h"
 #include "IJSPlatformRuntimeProvider.h"
+#include "V8AppPageAllocator.h"
 #include "V8Types.h"
 #include "ISnapshotObject.h"
 #include "JSRuntimeSnapData.h"
@@ -24,6 +27,27 @@ namespace v8App
     namespace JSRuntime
     {
         class JSContext;
+        class UVRunLoop;
+        class V8AppHighAllocationObserver;
+
+        // default time in seconds DrainTasks can run tasks for before returning
+        constexpr double kDefaultTaskDrainBudget = 0.005;
+        // default number of tasks DrainTasks runs before returning
+        constexpr size_t kDefaultTaskDrainMaxTasks = 64;
+        // longest the run loop runs idle tasks for before checking for other work
+        constexpr double kRunLoopIdleSlice = 0.05;
+
+        /**
+         * What a call to DrainTasks did
+         */
+        struct TaskDrainStats
+        {
+            size_t m_TasksRun = 0;
+            // time spent in the drain including taking the isolate lock
+            double m_Seconds = 0;
+            // stopped on the time budget or task count with tasks still ready
+            bool m_HitLimit = false;
+        };
 
         /**
          * Class that wrapps the v8 Isolate and provides a variety of utilitied related to it
@@ -77,11 +101,41 @@ namespace v8App
              * Runs the isolates tasks
              */
             void ProcessTasks();
+            /**
+             * Runs ready tasks under a single isolate lock till there are none left, inTimeBudget
+             * seconds have passed or inMaxTasks have run. Non nestable tasks are skipped when called
+             * from inside another task.
+             */
+            TaskDrainStats DrainTasks(double inTimeBudget = kDefaultTaskDrainBudget, size_t inMaxTasks = kDefaultTaskDrainMaxTasks);
+
+            /**
+             * Runs the runtime's tasks till QuitRunLoop is called or the task runner is terminated. When
+             * there's nothing to run it runs the idle tasks and then sleeps till a task is posted, a delayed
+             * task comes due or WakeRunLoop is called so an idle runtime doesn't use any cpu.
+             * Call it from the thread that owns the runtime and not from inside a task.
+             */
+            void RunLoop();
+            // makes RunLoop return once the task it's running is done, can be called from any thread
+            void QuitRunLoop();
+            // wakes RunLoop up to check for work, can be called from any thread
+            void WakeRunLoop();
+            /**
+             * Gets the runtime's uv run loop creating it on first use. Native modules register their uv
+             * handles on it's loop and once it exists RunLoop runs the tasks from the uv loop instead.
+             * Call it from the thread that owns the runtime.
+             */
+            UVRunLoop *GetUVRunLoop();
             /**
              * Runs the idle tasks for the isolate4
              */
             void ProcessIdleTasks(double inTimeLeft);
 
+            /**
+             * The pages the page allocator reserved for the isolate on the runtime's thread, only
+             * filled in when the platform is using a V8AppPageAllocator
+             */
+            V8AppPageAccountSharedPtr GetPageAccount() { return m_PageAccount; }
+
             /**
              * Sets the function template for normal functions bound to the global object
              */
@@ -236,6 +290,11 @@ namespace v8App
              */
             bool CreateIsolate();
 
+            /**
+             * Registers the callback that passes memory pressure on to the isolate
+             */
+            void RegisterReclaimCallback();
+
             /**
              * Clones the passin runtime for snapshotting. This will onyl copy contextex
              * that support snapshotting, runs the snap shot entry point if specified or the entry point script
@@ -291,6 +350,32 @@ namespace v8App
              */
             std::shared_ptr<ForegroundTaskRunner> m_TaskRunner;
 
+            /**
+             * Set to have the run loop return
+             */
+            std::atomic_bool m_QuitRunLoop{false};
+
+            /**
+             * Optional uv backend for the run loop, only created if asked for
+             */
+            std::unique_ptr<UVRunLoop> m_UVRunLoop;
+
+            /**
+             * Passes process memory pressure on to the isolate
+             */
+            std::unique_ptr<Memory::ScopedReclaimCallback> m_ReclaimCallback;
+
+            /**
+             * Pages reserved while the isolate is created or running it's tasks are charged to it
+             */
+            V8AppPageAccountSharedPtr m_PageAccount;
+
+            /**
+             * The platform's observer the isolate was created with, nullptr if it isn't a
+             * V8AppHighAllocationObserver. Like v8 we count on it outliving the isolate
+             */
+            V8AppHighAllocationObserver *m_HighAllocObserver = nullptr;
+
             /**
              * Atruct that holds info about the function template
              */
@@ -47,10 +47,14 @@ namespace v8App
             }
 
             void PushItem(V8TaskUniquePtr inItem);
-            void PushItemDelayed(double inDelaySeconds, V8TaskUniquePtr inItem);
+            // the delayed pushes return an id that can be passed to CancelItem
+            Queues::TimerId PushItemDelayed(double inDelaySeconds, V8TaskUniquePtr inItem);
 
             void PushNonNestableItem(V8TaskUniquePtr inItem);
-            void PushNonNestableItemDelayed(double inDelaySeconds, V8TaskUniquePtr inItem);
+            Queues::TimerId PushNonNestableItemDelayed(double inDelaySeconds, V8TaskUniquePtr inItem);
+
+            using TThreadSafeDelayedQueue::CancelItem;
+            using TThreadSafeDelayedQueue::GetNextDeadline;
 
             std::optional<V8TaskUniquePtr> GetNextItem(int inNestingDepth);
             virtual bool MayHaveItems() override;
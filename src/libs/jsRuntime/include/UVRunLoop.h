@@ -0,0 +1,78 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _UV_RUN_LOOP_H_
+#define _UV_RUN_LOOP_H_
+
+#include <atomic>
+#include <memory>
+
+#include "uv.h"
+
+#include "ForegroundTaskRunner.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        class JSRuntime;
+
+        /**
+         * Run loop backend that drives a runtime's foreground, delayed and idle tasks from a uv loop so
+         * native modules can put their timers, fs requests and pipes on the same loop as the isolate.
+         * Posted tasks wake the loop through an async handle, delayed tasks arm a uv timer for the next
+         * deadline and idle tasks run from an idle handle only when there's nothing else to do.
+         * Everything but Stop has to be called on the thread that runs the runtime.
+         */
+        class UVRunLoop
+        {
+        public:
+            UVRunLoop(JSRuntime *inRuntime, std::shared_ptr<ForegroundTaskRunner> inRunner);
+            ~UVRunLoop();
+
+            UVRunLoop(const UVRunLoop &) = delete;
+            UVRunLoop &operator=(const UVRunLoop &) = delete;
+
+            /**
+             * The loop native modules register their handles on. Handles still open when the run loop is
+             * destroyed are closed without a callback so modules should close their own first.
+             */
+            uv_loop_t *GetLoop() { return &m_Loop; }
+
+            // runs the loop till Stop is called or the task runner is terminated
+            void Run();
+            // makes Run return, can be called from any thread
+            void Stop();
+            // points the loop at the runtime it's been moved to, only while the loop isn't running
+            void SetRuntime(JSRuntime *inRuntime);
+
+        protected:
+            static void OnWake(uv_async_t *inHandle);
+            static void OnDelayedTimer(uv_timer_t *inHandle);
+            static void OnIdle(uv_idle_t *inHandle);
+            static void OnPrepare(uv_prepare_t *inHandle);
+
+            // arms the idle handle and delayed timer for what's queued before the loop polls
+            void ScheduleWork();
+            // runs the ready tasks or if there are none the idle tasks
+            void RunWork();
+            bool ShouldStop() { return m_Stop || m_TaskRunner->IsTerminated(); }
+
+            JSRuntime *m_Runtime;
+            std::shared_ptr<ForegroundTaskRunner> m_TaskRunner;
+            std::atomic_bool m_Stop{false};
+
+            uv_loop_t m_Loop;
+            // signaled from any thread when a task is posted
+            uv_async_t m_WakeHandle;
+            // fires when the next delayed task is due
+            uv_timer_t m_DelayedTimer;
+            // keeps the loop from blocking while there are tasks or idle tasks ready
+            uv_idle_t m_IdleHandle;
+            uv_prepare_t m_PrepareHandle;
+        };
+    } // namespace JSRuntime
+} // namespace v8App
+
+#endif //_UV_RUN_LOOP_H_
@@ -0,0 +1,91 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _V8APP_HIGH_ALLOCATION_OBSERVER_H_
+#define _V8APP_HIGH_ALLOCATION_OBSERVER_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+#include "v8/v8-platform.h"
+
+#include "V8Types.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        struct V8AppHighAllocationObserverOptions
+        {
+            // let v8's best effort background work use every worker while an allocation burst is on
+            bool m_BoostWorkers = false;
+            // hold off on idle tasks for an isolate while it's in an allocation burst
+            bool m_PauseIdleTasks = false;
+        };
+
+        struct V8AppHighAllocationStats
+        {
+            // number of bursts entered
+            size_t m_Sections = 0;
+            // nesting depth of the burst going on now, 0 when there isn't one
+            size_t m_ActiveSections = 0;
+            int64_t m_TotalNanoseconds = 0;
+            int64_t m_LongestNanoseconds = 0;
+            // when the burst going on now started
+            int64_t m_EnterTime = 0;
+        };
+
+        // called with true when the first burst starts and false when the last one ends
+        using V8AppHighAllocationListener = std::function<void(bool)>;
+
+        /**
+         * Tracks the sections v8 reports as having a high throughput of allocations for each isolate.
+         * v8 doesn't say which isolate a section is for so it's charged to the isolate entered on the
+         * calling thread, sections from threads without one are charged to nullptr. The platform
+         * listens for bursts starting and ending to adjust it's workers and idle work for them.
+         */
+        class V8AppHighAllocationObserver : public V8HighAllocationThroughputObserver
+        {
+        public:
+            explicit V8AppHighAllocationObserver(const V8AppHighAllocationObserverOptions &inOptions = V8AppHighAllocationObserverOptions());
+            virtual ~V8AppHighAllocationObserver() = default;
+
+            // v8::HighAllocationThroughputObserver interface
+            void EnterSection() override;
+            void LeaveSection() override;
+            // end v8::HighAllocationThroughputObserver interface
+
+            void EnterSection(V8Isolate *inIsolate);
+            void LeaveSection(V8Isolate *inIsolate);
+
+            const V8AppHighAllocationObserverOptions &GetOptions() const { return m_Options; }
+            void SetListener(V8AppHighAllocationListener inListener);
+
+            bool IsInSection(V8Isolate *inIsolate);
+            // true if the isolate is in a burst and the options say to hold off on idle tasks
+            bool ShouldPauseIdleTasks(V8Isolate *inIsolate);
+            V8AppHighAllocationStats GetStats(V8Isolate *inIsolate);
+            // the stats for every isolate added together, including ones that have been removed
+            V8AppHighAllocationStats GetTotalStats();
+            // drops the isolate's stats when it's disposed so a new isolate at the same address starts fresh
+            void RemoveIsolate(V8Isolate *inIsolate);
+            void DumpStats(std::ostream &inStream);
+
+        protected:
+            V8AppHighAllocationObserverOptions m_Options;
+
+            std::mutex m_Lock;
+            std::map<V8Isolate *, V8AppHighAllocationStats> m_Stats;
+            V8AppHighAllocationStats m_Removed;
+            // isolates in a burst right now
+            size_t m_ActiveIsolates = 0;
+            V8AppHighAllocationListener m_Listener;
+        };
+    } // namespace JSRuntime
+} // namespace v8App
+
+#endif //_V8APP_HIGH_ALLOCATION_OBSERVER_H_
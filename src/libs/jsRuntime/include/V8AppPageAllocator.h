@@ -0,0 +1,191 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _V8APP_PAGE_ALLOCATOR_H_
+#define _V8APP_PAGE_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+
+#include "v8/v8-platform.h"
+
+#include "V8Types.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        /**
+         * How pages v8 no longer needs are given back to the os.
+         * kDontNeed frees them right away so the rss drops straight away.
+         * kFree lets the kernel take them lazily when it needs the memory which is cheaper if they're
+         * reused soon, falls back to kDontNeed on kernels without MADV_FREE.
+         */
+        enum class PageDiscardPolicy
+        {
+            kDontNeed,
+            kFree
+        };
+
+        struct V8AppPageAllocatorOptions
+        {
+            // ask for transparent huge pages on large reservations to cut down on tlb misses
+            bool m_UseHugePages = false;
+            // reservations at least this big are huge page aligned and advised
+            size_t m_HugePageThreshold = 8 * 1024 * 1024;
+            PageDiscardPolicy m_DiscardPolicy = PageDiscardPolicy::kFree;
+        };
+
+        /**
+         * Bytes of pages charged to an owner, usually a runtime's isolate. Reserved bytes are the address
+         * space reserved while the account was current. Committed bytes are the pages given access while
+         * it was current, which includes the pages v8 commits out of a reservation made somewhere else
+         * like the pointer compression cage.
+         */
+        class V8AppPageAccount
+        {
+        public:
+            V8AppPageAccount(std::string inName) : m_Name(inName) {}
+
+            const std::string &GetName() const { return m_Name; }
+            size_t GetReservedBytes() const { return m_ReservedBytes; }
+            size_t GetPeakReservedBytes() const { return m_PeakReservedBytes; }
+            size_t GetCommittedBytes() const { return m_CommittedBytes; }
+            size_t GetPeakCommittedBytes() const { return m_PeakCommittedBytes; }
+
+            void AddReserved(size_t inBytes);
+            void RemoveReserved(size_t inBytes);
+            void AddCommitted(size_t inBytes);
+            void RemoveCommitted(size_t inBytes);
+
+        protected:
+            std::string m_Name;
+            std::atomic_size_t m_ReservedBytes{0};
+            std::atomic_size_t m_PeakReservedBytes{0};
+            std::atomic_size_t m_CommittedBytes{0};
+            std::atomic_size_t m_PeakCommittedBytes{0};
+        };
+
+        using V8AppPageAccountSharedPtr = std::shared_ptr<V8AppPageAccount>;
+
+        /**
+         * Charges the pages the allocator reserves or commits on this thread to the account for it's lifetime.
+         * Pages reserved on threads without a scope, like v8's gc workers, go to the allocator's
+         * shared account.
+         */
+        class V8AppPageAccountScope
+        {
+        public:
+            explicit V8AppPageAccountScope(V8AppPageAccountSharedPtr inAccount);
+            ~V8AppPageAccountScope();
+
+            V8AppPageAccountScope(const V8AppPageAccountScope &) = delete;
+            V8AppPageAccountScope &operator=(const V8AppPageAccountScope &) = delete;
+
+            static V8AppPageAccountSharedPtr GetCurrentAccount();
+
+        private:
+            V8AppPageAccountSharedPtr m_Previous;
+        };
+
+        struct V8AppPageAllocatorStats
+        {
+            size_t m_ReservedBytes = 0;
+            size_t m_CommittedBytes = 0;
+            size_t m_DiscardedBytes = 0;
+            size_t m_DecommittedBytes = 0;
+            size_t m_HugePageBytes = 0;
+        };
+
+        /**
+         * Linux page allocator for v8 and cppgc. Reserving address space and committing it are kept
+         * apart, a reservation is mapped no access and no reserve so it costs no memory till v8 gives
+         * part of it access. Large reservations can be huge page aligned and advised to use
+         * transparent huge pages and discarded pages are given back with the configured madvise policy.
+         * Every reservation is charged to the account of the thread that made it and every commit to the
+         * account of the thread that gave the pages access.
+         */
+        class V8AppPageAllocator : public V8PageAllocator
+        {
+        public:
+            explicit V8AppPageAllocator(const V8AppPageAllocatorOptions &inOptions = V8AppPageAllocatorOptions());
+            ~V8AppPageAllocator() override = default;
+
+            // v8::PageAllocator interface
+            size_t AllocatePageSize() override { return m_AllocatePageSize; }
+            size_t CommitPageSize() override { return m_CommitPageSize; }
+            void SetRandomMmapSeed(int64_t inSeed) override;
+            void *GetRandomMmapAddr() override;
+            void *AllocatePages(void *inAddress, size_t inLength, size_t inAlignment, Permission inPermissions) override;
+            bool FreePages(void *inAddress, size_t inLength) override;
+            bool ReleasePages(void *inAddress, size_t inLength, size_t inNewLength) override;
+            bool SetPermissions(void *inAddress, size_t inLength, Permission inPermissions) override;
+            bool RecommitPages(void *inAddress, size_t inLength, Permission inPermissions) override;
+            bool DiscardSystemPages(void *inAddress, size_t inSize) override;
+            bool DecommitPages(void *inAddress, size_t inSize) override;
+            // end v8::PageAllocator interface
+
+            const V8AppPageAllocatorOptions &GetOptions() const { return m_Options; }
+            V8AppPageAllocatorStats GetStats();
+            // the account for pages reserved outside of any V8AppPageAccountScope
+            V8AppPageAccountSharedPtr GetSharedAccount() { return m_SharedAccount; }
+
+        protected:
+            struct PageRange
+            {
+                size_t m_Length;
+                bool m_HugePages;
+                V8AppPageAccountSharedPtr m_Account;
+            };
+            // non overlapping ranges keyed by their start address
+            using PageRangeMap = std::map<uintptr_t, PageRange>;
+
+            // maps the pages for the reservation with inAlignment, nullptr on failure
+            void *Reserve(void *inHint, size_t inLength, size_t inAlignment);
+            // returns true if the kernel took the advice
+            bool AdviseHugePages(void *inAddress, size_t inLength);
+            void TrackReservation(void *inAddress, size_t inLength, bool inHugePages);
+            /**
+             * Returns true if every page in the range is already committed. Only takes the lock shared so
+             * flipping the permissions of committed pages, like v8 does for W^X, doesn't serialize the flips.
+             */
+            bool IsCommitted(void *inAddress, size_t inLength);
+            // charges the parts of the range that aren't already committed to the current account
+            void TrackCommit(void *inAddress, size_t inLength);
+            // takes the range out of the reservations and commits wherever it falls, splitting the ones it only
+            // partly covers, and credits their accounts
+            void UntrackReservation(void *inAddress, size_t inLength);
+            void UntrackCommit(void *inAddress, size_t inLength);
+            void RemoveRanges(PageRangeMap &inRanges, uintptr_t inStart, size_t inLength, bool inCommitted);
+            V8AppPageAccountSharedPtr GetCurrentAccount();
+
+            V8AppPageAllocatorOptions m_Options;
+            size_t m_AllocatePageSize;
+            size_t m_CommitPageSize;
+
+            std::mutex m_RandomLock;
+            std::mt19937_64 m_Random;
+
+            // taken shared when just checking the ranges
+            std::shared_mutex m_ReservationLock;
+            PageRangeMap m_Reservations;
+            PageRangeMap m_Commits;
+            V8AppPageAccountSharedPtr m_SharedAccount;
+
+            std::atomic_size_t m_DiscardedBytes{0};
+            std::atomic_size_t m_DecommittedBytes{0};
+            std::atomic_size_t m_HugePageBytes{0};
+            // set once the kernel says it doesn't know MADV_FREE
+            std::atomic_bool m_NoMadvFree{false};
+        };
+    } // namespace JSRuntime
+} // namespace v8App
+
+#endif //_V8APP_PAGE_ALLOCATOR_H_
@@ -6,18 +6,38 @@
 #define _V8APP_PLATFORM_H_
 
 #include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
 
 #include "v8/v8-platform.h"
 #include "v8/cppgc/platform.h"
 
 #include "ForegroundTaskRunner.h"
 #include "WorkerTaskRunner.h"
+#include "Threads/ScopedBlockingCall.h"
+#include "Threads/ThreadPoolLaneQueue.h"
+#include "V8AppHighAllocationObserver.h"
+#include "V8Jobs.h"
 #include "V8Types.h"
 
 namespace v8App
 {
     namespace JSRuntime
     {
+        /**
+         * Blocking scope handed to v8, lets the worker pool bring in another worker while v8 waits
+         */
+        class V8AppBlockingScope : public V8ScopedBlockingCall
+        {
+        public:
+            explicit V8AppBlockingScope(V8BlockingType inType);
+            ~V8AppBlockingScope() override = default;
+
+        private:
+            Threads::ScopedBlockingCall m_BlockingCall;
+        };
+
         /**
          * Class that implments v8 platform for v8App
          */
@@ -49,19 +69,39 @@ namespace v8App
             // end v8::platform interface
 
             void SetTracingController(V8TracingController *inController);
+            // the allocators have to be set before InitializeV8, on linux the page allocator defaults to a V8AppPageAllocator
             void SetPageAllocator(V8PageAllocator *inAllocator);
             void SetThreadIsolatatedAllocator(V8ThreadIsolatedAllocator *inAllocator);
+            /**
+             * v8 hangs on to the observer when an isolate is created so it has to be set before InitializeV8.
+             * Defaults to a V8AppHighAllocationObserver, passing one with different options turns on the
+             * worker boost and idle task pausing.
+             */
             void SetHighAllocatoionObserver(V8HighAllocationThroughputObserver *inObserver);
+            // nullptr if the observer that was set isn't a V8AppHighAllocationObserver
+            V8AppHighAllocationObserver *GetAppHighAllocationObserver() { return m_AppHighAllocObserver; }
 
             void SetIsolateHelper(PlatformRuntimeProviderUniquePtr inHelper);
 
-            static void InitializeV8(PlatformRuntimeProviderUniquePtr inHelper);
+            // the job policy is only applied when one is passed so one set with SetJobConcurrencyPolicy before is kept
+            static void InitializeV8(PlatformRuntimeProviderUniquePtr inHelper, std::optional<V8JobConcurrencyPolicy> inJobPolicy = std::nullopt);
             static void ShutdownV8();
 
             static std::shared_ptr<V8AppPlatform> Get();
 
             bool SetWorkersPaused(bool inPaused);
 
+            // sets how many workers v8's jobs can use, running jobs pick it up the next time they start a worker
+            void SetJobConcurrencyPolicy(const V8JobConcurrencyPolicy &inPolicy);
+            V8JobConcurrencyPolicy GetJobConcurrencyPolicy();
+
+            // gets the scheduling metrics for the worker pool
+            Threads::PoolMetricsSnapshot GetWorkerMetrics();
+            // writes the scheduling metrics and the state of each priority lane of the worker pool to the stream
+            void DumpWorkerMetrics(std::ostream &inStream);
+            // true while the workers have been boosted for an allocation burst
+            bool AreWorkersBoosted();
+
         protected:
             V8AppPlatform(const V8AppPlatform &) = delete;
             V8AppPlatform &operator=(const V8AppPlatform &) = delete;
@@ -78,6 +118,10 @@ namespace v8App
                 double delay_in_seconds, const V8SourceLocation &location) override;
             // end v8::platform interface
 
+            void InstallHighAllocationObserver(V8HighAllocationThroughputObserver *inObserver);
+            // called when the first allocation burst starts and the last one ends
+            void OnHighAllocationBurst(bool inEntered);
+
             inline Threads::ThreadPriority IntToPriority(int inInt)
             {
                 if (inInt < 0 || inInt > static_cast<int>(Threads::ThreadPriority::kMaxPriority))
@@ -100,12 +144,22 @@ namespace v8App
                 }
             }
 
-            std::shared_ptr<WorkerTaskRunner> m_WorkerRunners[static_cast<int>(Threads::ThreadPriority::kMaxPriority) + 1] = {0};
+            // one pool for all the worker tasks with a lane per priority
+            std::unique_ptr<Threads::ThreadPoolLaneQueue> m_WorkerPool;
+            // shared by all the jobs so they're held to the policy's caps together
+            V8JobConcurrencyLimiterSharedPtr m_JobLimiter;
 
             V8TracingControllerUniquePtr m_TracingController;
             V8PageAllocatorUniquePtr m_PageAllocator;
             V8ThreadIsolatedAllocatorUniquePtr m_ThreadIsolatedAllocator;
             V8HighAllocationThroughputObserverUniquePtr m_HighAllocObserver;
+            V8AppHighAllocationObserver *m_AppHighAllocObserver = nullptr;
+            std::mutex m_BurstLock;
+            bool m_WorkersBoosted = false;
+            // the best effort lane's cap from before the boost
+            int m_SavedBestEffortConcurrency = 0;
+            // the cap the boost set, if it's been changed since it's left alone when the boost ends
+            int m_BoostedBestEffortConcurrency = 0;
 
             int m_NumberOfWorkers;
 
@@ -0,0 +1,57 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#ifndef _V8APP_TRACING_CONTROLLER_H_
+#define _V8APP_TRACING_CONTROLLER_H_
+
+#include <mutex>
+#include <vector>
+
+#include "v8/v8-platform.h"
+
+#include "Tracing/TraceLog.h"
+#include "V8Types.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        /**
+         * Records v8's trace events into the TraceLog so they end up on the same timeline as the
+         * TRACE_SCOPE events from our thread pools and runtimes. Tracing is started, stopped and
+         * flushed through the TraceLog and TraceWriter.
+         */
+        class V8AppTracingController : public V8TracingController
+        {
+        public:
+            V8AppTracingController();
+            ~V8AppTracingController() override;
+
+            // v8::TracingController interface
+            const uint8_t *GetCategoryGroupEnabled(const char *inName) override;
+            uint64_t AddTraceEvent(char inPhase, const uint8_t *inCategoryEnabledFlag, const char *inName, const char *inScope,
+                                   uint64_t inId, uint64_t inBindId, int32_t inNumArgs, const char **inArgNames,
+                                   const uint8_t *inArgTypes, const uint64_t *inArgValues,
+                                   std::unique_ptr<v8::ConvertableToTraceFormat> *inArgConvertables, unsigned int inFlags) override;
+            uint64_t AddTraceEventWithTimestamp(char inPhase, const uint8_t *inCategoryEnabledFlag, const char *inName, const char *inScope,
+                                                uint64_t inId, uint64_t inBindId, int32_t inNumArgs, const char **inArgNames,
+                                                const uint8_t *inArgTypes, const uint64_t *inArgValues,
+                                                std::unique_ptr<v8::ConvertableToTraceFormat> *inArgConvertables, unsigned int inFlags,
+                                                int64_t inTimestamp) override;
+            void UpdateTraceEventDuration(const uint8_t *inCategoryEnabledFlag, const char *inName, uint64_t inHandle) override;
+            void AddTraceStateObserver(TraceStateObserver *inObserver) override;
+            void RemoveTraceStateObserver(TraceStateObserver *inObserver) override;
+            // end v8::TracingController interface
+
+        protected:
+            void OnTraceStateChanged(bool inTracing);
+
+            Tracing::TraceStateListenerId m_ListenerId;
+            std::mutex m_ObserverLock;
+            std::vector<TraceStateObserver *> m_Observers;
+        };
+    } // namespace JSRuntime
+} // namespace v8App
+
+#endif //_V8APP_TRACING_CONTROLLER_H_
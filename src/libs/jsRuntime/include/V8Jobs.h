@@ -6,7 +6,11 @@
 #define _V8_JOBS_H_
 
 #include <mutex>
+#include <array>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <limits>
 #include <memory>
 
 #include "V8Types.h"
@@ -15,15 +19,92 @@ namespace v8App
 {
     namespace JSRuntime
     {
-// For 64 bit platforms use a 64 bit type allowing more task ids.
+        // v8 takes the task id as a uint8_t with the max value meaning there isn't one
+        constexpr size_t kV8JobMaxTaskIds = std::numeric_limits<uint8_t>::max();
+
+// The id bitmap uses the native word size so the atomics are lock free on every platform.
 #ifdef PLATFORM_64
-        using V8JobTaskIdAtomicType = std::atomic_uint64_t;
-        using V8JobTaskIdType = utint64_t;
+        using V8JobTaskIdWord = uint64_t;
 #else
-        using V8JobTaskIdAtomicType = std::atomic_uint32_t;
-        using V8JobTaskIdType = uint32_t;
+        using V8JobTaskIdWord = uint32_t;
 #endif
-        const size_t V8JobTaskBits = sizeof(V8JobTaskIdType) * 8;
+        constexpr size_t kV8JobTaskIdWordBits = sizeof(V8JobTaskIdWord) * 8;
+        constexpr size_t kV8JobTaskIdWords = (kV8JobMaxTaskIds + kV8JobTaskIdWordBits - 1) / kV8JobTaskIdWordBits;
+
+        /**
+         * Lock free bitmap of the task ids handed out to a job's workers. Acquire always takes the lowest
+         * free id since v8 uses them to index per worker state sized by the job's concurrency.
+         */
+        class V8JobTaskIdSet
+        {
+        public:
+            static constexpr uint8_t kInvalidTaskId = kV8JobMaxTaskIds;
+
+            // takes the lowest free id, kInvalidTaskId if they're all taken
+            uint8_t Acquire();
+            // returns false if the id wasn't assigned
+            bool Release(uint8_t inId);
+            bool IsAssigned(uint8_t inId) const;
+            size_t GetAssignedCount() const;
+
+        protected:
+            std::array<std::atomic<V8JobTaskIdWord>, kV8JobTaskIdWords> m_Words{};
+        };
+
+        class V8JobState;
+
+        /**
+         * How many workers v8's jobs can use. A negative count uses the number of worker threads.
+         */
+        struct V8JobConcurrencyPolicy
+        {
+            // most workers a single job can have at each priority
+            int m_MaxBestEffortWorkers = 2;
+            int m_MaxUserVisibleWorkers = -1;
+            int m_MaxUserBlockingWorkers = -1;
+            // the thread that calls Join runs the job on top of it's workers instead of taking one's place
+            bool m_ReserveJoiningThread = true;
+            // most workers all the jobs together can have running
+            int m_GlobalMaxWorkers = -1;
+        };
+
+        /**
+         * Applies the concurrency policy to the jobs the platform creates. The policy can be changed while
+         * jobs are running and they pick up the new limits the next time they start a worker. A job that's
+         * turned away by the global cap is told when a worker frees up so it can post another.
+         */
+        class V8JobConcurrencyLimiter
+        {
+        public:
+            explicit V8JobConcurrencyLimiter(size_t inNumWorkers, const V8JobConcurrencyPolicy &inPolicy = V8JobConcurrencyPolicy());
+
+            void SetPolicy(const V8JobConcurrencyPolicy &inPolicy);
+            V8JobConcurrencyPolicy GetPolicy();
+
+            // the most workers a job at the priority can have
+            size_t GetMaxWorkers(V8TaskPriority inPriority);
+            bool ReserveJoiningThread();
+            size_t GetGlobalMaxWorkers();
+            size_t GetActiveWorkers();
+
+            // takes a global worker slot, if none are free inWaiter is notified when one is released
+            bool TryAcquireWorker(std::weak_ptr<V8JobState> inWaiter);
+            void ReleaseWorker();
+
+        protected:
+            size_t ResolveWorkers(int inWorkers);
+            // hands the free slots out to the waiting jobs, a job that doesn't post a worker passes it's slot on
+            void WakeWaiters();
+
+            std::mutex m_Lock;
+            size_t m_NumWorkers;
+            V8JobConcurrencyPolicy m_Policy;
+            size_t m_ActiveWorkers = 0;
+            // jobs turned away by the global cap
+            std::deque<std::weak_ptr<V8JobState>> m_Waiting;
+        };
+
+        using V8JobConcurrencyLimiterSharedPtr = std::shared_ptr<V8JobConcurrencyLimiter>;
 
         class V8JobState : public std::enable_shared_from_this<V8JobState>
         {
@@ -48,10 +129,16 @@ namespace v8App
                 bool m_Yielded = {false};
             };
 
-            V8JobState(V8Platform *inPlatform, V8JobTaskUniquePtr inTask, V8TaskPriority inPriority, size_t inNumWorkers);
+            /**
+             * Without a limiter the job is capped at inNumWorkers, with one the cap comes from the limiter's
+             * policy for the job's priority and the job's workers count against the global cap.
+             */
+            V8JobState(V8Platform *inPlatform, V8JobTaskUniquePtr inTask, V8TaskPriority inPriority, size_t inNumWorkers,
+                       V8JobConcurrencyLimiterSharedPtr inLimiter = nullptr);
             virtual ~V8JobState();
 
-            void NotifyConcurrencyIncrease();
+            // returns the number of workers that were posted
+            size_t NotifyConcurrencyIncrease();
             uint8_t AcquireTaskId();
             void ReleaseTaskID(uint8_t inTaskId);
 
@@ -66,29 +153,34 @@ namespace v8App
             void UpdatePriority(V8TaskPriority inPriority);
 
         protected:
+            // Must hold m_Lock
             size_t ComputeTaskToPost(size_t inMaxConcurrency);
             void PostonWorkerThread(size_t inNumToPost, V8TaskPriority inPriority);
 
+            // Must hold m_Lock
             inline size_t GetMaxConcurrency(size_t inWorkerCount)
             {
-                return std::min(m_Task->GetMaxConcurrency(inWorkerCount), m_NumWorkersAvailable);
+                return std::min(m_Task->GetMaxConcurrency(inWorkerCount), GetWorkerCap());
             }
+            // the most workers the job can have including the joining thread. Must hold m_Lock
+            size_t GetWorkerCap();
 
-            uint8_t FindFirstFreeTaskId(V8JobTaskIdType inIds);
-
-            static constexpr V8JobTaskIdType kInvalidJobId = std::numeric_limits<uint8_t>::max();
+            static constexpr uint8_t kInvalidJobId = V8JobTaskIdSet::kInvalidTaskId;
 
             V8Platform *m_Platform;
             V8JobTaskUniquePtr m_Task;
 
             std::mutex m_Lock;
-            V8JobTaskIdAtomicType m_AssignedTaskIds;
+            V8JobTaskIdSet m_AssignedTaskIds;
             std::atomic_bool m_Canceled{false};
             V8TaskPriority m_Priority;
             size_t m_ActiveTasks = 0;
             size_t m_PendingTasks = 0;
             size_t m_NumWorkersAvailable;
             std::condition_variable m_WorkerReleased;
+            V8JobConcurrencyLimiterSharedPtr m_Limiter;
+            // set once a thread joins the job
+            bool m_Joined = false;
         };
 
         class V8JobHandle : public v8::JobHandle
@@ -8,6 +8,7 @@
 #include <queue>
 #include <mutex>
 #include <tuple>
+#include <vector>
 
 #include "Threads/ThreadPoolDelayedQueue.h"
 
@@ -21,6 +22,8 @@ namespace v8App
         {
         public:
             explicit WorkerTaskRunner(int iNumberofWorkers, Threads::ThreadPriority inPriority);
+            // runner whose pool grows and shrinks it's workers with the load
+            WorkerTaskRunner(const Threads::ElasticPoolOptions &inOptions, Threads::ThreadPriority inPriority);
             ~WorkerTaskRunner();
 
             class TaskRunScope
@@ -47,6 +50,25 @@ namespace v8App
              */
             bool SetPaused(bool inPause) { return m_Tasks.SetPaused(inPause); }
 
+            /**
+             * Posts a batch of tasks with a single enqueue on the pool, only waking as many
+             * workers as there are tasks. Used for fan out work like compiling a module graph.
+             */
+            void PostTasks(std::vector<V8TaskUniquePtr> inTasks);
+            void PostDelayedTasks(std::vector<V8TaskUniquePtr> inTasks, double inDelaySeconds);
+
+            /**
+             * Posts a delayed task returning an id that can cancel it before it's due. Canceling frees
+             * the task straight away instead of leaving it in the pool till it fires.
+             */
+            Queues::TimerId PostCancelableDelayedTask(V8TaskUniquePtr inTask, double inDelaySeconds);
+            bool CancelDelayedTask(Queues::TimerId inId) { return m_Tasks.CancelDelayedTask(inId); }
+
+            /**
+             * Gets a snapshot of the scheduling metrics for the runner's pool
+             */
+            Threads::PoolMetricsSnapshot GetMetrics() const { return m_Tasks.GetMetrics(); }
+
             // TaskRunner implementation
         public:
             bool IdleTasksEnabled() override { return false; };
@@ -67,6 +89,8 @@ namespace v8App
             // end TaskRunner implementation
 
         protected:
+            std::vector<Threads::ThreadPoolTaskUniquePtr> WrapTasks(std::vector<V8TaskUniquePtr> inTasks);
+
             bool m_Terminated = false;
             Threads::ThreadPoolDelayedQueue m_Tasks;
         };
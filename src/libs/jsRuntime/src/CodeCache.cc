@@ -2,8 +2,10 @@
 // Use of this source code is governed by a MIT license that can be
 // found in the LICENSE file.
 
-#include <sstream>
+#include <cstring>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 #include "Logging/LogMacros.h"
 #include "Assets/AppAssetRoots.h"
@@ -22,10 +24,17 @@ namespace v8App
     {
         CodeCache::CodeCache(JSAppSharedPtr inApp) : m_App(inApp)
         {
+            m_ReclaimCallback = std::make_unique<Memory::ScopedReclaimCallback>("CodeCache", [this](Memory::MemoryPressureLevel inLevel)
+                                                                                {
+                if (inLevel != Memory::MemoryPressureLevel::kNone)
+                {
+                    PurgeMemory();
+                } });
         }
 
         CodeCache::~CodeCache()
         {
+            m_ReclaimCallback.reset();
             m_App.reset();
         }
 
@@ -77,44 +86,67 @@ namespace v8App
             std::filesystem::file_time_type jsModTime = std::filesystem::last_write_time(inFilePath);
             std::filesystem::file_time_type jsccModTime;
 
-            ScriptCacheInfo *cacheInfo = GetCachedScript(inFilePath.generic_string());
-            // no entry yet so build one
-            if (cacheInfo == nullptr)
+            std::string source;
+            std::string filePath;
+            std::vector<uint8_t> compiled;
             {
-                cacheInfo = CreateCacheInfo(inFilePath.generic_string());
-                if (std::filesystem::exists(cachePath))
+                // copied out so no lock is held while v8 allocates, a failed allocation runs the reclaim
+                // callbacks on this thread which purge the cache
+                std::lock_guard<std::mutex> lock(m_CacheLock);
+
+                ScriptCacheInfo *cacheInfo = GetCachedScript(inFilePath.generic_string());
+                // no entry yet so build one
+                if (cacheInfo == nullptr)
                 {
-                    jsccModTime = std::filesystem::last_write_time(cachePath);
-                    if (jsccModTime >= jsModTime)
+                    cacheInfo = CreateCacheInfo(inFilePath.generic_string());
+                    if (cacheInfo == nullptr)
+                    {
+                        // CreateCacheInfo emits a log
+                        return nullptr;
+                    }
+                    if (std::filesystem::exists(cachePath))
                     {
-                        if (ReadCachedDataFile(inFilePath, cacheInfo) == false)
+                        jsccModTime = std::filesystem::last_write_time(cachePath);
+                        if (jsccModTime >= jsModTime)
                         {
-                            // no log ReadCachedDataFile emits one
-                            return nullptr;
+                            if (ReadCachedDataFile(cachePath, cacheInfo) == false)
+                            {
+                                // no log ReadCachedDataFile emits one
+                                return nullptr;
+                            }
                         }
+                        cacheInfo->m_LastCompiled = jsccModTime;
                     }
-                    cacheInfo->m_LastCompiled = jsccModTime;
                 }
-            }
 
-            if (cacheInfo->m_LastCompiled < jsModTime)
-            {
-                delete cacheInfo->m_Compiled;
-                cacheInfo->m_Compiled = nullptr;
-                cacheInfo->m_CompiledLength = 0;
+                if (cacheInfo->m_LastCompiled < jsModTime)
+                {
+                    delete[] cacheInfo->m_Compiled;
+                    cacheInfo->m_Compiled = nullptr;
+                    cacheInfo->m_CompiledLength = 0;
 
-                if (ReadScriptFile(inFilePath, cacheInfo) == false)
+                    if (ReadScriptFile(inFilePath, cacheInfo) == false)
+                    {
+                        return nullptr;
+                    }
+                }
+                source = cacheInfo->m_SourceStr;
+                filePath = cacheInfo->m_FilePath.generic_string();
+                if (cacheInfo->m_Compiled != nullptr)
                 {
-                    return nullptr;
+                    compiled.assign(cacheInfo->m_Compiled, cacheInfo->m_Compiled + cacheInfo->m_CompiledLength);
                 }
             }
 
-            V8LString sourceStr = JSUtilities::StringToV8(inIsolate, cacheInfo->m_SourceStr);
-            V8LString fileStr = JSUtilities::StringToV8(inIsolate, cacheInfo->m_FilePath.generic_string());
+            V8LString sourceStr = JSUtilities::StringToV8(inIsolate, source);
+            V8LString fileStr = JSUtilities::StringToV8(inIsolate, filePath);
             V8ScriptCachedData *cache = nullptr;
-            if (cacheInfo->m_Compiled != nullptr)
+            if (compiled.empty() == false)
             {
-                cache = new V8ScriptCachedData(cacheInfo->m_Compiled, cacheInfo->m_CompiledLength, V8ScriptCachedData::BufferNotOwned);
+                // v8 gets it's own copy of the data that it frees
+                uint8_t *data = new uint8_t[compiled.size()];
+                memcpy(data, compiled.data(), compiled.size());
+                cache = new V8ScriptCachedData(data, static_cast<int>(compiled.size()), V8ScriptCachedData::BufferOwned);
             }
             V8ScriptOrigin origin(fileStr, 0, 0, false, -1, V8LValue(), false, false, true);
             return std::make_unique<V8ScriptSource>(sourceStr, origin, cache);
@@ -122,6 +154,7 @@ namespace v8App
 
         bool CodeCache::HasCodeCache(std::filesystem::path inFilePath)
         {
+            std::lock_guard<std::mutex> lock(m_CacheLock);
             ScriptCacheInfo* info = GetCachedScript(inFilePath.generic_string());
             if(info == nullptr)
             {
@@ -139,6 +172,7 @@ namespace v8App
                 LOG_ERROR(msg);
                 return false;
             }
+            std::lock_guard<std::mutex> lock(m_CacheLock);
             ScriptCacheInfo *info = GetCachedScript(inFilePath.generic_string());
             if (info == nullptr)
             {
@@ -157,17 +191,32 @@ namespace v8App
                 return false;
             }
 
-            if (info->m_Compiled != nullptr)
-            {
-                delete info->m_Compiled;
-            }
+            delete[] info->m_Compiled;
 
+            info->m_CompiledLength = inCachedData->length;
             info->m_Compiled = new uint8_t[inCachedData->length];
             memcpy(info->m_Compiled, inCachedData->data, inCachedData->length);
             info->m_LastCompiled = std::filesystem::last_write_time(info->m_CachedFilePath);
             return true;
         }
 
+        void CodeCache::PurgeMemory()
+        {
+            // the pressure can be reported from a thread already in the cache, skip it rather than deadlock
+            std::unique_lock<std::mutex> lock(m_CacheLock, std::try_to_lock);
+            if (lock.owns_lock() == false)
+            {
+                return;
+            }
+            m_ScriptCache.clear();
+        }
+
+        size_t CodeCache::GetNumberOfCachedScripts()
+        {
+            std::lock_guard<std::mutex> lock(m_CacheLock);
+            return m_ScriptCache.size();
+        }
+
         CodeCache::ScriptCacheInfo *CodeCache::GetCachedScript(std::string inFile)
         {
             auto it = m_ScriptCache.find(inFile);
@@ -313,10 +362,7 @@ namespace v8App
             }
 
             inInfo->m_CompiledLength = buffer.size();
-            if (inInfo->m_Compiled != nullptr)
-            {
-                delete inInfo->m_Compiled;
-            }
+            delete[] inInfo->m_Compiled;
             inInfo->m_Compiled = new uint8_t[inInfo->m_CompiledLength];
             memcpy(inInfo->m_Compiled, buffer.data(), inInfo->m_CompiledLength);
 
@@ -2,6 +2,10 @@
 // Use of this source code is governed by a MIT license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
 #include "Logging/LogMacros.h"
 #include "Time/Time.h"
 #include "ForegroundTaskRunner.h"
@@ -24,6 +28,9 @@ namespace v8App
 
         ForegroundTaskRunner::ForegroundTaskRunner() : m_Tasks()
         {
+            // the delayed tasks' deadlines move when the time jumps so the waiter works them out again
+            m_ClockChangedCallback = std::make_unique<Time::ScopedClockChangedCallback>([this]()
+                                                                                         { NotifyClockChanged(); });
         }
 
         ForegroundTaskRunner::~ForegroundTaskRunner()
@@ -34,26 +41,46 @@ namespace v8App
         void ForegroundTaskRunner::PostTaskImpl(V8TaskUniquePtr inTask, const V8SourceLocation& inLocation)
         {
             m_Tasks.PushItem(std::move(inTask));
+            NotifyWaiter();
         }
 
         void ForegroundTaskRunner::PostNonNestableTaskImpl(V8TaskUniquePtr inTask, const V8SourceLocation& inLocation)
         {
             m_Tasks.PushNonNestableItem(std::move(inTask));
+            NotifyWaiter();
         }
 
         void ForegroundTaskRunner::PostDelayedTaskImpl(V8TaskUniquePtr inTask, double inDelaySeconds, const V8SourceLocation& inLocation)
         {
             m_Tasks.PushItemDelayed(inDelaySeconds, std::move(inTask));
+            NotifyWaiter();
         }
 
         void ForegroundTaskRunner::PostNonNestableDelayedTaskImpl(V8TaskUniquePtr inTask, double inDelaySeconds, const V8SourceLocation& inLocation)
         {
             m_Tasks.PushNonNestableItemDelayed(inDelaySeconds, std::move(inTask));
+            NotifyWaiter();
+        }
+
+        Queues::TimerId ForegroundTaskRunner::PostCancelableDelayedTask(V8TaskUniquePtr inTask, double inDelaySeconds)
+        {
+            Queues::TimerId id = m_Tasks.PushItemDelayed(inDelaySeconds, std::move(inTask));
+            // the new task may be due before the one the waiter is sleeping till
+            NotifyWaiter();
+            return id;
+        }
+
+        Queues::TimerId ForegroundTaskRunner::PostCancelableNonNestableDelayedTask(V8TaskUniquePtr inTask, double inDelaySeconds)
+        {
+            Queues::TimerId id = m_Tasks.PushNonNestableItemDelayed(inDelaySeconds, std::move(inTask));
+            NotifyWaiter();
+            return id;
         }
 
         void ForegroundTaskRunner::PostIdleTaskImpl(V8IdleTaskUniquePtr inTask, const V8SourceLocation& inLocation)
         {
             m_IdleTasks.PushItem(std::move(inTask));
+            NotifyWaiter();
         }
 
         V8TaskUniquePtr ForegroundTaskRunner::GetNextTask()
@@ -85,6 +112,86 @@ namespace v8App
             m_Tasks.Terminate();
             m_IdleTasks.Terminate();
             m_Terminated = true;
+            m_ClockChangedCallback.reset();
+            NotifyWaiter();
+        }
+
+        bool ForegroundTaskRunner::WaitForWork(double inMaxWaitSeconds)
+        {
+            std::unique_lock<std::mutex> lock(m_WaitLock);
+            double waitUntil = inMaxWaitSeconds < 0 ? std::numeric_limits<double>::infinity()
+                                                    : Time::MonotonicallyIncreasingTimeSeconds() + inMaxWaitSeconds;
+            while (m_Terminated == false)
+            {
+                m_ClockChanged = false;
+                if (m_WaitSignaled)
+                {
+                    m_WaitSignaled = false;
+                    return true;
+                }
+                // this also moves any delayed tasks that came due over
+                if (m_Tasks.MayHaveItems())
+                {
+                    return true;
+                }
+
+                double now = Time::MonotonicallyIncreasingTimeSeconds();
+                if (now >= waitUntil)
+                {
+                    return false;
+                }
+                double wakeAt = std::min(waitUntil, m_Tasks.GetNextDeadline().value_or(waitUntil));
+                auto signaled = [this]()
+                {
+                    return m_WaitSignaled || m_ClockChanged || m_Terminated;
+                };
+                if (wakeAt == std::numeric_limits<double>::infinity())
+                {
+                    m_WaitCondition.wait(lock, signaled);
+                }
+                else
+                {
+                    m_WaitCondition.wait_for(lock, std::chrono::duration<double>(wakeAt - now), signaled);
+                }
+            }
+            return false;
+        }
+
+        void ForegroundTaskRunner::Wake()
+        {
+            NotifyWaiter();
+        }
+
+        void ForegroundTaskRunner::SetWakeDelegate(WakeDelegate inDelegate)
+        {
+            std::lock_guard<std::mutex> lock(m_WaitLock);
+            m_WakeDelegate = std::move(inDelegate);
+        }
+
+        void ForegroundTaskRunner::NotifyClockChanged()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_WaitLock);
+                m_ClockChanged = true;
+                if (m_WakeDelegate)
+                {
+                    m_WakeDelegate();
+                }
+            }
+            m_WaitCondition.notify_all();
+        }
+
+        void ForegroundTaskRunner::NotifyWaiter()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_WaitLock);
+                m_WaitSignaled = true;
+                if (m_WakeDelegate)
+                {
+                    m_WakeDelegate();
+                }
+            }
+            m_WaitCondition.notify_all();
         }
     } // namespace JSRuntime
 } // namespace v8App
\ No newline at end of file
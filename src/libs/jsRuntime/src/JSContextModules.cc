@@ -8,6 +8,7 @@
 #include "Assets/AppAssetRoots.h"
 #include "Assets/TextAsset.h"
 #include "Logging/LogMacros.h"
+#include "Tracing/TraceMacros.h"
 #include "Utils/Format.h"
 #include "Utils/Paths.h"
 
@@ -70,6 +71,7 @@ namespace v8App
 
         JSModuleInfoSharedPtr JSContextModules::LoadModule(std::filesystem::path inModulePath)
         {
+            TRACE_SCOPE("v8app.modules", "JSContextModules::LoadModule");
             V8Isolate *isolate = m_Context->GetIsolate();
             if (isolate == nullptr)
             {
@@ -120,6 +122,7 @@ namespace v8App
 
         bool JSContextModules::InstantiateModule(JSModuleInfoSharedPtr inModule)
         {
+            TRACE_SCOPE("v8app.modules", "JSContextModules::InstantiateModule");
             if (inModule == nullptr)
             {
                 LOG_ERROR("InstantiateModule passed a null module ptr");
@@ -152,6 +155,7 @@ namespace v8App
 
         V8LValue JSContextModules::RunModule(JSModuleInfoSharedPtr inModule)
         {
+            TRACE_SCOPE("v8app.modules", "JSContextModules::RunModule");
             V8Isolate *isolate = m_Context->GetIsolate();
             // We should probably actually raise an error or excpetion to propgate up to the caller
             if (inModule == nullptr)
@@ -809,6 +813,7 @@ namespace v8App
 
         JSModuleInfoSharedPtr JSContextModules::LoadModuleTree(JSContextSharedPtr inContext, const JSModuleInfoSharedPtr inModuleInfo)
         {
+            TRACE_SCOPE("v8app.modules", "JSContextModules::LoadModuleTree");
             V8Isolate *isolate = inContext->GetIsolate();
             V8LContext context = inContext->GetLocalContext();
             JSAppSharedPtr app = inContext->GetJSRuntime()->GetApp();
@@ -8,6 +8,7 @@
 #include "Time/Time.h"
 #include "Serialization/ReadBuffer.h"
 #include "Serialization/TypeSerializer.h"
+#include "Tracing/TraceMacros.h"
 #include "Utils/Format.h"
 
 #include "JSApp.h"
@@ -22,11 +23,35 @@
 #include "IJSSnapshotProvider.h"
 #include "JSRuntimeSnapData.h"
 #include "JSUtilities.h"
+#include "UVRunLoop.h"
 
 namespace v8App
 {
     namespace JSRuntime
     {
+        /**
+         * Run on the isolate's thread after it's been told about the pressure, when memory is
+         * critically low it has the isolate do a full gc to free what it can
+         */
+        class MemoryPressureTask : public V8Task
+        {
+        public:
+            MemoryPressureTask(std::weak_ptr<V8Isolate> inIsolate, Memory::MemoryPressureLevel inLevel) : m_Isolate(inIsolate), m_Level(inLevel) {}
+
+            void Run() override
+            {
+                V8IsolateSharedPtr isolate = m_Isolate.lock();
+                if (isolate != nullptr && m_Level == Memory::MemoryPressureLevel::kCritical)
+                {
+                    isolate->LowMemoryNotification();
+                }
+            }
+
+        private:
+            std::weak_ptr<V8Isolate> m_Isolate;
+            Memory::MemoryPressureLevel m_Level;
+        };
+
         JSRuntime::JSRuntime()
         {
         }
@@ -45,9 +70,19 @@ namespace v8App
             m_Isolate = std::move(inRuntime.m_Isolate);
             m_Contextes = std::move(inRuntime.m_Contextes);
             m_TaskRunner = std::move(inRuntime.m_TaskRunner);
+            m_PageAccount = std::move(inRuntime.m_PageAccount);
+            m_HighAllocObserver = inRuntime.m_HighAllocObserver;
+            inRuntime.m_HighAllocObserver = nullptr;
             m_ObjectTemplates = std::move(inRuntime.m_ObjectTemplates);
             m_Creator = std::move(inRuntime.m_Creator);
             m_IsSnapshotter = inRuntime.m_IsSnapshotter;
+            // the loop owns the task runner's wake delegate so it has to come along and call back into us now
+            m_UVRunLoop = std::move(inRuntime.m_UVRunLoop);
+            if (m_UVRunLoop != nullptr)
+            {
+                m_UVRunLoop->SetRuntime(this);
+            }
+            m_ReclaimCallback = std::move(inRuntime.m_ReclaimCallback);
 
             m_Initialized = inRuntime.m_Initialized;
             inRuntime.m_Initialized = false;
@@ -101,29 +136,136 @@ namespace v8App
 
         void JSRuntime::ProcessTasks()
         {
+            TRACE_SCOPE("v8app.runtime", "JSRuntime::ProcessTasks");
+            // drain in batches so the isolate lock is let go of now and then for other threads
             while (m_TaskRunner->MaybeHasTask())
             {
-                V8TaskUniquePtr task = m_TaskRunner->GetNextTask();
+                if (DrainTasks().m_TasksRun == 0)
                 {
-                    V8IsolateScope isolateScope(m_Isolate.get());
-                    V8Locker locker(m_Isolate.get());
-                    ForegroundTaskRunner::TaskRunScope runScope(m_TaskRunner);
-                    task->Run();
+                    // only non nestable or tasks that aren't due are left
+                    break;
+                }
+            }
+        }
+
+        TaskDrainStats JSRuntime::DrainTasks(double inTimeBudget, size_t inMaxTasks)
+        {
+            TRACE_SCOPE("v8app.runtime", "JSRuntime::DrainTasks");
+            TaskDrainStats stats;
+            double start = Time::MonotonicallyIncreasingTimeSeconds();
+            V8TaskUniquePtr task = m_TaskRunner->GetNextTask();
+            if (task == nullptr)
+            {
+                return stats;
+            }
+
+            double deadline = start + inTimeBudget;
+            {
+                V8AppPageAccountScope accountScope(m_PageAccount);
+                V8IsolateScope isolateScope(m_Isolate.get());
+                V8Locker locker(m_Isolate.get());
+                while (task != nullptr)
+                {
+                    {
+                        ForegroundTaskRunner::TaskRunScope runScope(m_TaskRunner);
+                        task->Run();
+                    }
+                    task.reset();
+                    stats.m_TasksRun++;
+                    if (stats.m_TasksRun >= inMaxTasks || Time::MonotonicallyIncreasingTimeSeconds() >= deadline)
+                    {
+                        stats.m_HitLimit = m_TaskRunner->MaybeHasTask();
+                        break;
+                    }
+                    // fetched outside the run scope so the nesting depth is the caller's
+                    task = m_TaskRunner->GetNextTask();
+                }
+            }
+            stats.m_Seconds = Time::MonotonicallyIncreasingTimeSeconds() - start;
+            return stats;
+        }
+
+        void JSRuntime::RunLoop()
+        {
+            if (m_UVRunLoop != nullptr)
+            {
+                if (m_QuitRunLoop == false)
+                {
+                    m_UVRunLoop->Run();
+                }
+                m_QuitRunLoop = false;
+                return;
+            }
+            while (m_QuitRunLoop == false && m_TaskRunner->IsTerminated() == false)
+            {
+                if (m_TaskRunner->MaybeHasTask() && DrainTasks().m_TasksRun > 0)
+                {
+                    continue;
+                }
+
+                if (IdleTasksEnabled() && m_TaskRunner->MaybeHasIdleTask())
+                {
+                    // give the idle tasks the time till the next delayed task is due
+                    double idleTime = kRunLoopIdleSlice;
+                    std::optional<double> deadline = m_TaskRunner->GetNextDelayedDeadline();
+                    if (deadline.has_value())
+                    {
+                        idleTime = std::min(idleTime, deadline.value() - Time::MonotonicallyIncreasingTimeSeconds());
+                    }
+                    if (idleTime > 0)
+                    {
+                        ProcessIdleTasks(idleTime);
+                        continue;
+                    }
                 }
+
+                m_TaskRunner->WaitForWork();
+            }
+            m_QuitRunLoop = false;
+        }
+
+        void JSRuntime::QuitRunLoop()
+        {
+            m_QuitRunLoop = true;
+            if (m_UVRunLoop != nullptr)
+            {
+                m_UVRunLoop->Stop();
+            }
+            m_TaskRunner->Wake();
+        }
+
+        void JSRuntime::WakeRunLoop()
+        {
+            m_TaskRunner->Wake();
+        }
+
+        UVRunLoop *JSRuntime::GetUVRunLoop()
+        {
+            CHECK_NOT_NULL(m_TaskRunner.get());
+            if (m_UVRunLoop == nullptr)
+            {
+                m_UVRunLoop = std::make_unique<UVRunLoop>(this, m_TaskRunner);
             }
+            return m_UVRunLoop.get();
         }
 
         void JSRuntime::ProcessIdleTasks(double inTimeLeft)
         {
+            TRACE_SCOPE("v8app.runtime", "JSRuntime::ProcessIdleTasks");
             if (IdleTasksEnabled() == false)
             {
                 return;
             }
 
             double deadline = Time::MonotonicallyIncreasingTimeSeconds() + inTimeLeft;
-
+            V8AppPageAccountScope accountScope(m_PageAccount);
             while (deadline > Time::MonotonicallyIncreasingTimeSeconds() && m_TaskRunner->MaybeHasIdleTask())
             {
+                // idle work is held off while the isolate is in an allocation burst if the platform's set up to
+                if (m_HighAllocObserver != nullptr && m_HighAllocObserver->ShouldPauseIdleTasks(m_Isolate.get()))
+                {
+                    break;
+                }
                 V8IdleTaskUniquePtr task = m_TaskRunner->GetNextIdleTask();
                 {
                     V8IsolateScope isolateScope(m_Isolate.get());
@@ -306,6 +448,9 @@ namespace v8App
             {
                 return;
             }
+            m_ReclaimCallback.reset();
+            // closes any handles native modules left on the loop
+            m_UVRunLoop.reset();
             m_HandleClosers.clear();
             if (m_Isolate != nullptr && m_Creator == nullptr)
             {
@@ -324,6 +469,11 @@ namespace v8App
                 delete weakPtr;
                 m_Isolate->SetData(uint32_t(JSRuntime::DataSlot::kJSRuntimeWeakPtr), nullptr);
             }
+            if (m_Isolate != nullptr && m_HighAllocObserver != nullptr)
+            {
+                m_HighAllocObserver->RemoveIsolate(m_Isolate.get());
+            }
+            m_HighAllocObserver = nullptr;
             m_Creator.reset();
             m_Isolate.reset();
             m_App.reset();
@@ -692,11 +842,17 @@ namespace v8App
             }
             params.external_references = m_App->GetSnapshotProvider()->GetExternalReferences();
 
+            // the heap's reservations are made while the isolate is set up so charge them to this runtime
+            m_PageAccount = std::make_shared<V8AppPageAccount>(m_Name);
+            V8AppPageAccountScope accountScope(m_PageAccount);
+
             // TODO: replace with custom allocator
             params.array_buffer_allocator =
                 V8ArrayBuffer::Allocator::NewDefaultAllocator();
 
             V8CppHeapUniquePtr heap = V8CppHeap::Create(V8AppPlatform::Get().get(), v8::CppHeapCreateParams({}));
+            // v8 asks the platform for the observer as the isolate's created so it's the one it reports to
+            m_HighAllocObserver = V8AppPlatform::Get()->GetAppHighAllocationObserver();
             params.cpp_heap = heap.get();
             // the isolate will own the heap so release it
             heap.release();
@@ -742,9 +898,33 @@ namespace v8App
                     }
                 }
             }
+            RegisterReclaimCallback();
             return true;
         }
 
+        void JSRuntime::RegisterReclaimCallback()
+        {
+            // the isolate may be gone by the time a posted task runs
+            std::weak_ptr<V8Isolate> weakIsolate = m_Isolate;
+            std::weak_ptr<ForegroundTaskRunner> weakRunner = m_TaskRunner;
+            m_ReclaimCallback = std::make_unique<Memory::ScopedReclaimCallback>(m_Name, [weakIsolate, weakRunner](Memory::MemoryPressureLevel inLevel)
+                                                                                {
+                V8IsolateSharedPtr isolate = weakIsolate.lock();
+                if (isolate == nullptr)
+                {
+                    return;
+                }
+                // safe to call from any thread, v8 starts freeing before it retries a failed allocation
+                isolate->MemoryPressureNotification(static_cast<v8::MemoryPressureLevel>(inLevel));
+                std::shared_ptr<ForegroundTaskRunner> runner = weakRunner.lock();
+                if (inLevel != Memory::MemoryPressureLevel::kCritical || runner == nullptr)
+                {
+                    return;
+                }
+                // a full gc has to run on the isolate's thread and not from inside a failing allocation
+                runner->PostTask(std::make_unique<MemoryPressureTask>(weakIsolate, inLevel)); });
+        }
+
         JSRuntimeSharedPtr JSRuntime::CloneRuntimeForSnapshotting(JSAppSharedPtr inApp)
         {
             JSRuntimeSharedPtr runtime = std::make_shared<JSRuntime>();
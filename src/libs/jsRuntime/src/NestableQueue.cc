@@ -26,12 +26,12 @@ namespace v8App
             temp.m_Task = std::move(inItem);
             PushItem(std::move(temp));
         }
-        void NestableQueue::PushItemDelayed(double inDelaySeconds, V8TaskUniquePtr inItem)
+        Queues::TimerId NestableQueue::PushItemDelayed(double inDelaySeconds, V8TaskUniquePtr inItem)
         {
             internal::QueueEntry temp;
             temp.m_Nestable = Nestability::kNestable;
             temp.m_Task = std::move(inItem);
-            PushItemDelayed(inDelaySeconds, std::move(temp));
+            return PushItemDelayed(inDelaySeconds, std::move(temp));
         }
 
         void NestableQueue::PushNonNestableItem(V8TaskUniquePtr inItem)
@@ -41,12 +41,12 @@ namespace v8App
             temp.m_Task = std::move(inItem);
             PushItem(std::move(temp));
         }
-        void NestableQueue::PushNonNestableItemDelayed(double inDelaySeconds, V8TaskUniquePtr inItem)
+        Queues::TimerId NestableQueue::PushNonNestableItemDelayed(double inDelaySeconds, V8TaskUniquePtr inItem)
         {
             internal::QueueEntry temp;
             temp.m_Nestable = Nestability::kNonstable;
             temp.m_Task = std::move(inItem);
-            PushItemDelayed(inDelaySeconds, std::move(temp));
+            return PushItemDelayed(inDelaySeconds, std::move(temp));
         }
 
         std::optional<V8TaskUniquePtr> NestableQueue::GetNextItem(int inNestingDepth)
@@ -0,0 +1,165 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <cmath>
+
+#include "Logging/LogMacros.h"
+#include "Time/Time.h"
+#include "JSRuntime.h"
+#include "UVRunLoop.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        UVRunLoop::UVRunLoop(JSRuntime *inRuntime, std::shared_ptr<ForegroundTaskRunner> inRunner)
+            : m_Runtime(inRuntime), m_TaskRunner(inRunner)
+        {
+            CHECK_NOT_NULL(m_Runtime);
+            CHECK_NOT_NULL(m_TaskRunner.get());
+            CHECK_EQ(0, uv_loop_init(&m_Loop));
+            m_Loop.data = this;
+
+            uv_async_init(&m_Loop, &m_WakeHandle, &UVRunLoop::OnWake);
+            m_WakeHandle.data = this;
+            uv_timer_init(&m_Loop, &m_DelayedTimer);
+            m_DelayedTimer.data = this;
+            uv_idle_init(&m_Loop, &m_IdleHandle);
+            m_IdleHandle.data = this;
+            uv_prepare_init(&m_Loop, &m_PrepareHandle);
+            m_PrepareHandle.data = this;
+            uv_prepare_start(&m_PrepareHandle, &UVRunLoop::OnPrepare);
+
+            // only the wake handle keeps the loop alive, the rest come and go with the tasks
+            uv_unref(reinterpret_cast<uv_handle_t *>(&m_DelayedTimer));
+            uv_unref(reinterpret_cast<uv_handle_t *>(&m_IdleHandle));
+            uv_unref(reinterpret_cast<uv_handle_t *>(&m_PrepareHandle));
+
+            // uv_async_send is the only uv call that's safe from another thread
+            m_TaskRunner->SetWakeDelegate([this]()
+                                          { uv_async_send(&m_WakeHandle); });
+        }
+
+        UVRunLoop::~UVRunLoop()
+        {
+            m_TaskRunner->SetWakeDelegate(nullptr);
+            uv_walk(&m_Loop, [](uv_handle_t *inHandle, void *)
+                    {
+                if (uv_is_closing(inHandle) == 0)
+                {
+                    uv_close(inHandle, nullptr);
+                } },
+                    nullptr);
+            // lets the close callbacks run
+            uv_run(&m_Loop, UV_RUN_DEFAULT);
+            [[maybe_unused]] int result = uv_loop_close(&m_Loop);
+            DCHECK_EQ(0, result);
+        }
+
+        void UVRunLoop::Run()
+        {
+            if (ShouldStop() == false)
+            {
+                uv_run(&m_Loop, UV_RUN_DEFAULT);
+            }
+            m_Stop = false;
+        }
+
+        void UVRunLoop::Stop()
+        {
+            m_Stop = true;
+            uv_async_send(&m_WakeHandle);
+        }
+
+        void UVRunLoop::SetRuntime(JSRuntime *inRuntime)
+        {
+            CHECK_NOT_NULL(inRuntime);
+            m_Runtime = inRuntime;
+        }
+
+        void UVRunLoop::OnWake(uv_async_t *inHandle)
+        {
+            UVRunLoop *loop = static_cast<UVRunLoop *>(inHandle->data);
+            if (loop->ShouldStop())
+            {
+                uv_stop(&loop->m_Loop);
+                return;
+            }
+            loop->RunWork();
+        }
+
+        void UVRunLoop::OnDelayedTimer(uv_timer_t *inHandle)
+        {
+            UVRunLoop *loop = static_cast<UVRunLoop *>(inHandle->data);
+            loop->RunWork();
+        }
+
+        void UVRunLoop::OnIdle(uv_idle_t *inHandle)
+        {
+            UVRunLoop *loop = static_cast<UVRunLoop *>(inHandle->data);
+            loop->RunWork();
+        }
+
+        void UVRunLoop::OnPrepare(uv_prepare_t *inHandle)
+        {
+            UVRunLoop *loop = static_cast<UVRunLoop *>(inHandle->data);
+            if (loop->ShouldStop())
+            {
+                uv_stop(&loop->m_Loop);
+                return;
+            }
+            loop->ScheduleWork();
+        }
+
+        void UVRunLoop::ScheduleWork()
+        {
+            // an active idle handle makes the loop poll without blocking
+            bool hasIdleTasks = m_Runtime->IdleTasksEnabled() && m_TaskRunner->MaybeHasIdleTask();
+            if (m_TaskRunner->MaybeHasTask() || hasIdleTasks)
+            {
+                uv_idle_start(&m_IdleHandle, &UVRunLoop::OnIdle);
+            }
+            else
+            {
+                uv_idle_stop(&m_IdleHandle);
+            }
+
+            std::optional<double> deadline = m_TaskRunner->GetNextDelayedDeadline();
+            if (deadline.has_value() == false)
+            {
+                uv_timer_stop(&m_DelayedTimer);
+                return;
+            }
+            // if the time jumps the task runner wakes the loop and the timer is set again from here
+            double delay = std::max(0.0, deadline.value() - Time::MonotonicallyIncreasingTimeSeconds());
+            // uv timers are in milliseconds so round up so it isn't early
+            uint64_t delayMs = static_cast<uint64_t>(std::ceil(delay * 1000.0));
+            uv_timer_start(&m_DelayedTimer, &UVRunLoop::OnDelayedTimer, delayMs, 0);
+        }
+
+        void UVRunLoop::RunWork()
+        {
+            if (m_TaskRunner->MaybeHasTask() && m_Runtime->DrainTasks().m_TasksRun > 0)
+            {
+                return;
+            }
+            if (m_Runtime->IdleTasksEnabled() == false || m_TaskRunner->MaybeHasIdleTask() == false)
+            {
+                return;
+            }
+            // give the idle tasks the time till the next delayed task is due
+            double idleTime = kRunLoopIdleSlice;
+            std::optional<double> deadline = m_TaskRunner->GetNextDelayedDeadline();
+            if (deadline.has_value())
+            {
+                idleTime = std::min(idleTime, deadline.value() - Time::MonotonicallyIncreasingTimeSeconds());
+            }
+            if (idleTime > 0)
+            {
+                m_Runtime->ProcessIdleTasks(idleTime);
+            }
+        }
+    } // namespace JSRuntime
+} // namespace v8App
@@ -0,0 +1,142 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+
+#include "Time/Clock.h"
+#include "Tracing/TraceMacros.h"
+#include "V8AppHighAllocationObserver.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        V8AppHighAllocationObserver::V8AppHighAllocationObserver(const V8AppHighAllocationObserverOptions &inOptions)
+            : m_Options(inOptions)
+        {
+        }
+
+        void V8AppHighAllocationObserver::EnterSection()
+        {
+            EnterSection(V8Isolate::TryGetCurrent());
+        }
+
+        void V8AppHighAllocationObserver::LeaveSection()
+        {
+            LeaveSection(V8Isolate::TryGetCurrent());
+        }
+
+        void V8AppHighAllocationObserver::EnterSection(V8Isolate *inIsolate)
+        {
+            TRACE_INSTANT("v8app.memory", "HighAllocationEnter");
+            std::lock_guard<std::mutex> lock(m_Lock);
+            V8AppHighAllocationStats &stats = m_Stats[inIsolate];
+            if (stats.m_ActiveSections++ > 0)
+            {
+                return;
+            }
+            stats.m_Sections++;
+            stats.m_EnterTime = Time::NowNanoseconds();
+            // the listener is called under the lock so it sees the bursts start and end in order
+            if (m_ActiveIsolates++ == 0 && m_Listener)
+            {
+                m_Listener(true);
+            }
+        }
+
+        void V8AppHighAllocationObserver::LeaveSection(V8Isolate *inIsolate)
+        {
+            TRACE_INSTANT("v8app.memory", "HighAllocationLeave");
+            std::lock_guard<std::mutex> lock(m_Lock);
+            auto it = m_Stats.find(inIsolate);
+            if (it == m_Stats.end() || it->second.m_ActiveSections == 0)
+            {
+                return;
+            }
+            V8AppHighAllocationStats &stats = it->second;
+            if (--stats.m_ActiveSections > 0)
+            {
+                return;
+            }
+            int64_t duration = Time::NowNanoseconds() - stats.m_EnterTime;
+            stats.m_TotalNanoseconds += duration;
+            stats.m_LongestNanoseconds = std::max(stats.m_LongestNanoseconds, duration);
+            stats.m_EnterTime = 0;
+            if (--m_ActiveIsolates == 0 && m_Listener)
+            {
+                m_Listener(false);
+            }
+        }
+
+        void V8AppHighAllocationObserver::SetListener(V8AppHighAllocationListener inListener)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            m_Listener = std::move(inListener);
+        }
+
+        bool V8AppHighAllocationObserver::IsInSection(V8Isolate *inIsolate)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            auto it = m_Stats.find(inIsolate);
+            return it != m_Stats.end() && it->second.m_ActiveSections > 0;
+        }
+
+        bool V8AppHighAllocationObserver::ShouldPauseIdleTasks(V8Isolate *inIsolate)
+        {
+            return m_Options.m_PauseIdleTasks && IsInSection(inIsolate);
+        }
+
+        V8AppHighAllocationStats V8AppHighAllocationObserver::GetStats(V8Isolate *inIsolate)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            auto it = m_Stats.find(inIsolate);
+            if (it == m_Stats.end())
+            {
+                return V8AppHighAllocationStats();
+            }
+            return it->second;
+        }
+
+        V8AppHighAllocationStats V8AppHighAllocationObserver::GetTotalStats()
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            V8AppHighAllocationStats total = m_Removed;
+            for (const auto &it : m_Stats)
+            {
+                total.m_Sections += it.second.m_Sections;
+                total.m_ActiveSections += it.second.m_ActiveSections;
+                total.m_TotalNanoseconds += it.second.m_TotalNanoseconds;
+                total.m_LongestNanoseconds = std::max(total.m_LongestNanoseconds, it.second.m_LongestNanoseconds);
+            }
+            return total;
+        }
+
+        void V8AppHighAllocationObserver::RemoveIsolate(V8Isolate *inIsolate)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            auto it = m_Stats.find(inIsolate);
+            if (it == m_Stats.end())
+            {
+                return;
+            }
+            V8AppHighAllocationStats &stats = it->second;
+            m_Removed.m_Sections += stats.m_Sections;
+            m_Removed.m_TotalNanoseconds += stats.m_TotalNanoseconds;
+            m_Removed.m_LongestNanoseconds = std::max(m_Removed.m_LongestNanoseconds, stats.m_LongestNanoseconds);
+            // a burst that never left would hold the platform in burst mode for good
+            if (stats.m_ActiveSections > 0 && --m_ActiveIsolates == 0 && m_Listener)
+            {
+                m_Listener(false);
+            }
+            m_Stats.erase(it);
+        }
+
+        void V8AppHighAllocationObserver::DumpStats(std::ostream &inStream)
+        {
+            V8AppHighAllocationStats total = GetTotalStats();
+            inStream << "High allocation sections: " << total.m_Sections << " active=" << total.m_ActiveSections
+                     << " totalMs=" << total.m_TotalNanoseconds / 1000000.0 << " longestMs=" << total.m_LongestNanoseconds / 1000000.0 << "\n";
+        }
+    } // namespace JSRuntime
+} // namespace v8App
@@ -0,0 +1,471 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <iterator>
+
+#if defined(V8APP_LINUX)
+#include <cerrno>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Logging/LogMacros.h"
+#include "V8AppPageAllocator.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        // the account pages reserved on this thread are charged to, null for the allocator's shared one
+        static thread_local V8AppPageAccountSharedPtr s_CurrentAccount;
+
+        void V8AppPageAccount::AddReserved(size_t inBytes)
+        {
+            size_t reserved = m_ReservedBytes.fetch_add(inBytes) + inBytes;
+            size_t peak = m_PeakReservedBytes.load();
+            while (reserved > peak && m_PeakReservedBytes.compare_exchange_weak(peak, reserved) == false)
+            {
+            }
+        }
+
+        void V8AppPageAccount::RemoveReserved(size_t inBytes)
+        {
+            m_ReservedBytes.fetch_sub(inBytes);
+        }
+
+        void V8AppPageAccount::AddCommitted(size_t inBytes)
+        {
+            size_t committed = m_CommittedBytes.fetch_add(inBytes) + inBytes;
+            size_t peak = m_PeakCommittedBytes.load();
+            while (committed > peak && m_PeakCommittedBytes.compare_exchange_weak(peak, committed) == false)
+            {
+            }
+        }
+
+        void V8AppPageAccount::RemoveCommitted(size_t inBytes)
+        {
+            m_CommittedBytes.fetch_sub(inBytes);
+        }
+
+        V8AppPageAccountScope::V8AppPageAccountScope(V8AppPageAccountSharedPtr inAccount)
+            : m_Previous(std::move(s_CurrentAccount))
+        {
+            s_CurrentAccount = std::move(inAccount);
+        }
+
+        V8AppPageAccountScope::~V8AppPageAccountScope()
+        {
+            s_CurrentAccount = std::move(m_Previous);
+        }
+
+        V8AppPageAccountSharedPtr V8AppPageAccountScope::GetCurrentAccount()
+        {
+            return s_CurrentAccount;
+        }
+
+#if defined(V8APP_LINUX)
+        namespace
+        {
+            // size of a transparent huge page on x64 and arm64 with 4k pages
+            constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+#if defined(PLATFORM_64)
+            // keeps the random hints in the lower part of the 47 bit user address space
+            constexpr uint64_t kRandomMmapMask = 0x3FFFFFFFF000ull;
+#endif
+
+            int PermissionToProtection(V8PageAllocator::Permission inPermission)
+            {
+                switch (inPermission)
+                {
+                case V8PageAllocator::kRead:
+                    return PROT_READ;
+                case V8PageAllocator::kReadWrite:
+                    return PROT_READ | PROT_WRITE;
+                case V8PageAllocator::kReadWriteExecute:
+                    return PROT_READ | PROT_WRITE | PROT_EXEC;
+                case V8PageAllocator::kReadExecute:
+                    return PROT_READ | PROT_EXEC;
+                default:
+                    return PROT_NONE;
+                }
+            }
+
+            uintptr_t RoundUp(uintptr_t inValue, size_t inAlignment)
+            {
+                return (inValue + inAlignment - 1) & ~(static_cast<uintptr_t>(inAlignment) - 1);
+            }
+        } // namespace
+
+        V8AppPageAllocator::V8AppPageAllocator(const V8AppPageAllocatorOptions &inOptions)
+            : m_Options(inOptions), m_SharedAccount(std::make_shared<V8AppPageAccount>("shared"))
+        {
+            m_CommitPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            m_AllocatePageSize = m_CommitPageSize;
+            m_Random.seed(std::random_device()());
+        }
+
+        void V8AppPageAllocator::SetRandomMmapSeed(int64_t inSeed)
+        {
+            std::lock_guard<std::mutex> lock(m_RandomLock);
+            m_Random.seed(static_cast<uint64_t>(inSeed));
+        }
+
+        void *V8AppPageAllocator::GetRandomMmapAddr()
+        {
+#if defined(PLATFORM_64)
+            uint64_t address;
+            {
+                std::lock_guard<std::mutex> lock(m_RandomLock);
+                address = m_Random();
+            }
+            address &= kRandomMmapMask;
+            address &= ~static_cast<uint64_t>(m_AllocatePageSize - 1);
+            return reinterpret_cast<void *>(address);
+#else
+            // the address space is too small to be worth randomizing so let the kernel pick
+            return nullptr;
+#endif
+        }
+
+        void *V8AppPageAllocator::AllocatePages(void *inAddress, size_t inLength, size_t inAlignment, Permission inPermissions)
+        {
+            size_t alignment = std::max(inAlignment, m_AllocatePageSize);
+            bool hugePages = m_Options.m_UseHugePages && inLength >= m_Options.m_HugePageThreshold;
+            if (hugePages)
+            {
+                // the kernel can only back huge page aligned ranges with huge pages
+                alignment = std::max(alignment, kHugePageSize);
+            }
+
+            void *address = Reserve(inAddress, inLength, alignment);
+            if (address == nullptr)
+            {
+                return nullptr;
+            }
+            // a no access reservation isn't committed till v8 sets the permissions on part of it
+            if (inPermissions != kNoAccess && inPermissions != kNoAccessWillJitLater)
+            {
+                if (mprotect(address, inLength, PermissionToProtection(inPermissions)) != 0)
+                {
+                    munmap(address, inLength);
+                    return nullptr;
+                }
+            }
+            if (hugePages)
+            {
+                hugePages = AdviseHugePages(address, inLength);
+            }
+            TrackReservation(address, inLength, hugePages);
+            if (inPermissions != kNoAccess && inPermissions != kNoAccessWillJitLater)
+            {
+                TrackCommit(address, inLength);
+            }
+            return address;
+        }
+
+        bool V8AppPageAllocator::FreePages(void *inAddress, size_t inLength)
+        {
+            if (munmap(inAddress, inLength) != 0)
+            {
+                return false;
+            }
+            UntrackReservation(inAddress, inLength);
+            UntrackCommit(inAddress, inLength);
+            return true;
+        }
+
+        bool V8AppPageAllocator::ReleasePages(void *inAddress, size_t inLength, size_t inNewLength)
+        {
+            DCHECK_LT(inNewLength, inLength);
+            if (munmap(static_cast<uint8_t *>(inAddress) + inNewLength, inLength - inNewLength) != 0)
+            {
+                return false;
+            }
+            void *released = static_cast<uint8_t *>(inAddress) + inNewLength;
+            UntrackReservation(released, inLength - inNewLength);
+            UntrackCommit(released, inLength - inNewLength);
+            return true;
+        }
+
+        bool V8AppPageAllocator::SetPermissions(void *inAddress, size_t inLength, Permission inPermissions)
+        {
+            if (mprotect(inAddress, inLength, PermissionToProtection(inPermissions)) != 0)
+            {
+                return false;
+            }
+            if (inPermissions == kNoAccess || inPermissions == kNoAccessWillJitLater)
+            {
+                // pages that can't be accessed anymore don't need to keep their memory
+                if (inPermissions == kNoAccess)
+                {
+                    madvise(inAddress, inLength, MADV_DONTNEED);
+                    m_DecommittedBytes += inLength;
+                }
+                UntrackCommit(inAddress, inLength);
+            }
+            else if (IsCommitted(inAddress, inLength) == false)
+            {
+                TrackCommit(inAddress, inLength);
+            }
+            return true;
+        }
+
+        bool V8AppPageAllocator::RecommitPages(void *inAddress, size_t inLength, Permission inPermissions)
+        {
+            // discarded pages come back on the next touch so only the permissions need restoring
+            return SetPermissions(inAddress, inLength, inPermissions);
+        }
+
+        bool V8AppPageAllocator::DiscardSystemPages(void *inAddress, size_t inSize)
+        {
+            int result = -1;
+            if (m_Options.m_DiscardPolicy == PageDiscardPolicy::kFree && m_NoMadvFree == false)
+            {
+#if defined(MADV_FREE)
+                result = madvise(inAddress, inSize, MADV_FREE);
+                if (result != 0 && errno == EINVAL)
+                {
+                    // kernels before 4.5 don't support it
+                    m_NoMadvFree = true;
+                }
+#endif
+            }
+            if (result != 0)
+            {
+                result = madvise(inAddress, inSize, MADV_DONTNEED);
+            }
+            if (result == 0)
+            {
+                m_DiscardedBytes += inSize;
+            }
+            return result == 0;
+        }
+
+        bool V8AppPageAllocator::DecommitPages(void *inAddress, size_t inSize)
+        {
+            // mapping fresh no access pages over the range frees the memory and guarantees they read back as zero
+            void *address = mmap(inAddress, inSize, PROT_NONE, MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0);
+            if (address != inAddress)
+            {
+                return false;
+            }
+            m_DecommittedBytes += inSize;
+            UntrackCommit(inAddress, inSize);
+            return true;
+        }
+
+        V8AppPageAllocatorStats V8AppPageAllocator::GetStats()
+        {
+            V8AppPageAllocatorStats stats;
+            {
+                std::shared_lock<std::shared_mutex> lock(m_ReservationLock);
+                for (const auto &it : m_Reservations)
+                {
+                    stats.m_ReservedBytes += it.second.m_Length;
+                }
+                for (const auto &it : m_Commits)
+                {
+                    stats.m_CommittedBytes += it.second.m_Length;
+                }
+            }
+            stats.m_DiscardedBytes = m_DiscardedBytes;
+            stats.m_DecommittedBytes = m_DecommittedBytes;
+            stats.m_HugePageBytes = m_HugePageBytes;
+            return stats;
+        }
+
+        void *V8AppPageAllocator::Reserve(void *inHint, size_t inLength, size_t inAlignment)
+        {
+            // over reserve so an aligned range fits then give back the ends
+            size_t requestLength = inLength + (inAlignment - m_AllocatePageSize);
+            void *result = mmap(inHint, requestLength, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (result == MAP_FAILED)
+            {
+                return nullptr;
+            }
+            uintptr_t base = reinterpret_cast<uintptr_t>(result);
+            uintptr_t aligned = RoundUp(base, inAlignment);
+            size_t prefix = aligned - base;
+            if (prefix > 0)
+            {
+                munmap(result, prefix);
+            }
+            size_t suffix = requestLength - prefix - inLength;
+            if (suffix > 0)
+            {
+                munmap(reinterpret_cast<void *>(aligned + inLength), suffix);
+            }
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        bool V8AppPageAllocator::AdviseHugePages(void *inAddress, size_t inLength)
+        {
+            // only a hint, when thp is off the range just stays on normal pages
+            if (madvise(inAddress, inLength, MADV_HUGEPAGE) != 0)
+            {
+                return false;
+            }
+            m_HugePageBytes += inLength;
+            return true;
+        }
+
+        V8AppPageAccountSharedPtr V8AppPageAllocator::GetCurrentAccount()
+        {
+            return s_CurrentAccount != nullptr ? s_CurrentAccount : m_SharedAccount;
+        }
+
+        void V8AppPageAllocator::TrackReservation(void *inAddress, size_t inLength, bool inHugePages)
+        {
+            V8AppPageAccountSharedPtr account = GetCurrentAccount();
+            account->AddReserved(inLength);
+            std::lock_guard<std::shared_mutex> lock(m_ReservationLock);
+            m_Reservations[reinterpret_cast<uintptr_t>(inAddress)] = PageRange{inLength, inHugePages, std::move(account)};
+        }
+
+        bool V8AppPageAllocator::IsCommitted(void *inAddress, size_t inLength)
+        {
+            uintptr_t start = reinterpret_cast<uintptr_t>(inAddress);
+            uintptr_t end = start + inLength;
+
+            std::shared_lock<std::shared_mutex> lock(m_ReservationLock);
+            auto it = m_Commits.upper_bound(start);
+            if (it == m_Commits.begin())
+            {
+                return false;
+            }
+            it--;
+            // the commits have to run on from each other with no gap till the end
+            uintptr_t cursor = start;
+            while (it != m_Commits.end() && it->first <= cursor)
+            {
+                cursor = std::max(cursor, it->first + it->second.m_Length);
+                if (cursor >= end)
+                {
+                    return true;
+                }
+                it++;
+            }
+            return false;
+        }
+
+        void V8AppPageAllocator::TrackCommit(void *inAddress, size_t inLength)
+        {
+            V8AppPageAccountSharedPtr account = GetCurrentAccount();
+            uintptr_t start = reinterpret_cast<uintptr_t>(inAddress);
+            uintptr_t end = start + inLength;
+
+            std::lock_guard<std::shared_mutex> lock(m_ReservationLock);
+            // changing the permissions of pages that are already committed doesn't commit them again so only
+            // the gaps between the existing commits are charged
+            auto it = m_Commits.upper_bound(start);
+            if (it != m_Commits.begin())
+            {
+                it--;
+            }
+            uintptr_t cursor = start;
+            while (cursor < end)
+            {
+                uintptr_t nextStart = end;
+                uintptr_t nextEnd = end;
+                if (it != m_Commits.end() && it->first < end)
+                {
+                    nextStart = std::max(it->first, cursor);
+                    nextEnd = it->first + it->second.m_Length;
+                    it++;
+                }
+                if (nextStart > cursor)
+                {
+                    m_Commits.emplace(cursor, PageRange{nextStart - cursor, false, account});
+                    account->AddCommitted(nextStart - cursor);
+                }
+                cursor = std::max(cursor, nextEnd);
+            }
+
+            // join the commits that run on from each other and are charged to the same account so the
+            // range is a single entry when it's checked again
+            it = m_Commits.lower_bound(start);
+            if (it != m_Commits.begin())
+            {
+                it--;
+            }
+            while (it != m_Commits.end() && it->first <= end)
+            {
+                auto next = std::next(it);
+                if (next != m_Commits.end() && next->first == it->first + it->second.m_Length &&
+                    next->second.m_Account == it->second.m_Account)
+                {
+                    it->second.m_Length += next->second.m_Length;
+                    m_Commits.erase(next);
+                }
+                else
+                {
+                    it = next;
+                }
+            }
+        }
+
+        void V8AppPageAllocator::UntrackReservation(void *inAddress, size_t inLength)
+        {
+            std::lock_guard<std::shared_mutex> lock(m_ReservationLock);
+            RemoveRanges(m_Reservations, reinterpret_cast<uintptr_t>(inAddress), inLength, false);
+        }
+
+        void V8AppPageAllocator::UntrackCommit(void *inAddress, size_t inLength)
+        {
+            std::lock_guard<std::shared_mutex> lock(m_ReservationLock);
+            RemoveRanges(m_Commits, reinterpret_cast<uintptr_t>(inAddress), inLength, true);
+        }
+
+        void V8AppPageAllocator::RemoveRanges(PageRangeMap &inRanges, uintptr_t inStart, size_t inLength, bool inCommitted)
+        {
+            uintptr_t end = inStart + inLength;
+            // the range before the start may run into it
+            auto it = inRanges.upper_bound(inStart);
+            if (it != inRanges.begin())
+            {
+                it--;
+            }
+            while (it != inRanges.end() && it->first < end)
+            {
+                uintptr_t rangeStart = it->first;
+                uintptr_t rangeEnd = rangeStart + it->second.m_Length;
+                if (rangeEnd <= inStart)
+                {
+                    it++;
+                    continue;
+                }
+                PageRange range = std::move(it->second);
+                it = inRanges.erase(it);
+
+                uintptr_t removeStart = std::max(rangeStart, inStart);
+                uintptr_t removeEnd = std::min(rangeEnd, end);
+                size_t removed = removeEnd - removeStart;
+                if (inCommitted)
+                {
+                    range.m_Account->RemoveCommitted(removed);
+                }
+                else
+                {
+                    range.m_Account->RemoveReserved(removed);
+                }
+                if (range.m_HugePages)
+                {
+                    m_HugePageBytes -= removed;
+                }
+
+                // put back what's left either side of the removed part
+                if (rangeStart < removeStart)
+                {
+                    inRanges.emplace(rangeStart, PageRange{removeStart - rangeStart, range.m_HugePages, range.m_Account});
+                }
+                if (removeEnd < rangeEnd)
+                {
+                    inRanges.emplace(removeEnd, PageRange{rangeEnd - removeEnd, range.m_HugePages, range.m_Account});
+                }
+            }
+        }
+#endif
+    } // namespace JSRuntime
+} // namespace v8App
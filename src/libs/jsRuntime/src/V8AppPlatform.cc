@@ -9,7 +9,10 @@
 #include "Time/Time.h"
 #include "Logging/LogMacros.h"
 #include "Logging/Log.h"
+#include "Memory/MemoryPressure.h"
 #include "V8AppPlatform.h"
+#include "V8AppPageAllocator.h"
+#include "V8AppTracingController.h"
 #include "V8Jobs.h"
 #include "v8/v8.h"
 #include "JSRuntime.h"
@@ -18,19 +21,31 @@ namespace v8App
 {
     namespace JSRuntime
     {
+        V8AppBlockingScope::V8AppBlockingScope(V8BlockingType inType)
+            : m_BlockingCall(inType == V8BlockingType::kWillBlock ? Threads::BlockingType::kWillBlock : Threads::BlockingType::kMayBlock)
+        {
+        }
+
         std::shared_ptr<V8AppPlatform> V8AppPlatform::s_Platform;
         bool V8AppPlatform::s_PlatformDestroyed = false;
         bool V8AppPlatform::s_PlatformInited = false;
 
         V8AppPlatform::V8AppPlatform()
         {
-            m_TracingController = std::make_unique<V8TracingController>();
+            m_TracingController = std::make_unique<V8AppTracingController>();
             int cores = Threads::GetHardwareCores();
             m_NumberOfWorkers = std::max(1, cores);
-            for (int idx = 0; idx <= static_cast<int>(Threads::ThreadPriority::kMaxPriority); idx++)
-            {
-                m_WorkerRunners[idx] = std::make_shared<WorkerTaskRunner>(m_NumberOfWorkers, IntToPriority(idx));
-            }
+            // the pool starts with a single worker and grows up to the number of cores when v8 posts bursts of work
+            Threads::ElasticPoolOptions options;
+            options.m_MinWorkers = 1;
+            options.m_MaxWorkers = m_NumberOfWorkers;
+            m_WorkerPool = std::make_unique<Threads::ThreadPoolLaneQueue>(options, Threads::ThreadPriority::kUserVisible);
+            m_JobLimiter = std::make_shared<V8JobConcurrencyLimiter>(m_NumberOfWorkers);
+#if defined(V8APP_LINUX)
+            // can be replaced before InitializeV8 hands it to v8 and cppgc
+            m_PageAllocator = std::make_unique<V8AppPageAllocator>();
+#endif
+            InstallHighAllocationObserver(new V8AppHighAllocationObserver());
         }
 
         V8AppPlatform::~V8AppPlatform()
@@ -50,7 +65,8 @@ namespace v8App
 
         void V8AppPlatform::OnCriticalMemoryPressure()
         {
-            // for now we do nothing
+            // v8 failed to allocate so have everything give back what it can before it retries
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kCritical);
         }
 
         int V8AppPlatform::NumberOfWorkerThreads()
@@ -69,13 +85,17 @@ namespace v8App
         {
             // make sure it's not null in debug
             DCHECK_NE(m_IsolateHelper, nullptr);
+            if (m_AppHighAllocObserver != nullptr && m_AppHighAllocObserver->ShouldPauseIdleTasks(inIsolate))
+            {
+                return false;
+            }
             return m_IsolateHelper->IdleTasksEnabled(inIsolate);
         }
 
         std::unique_ptr<v8::ScopedBlockingCall> V8AppPlatform::CreateBlockingScope(V8BlockingType blocking_type)
         {
-            // For now return nullptr
-            return nullptr;
+            // only does something on one of the worker pool's threads
+            return std::make_unique<V8AppBlockingScope>(blocking_type);
         }
 
         double V8AppPlatform::MonotonicallyIncreasingTime()
@@ -85,7 +105,7 @@ namespace v8App
 
         double V8AppPlatform::CurrentClockTimeMillis()
         {
-            return Time::MonotonicallyIncreasingTimeMilliSeconds();
+            return Time::CurrentWallClockTimeMilliSeconds();
         }
 
         V8Platform::StackTracePrinter V8AppPlatform::GetStackTracePrinter()
@@ -107,7 +127,6 @@ namespace v8App
 
         V8HighAllocationThroughputObserver *V8AppPlatform::GetHighAllocationThroughputObserver()
         {
-            // for now call the base
             if (m_HighAllocObserver == nullptr)
             {
                 return V8Platform::GetHighAllocationThroughputObserver();
@@ -125,7 +144,8 @@ namespace v8App
 
         void V8AppPlatform::SetPageAllocator(V8PageAllocator *inAllocator)
         {
-            if (s_PlatformInited != false && inAllocator != nullptr)
+            // v8 and cppgc hold on to the allocator from initialization so it can't change after
+            if (s_PlatformInited == false && inAllocator != nullptr)
             {
                 m_PageAllocator.reset(inAllocator);
             }
@@ -133,7 +153,8 @@ namespace v8App
 
         void V8AppPlatform::SetThreadIsolatatedAllocator(V8ThreadIsolatedAllocator *inAllocator)
         {
-            if (s_PlatformInited != false && inAllocator != nullptr)
+            // v8 holds on to the allocator from initialization so it can't change after
+            if (s_PlatformInited == false && inAllocator != nullptr)
             {
                 m_ThreadIsolatedAllocator.reset(inAllocator);
             }
@@ -141,9 +162,27 @@ namespace v8App
 
         void V8AppPlatform::SetHighAllocatoionObserver(V8HighAllocationThroughputObserver *inObserver)
         {
-            if (s_PlatformInited != false && inObserver != nullptr)
+            // v8 holds on to the observer from when an isolate is created so it can't change after
+            if (s_PlatformInited == false && inObserver != nullptr)
+            {
+                InstallHighAllocationObserver(inObserver);
+            }
+        }
+
+        void V8AppPlatform::InstallHighAllocationObserver(V8HighAllocationThroughputObserver *inObserver)
+        {
+            if (m_AppHighAllocObserver != nullptr)
+            {
+                m_AppHighAllocObserver->SetListener(nullptr);
+            }
+            // end a boost the old observer started
+            OnHighAllocationBurst(false);
+            m_HighAllocObserver.reset(inObserver);
+            m_AppHighAllocObserver = dynamic_cast<V8AppHighAllocationObserver *>(inObserver);
+            if (m_AppHighAllocObserver != nullptr)
             {
-                m_HighAllocObserver.reset(inObserver);
+                m_AppHighAllocObserver->SetListener([this](bool inEntered)
+                                                    { OnHighAllocationBurst(inEntered); });
             }
         }
 
@@ -152,7 +191,7 @@ namespace v8App
             m_IsolateHelper = std::move(inHelper);
         }
 
-        void V8AppPlatform::InitializeV8(PlatformRuntimeProviderUniquePtr inHelper)
+        void V8AppPlatform::InitializeV8(PlatformRuntimeProviderUniquePtr inHelper, std::optional<V8JobConcurrencyPolicy> inJobPolicy)
         {
             if (s_Platform != nullptr && s_PlatformInited)
             {
@@ -168,6 +207,10 @@ namespace v8App
                 return;
             }
             Get()->SetIsolateHelper(std::move(inHelper));
+            if (inJobPolicy.has_value())
+            {
+                Get()->SetJobConcurrencyPolicy(inJobPolicy.value());
+            }
             v8::V8::InitializePlatform(Get().get());
             v8::V8::Initialize();
             cppgc::InitializeProcess(s_Platform->GetPageAllocator());
@@ -180,10 +223,7 @@ namespace v8App
             {
                 return;
             }
-            for (int idx = 0; idx <= static_cast<int>(Threads::ThreadPriority::kMaxPriority); idx++)
-            {
-                s_Platform->m_WorkerRunners[idx]->Terminate();
-            }
+            s_Platform->m_WorkerPool->Terminate();
             if (s_PlatformInited)
             {
                 cppgc::ShutdownProcess();
@@ -206,38 +246,99 @@ namespace v8App
 
         bool V8AppPlatform::SetWorkersPaused(bool inPaused)
         {
-            for(int idx = 0; idx < static_cast<int>(Threads::ThreadPriority::kMaxPriority) + 1; idx++)
+            m_WorkerPool->SetPaused(inPaused);
+            return true;
+        }
+
+        void V8AppPlatform::SetJobConcurrencyPolicy(const V8JobConcurrencyPolicy &inPolicy)
+        {
+            m_JobLimiter->SetPolicy(inPolicy);
+        }
+
+        V8JobConcurrencyPolicy V8AppPlatform::GetJobConcurrencyPolicy()
+        {
+            return m_JobLimiter->GetPolicy();
+        }
+
+        Threads::PoolMetricsSnapshot V8AppPlatform::GetWorkerMetrics()
+        {
+            return m_WorkerPool->GetMetrics();
+        }
+
+        void V8AppPlatform::DumpWorkerMetrics(std::ostream &inStream)
+        {
+            inStream << "Worker pool workers: " << m_WorkerPool->GetNumberOfActiveWorkers() << "/" << m_WorkerPool->GetNumberOfWorkers() << "\n";
+            // kDefault shares the user visible lane so it's not listed
+            for (int idx = static_cast<int>(Threads::ThreadPriority::kBestEffort); idx < static_cast<int>(Threads::ThreadPriority::kMaxPriority) + 1; idx++)
             {
-                m_WorkerRunners[idx]->SetPaused(inPaused);
+                Threads::ThreadPriority lane = IntToPriority(idx);
+                inStream << "  Lane " << idx << ": queued=" << m_WorkerPool->GetLaneQueuedCount(lane)
+                         << " running=" << m_WorkerPool->GetLaneRunningCount(lane)
+                         << " cap=" << m_WorkerPool->GetLaneConcurrency(lane) << "\n";
+            }
+            m_WorkerPool->GetMetrics().Dump(inStream);
+            if (m_AppHighAllocObserver != nullptr)
+            {
+                m_AppHighAllocObserver->DumpStats(inStream);
+            }
+        }
+
+        bool V8AppPlatform::AreWorkersBoosted()
+        {
+            std::lock_guard<std::mutex> lock(m_BurstLock);
+            return m_WorkersBoosted;
+        }
+
+        void V8AppPlatform::OnHighAllocationBurst(bool inEntered)
+        {
+            std::lock_guard<std::mutex> lock(m_BurstLock);
+            if (inEntered)
+            {
+                if (m_WorkersBoosted || m_AppHighAllocObserver == nullptr || m_AppHighAllocObserver->GetOptions().m_BoostWorkers == false)
+                {
+                    return;
+                }
+                // v8 posts the concurrent marking and sweeping that keeps up with the allocations as best
+                // effort so let it have the whole pool instead of it's usual share
+                m_SavedBestEffortConcurrency = m_WorkerPool->GetLaneConcurrency(Threads::ThreadPriority::kBestEffort);
+                m_WorkerPool->SetLaneConcurrency(Threads::ThreadPriority::kBestEffort, m_WorkerPool->GetNumberOfWorkers());
+                m_BoostedBestEffortConcurrency = m_WorkerPool->GetLaneConcurrency(Threads::ThreadPriority::kBestEffort);
+                m_WorkersBoosted = true;
+            }
+            else if (m_WorkersBoosted)
+            {
+                // someone set the cap during the burst so theirs wins over the one from before it
+                if (m_WorkerPool->GetLaneConcurrency(Threads::ThreadPriority::kBestEffort) == m_BoostedBestEffortConcurrency)
+                {
+                    m_WorkerPool->SetLaneConcurrency(Threads::ThreadPriority::kBestEffort, m_SavedBestEffortConcurrency);
+                }
+                m_WorkersBoosted = false;
             }
-            return true;
         }
 
         V8JobHandleUniquePtr V8AppPlatform::CreateJobImpl(
             V8TaskPriority priority, std::unique_ptr<v8::JobTask> job_task,
             const V8SourceLocation &location)
         {
-            size_t numWorkers = NumberOfWorkerThreads();
-            if (priority == V8TaskPriority::kBestEffort || numWorkers > 2)
-            {
-                numWorkers = 2;
-            }
-            return std::make_unique<V8JobHandle>(std::make_shared<V8JobState>(this, std::move(job_task), priority, numWorkers));
+            size_t numWorkers = m_JobLimiter->GetMaxWorkers(priority);
+            return std::make_unique<V8JobHandle>(std::make_shared<V8JobState>(this, std::move(job_task), priority, numWorkers, m_JobLimiter));
         }
 
         void V8AppPlatform::PostTaskOnWorkerThreadImpl(V8TaskPriority priority,
                                                     V8TaskUniquePtr task,
                                                     const V8SourceLocation &location)
         {
-            int idx = PriorityToInt(priority);
-            m_WorkerRunners[idx]->PostTask(std::move(task));
+            Threads::ThreadPoolTaskUniquePtr poolTask = std::make_unique<Threads::CallableThreadTask>([task = std::move(task)]
+                                                                                                      { task->Run(); });
+            m_WorkerPool->PostTask(IntToPriority(PriorityToInt(priority)), std::move(poolTask));
         }
         void V8AppPlatform::PostDelayedTaskOnWorkerThreadImpl(
             V8TaskPriority priority, V8TaskUniquePtr task,
             double delay_in_seconds, const V8SourceLocation &location)
         {
-            int idx = PriorityToInt(priority);
-            m_WorkerRunners[idx]->PostDelayedTask(std::move(task), delay_in_seconds);
+            Threads::ThreadPoolTaskUniquePtr poolTask = std::make_unique<Threads::CallableThreadTask>([task = std::move(task)]
+                                                                                                      { task->Run(); });
+            m_WorkerPool->PostDelayedTask(IntToPriority(PriorityToInt(priority)), delay_in_seconds, std::move(poolTask));
         }
 
     } // namespace JSRuntime
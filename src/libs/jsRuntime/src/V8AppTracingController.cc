@@ -0,0 +1,161 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+
+#include "Time/Clock.h"
+#include "V8AppTracingController.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        namespace
+        {
+            // v8's TRACE_VALUE_TYPE_* values
+            constexpr uint8_t kV8TraceValueBool = 1;
+            constexpr uint8_t kV8TraceValueUInt = 2;
+            constexpr uint8_t kV8TraceValueInt = 3;
+            constexpr uint8_t kV8TraceValueDouble = 4;
+            constexpr uint8_t kV8TraceValuePointer = 5;
+            constexpr uint8_t kV8TraceValueString = 6;
+            constexpr uint8_t kV8TraceValueCopyString = 7;
+            constexpr uint8_t kV8TraceValueConvertable = 8;
+
+            Tracing::TraceArgType ToTraceArgType(uint8_t inType)
+            {
+                switch (inType)
+                {
+                case kV8TraceValueBool:
+                    return Tracing::TraceArgType::kBool;
+                case kV8TraceValueUInt:
+                    return Tracing::TraceArgType::kUInt;
+                case kV8TraceValueInt:
+                    return Tracing::TraceArgType::kInt;
+                case kV8TraceValueDouble:
+                    return Tracing::TraceArgType::kDouble;
+                case kV8TraceValuePointer:
+                    return Tracing::TraceArgType::kPointer;
+                case kV8TraceValueString:
+                case kV8TraceValueCopyString:
+                    return Tracing::TraceArgType::kString;
+                case kV8TraceValueConvertable:
+                    return Tracing::TraceArgType::kJSON;
+                default:
+                    return Tracing::TraceArgType::kNone;
+                }
+            }
+        } // namespace
+
+        V8AppTracingController::V8AppTracingController()
+        {
+            m_ListenerId = Tracing::TraceLog::AddStateListener([this](bool inTracing)
+                                                               { OnTraceStateChanged(inTracing); });
+        }
+
+        V8AppTracingController::~V8AppTracingController()
+        {
+            Tracing::TraceLog::RemoveStateListener(m_ListenerId);
+        }
+
+        const uint8_t *V8AppTracingController::GetCategoryGroupEnabled(const char *inName)
+        {
+            return Tracing::TraceLog::GetCategoryGroupEnabled(inName);
+        }
+
+        uint64_t V8AppTracingController::AddTraceEvent(char inPhase, const uint8_t *inCategoryEnabledFlag, const char *inName, const char *inScope,
+                                                       uint64_t inId, uint64_t inBindId, int32_t inNumArgs, const char **inArgNames,
+                                                       const uint8_t *inArgTypes, const uint64_t *inArgValues,
+                                                       std::unique_ptr<v8::ConvertableToTraceFormat> *inArgConvertables, unsigned int inFlags)
+        {
+            return AddTraceEventWithTimestamp(inPhase, inCategoryEnabledFlag, inName, inScope, inId, inBindId, inNumArgs, inArgNames,
+                                              inArgTypes, inArgValues, inArgConvertables, inFlags, Time::NowNanoseconds() / 1000);
+        }
+
+        uint64_t V8AppTracingController::AddTraceEventWithTimestamp(char inPhase, const uint8_t *inCategoryEnabledFlag, const char *inName,
+                                                                    const char *inScope, uint64_t inId, uint64_t inBindId, int32_t inNumArgs,
+                                                                    const char **inArgNames, const uint8_t *inArgTypes, const uint64_t *inArgValues,
+                                                                    std::unique_ptr<v8::ConvertableToTraceFormat> *inArgConvertables,
+                                                                    unsigned int inFlags, int64_t inTimestamp)
+        {
+            if (Tracing::TraceLog::IsTracing() == false)
+            {
+                return 0;
+            }
+            int numArgs = std::min(static_cast<int>(inNumArgs), Tracing::kMaxTraceArgs);
+            Tracing::TraceArg args[Tracing::kMaxTraceArgs];
+            for (int idx = 0; idx < numArgs; idx++)
+            {
+                Tracing::TraceArg &arg = args[idx];
+                arg.m_Name = inArgNames[idx];
+                arg.m_Type = ToTraceArgType(inArgTypes[idx]);
+                switch (inArgTypes[idx])
+                {
+                case kV8TraceValueString:
+                case kV8TraceValueCopyString:
+                {
+                    const char *value = reinterpret_cast<const char *>(inArgValues[idx]);
+                    arg.m_String = value == nullptr ? "" : value;
+                    break;
+                }
+                case kV8TraceValueConvertable:
+                    if (inArgConvertables != nullptr && inArgConvertables[idx] != nullptr)
+                    {
+                        inArgConvertables[idx]->AppendAsTraceFormat(&arg.m_String);
+                    }
+                    break;
+                default:
+                    arg.m_Value = inArgValues[idx];
+                }
+            }
+            // v8 times are microseconds on the monotonic clock
+            return Tracing::TraceLog::AddTraceEvent(inPhase, inCategoryEnabledFlag, inName, inScope, inId, inFlags,
+                                                    inTimestamp * 1000, numArgs, args);
+        }
+
+        void V8AppTracingController::UpdateTraceEventDuration(const uint8_t *inCategoryEnabledFlag, const char *inName, uint64_t inHandle)
+        {
+            Tracing::TraceLog::UpdateTraceEventDuration(inHandle, Time::NowNanoseconds());
+        }
+
+        void V8AppTracingController::AddTraceStateObserver(TraceStateObserver *inObserver)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_ObserverLock);
+                m_Observers.push_back(inObserver);
+            }
+            // v8 expects to hear about tracing that's already on
+            if (Tracing::TraceLog::IsTracing())
+            {
+                inObserver->OnTraceEnabled();
+            }
+        }
+
+        void V8AppTracingController::RemoveTraceStateObserver(TraceStateObserver *inObserver)
+        {
+            std::lock_guard<std::mutex> lock(m_ObserverLock);
+            m_Observers.erase(std::remove(m_Observers.begin(), m_Observers.end(), inObserver), m_Observers.end());
+        }
+
+        void V8AppTracingController::OnTraceStateChanged(bool inTracing)
+        {
+            std::vector<TraceStateObserver *> observers;
+            {
+                std::lock_guard<std::mutex> lock(m_ObserverLock);
+                observers = m_Observers;
+            }
+            for (TraceStateObserver *observer : observers)
+            {
+                if (inTracing)
+                {
+                    observer->OnTraceEnabled();
+                }
+                else
+                {
+                    observer->OnTraceDisabled();
+                }
+            }
+        }
+    } // namespace JSRuntime
+} // namespace v8App
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a MIT license that can be
 // found in the LICENSE file.
 
+#include <bit>
+
 #include "Logging/LogMacros.h"
 
 #include "V8Jobs.h"
@@ -10,9 +12,189 @@ namespace v8App
 {
     namespace JSRuntime
     {
+        uint8_t V8JobTaskIdSet::Acquire()
+        {
+            for (size_t word = 0; word < kV8JobTaskIdWords; word++)
+            {
+                V8JobTaskIdWord bits = m_Words[word].load(std::memory_order::relaxed);
+                while (bits != std::numeric_limits<V8JobTaskIdWord>::max())
+                {
+                    size_t bit = std::countr_one(bits);
+                    size_t id = word * kV8JobTaskIdWordBits + bit;
+                    if (id >= kV8JobMaxTaskIds)
+                    {
+                        return kInvalidTaskId;
+                    }
+                    V8JobTaskIdWord mask = V8JobTaskIdWord(1) << bit;
+                    // setting a bit that's already set changes nothing so a lost race just tries the next one
+                    bits = m_Words[word].fetch_or(mask, std::memory_order::acquire);
+                    if ((bits & mask) == 0)
+                    {
+                        return static_cast<uint8_t>(id);
+                    }
+                }
+            }
+            return kInvalidTaskId;
+        }
+
+        bool V8JobTaskIdSet::Release(uint8_t inId)
+        {
+            if (inId >= kV8JobMaxTaskIds)
+            {
+                return false;
+            }
+            V8JobTaskIdWord mask = V8JobTaskIdWord(1) << (inId % kV8JobTaskIdWordBits);
+            V8JobTaskIdWord previous = m_Words[inId / kV8JobTaskIdWordBits].fetch_and(~mask, std::memory_order::release);
+            return (previous & mask) != 0;
+        }
+
+        bool V8JobTaskIdSet::IsAssigned(uint8_t inId) const
+        {
+            if (inId >= kV8JobMaxTaskIds)
+            {
+                return false;
+            }
+            V8JobTaskIdWord mask = V8JobTaskIdWord(1) << (inId % kV8JobTaskIdWordBits);
+            return (m_Words[inId / kV8JobTaskIdWordBits].load(std::memory_order::relaxed) & mask) != 0;
+        }
+
+        size_t V8JobTaskIdSet::GetAssignedCount() const
+        {
+            size_t count = 0;
+            for (const std::atomic<V8JobTaskIdWord> &word : m_Words)
+            {
+                count += std::popcount(word.load(std::memory_order::relaxed));
+            }
+            return count;
+        }
+
+        V8JobConcurrencyLimiter::V8JobConcurrencyLimiter(size_t inNumWorkers, const V8JobConcurrencyPolicy &inPolicy)
+            : m_NumWorkers(std::max<size_t>(1, inNumWorkers)), m_Policy(inPolicy)
+        {
+        }
+
+        void V8JobConcurrencyLimiter::SetPolicy(const V8JobConcurrencyPolicy &inPolicy)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                m_Policy = inPolicy;
+            }
+            // the cap may have gone up so let the waiting jobs try again
+            WakeWaiters();
+        }
+
+        V8JobConcurrencyPolicy V8JobConcurrencyLimiter::GetPolicy()
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            return m_Policy;
+        }
+
+        size_t V8JobConcurrencyLimiter::GetMaxWorkers(V8TaskPriority inPriority)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            switch (inPriority)
+            {
+            case V8TaskPriority::kUserBlocking:
+                return ResolveWorkers(m_Policy.m_MaxUserBlockingWorkers);
+            case V8TaskPriority::kUserVisible:
+                return ResolveWorkers(m_Policy.m_MaxUserVisibleWorkers);
+            default:
+                return ResolveWorkers(m_Policy.m_MaxBestEffortWorkers);
+            }
+        }
+
+        bool V8JobConcurrencyLimiter::ReserveJoiningThread()
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            return m_Policy.m_ReserveJoiningThread;
+        }
+
+        size_t V8JobConcurrencyLimiter::GetGlobalMaxWorkers()
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            return ResolveWorkers(m_Policy.m_GlobalMaxWorkers);
+        }
+
+        size_t V8JobConcurrencyLimiter::GetActiveWorkers()
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            return m_ActiveWorkers;
+        }
+
+        bool V8JobConcurrencyLimiter::TryAcquireWorker(std::weak_ptr<V8JobState> inWaiter)
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            if (m_ActiveWorkers < ResolveWorkers(m_Policy.m_GlobalMaxWorkers))
+            {
+                m_ActiveWorkers++;
+                return true;
+            }
+            // a job only needs to be told once
+            for (const std::weak_ptr<V8JobState> &waiter : m_Waiting)
+            {
+                if (waiter.owner_before(inWaiter) == false && inWaiter.owner_before(waiter) == false)
+                {
+                    return false;
+                }
+            }
+            m_Waiting.push_back(std::move(inWaiter));
+            return false;
+        }
+
+        void V8JobConcurrencyLimiter::ReleaseWorker()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                DCHECK_GT(m_ActiveWorkers, 0);
+                m_ActiveWorkers--;
+            }
+            WakeWaiters();
+        }
+
+        void V8JobConcurrencyLimiter::WakeWaiters()
+        {
+            size_t freeSlots = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                size_t maxWorkers = ResolveWorkers(m_Policy.m_GlobalMaxWorkers);
+                freeSlots = m_ActiveWorkers < maxWorkers ? maxWorkers - m_ActiveWorkers : 0;
+            }
+            while (freeSlots > 0)
+            {
+                std::shared_ptr<V8JobState> state;
+                {
+                    std::lock_guard<std::mutex> lock(m_Lock);
+                    // skip over jobs that have already gone away
+                    while (state == nullptr && m_Waiting.empty() == false)
+                    {
+                        state = m_Waiting.front().lock();
+                        m_Waiting.pop_front();
+                    }
+                }
+                if (state == nullptr)
+                {
+                    return;
+                }
+                // never call into the job while holding our lock, it calls back in to us. A job that's been
+                // canceled or has nothing left to run doesn't post so the slot goes to the next one.
+                size_t posted = state->NotifyConcurrencyIncrease();
+                freeSlots -= std::min(posted, freeSlots);
+            }
+        }
+
+        size_t V8JobConcurrencyLimiter::ResolveWorkers(int inWorkers)
+        {
+            if (inWorkers < 0)
+            {
+                return m_NumWorkers;
+            }
+            // a job always gets at least one worker so it can make progress without a join
+            return std::max<size_t>(1, static_cast<size_t>(inWorkers));
+        }
+
         V8JobState::V8JobDelegate::V8JobDelegate(V8JobState *inState, bool isJoiningThread) : m_JobState(inState), m_JoingThread(isJoiningThread)
         {
-            static_assert(V8JobState::kInvalidJobId >= V8JobTaskBits, "kInvalidJobID is not outside of the assignable task ids");
+            static_assert(V8JobState::kInvalidJobId >= kV8JobMaxTaskIds, "kInvalidJobID is not outside of the assignable task ids");
         }
 
         V8JobState::V8JobDelegate::~V8JobDelegate()
@@ -49,8 +231,10 @@ namespace v8App
             return m_JoingThread;
         }
 
-        V8JobState::V8JobState(V8Platform *inPlatfor, V8JobTaskUniquePtr inTask, V8TaskPriority inPriority, size_t inNumWorkers)
-            : m_Platform(inPlatfor), m_Task(std::move(inTask)), m_Priority(inPriority), m_NumWorkersAvailable(inNumWorkers)
+        V8JobState::V8JobState(V8Platform *inPlatfor, V8JobTaskUniquePtr inTask, V8TaskPriority inPriority, size_t inNumWorkers,
+                               V8JobConcurrencyLimiterSharedPtr inLimiter)
+            : m_Platform(inPlatfor), m_Task(std::move(inTask)), m_Priority(inPriority), m_NumWorkersAvailable(inNumWorkers),
+              m_Limiter(std::move(inLimiter))
         {
         }
 
@@ -59,42 +243,34 @@ namespace v8App
             DCHECK_EQ(0, m_ActiveTasks);
         }
 
-        void V8JobState::NotifyConcurrencyIncrease()
+        size_t V8JobState::NotifyConcurrencyIncrease()
         {
             if (m_Canceled.load(std::memory_order::relaxed))
             {
-                return;
+                return 0;
             }
             V8TaskPriority priority;
+            size_t numToPost;
             {
+                // the limiter calls this from any thread while Join and UpdatePriority change the state
                 std::unique_lock<std::mutex> lock(m_Lock);
                 priority = m_Priority;
+                numToPost = ComputeTaskToPost(GetMaxConcurrency(m_ActiveTasks));
             }
-            PostonWorkerThread(ComputeTaskToPost(GetMaxConcurrency(m_ActiveTasks)), priority);
+            PostonWorkerThread(numToPost, priority);
+            return numToPost;
         }
 
         uint8_t V8JobState::AcquireTaskId()
         {
-            V8JobTaskIdType assignedTaskIds = m_AssignedTaskIds.load(std::memory_order::relaxed);
-            V8JobTaskIdType newTaskIds;
-            uint8_t taskID;
-            do
-            {
-                taskID = FindFirstFreeTaskId(assignedTaskIds);
-                if (taskID == kInvalidJobId)
-                {
-                    return taskID;
-                }
-                newTaskIds = m_AssignedTaskIds | (1 << taskID);
-            } while (m_AssignedTaskIds.compare_exchange_weak(assignedTaskIds, newTaskIds, std::memory_order::acquire, std::memory_order::relaxed));
-            return taskID;
+            return m_AssignedTaskIds.Acquire();
         }
 
         void V8JobState::ReleaseTaskID(uint8_t inTaskId)
         {
-            V8JobTaskIdType previousTaskIDs = m_AssignedTaskIds.fetch_and(~(1 << inTaskId), std::memory_order::release);
-            DCHECK_TRUE(previousTaskIDs & (1 << inTaskId));
-            (void)previousTaskIDs;
+            bool wasAssigned = m_AssignedTaskIds.Release(inTaskId);
+            DCHECK_TRUE(wasAssigned);
+            (void)wasAssigned;
         }
 
         void V8JobState::Join()
@@ -124,13 +300,21 @@ namespace v8App
                 m_Priority = V8TaskPriority::kUserBlocking;
                 m_ActiveTasks++;
                 m_NumWorkersAvailable++;
+                m_Joined = true;
             }
             size_t maxConcurrency = WaitForRunOpportunity();
             if (maxConcurrency == 0)
             {
                 return;
             }
-            PostonWorkerThread(ComputeTaskToPost(maxConcurrency), m_Priority);
+            V8TaskPriority priority;
+            size_t numToPost;
+            {
+                std::unique_lock<std::mutex> lock(m_Lock);
+                priority = m_Priority;
+                numToPost = ComputeTaskToPost(maxConcurrency);
+            }
+            PostonWorkerThread(numToPost, priority);
             V8JobState::V8JobDelegate delegate(this, true);
             while (true)
             {
@@ -175,6 +359,10 @@ namespace v8App
             {
                 return false;
             }
+            if (m_Limiter != nullptr && m_Limiter->TryAcquireWorker(weak_from_this()) == false)
+            {
+                return false;
+            }
             m_ActiveTasks++;
             return true;
         }
@@ -182,6 +370,7 @@ namespace v8App
         bool V8JobState::DidRunFirstTask()
         {
             V8TaskPriority prioirty;
+            size_t numToPost;
             {
                 std::unique_lock<std::mutex> lock(m_Lock);
                 prioirty = m_Priority;
@@ -190,10 +379,16 @@ namespace v8App
                 {
                     m_ActiveTasks--;
                     m_WorkerReleased.notify_one();
+                    lock.unlock();
+                    if (m_Limiter != nullptr)
+                    {
+                        m_Limiter->ReleaseWorker();
+                    }
                     return false;
                 }
+                numToPost = ComputeTaskToPost(maxConcurrency);
             }
-            PostonWorkerThread(ComputeTaskToPost(GetMaxConcurrency(m_ActiveTasks - 1)), prioirty);
+            PostonWorkerThread(numToPost, prioirty);
             return true;
         }
 
@@ -203,9 +398,23 @@ namespace v8App
             m_Priority = inPriority;
         }
 
+        size_t V8JobState::GetWorkerCap()
+        {
+            if (m_Limiter == nullptr)
+            {
+                return m_NumWorkersAvailable;
+            }
+            size_t cap = m_Limiter->GetMaxWorkers(m_Priority);
+            if (m_Joined && m_Limiter->ReserveJoiningThread())
+            {
+                cap++;
+            }
+            // every worker needs a task id
+            return std::min(cap, kV8JobMaxTaskIds);
+        }
+
         size_t V8JobState::ComputeTaskToPost(size_t inMaxConcurrency)
         {
-            std::unique_lock<std::mutex> lock(m_Lock);
             if (inMaxConcurrency > m_ActiveTasks + m_PendingTasks)
             {
                 inMaxConcurrency -= m_ActiveTasks + m_PendingTasks;
@@ -235,19 +444,6 @@ namespace v8App
             }
         }
 
-        uint8_t V8JobState::FindFirstFreeTaskId(V8JobTaskIdType inIds)
-        {
-            for (uint8_t idx = 0; idx < V8JobTaskBits; idx++)
-            {
-                if ((1 << idx) & inIds)
-                {
-                    continue;
-                }
-                return idx;
-            }
-            return kInvalidJobId;
-        }
-
         V8JobHandle::V8JobHandle(std::shared_ptr<V8JobState> inState) : m_State(std::move(inState))
         {
         }
@@ -14,6 +14,10 @@ namespace v8App
         {
         }
 
+        WorkerTaskRunner::WorkerTaskRunner(const Threads::ElasticPoolOptions &inOptions, Threads::ThreadPriority inPriority) : m_Tasks(inOptions, inPriority)
+        {
+        }
+
         WorkerTaskRunner::~WorkerTaskRunner()
         {
             Terminate();
@@ -33,6 +37,35 @@ namespace v8App
             m_Tasks.PostDelayedTask(inDelaySeconds, std::move(task));
         }
 
+        Queues::TimerId WorkerTaskRunner::PostCancelableDelayedTask(V8TaskUniquePtr inTask, double inDelaySeconds)
+        {
+            Threads::ThreadPoolTaskUniquePtr task = std::make_unique<Threads::CallableThreadTask>([task = std::move(inTask)]
+                                                                                                  { task->Run(); });
+            return m_Tasks.PostCancelableDelayedTask(inDelaySeconds, std::move(task));
+        }
+
+        void WorkerTaskRunner::PostTasks(std::vector<V8TaskUniquePtr> inTasks)
+        {
+            m_Tasks.PostTasks(WrapTasks(std::move(inTasks)));
+        }
+
+        void WorkerTaskRunner::PostDelayedTasks(std::vector<V8TaskUniquePtr> inTasks, double inDelaySeconds)
+        {
+            m_Tasks.PostDelayedTasks(inDelaySeconds, WrapTasks(std::move(inTasks)));
+        }
+
+        std::vector<Threads::ThreadPoolTaskUniquePtr> WorkerTaskRunner::WrapTasks(std::vector<V8TaskUniquePtr> inTasks)
+        {
+            std::vector<Threads::ThreadPoolTaskUniquePtr> tasks;
+            tasks.reserve(inTasks.size());
+            for (V8TaskUniquePtr &inTask : inTasks)
+            {
+                tasks.push_back(std::make_unique<Threads::CallableThreadTask>([task = std::move(inTask)]
+                                                                              { task->Run(); }));
+            }
+            return tasks;
+        }
+
         void WorkerTaskRunner::PostNonNestableTaskImpl(V8TaskUniquePtr task,
                                                         const V8SourceLocation &location)
         {
@@ -0,0 +1,111 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "Memory/MemoryPressure.h"
+
+namespace v8App
+{
+    namespace Memory
+    {
+        TEST(MemoryPressureTest, RegisterUnregister)
+        {
+            size_t numCallbacks = MemoryPressure::GetNumberOfCallbacks();
+
+            EXPECT_EQ(kInvalidReclaimCallbackId, MemoryPressure::RegisterReclaimCallback("null", nullptr));
+            EXPECT_EQ(numCallbacks, MemoryPressure::GetNumberOfCallbacks());
+
+            ReclaimCallbackId id1 = MemoryPressure::RegisterReclaimCallback("test1", [](MemoryPressureLevel) {});
+            ReclaimCallbackId id2 = MemoryPressure::RegisterReclaimCallback("test2", [](MemoryPressureLevel) {});
+            EXPECT_NE(kInvalidReclaimCallbackId, id1);
+            EXPECT_NE(kInvalidReclaimCallbackId, id2);
+            EXPECT_NE(id1, id2);
+            EXPECT_EQ(numCallbacks + 2, MemoryPressure::GetNumberOfCallbacks());
+
+            EXPECT_TRUE(MemoryPressure::UnregisterReclaimCallback(id1));
+            EXPECT_FALSE(MemoryPressure::UnregisterReclaimCallback(id1));
+            EXPECT_FALSE(MemoryPressure::UnregisterReclaimCallback(kInvalidReclaimCallbackId));
+            EXPECT_TRUE(MemoryPressure::UnregisterReclaimCallback(id2));
+            EXPECT_EQ(numCallbacks, MemoryPressure::GetNumberOfCallbacks());
+        }
+
+        TEST(MemoryPressureTest, NotifyMemoryPressure)
+        {
+            std::vector<MemoryPressureLevel> levels1;
+            std::vector<MemoryPressureLevel> levels2;
+            ReclaimCallbackId id1 = MemoryPressure::RegisterReclaimCallback("test1", [&levels1](MemoryPressureLevel inLevel)
+                                                                            { levels1.push_back(inLevel); });
+            ReclaimCallbackId id2 = MemoryPressure::RegisterReclaimCallback("test2", [&levels2](MemoryPressureLevel inLevel)
+                                                                            { levels2.push_back(inLevel); });
+
+            MemoryPressure::NotifyMemoryPressure(MemoryPressureLevel::kModerate);
+            EXPECT_EQ(MemoryPressureLevel::kModerate, MemoryPressure::GetLastLevel());
+            MemoryPressure::NotifyMemoryPressure(MemoryPressureLevel::kCritical);
+            EXPECT_EQ(MemoryPressureLevel::kCritical, MemoryPressure::GetLastLevel());
+
+            std::vector<MemoryPressureLevel> expected = {MemoryPressureLevel::kModerate, MemoryPressureLevel::kCritical};
+            EXPECT_EQ(expected, levels1);
+            EXPECT_EQ(expected, levels2);
+
+            // unregistered callbacks aren't called
+            MemoryPressure::UnregisterReclaimCallback(id1);
+            MemoryPressure::NotifyMemoryPressure(MemoryPressureLevel::kNone);
+            EXPECT_EQ(MemoryPressureLevel::kNone, MemoryPressure::GetLastLevel());
+            EXPECT_EQ(2, levels1.size());
+            EXPECT_EQ(3, levels2.size());
+            EXPECT_EQ(MemoryPressureLevel::kNone, levels2.back());
+
+            MemoryPressure::UnregisterReclaimCallback(id2);
+        }
+
+        TEST(MemoryPressureTest, UnregisterDuringNotify)
+        {
+            size_t numCallbacks = MemoryPressure::GetNumberOfCallbacks();
+            int called1 = 0;
+            int called2 = 0;
+            ReclaimCallbackId id1 = kInvalidReclaimCallbackId;
+            ReclaimCallbackId id2 = kInvalidReclaimCallbackId;
+
+            // the first one removes itself and the one after it
+            id1 = MemoryPressure::RegisterReclaimCallback("test1", [&called1, &id1, &id2](MemoryPressureLevel)
+                                                          {
+                called1++;
+                MemoryPressure::UnregisterReclaimCallback(id1);
+                MemoryPressure::UnregisterReclaimCallback(id2); });
+            id2 = MemoryPressure::RegisterReclaimCallback("test2", [&called2](MemoryPressureLevel)
+                                                          { called2++; });
+
+            MemoryPressure::NotifyMemoryPressure(MemoryPressureLevel::kCritical);
+            EXPECT_EQ(1, called1);
+            EXPECT_EQ(0, called2);
+            EXPECT_EQ(numCallbacks, MemoryPressure::GetNumberOfCallbacks());
+
+            MemoryPressure::NotifyMemoryPressure(MemoryPressureLevel::kNone);
+            EXPECT_EQ(1, called1);
+            EXPECT_EQ(0, called2);
+        }
+
+        TEST(MemoryPressureTest, ScopedReclaimCallback)
+        {
+            size_t numCallbacks = MemoryPressure::GetNumberOfCallbacks();
+            int called = 0;
+            {
+                ScopedReclaimCallback scoped("scoped", [&called](MemoryPressureLevel)
+                                             { called++; });
+                EXPECT_NE(kInvalidReclaimCallbackId, scoped.GetId());
+                EXPECT_EQ(numCallbacks + 1, MemoryPressure::GetNumberOfCallbacks());
+                MemoryPressure::NotifyMemoryPressure(MemoryPressureLevel::kModerate);
+                EXPECT_EQ(1, called);
+            }
+            EXPECT_EQ(numCallbacks, MemoryPressure::GetNumberOfCallbacks());
+            MemoryPressure::NotifyMemoryPressure(MemoryPressureLevel::kNone);
+            EXPECT_EQ(1, called);
+        }
+    } // namespace Memory
+} // namespace v8App
@@ -0,0 +1,285 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Queues/TLockFreeQueue.h"
+
+namespace v8App
+{
+    namespace Queues
+    {
+        class TestLockFreeQueueTask
+        {
+        public:
+            ~TestLockFreeQueueTask() {}
+
+            void Run()
+            {
+            }
+        };
+
+        using LockFreeTaskUniquePtr = std::unique_ptr<TestLockFreeQueueTask>;
+
+        class TestLockFreeQueue : public TLockFreeQueue<LockFreeTaskUniquePtr>
+        {
+        public:
+            TestLockFreeQueue(size_t inCapacity, QueueFullPolicy inPolicy) : TLockFreeQueue(inCapacity, inPolicy) {}
+            size_t GetSpillSize() { return m_SpillCount; }
+            bool IsTerminated() { return m_Terminated; }
+        };
+
+        TEST(TLockFreeQueue, Constrcutor)
+        {
+            TestLockFreeQueue queue(5, QueueFullPolicy::kSpill);
+
+            EXPECT_FALSE(queue.IsTerminated());
+            EXPECT_EQ(8, queue.GetCapacity());
+            EXPECT_EQ(QueueFullPolicy::kSpill, queue.GetFullPolicy());
+            EXPECT_FALSE(queue.MayHaveItems());
+
+            TestLockFreeQueue small(0, QueueFullPolicy::kBlock);
+            EXPECT_EQ(2, small.GetCapacity());
+            EXPECT_EQ(QueueFullPolicy::kBlock, small.GetFullPolicy());
+        }
+
+        TEST(TLockFreeQueue, PushItemGetNextItem)
+        {
+            TestLockFreeQueue queue(4, QueueFullPolicy::kSpill);
+            LockFreeTaskUniquePtr taskPtr1 = std::make_unique<TestLockFreeQueueTask>();
+            LockFreeTaskUniquePtr taskPtr2 = std::make_unique<TestLockFreeQueueTask>();
+            TestLockFreeQueueTask *task1 = taskPtr1.get();
+            TestLockFreeQueueTask *task2 = taskPtr2.get();
+
+            EXPECT_FALSE(queue.GetNextItem());
+            queue.PushItem(std::move(taskPtr1));
+            EXPECT_TRUE(queue.MayHaveItems());
+            queue.PushItem(std::move(taskPtr2));
+
+            auto opt = queue.GetNextItem();
+            ASSERT_TRUE(opt.has_value());
+            EXPECT_EQ(opt.value().get(), task1);
+
+            opt = queue.GetNextItem();
+            ASSERT_TRUE(opt.has_value());
+            EXPECT_EQ(opt.value().get(), task2);
+
+            EXPECT_FALSE(queue.MayHaveItems());
+            EXPECT_FALSE(queue.GetNextItem());
+
+            // wrap around the ring a few times
+            for (int x = 0; x < 20; x++)
+            {
+                LockFreeTaskUniquePtr taskPtr = std::make_unique<TestLockFreeQueueTask>();
+                TestLockFreeQueueTask *task = taskPtr.get();
+                queue.PushItem(std::move(taskPtr));
+                opt = queue.GetNextItem();
+                ASSERT_TRUE(opt.has_value());
+                EXPECT_EQ(opt.value().get(), task);
+            }
+        }
+
+        TEST(TLockFreeQueue, SpillWhenFull)
+        {
+            TestLockFreeQueue queue(2, QueueFullPolicy::kSpill);
+            std::vector<TestLockFreeQueueTask *> tasks;
+
+            for (int x = 0; x < 5; x++)
+            {
+                LockFreeTaskUniquePtr taskPtr = std::make_unique<TestLockFreeQueueTask>();
+                tasks.push_back(taskPtr.get());
+                queue.PushItem(std::move(taskPtr));
+            }
+            EXPECT_EQ(3, queue.GetSpillSize());
+
+            // items come back out in the order they were pushed, ring first then the spill
+            for (int x = 0; x < 5; x++)
+            {
+                auto opt = queue.GetNextItem();
+                ASSERT_TRUE(opt.has_value());
+                EXPECT_EQ(opt.value().get(), tasks[x]);
+            }
+            EXPECT_EQ(0, queue.GetSpillSize());
+            EXPECT_FALSE(queue.MayHaveItems());
+        }
+
+        TEST(TLockFreeQueue, PushItems)
+        {
+            TLockFreeQueue<int> queue(4, QueueFullPolicy::kSpill);
+            queue.PushItem(0);
+            // fills the ring with one claim and spills the rest
+            queue.PushItems({1, 2, 3, 4, 5});
+            for (int x = 0; x < 6; x++)
+            {
+                std::optional<int> item = queue.GetNextItem();
+                ASSERT_TRUE(item.has_value());
+                EXPECT_EQ(x, item.value());
+            }
+            EXPECT_FALSE(queue.MayHaveItems());
+
+            // wraps the ring
+            for (int x = 0; x < 10; x++)
+            {
+                queue.PushItems({x, x + 1, x + 2});
+                EXPECT_EQ(x, queue.GetNextItem().value());
+                EXPECT_EQ(x + 1, queue.GetNextItem().value());
+                EXPECT_EQ(x + 2, queue.GetNextItem().value());
+            }
+
+            TLockFreeQueue<int> blocking(2, QueueFullPolicy::kBlock);
+            std::atomic_bool pushed{false};
+            std::thread producer([&blocking, &pushed]()
+                                 {
+                blocking.PushItems({1, 2, 3, 4});
+                pushed = true; });
+            std::vector<int> items;
+            while (items.size() < 4)
+            {
+                std::optional<int> item = blocking.GetNextItem();
+                if (item)
+                {
+                    items.push_back(item.value());
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+            producer.join();
+            EXPECT_TRUE(pushed);
+            EXPECT_THAT(items, ::testing::ElementsAre(1, 2, 3, 4));
+        }
+
+        TEST(TLockFreeQueue, MultipleBatchProducers)
+        {
+            constexpr int kNumThreads = 4;
+            constexpr int kBatches = 500;
+            constexpr int kBatchSize = 10;
+            TLockFreeQueue<int> queue(32, QueueFullPolicy::kBlock);
+            std::atomic_int consumed{0};
+            std::atomic<long long> sum{0};
+
+            std::vector<std::thread> threads;
+            for (int t = 0; t < kNumThreads; t++)
+            {
+                threads.emplace_back([&queue]()
+                                     {
+                    for (int batch = 0; batch < kBatches; batch++)
+                    {
+                        std::vector<int> items(kBatchSize, 1);
+                        queue.PushItems(std::move(items));
+                    } });
+                threads.emplace_back([&queue, &consumed, &sum]()
+                                     {
+                    while (consumed < kNumThreads * kBatches * kBatchSize)
+                    {
+                        std::optional<int> item = queue.GetNextItem();
+                        if (item)
+                        {
+                            sum += item.value();
+                            consumed++;
+                        }
+                        else
+                        {
+                            std::this_thread::yield();
+                        }
+                    } });
+            }
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+            EXPECT_EQ(kNumThreads * kBatches * kBatchSize, sum);
+            EXPECT_FALSE(queue.MayHaveItems());
+        }
+
+        TEST(TLockFreeQueue, BlockWhenFull)
+        {
+            TestLockFreeQueue queue(2, QueueFullPolicy::kBlock);
+            queue.PushItem(std::make_unique<TestLockFreeQueueTask>());
+            queue.PushItem(std::make_unique<TestLockFreeQueueTask>());
+
+            std::atomic_bool pushed{false};
+            std::thread producer([&queue, &pushed]()
+                                 {
+                queue.PushItem(std::make_unique<TestLockFreeQueueTask>());
+                pushed = true; });
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            EXPECT_FALSE(pushed);
+            EXPECT_TRUE(queue.GetNextItem());
+            producer.join();
+            EXPECT_TRUE(pushed);
+            EXPECT_EQ(0, queue.GetSpillSize());
+            EXPECT_TRUE(queue.GetNextItem());
+            EXPECT_TRUE(queue.GetNextItem());
+            EXPECT_FALSE(queue.GetNextItem());
+        }
+
+        TEST(TLockFreeQueue, MultipleProducersConsumers)
+        {
+            constexpr int kNumThreads = 4;
+            constexpr int kItemsPerThread = 5000;
+            TLockFreeQueue<int> queue(64, QueueFullPolicy::kBlock);
+            std::atomic_int consumed{0};
+            std::atomic<long long> sum{0};
+
+            std::vector<std::thread> threads;
+            for (int t = 0; t < kNumThreads; t++)
+            {
+                threads.emplace_back([&queue]()
+                                     {
+                    for (int x = 1; x <= kItemsPerThread; x++)
+                    {
+                        queue.PushItem(x);
+                    } });
+                threads.emplace_back([&queue, &consumed, &sum]()
+                                     {
+                    while (consumed < kNumThreads * kItemsPerThread)
+                    {
+                        std::optional<int> item = queue.GetNextItem();
+                        if (item)
+                        {
+                            sum += item.value();
+                            consumed++;
+                        }
+                        else
+                        {
+                            std::this_thread::yield();
+                        }
+                    } });
+            }
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+            EXPECT_EQ(kNumThreads * kItemsPerThread, consumed);
+            EXPECT_EQ(static_cast<long long>(kNumThreads) * kItemsPerThread * (kItemsPerThread + 1) / 2, sum);
+            EXPECT_FALSE(queue.MayHaveItems());
+        }
+
+        TEST(TLockFreeQueue, Terminates)
+        {
+            TestLockFreeQueue queue(2, QueueFullPolicy::kBlock);
+            queue.PushItem(std::make_unique<TestLockFreeQueueTask>());
+            queue.PushItem(std::make_unique<TestLockFreeQueueTask>());
+
+            // a blocked producer gets released when the queue terminates
+            std::thread producer([&queue]()
+                                 { queue.PushItem(std::make_unique<TestLockFreeQueueTask>()); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            queue.Terminate();
+            producer.join();
+            EXPECT_TRUE(queue.IsTerminated());
+            EXPECT_FALSE(queue.GetNextItem());
+            queue.PushItem(std::make_unique<TestLockFreeQueueTask>());
+            EXPECT_FALSE(queue.GetNextItem());
+        }
+    } // namespace Queues
+} // namespace v8App
@@ -28,10 +28,10 @@ namespace v8App
             }
         };
 
-        static bool notifier = false;
-        void TestNotifier()
+        static size_t notifier = 0;
+        void TestNotifier(size_t inCount)
         {
-            notifier = true;
+            notifier = inCount;
         }
 
         using TaskDelayedTaskUniquePtr = std::unique_ptr<TestDelayedQueueTask>;
@@ -41,7 +41,7 @@ namespace v8App
         public:
             TestDelayedTaskQueue() : TThreadSafeDelayedQueue() {}
             size_t GetQueueSize() { return m_Queue.size(); }
-            size_t GetDelayedQueueSize() { return m_DelayedQueue.size(); }
+            size_t GetDelayedQueueSize() { return m_DelayedQueue.GetSize(); }
             bool IsTerminated() { return m_Terminated; }
         };
 
@@ -93,7 +93,7 @@ namespace v8App
             ASSERT_EQ(opt.value().get(), task2);
             EXPECT_EQ(1, queue.GetQueueSize());
             EXPECT_EQ(1, queue.GetDelayedQueueSize());
-            EXPECT_TRUE(notifier);
+            EXPECT_EQ(2, notifier);
 
             opt =queue.GetNextItem();
             EXPECT_TRUE(opt.has_value());
@@ -104,6 +104,54 @@ namespace v8App
             EXPECT_FALSE(queue.GetNextItem());
         }
 
+        TEST(TThreadSafeDelayedQueue, PushItemsDelayed)
+        {
+            TestDelayedTaskQueue queue = TestDelayedTaskQueue();
+            TestTime::TestTimeSeconds::Enable();
+            TestTime::TestTimeSeconds::Set(0);
+
+            std::vector<TaskDelayedTaskUniquePtr> items;
+            items.push_back(std::make_unique<TestDelayedQueueTask>());
+            items.push_back(std::make_unique<TestDelayedQueueTask>());
+            queue.PushItemsDelayed(2.0, std::move(items));
+            EXPECT_EQ(2, queue.GetDelayedQueueSize());
+            EXPECT_FALSE(queue.MayHaveItems());
+
+            TestTime::TestTimeSeconds::Set(2);
+            EXPECT_TRUE(queue.MayHaveItems());
+            EXPECT_EQ(0, queue.GetDelayedQueueSize());
+            EXPECT_EQ(2, queue.GetQueueSize());
+            TestTime::TestTimeSeconds::Clear();
+        }
+
+        TEST(TThreadSafeDelayedQueue, CancelItem)
+        {
+            TestDelayedTaskQueue queue = TestDelayedTaskQueue();
+            TestTime::TestTimeSeconds::Enable();
+            TestTime::TestTimeSeconds::Set(0);
+
+            TimerId id1 = queue.PushItemDelayed(2.0, std::make_unique<TestDelayedQueueTask>());
+            TimerId id2 = queue.PushItemDelayed(2.0, std::make_unique<TestDelayedQueueTask>());
+            EXPECT_NE(kInvalidTimerId, id1);
+            EXPECT_NE(id1, id2);
+            EXPECT_EQ(2, queue.GetDelayedQueueSize());
+
+            // canceled items are gone straight away
+            EXPECT_TRUE(queue.CancelItem(id1));
+            EXPECT_EQ(1, queue.GetDelayedQueueSize());
+            EXPECT_FALSE(queue.CancelItem(id1));
+
+            TestTime::TestTimeSeconds::Set(2);
+            EXPECT_TRUE(queue.MayHaveItems());
+            EXPECT_EQ(1, queue.GetQueueSize());
+            // already moved to the main queue so it can't be canceled
+            EXPECT_FALSE(queue.CancelItem(id2));
+
+            queue.Terminate();
+            EXPECT_EQ(kInvalidTimerId, queue.PushItemDelayed(2.0, std::make_unique<TestDelayedQueueTask>()));
+            TestTime::TestTimeSeconds::Clear();
+        }
+
         TEST(TThreadSafeDelayedQueue, MayHaveItems)
         {
             TestDelayedTaskQueue queue = TestDelayedTaskQueue();
@@ -62,6 +62,31 @@ namespace v8App
             EXPECT_FALSE(queue.GetNextItem());
         }
         
+        TEST(TThreadSafeQueue, PushItems)
+        {
+            TestTaskQueue queue = TestTaskQueue();
+            std::vector<TaskTaskUniquePtr> items;
+            std::vector<TestQueueTask *> tasks;
+            for (int x = 0; x < 3; x++)
+            {
+                items.push_back(std::make_unique<TestQueueTask>());
+                tasks.push_back(items.back().get());
+            }
+            queue.PushItems(std::move(items));
+            EXPECT_EQ(3, queue.GetQueueSize());
+            for (int x = 0; x < 3; x++)
+            {
+                auto opt = queue.GetNextItem();
+                ASSERT_TRUE(opt.has_value());
+                EXPECT_EQ(opt.value().get(), tasks[x]);
+            }
+
+            queue.Terminate();
+            items.push_back(std::make_unique<TestQueueTask>());
+            queue.PushItems(std::move(items));
+            EXPECT_EQ(0, queue.GetQueueSize());
+        }
+
         TEST(TThreadSafeQueue, MayHaveItems)
         {
             TestTaskQueue queue = TestTaskQueue();
@@ -0,0 +1,222 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Queues/TTimingWheel.h"
+
+namespace v8App
+{
+    namespace Queues
+    {
+        class TestTimingWheel : public TTimingWheel<int>
+        {
+        public:
+            TestTimingWheel(uint32_t inTicksPerSecond = kDefaultTicksPerSecond) : TTimingWheel(inTicksPerSecond) {}
+            uint64_t GetCurrentTick() { return m_CurrentTick; }
+            size_t GetLevelCount(int inLevel) { return m_LevelCounts[inLevel]; }
+        };
+
+        TEST(TTimingWheel, Constructor)
+        {
+            TestTimingWheel wheel;
+            EXPECT_EQ(1000, wheel.GetTicksPerSecond());
+            EXPECT_TRUE(wheel.IsEmpty());
+            EXPECT_EQ(0, wheel.GetSize());
+            EXPECT_FALSE(wheel.GetNextDeadline().has_value());
+
+            TestTimingWheel zeroTicks(0);
+            EXPECT_EQ(1, zeroTicks.GetTicksPerSecond());
+        }
+
+        TEST(TTimingWheel, InsertAdvance)
+        {
+            TestTimingWheel wheel;
+            std::vector<int> expired;
+
+            wheel.Insert(0.003, 3);
+            wheel.Insert(0.001, 1);
+            wheel.Insert(0.002, 2);
+            wheel.Insert(0.002, 4);
+            EXPECT_EQ(4, wheel.GetSize());
+
+            wheel.Advance(0.0015, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(1));
+            EXPECT_EQ(3, wheel.GetSize());
+
+            // same deadline comes out in the order it went in
+            expired.clear();
+            wheel.Advance(0.01, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(2, 4, 3));
+            EXPECT_TRUE(wheel.IsEmpty());
+            EXPECT_EQ(10, wheel.GetCurrentTick());
+
+            // items at or before the current time come out on the next advance
+            expired.clear();
+            wheel.Insert(0.005, 5);
+            EXPECT_DOUBLE_EQ(0.005, wheel.GetNextDeadline().value());
+            wheel.Advance(0.01, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(5));
+        }
+
+        TEST(TTimingWheel, Cancel)
+        {
+            TestTimingWheel wheel;
+            std::vector<int> expired;
+
+            TimerId id1 = wheel.Insert(0.001, 1);
+            TimerId id2 = wheel.Insert(10.0, 2);
+            EXPECT_NE(kInvalidTimerId, id1);
+            EXPECT_NE(id1, id2);
+
+            EXPECT_TRUE(wheel.Cancel(id2));
+            EXPECT_FALSE(wheel.Cancel(id2));
+            EXPECT_FALSE(wheel.Cancel(kInvalidTimerId));
+            EXPECT_EQ(1, wheel.GetSize());
+
+            wheel.Advance(20.0, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(1));
+            // already expired so can't be canceled
+            EXPECT_FALSE(wheel.Cancel(id1));
+        }
+
+        TEST(TTimingWheel, Remove)
+        {
+            TTimingWheel<std::unique_ptr<int>> wheel;
+            std::vector<std::unique_ptr<int>> expired;
+
+            TimerId id = wheel.Insert(10.0, std::make_unique<int>(5));
+            std::optional<std::unique_ptr<int>> removed = wheel.Remove(id);
+            ASSERT_TRUE(removed.has_value());
+            EXPECT_EQ(5, *removed.value());
+            EXPECT_TRUE(wheel.IsEmpty());
+            EXPECT_FALSE(wheel.Remove(id).has_value());
+
+            wheel.Advance(20.0, expired);
+            EXPECT_TRUE(expired.empty());
+        }
+
+        TEST(TTimingWheel, CascadesLongDelays)
+        {
+            TestTimingWheel wheel;
+            std::vector<int> expired;
+
+            // one item per level
+            wheel.Insert(0.1, 0);
+            wheel.Insert(1.0, 1);
+            wheel.Insert(100.0, 2);
+            wheel.Insert(20000.0, 3);
+            EXPECT_EQ(1, wheel.GetLevelCount(0));
+            EXPECT_EQ(1, wheel.GetLevelCount(1));
+            EXPECT_EQ(1, wheel.GetLevelCount(2));
+            EXPECT_EQ(1, wheel.GetLevelCount(3));
+
+            wheel.Advance(0.999, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(0));
+            EXPECT_DOUBLE_EQ(1.0, wheel.GetNextDeadline().value());
+
+            expired.clear();
+            wheel.Advance(99.999, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(1));
+
+            expired.clear();
+            wheel.Advance(100.0, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(2));
+
+            expired.clear();
+            wheel.Advance(19999.999, expired);
+            EXPECT_TRUE(expired.empty());
+            wheel.Advance(20000.0, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(3));
+            EXPECT_TRUE(wheel.IsEmpty());
+        }
+
+        TEST(TTimingWheel, BeyondWheelRange)
+        {
+            TestTimingWheel wheel;
+            std::vector<int> expired;
+
+            // 2^32 ms is about 49 days so this is past what the wheel covers
+            double deadline = 60.0 * 60 * 24 * 100;
+            wheel.Insert(deadline, 1);
+            EXPECT_EQ(deadline, wheel.GetNextDeadline().value());
+
+            wheel.Advance(deadline - 1, expired);
+            EXPECT_TRUE(expired.empty());
+            EXPECT_EQ(1, wheel.GetSize());
+
+            wheel.Advance(deadline, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(1));
+        }
+
+        TEST(TTimingWheel, NextDeadlineIsTickBoundary)
+        {
+            const double deadlines[] = {0.0013, 1.0 / 3, 0.999999, 2.5, 123.4567, 1000.0001};
+            const uint32_t tickRates[] = {1000, 60, 7};
+            for (uint32_t ticks : tickRates)
+            {
+                for (double deadline : deadlines)
+                {
+                    TestTimingWheel wheel(ticks);
+                    std::vector<int> expired;
+                    wheel.Insert(deadline, 1);
+
+                    // the deadline rounded up to the tick, sleeping until it must find the item expired
+                    double next = wheel.GetNextDeadline().value();
+                    EXPECT_GE(next, deadline);
+                    EXPECT_LT(next - deadline, 1.0 / ticks);
+
+                    wheel.Advance(next - 0.5 / ticks, expired);
+                    EXPECT_TRUE(expired.empty()) << ticks << " " << deadline;
+                    EXPECT_EQ(next, wheel.GetNextDeadline().value());
+                    wheel.Advance(next, expired);
+                    EXPECT_THAT(expired, ::testing::ElementsAre(1)) << ticks << " " << deadline;
+                }
+            }
+        }
+
+        TEST(TTimingWheel, NextDeadlineAfterRemove)
+        {
+            TestTimingWheel wheel;
+            std::vector<int> expired;
+
+            TimerId id1 = wheel.Insert(0.001, 1);
+            wheel.Insert(300.0, 2);
+            wheel.Insert(0.5, 3);
+            EXPECT_DOUBLE_EQ(0.001, wheel.GetNextDeadline().value());
+
+            // taking the earliest out finds the next one
+            EXPECT_TRUE(wheel.Cancel(id1));
+            EXPECT_DOUBLE_EQ(0.5, wheel.GetNextDeadline().value());
+            wheel.Insert(0.2, 4);
+            EXPECT_DOUBLE_EQ(0.2, wheel.GetNextDeadline().value());
+
+            wheel.Advance(0.5, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(4, 3));
+            EXPECT_DOUBLE_EQ(300.0, wheel.GetNextDeadline().value());
+        }
+
+        TEST(TTimingWheel, MoveAndClear)
+        {
+            TestTimingWheel wheel;
+            std::vector<int> expired;
+            wheel.Insert(0.001, 1);
+            wheel.Insert(5.0, 2);
+
+            TTimingWheel<int> moved(std::move(wheel));
+            EXPECT_TRUE(wheel.IsEmpty());
+            EXPECT_EQ(2, moved.GetSize());
+
+            moved.Advance(1.0, expired);
+            EXPECT_THAT(expired, ::testing::ElementsAre(1));
+
+            moved.Clear();
+            EXPECT_TRUE(moved.IsEmpty());
+            EXPECT_FALSE(moved.GetNextDeadline().has_value());
+        }
+    } // namespace Queues
+} // namespace v8App
@@ -0,0 +1,107 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Queues/TWorkStealingQueue.h"
+
+namespace v8App
+{
+    namespace Queues
+    {
+        class TestStealQueueTask
+        {
+        public:
+            ~TestStealQueueTask() {}
+
+            void Run()
+            {
+            }
+        };
+
+        using StealTaskUniquePtr = std::unique_ptr<TestStealQueueTask>;
+
+        class TestStealQueue : public TWorkStealingQueue<StealTaskUniquePtr>
+        {
+        public:
+            size_t GetQueueSize() { return m_Queue.size(); }
+            bool IsTerminated() { return m_Terminated; }
+        };
+
+        TEST(TWorkStealingQueue, Constrcutor)
+        {
+            TestStealQueue queue;
+
+            EXPECT_FALSE(queue.IsTerminated());
+            EXPECT_EQ(0, queue.GetQueueSize());
+            EXPECT_FALSE(queue.MayHaveItems());
+        }
+
+        TEST(TWorkStealingQueue, OwnerPopsNewestThiefStealsOldest)
+        {
+            TestStealQueue queue;
+            StealTaskUniquePtr taskPtr1 = std::make_unique<TestStealQueueTask>();
+            StealTaskUniquePtr taskPtr2 = std::make_unique<TestStealQueueTask>();
+            StealTaskUniquePtr taskPtr3 = std::make_unique<TestStealQueueTask>();
+            TestStealQueueTask *task1 = taskPtr1.get();
+            TestStealQueueTask *task2 = taskPtr2.get();
+            TestStealQueueTask *task3 = taskPtr3.get();
+
+            EXPECT_FALSE(queue.GetNextItem());
+            EXPECT_FALSE(queue.StealItem());
+
+            queue.PushItem(std::move(taskPtr1));
+            queue.PushItem(std::move(taskPtr2));
+            queue.PushItem(std::move(taskPtr3));
+            EXPECT_EQ(3, queue.GetSize());
+            EXPECT_TRUE(queue.MayHaveItems());
+
+            auto opt = queue.GetNextItem();
+            ASSERT_TRUE(opt.has_value());
+            EXPECT_EQ(opt.value().get(), task3);
+
+            opt = queue.StealItem();
+            ASSERT_TRUE(opt.has_value());
+            EXPECT_EQ(opt.value().get(), task1);
+
+            opt = queue.GetNextItem();
+            ASSERT_TRUE(opt.has_value());
+            EXPECT_EQ(opt.value().get(), task2);
+
+            EXPECT_FALSE(queue.MayHaveItems());
+            EXPECT_FALSE(queue.GetNextItem());
+            EXPECT_FALSE(queue.StealItem());
+        }
+
+        TEST(TWorkStealingQueue, PushItems)
+        {
+            TWorkStealingQueue<int> queue;
+            queue.PushItems({1, 2, 3});
+            EXPECT_EQ(3, queue.GetSize());
+            // owner gets the newest, thieves the oldest
+            EXPECT_EQ(3, queue.GetNextItem().value());
+            EXPECT_EQ(1, queue.StealItem().value());
+            EXPECT_EQ(2, queue.GetNextItem().value());
+            EXPECT_FALSE(queue.MayHaveItems());
+
+            queue.Terminate();
+            queue.PushItems({4});
+            EXPECT_FALSE(queue.MayHaveItems());
+        }
+
+        TEST(TWorkStealingQueue, Terminates)
+        {
+            TestStealQueue queue;
+            queue.PushItem(std::make_unique<TestStealQueueTask>());
+            EXPECT_EQ(1, queue.GetQueueSize());
+
+            queue.Terminate();
+            EXPECT_TRUE(queue.IsTerminated());
+            EXPECT_FALSE(queue.GetNextItem());
+            EXPECT_FALSE(queue.StealItem());
+            queue.PushItem(std::make_unique<TestStealQueueTask>());
+            EXPECT_EQ(1, queue.GetQueueSize());
+        }
+    } // namespace Queues
+} // namespace v8App
@@ -0,0 +1,53 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/CpuTopology.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        TEST(CpuTopologyTest, ParseCpuList)
+        {
+            EXPECT_THAT(ParseCpuList("0"), ::testing::ElementsAre(0));
+            EXPECT_THAT(ParseCpuList("0-3"), ::testing::ElementsAre(0, 1, 2, 3));
+            EXPECT_THAT(ParseCpuList("8,0-1,10-11"), ::testing::ElementsAre(0, 1, 8, 10, 11));
+            // duplicates and trailing newline junk get cleaned up
+            EXPECT_THAT(ParseCpuList("1,1,0-1"), ::testing::ElementsAre(0, 1));
+            EXPECT_TRUE(ParseCpuList("").empty());
+            EXPECT_THAT(ParseCpuList("a,2,3-,-4,5"), ::testing::ElementsAre(2, 5));
+        }
+
+        TEST(CpuTopologyTest, GetCpuTopology)
+        {
+            const CpuTopology &topology = GetCpuTopology();
+            EXPECT_EQ(&topology, &GetCpuTopology());
+
+            ASSERT_GE(topology.GetNumberOfLogicalCores(), 1);
+            EXPECT_GE(topology.GetNumberOfPhysicalCores(), 1);
+            EXPECT_LE(topology.GetNumberOfPhysicalCores(), topology.GetNumberOfLogicalCores());
+            EXPECT_TRUE(std::is_sorted(topology.m_LogicalCpus.begin(), topology.m_LogicalCpus.end()));
+
+            // every group has to partition the logical cpus
+            auto checkGroups = [&topology](const std::vector<std::vector<int>> &inGroups)
+            {
+                std::vector<int> cpus;
+                for (const std::vector<int> &group : inGroups)
+                {
+                    EXPECT_FALSE(group.empty());
+                    cpus.insert(cpus.end(), group.begin(), group.end());
+                }
+                std::sort(cpus.begin(), cpus.end());
+                EXPECT_EQ(topology.m_LogicalCpus, cpus);
+            };
+            checkGroups(topology.m_PhysicalCores);
+            checkGroups(topology.m_CacheDomains);
+            checkGroups(topology.m_NumaNodes);
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,140 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <atomic>
+#include <future>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/ParallelAlgorithms.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        TEST(ParallelAlgorithmsTest, GetParallelGrainSize)
+        {
+            ThreadPoolQueue pool(2);
+            size_t threads = pool.GetNumberOfWorkers() + 1;
+            EXPECT_EQ(7, GetParallelGrainSize(pool, 1000, 7));
+            EXPECT_EQ(1000 / (threads * kParallelChunksPerThread), GetParallelGrainSize(pool, 1000));
+            EXPECT_EQ(1, GetParallelGrainSize(pool, 1));
+        }
+
+        TEST(ParallelAlgorithmsTest, ParallelFor)
+        {
+            ThreadPoolQueue pool(2);
+            std::vector<int> values(10000, 0);
+            ParallelFor(pool, 0, values.size(), [&values](size_t inIndex)
+                        { values[inIndex] += static_cast<int>(inIndex); });
+            for (size_t x = 0; x < values.size(); x++)
+            {
+                ASSERT_EQ(static_cast<int>(x), values[x]);
+            }
+
+            // sub range with an explicit grain
+            std::atomic_int calls{0};
+            ParallelFor(pool, 10, 20, [&calls](size_t inIndex)
+                        { calls++; },
+                        3);
+            EXPECT_EQ(10, calls);
+
+            // empty range does nothing
+            ParallelFor(pool, 5, 5, [&calls](size_t)
+                        { calls++; });
+            EXPECT_EQ(10, calls);
+        }
+
+        TEST(ParallelAlgorithmsTest, Nested)
+        {
+            ThreadPoolQueue pool(2);
+            std::vector<std::atomic_int> counts(64);
+            // run from inside pool tasks so the workers are all busy waiting on nested calls
+            ParallelFor(pool, 0, counts.size(), [&pool, &counts](size_t inOuter)
+                        { ParallelFor(pool, 0, 100, [&counts, inOuter](size_t)
+                                      { counts[inOuter]++; },
+                                      1); },
+                        1);
+            for (auto &count : counts)
+            {
+                EXPECT_EQ(100, count);
+            }
+
+            std::promise<int> promise;
+            std::future<int> future = promise.get_future();
+            pool.PostTask(std::make_unique<CallableThreadTask>([&pool, &promise]()
+                                                               { promise.set_value(ParallelReduce(pool, 0, 1000, 0,
+                                                                                                  [](size_t inIndex)
+                                                                                                  { return 1; },
+                                                                                                  [](int inA, int inB)
+                                                                                                  { return inA + inB; })); }));
+            EXPECT_EQ(1000, future.get());
+        }
+
+        TEST(ParallelAlgorithmsTest, Exceptions)
+        {
+            ThreadPoolQueue pool(2);
+            EXPECT_THROW(ParallelFor(pool, 0, 1000, [](size_t inIndex)
+                                     {
+                if (inIndex == 500)
+                {
+                    throw std::runtime_error("failed");
+                } }),
+                         std::runtime_error);
+        }
+
+        TEST(ParallelAlgorithmsTest, ParallelReduce)
+        {
+            ThreadPoolQueue pool(2);
+            size_t sum = ParallelReduce(pool, 0, 100001, size_t(0), [](size_t inIndex)
+                                        { return inIndex; },
+                                        [](size_t inA, size_t inB)
+                                        { return inA + inB; });
+            EXPECT_EQ(size_t(100000) * 100001 / 2, sum);
+
+            // chunks are combined in order so non commutative reduces work
+            std::string joined = ParallelReduce(pool, 0, 26, std::string(), [](size_t inIndex)
+                                                { return std::string(1, static_cast<char>('a' + inIndex)); },
+                                                [](std::string inA, std::string inB)
+                                                { return inA + inB; },
+                                                2);
+            EXPECT_EQ("abcdefghijklmnopqrstuvwxyz", joined);
+
+            EXPECT_EQ(42, ParallelReduce(pool, 3, 3, 42, [](size_t)
+                                         { return 1; },
+                                         [](int inA, int inB)
+                                         { return inA + inB; }));
+        }
+
+        TEST(ParallelAlgorithmsTest, ParallelSort)
+        {
+            ThreadPoolQueue pool(2);
+            std::mt19937 random(1234);
+            std::vector<int> values(100000);
+            for (auto &value : values)
+            {
+                value = static_cast<int>(random() % 10000);
+            }
+            std::vector<int> expected = values;
+            std::sort(expected.begin(), expected.end());
+
+            ParallelSort(pool, values.begin(), values.end());
+            EXPECT_EQ(expected, values);
+
+            ParallelSort(pool, values.begin(), values.end(), std::greater<int>());
+            std::reverse(expected.begin(), expected.end());
+            EXPECT_EQ(expected, values);
+
+            // small ranges
+            std::vector<int> small{3, 1, 2};
+            ParallelSort(pool, small.begin(), small.end());
+            EXPECT_THAT(small, ::testing::ElementsAre(1, 2, 3));
+        }
+    } // namespace Threads
+} // namespace v8App
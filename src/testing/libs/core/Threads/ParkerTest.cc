@@ -0,0 +1,180 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/Parker.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        namespace
+        {
+            void WaitForParked(Parker &inParker, int inCount)
+            {
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (inParker.GetParkedCount() < inCount && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        } // namespace
+
+        TEST(ParkerTest, Constructor)
+        {
+            Parker parker;
+            EXPECT_EQ(kDefaultParkSpinCount, parker.GetSpinCount());
+            EXPECT_EQ(0, parker.GetParkedCount());
+
+            Parker noSpin(-5);
+            EXPECT_EQ(0, noSpin.GetSpinCount());
+        }
+
+        TEST(ParkerTest, PrepareAndCancel)
+        {
+            Parker parker;
+            parker.PrepareToPark();
+            EXPECT_EQ(1, parker.GetParkedCount());
+            parker.CancelPark();
+            EXPECT_EQ(0, parker.GetParkedCount());
+        }
+
+        TEST(ParkerTest, UnparkBeforeParkIsNotLost)
+        {
+            Parker parker;
+            Parker::ParkToken token = parker.PrepareToPark();
+            // the unpark lands between the prepare and the park
+            parker.Unpark(1);
+            // would hang if the unpark was lost
+            parker.Park(token);
+            EXPECT_EQ(0, parker.GetParkedCount());
+        }
+
+        TEST(ParkerTest, UnparkWithNoneParked)
+        {
+            Parker parker;
+            Parker::ParkToken token = parker.PrepareToPark();
+            parker.CancelPark();
+            // nothing parked so the epoch is left alone
+            parker.Unpark(1);
+            EXPECT_EQ(token, parker.PrepareToPark());
+            parker.CancelPark();
+        }
+
+        TEST(ParkerTest, ParkForTimesOut)
+        {
+            Parker parker(0);
+            Parker::ParkToken token = parker.PrepareToPark();
+            auto start = std::chrono::steady_clock::now();
+            EXPECT_FALSE(parker.ParkFor(token, 0.05));
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            EXPECT_GE(elapsed, 0.04);
+            EXPECT_EQ(0, parker.GetParkedCount());
+        }
+
+        TEST(ParkerTest, UnparkWakesParked)
+        {
+            Parker parker;
+            std::atomic_bool woke{false};
+            std::thread waiter([&parker, &woke]()
+                               {
+                Parker::ParkToken token = parker.PrepareToPark();
+                woke = parker.ParkFor(token, 5.0); });
+            WaitForParked(parker, 1);
+            parker.Unpark(1);
+            waiter.join();
+            EXPECT_TRUE(woke);
+        }
+
+        TEST(ParkerTest, UnparkAll)
+        {
+            Parker parker;
+            std::atomic_int woke{0};
+            std::vector<std::thread> waiters;
+            for (int x = 0; x < 3; x++)
+            {
+                waiters.emplace_back([&parker, &woke]()
+                                     {
+                    Parker::ParkToken token = parker.PrepareToPark();
+                    if (parker.ParkFor(token, 5.0))
+                    {
+                        woke++;
+                    } });
+            }
+            WaitForParked(parker, 3);
+            parker.UnparkAll();
+            for (auto &waiter : waiters)
+            {
+                waiter.join();
+            }
+            EXPECT_EQ(3, woke);
+            EXPECT_EQ(0, parker.GetParkedCount());
+        }
+
+        TEST(ParkerTest, ProducerConsumer)
+        {
+            // every item posted has to be consumed without a lost wake up stalling a consumer
+            Parker parker;
+            std::atomic_int items{0};
+            std::atomic_int consumed{0};
+            std::atomic_bool done{false};
+            constexpr int kItems = 20000;
+
+            auto consumer = [&]()
+            {
+                while (true)
+                {
+                    int available = items.load();
+                    if (available > 0)
+                    {
+                        if (items.compare_exchange_weak(available, available - 1))
+                        {
+                            consumed++;
+                        }
+                        continue;
+                    }
+                    if (done)
+                    {
+                        return;
+                    }
+                    Parker::ParkToken token = parker.PrepareToPark();
+                    if (items.load() > 0 || done)
+                    {
+                        parker.CancelPark();
+                        continue;
+                    }
+                    parker.Park(token);
+                }
+            };
+            std::vector<std::thread> consumers;
+            for (int x = 0; x < 3; x++)
+            {
+                consumers.emplace_back(consumer);
+            }
+            for (int x = 0; x < kItems; x++)
+            {
+                items++;
+                parker.Unpark(1);
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (consumed < kItems && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            EXPECT_EQ(kItems, consumed);
+            done = true;
+            parker.UnparkAll();
+            for (auto &thread : consumers)
+            {
+                thread.join();
+            }
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,93 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/PoolMetrics.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        TEST(PoolMetricsTest, HistogramBuckets)
+        {
+            EXPECT_EQ(0, LatencyHistogram::GetBucketIndex(-5));
+            EXPECT_EQ(0, LatencyHistogram::GetBucketIndex(0));
+            EXPECT_EQ(0, LatencyHistogram::GetBucketIndex(1));
+            EXPECT_EQ(1, LatencyHistogram::GetBucketIndex(2));
+            EXPECT_EQ(1, LatencyHistogram::GetBucketIndex(3));
+            EXPECT_EQ(10, LatencyHistogram::GetBucketIndex(1024));
+            EXPECT_EQ(HistogramSnapshot::kNumBuckets - 1, LatencyHistogram::GetBucketIndex(INT64_MAX));
+        }
+
+        TEST(PoolMetricsTest, HistogramSnapshot)
+        {
+            LatencyHistogram histogram;
+            HistogramSnapshot empty = histogram.GetSnapshot();
+            EXPECT_EQ(0, empty.m_Count);
+            EXPECT_EQ(0, empty.GetMeanNanoseconds());
+            EXPECT_EQ(0, empty.GetPercentileNanoseconds(50));
+
+            for (int x = 0; x < 99; x++)
+            {
+                histogram.Record(100);
+            }
+            histogram.Record(10000);
+            // negative durations are clamped
+            histogram.Record(-10);
+
+            HistogramSnapshot snapshot = histogram.GetSnapshot();
+            EXPECT_EQ(101, snapshot.m_Count);
+            EXPECT_EQ(99 * 100 + 10000, snapshot.m_SumNanoseconds);
+            EXPECT_EQ(10000, snapshot.m_MaxNanoseconds);
+            EXPECT_EQ(1, snapshot.m_Buckets[0]);
+            EXPECT_EQ(99, snapshot.m_Buckets[6]);
+            // percentiles report the top of the bucket
+            EXPECT_EQ(127, snapshot.GetPercentileNanoseconds(50));
+            EXPECT_EQ(10000, snapshot.GetPercentileNanoseconds(100));
+
+            HistogramSnapshot merged;
+            merged.Merge(snapshot);
+            merged.Merge(snapshot);
+            EXPECT_EQ(202, merged.m_Count);
+            EXPECT_EQ(198, merged.m_Buckets[6]);
+            EXPECT_EQ(10000, merged.m_MaxNanoseconds);
+        }
+
+        TEST(PoolMetricsTest, PoolMetrics)
+        {
+            PoolMetrics metrics(2);
+            metrics.RecordPosted(3);
+            metrics.RecordDelayedPosted(1);
+            metrics.RecordStarted(0, 100, false, 600);
+            metrics.RecordRun(0, 300);
+            metrics.RecordStarted(1, 1000, true, 1200);
+            metrics.RecordRun(1, 100);
+            metrics.RecordIdle(1, 300);
+
+            PoolMetricsSnapshot snapshot = metrics.GetSnapshot();
+            EXPECT_EQ(3, snapshot.m_Posted);
+            EXPECT_EQ(1, snapshot.m_DelayedPosted);
+            EXPECT_EQ(2, snapshot.m_Started);
+            EXPECT_EQ(2, snapshot.GetQueueDepth());
+            EXPECT_EQ(1, snapshot.m_WaitTime.m_Count);
+            EXPECT_EQ(500, snapshot.m_WaitTime.m_MaxNanoseconds);
+            EXPECT_EQ(1, snapshot.m_DelayedLateness.m_Count);
+            EXPECT_EQ(200, snapshot.m_DelayedLateness.m_MaxNanoseconds);
+            EXPECT_EQ(2, snapshot.m_RunTime.m_Count);
+
+            ASSERT_EQ(2, snapshot.m_Workers.size());
+            EXPECT_EQ(1, snapshot.m_Workers[0].m_TasksRun);
+            EXPECT_EQ(1.0, snapshot.m_Workers[0].GetBusyRatio());
+            EXPECT_EQ(0.25, snapshot.m_Workers[1].GetBusyRatio());
+            EXPECT_EQ(0, WorkerMetricsSnapshot().GetBusyRatio());
+
+            std::string dump = snapshot.ToString();
+            EXPECT_NE(std::string::npos, dump.find("Depth: 2"));
+            EXPECT_NE(std::string::npos, dump.find("Worker #1"));
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,72 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/ScopedBlockingCall.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        class TestBlockingObserver : public IBlockingObserver
+        {
+        public:
+            void BlockingStarted(BlockingType inType) override { m_Started.push_back(inType); }
+            void BlockingEnded() override { m_Ended++; }
+
+            std::vector<BlockingType> m_Started;
+            int m_Ended = 0;
+        };
+
+        TEST(ScopedBlockingCallTest, NoObserver)
+        {
+            EXPECT_EQ(nullptr, GetBlockingObserverForCurrentThread());
+            // nothing to tell so it's a no op
+            ScopedBlockingCall call(BlockingType::kWillBlock);
+        }
+
+        TEST(ScopedBlockingCallTest, NotifiesObserver)
+        {
+            TestBlockingObserver observer;
+            SetBlockingObserverForCurrentThread(&observer);
+            EXPECT_EQ(&observer, GetBlockingObserverForCurrentThread());
+            {
+                ScopedBlockingCall call(BlockingType::kWillBlock);
+                EXPECT_THAT(observer.m_Started, ::testing::ElementsAre(BlockingType::kWillBlock));
+                EXPECT_EQ(0, observer.m_Ended);
+                {
+                    // nested calls are part of the outer one
+                    ScopedBlockingCall nested(BlockingType::kMayBlock);
+                    EXPECT_EQ(1, observer.m_Started.size());
+                }
+                EXPECT_EQ(0, observer.m_Ended);
+            }
+            EXPECT_EQ(1, observer.m_Ended);
+
+            {
+                ScopedBlockingCall call(BlockingType::kMayBlock);
+            }
+            EXPECT_THAT(observer.m_Started, ::testing::ElementsAre(BlockingType::kWillBlock, BlockingType::kMayBlock));
+            EXPECT_EQ(2, observer.m_Ended);
+            SetBlockingObserverForCurrentThread(nullptr);
+        }
+
+        TEST(ScopedBlockingCallTest, ObserverIsPerThread)
+        {
+            TestBlockingObserver observer;
+            SetBlockingObserverForCurrentThread(&observer);
+            std::thread other([]()
+                              {
+                EXPECT_EQ(nullptr, GetBlockingObserverForCurrentThread());
+                ScopedBlockingCall call(BlockingType::kWillBlock); });
+            other.join();
+            EXPECT_TRUE(observer.m_Started.empty());
+            SetBlockingObserverForCurrentThread(nullptr);
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -0,0 +1,215 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/SequencedTaskRunner.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        namespace
+        {
+            ElasticPoolOptions FixedOptions(int inWorkers)
+            {
+                ElasticPoolOptions options;
+                options.m_MinWorkers = inWorkers;
+                options.m_MaxWorkers = inWorkers;
+                return options;
+            }
+        } // namespace
+
+        TEST(SequencedTaskRunnerTest, Constructor)
+        {
+            ThreadPoolQueue pool(1);
+            SequencedTaskRunner runner(pool);
+            EXPECT_EQ(kDefaultSequenceBatchSize, runner.GetBatchSize());
+            EXPECT_EQ(0, runner.GetPendingCount());
+            EXPECT_FALSE(runner.RunsTasksInCurrentSequence());
+
+            SequencedTaskRunner zeroBatch(pool, 0);
+            EXPECT_EQ(1, zeroBatch.GetBatchSize());
+        }
+
+        TEST(SequencedTaskRunnerTest, RunsInOrder)
+        {
+            ThreadPoolQueue pool(FixedOptions(4));
+            SequencedTaskRunner runner(pool, 4);
+            std::vector<int> order;
+            std::atomic_int running{0};
+            std::atomic_bool overlapped{false};
+            std::promise<void> done;
+            std::future<void> doneFuture = done.get_future();
+            constexpr int kTasks = 500;
+
+            for (int x = 0; x < kTasks; x++)
+            {
+                EXPECT_TRUE(runner.PostTask(std::make_unique<CallableThreadTask>([&, x]()
+                                                                                 {
+                    if (running.fetch_add(1) != 0)
+                    {
+                        overlapped = true;
+                    }
+                    // the sequence orders the writes so the vector needs no lock
+                    order.push_back(x);
+                    running--;
+                    if (x == kTasks - 1)
+                    {
+                        done.set_value();
+                    } })));
+            }
+            ASSERT_EQ(std::future_status::ready, doneFuture.wait_for(std::chrono::seconds(10)));
+            EXPECT_FALSE(overlapped);
+            ASSERT_EQ(kTasks, order.size());
+            for (int x = 0; x < kTasks; x++)
+            {
+                EXPECT_EQ(x, order[x]);
+            }
+        }
+
+        TEST(SequencedTaskRunnerTest, ManySequencesShareThePool)
+        {
+            ThreadPoolQueue pool(FixedOptions(4));
+            constexpr int kSequences = 200;
+            constexpr int kTasks = 50;
+
+            struct Sequence
+            {
+                std::unique_ptr<SequencedTaskRunner> m_Runner;
+                int m_Next = 0;
+                bool m_OutOfOrder = false;
+            };
+            std::vector<Sequence> sequences(kSequences);
+            std::atomic_int completed{0};
+            for (auto &sequence : sequences)
+            {
+                sequence.m_Runner = std::make_unique<SequencedTaskRunner>(pool);
+            }
+            // interleave the posts across the sequences
+            for (int task = 0; task < kTasks; task++)
+            {
+                for (auto &sequence : sequences)
+                {
+                    Sequence *seq = &sequence;
+                    seq->m_Runner->PostTask(std::make_unique<CallableThreadTask>([seq, task, &completed]()
+                                                                                 {
+                        if (seq->m_Next != task || seq->m_Runner->RunsTasksInCurrentSequence() == false)
+                        {
+                            seq->m_OutOfOrder = true;
+                        }
+                        seq->m_Next++;
+                        completed++; }));
+                }
+            }
+            for (int x = 0; x < 1000 && completed < kSequences * kTasks; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            EXPECT_EQ(kSequences * kTasks, completed);
+            for (auto &sequence : sequences)
+            {
+                EXPECT_FALSE(sequence.m_OutOfOrder);
+                EXPECT_EQ(kTasks, sequence.m_Next);
+                // another sequence's task isn't ours
+                EXPECT_FALSE(sequence.m_Runner->RunsTasksInCurrentSequence());
+            }
+        }
+
+        TEST(SequencedTaskRunnerTest, SequencesTakeTurns)
+        {
+            ThreadPoolQueue pool(1);
+            constexpr size_t kBatchSize = 2;
+            constexpr int kTasks = 6;
+            SequencedTaskRunner first(pool, kBatchSize);
+            SequencedTaskRunner second(pool, kBatchSize);
+
+            // hold the only worker till both sequences have their tasks queued
+            std::promise<void> release;
+            std::shared_future<void> released = release.get_future().share();
+            pool.PostTask(std::make_unique<CallableThreadTask>([released]()
+                                                               { released.wait(); }));
+            std::mutex orderLock;
+            std::vector<int> order;
+            for (int x = 0; x < kTasks; x++)
+            {
+                for (int sequence : {1, 2})
+                {
+                    SequencedTaskRunner &runner = sequence == 1 ? first : second;
+                    runner.PostTask(std::make_unique<CallableThreadTask>([sequence, &orderLock, &order]()
+                                                                         {
+                        std::lock_guard<std::mutex> lock(orderLock);
+                        order.push_back(sequence); }));
+                }
+            }
+            release.set_value();
+            for (int x = 0; x < 500 && (first.GetPendingCount() > 0 || second.GetPendingCount() > 0); x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            pool.Terminate();
+
+            // a sequence gives the worker up after each batch even though it's reposted from the worker
+            std::vector<int> expected;
+            for (int x = 0; x < kTasks / static_cast<int>(kBatchSize); x++)
+            {
+                expected.insert(expected.end(), {1, 1, 2, 2});
+            }
+            std::lock_guard<std::mutex> lock(orderLock);
+            EXPECT_EQ(expected, order);
+        }
+
+        TEST(SequencedTaskRunnerTest, PostFromSequence)
+        {
+            ThreadPoolQueue pool(FixedOptions(2));
+            SequencedTaskRunner runner(pool);
+            std::vector<int> order;
+            std::promise<void> done;
+            std::future<void> doneFuture = done.get_future();
+
+            runner.PostTask(std::make_unique<CallableThreadTask>([&]()
+                                                                 {
+                order.push_back(1);
+                // posted from the sequence so it runs after the task already queued
+                runner.PostTask(std::make_unique<CallableThreadTask>([&]()
+                                                                     {
+                    order.push_back(3);
+                    done.set_value(); })); }));
+            runner.PostTask(std::make_unique<CallableThreadTask>([&]()
+                                                                 { order.push_back(2); }));
+            ASSERT_EQ(std::future_status::ready, doneFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_THAT(order, ::testing::ElementsAre(1, 2, 3));
+        }
+
+        TEST(SequencedTaskRunnerTest, OutlivesRunner)
+        {
+            ThreadPoolQueue pool(1);
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            {
+                SequencedTaskRunner runner(pool);
+                runner.PostTask(std::make_unique<CallableThreadTask>([&ran]()
+                                                                     { ran.set_value(); }));
+            }
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+        }
+
+        TEST(SequencedTaskRunnerTest, Terminated)
+        {
+            ThreadPoolQueue pool(1);
+            SequencedTaskRunner runner(pool);
+            pool.Terminate();
+            EXPECT_FALSE(runner.PostTask(std::make_unique<CallableThreadTask>([]() {})));
+            EXPECT_EQ(0, runner.GetPendingCount());
+        }
+    } // namespace Threads
+} // namespace v8App
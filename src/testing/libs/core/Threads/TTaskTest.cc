@@ -0,0 +1,168 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/TTask.h"
+#include "Threads/PoolAwaiters.h"
+#include "Time/Time.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        namespace
+        {
+            TTask<int> ReturnValue(int inValue)
+            {
+                co_return inValue;
+            }
+
+            TTask<> SetValue(int &outValue, int inValue)
+            {
+                outValue = inValue;
+                co_return;
+            }
+
+            TTask<int> Throws()
+            {
+                throw std::runtime_error("task failed");
+                co_return 0;
+            }
+
+            TTask<int> AddNested(int inA, int inB)
+            {
+                int a = co_await ReturnValue(inA);
+                TTask<int> b = ReturnValue(inB);
+                co_return a + co_await b;
+            }
+
+            TTask<std::thread::id> HopOnto(ThreadPoolQueue &inPool)
+            {
+                co_await ScheduleOn(inPool);
+                co_return std::this_thread::get_id();
+            }
+        } // namespace
+
+        TEST(TTaskTest, LazyStart)
+        {
+            int value = 0;
+            TTask<> task = SetValue(value, 5);
+            EXPECT_TRUE(task.IsValid());
+            EXPECT_FALSE(task.IsDone());
+            EXPECT_EQ(0, value);
+
+            TTask<> moved = std::move(task);
+            EXPECT_FALSE(task.IsValid());
+            SyncWait(std::move(moved));
+            EXPECT_EQ(5, value);
+
+            // a task that's never started is just destroyed
+            {
+                TTask<> unstarted = SetValue(value, 10);
+            }
+            EXPECT_EQ(5, value);
+        }
+
+        TEST(TTaskTest, SyncWait)
+        {
+            EXPECT_EQ(3, SyncWait(ReturnValue(3)));
+            EXPECT_EQ(7, SyncWait(AddNested(3, 4)));
+            std::string result = SyncWait([]() -> TTask<std::string>
+                                          { co_return std::string("test"); }());
+            EXPECT_EQ("test", result);
+        }
+
+        TEST(TTaskTest, Exceptions)
+        {
+            EXPECT_THROW(SyncWait(Throws()), std::runtime_error);
+
+            // the exception goes to the awaiting task
+            bool caught = SyncWait([]() -> TTask<bool>
+                                   {
+                try
+                {
+                    co_await Throws();
+                }
+                catch (const std::runtime_error &)
+                {
+                    co_return true;
+                }
+                co_return false; }());
+            EXPECT_TRUE(caught);
+
+            // awaiting an empty or moved from task has no result
+            EXPECT_THROW(SyncWait(TTask<int>()), std::logic_error);
+            TTask<int> task = ReturnValue(1);
+            TTask<int> moved = std::move(task);
+            bool emptyCaught = SyncWait([&task]() -> TTask<bool>
+                                        {
+                try
+                {
+                    co_await task;
+                }
+                catch (const std::logic_error &)
+                {
+                    co_return true;
+                }
+                co_return false; }());
+            EXPECT_TRUE(emptyCaught);
+            EXPECT_EQ(1, SyncWait(std::move(moved)));
+        }
+
+        TEST(TTaskTest, ScheduleOn)
+        {
+            ThreadPoolQueue pool(2);
+            std::thread::id poolThread = SyncWait(HopOnto(pool));
+            EXPECT_NE(std::this_thread::get_id(), poolThread);
+
+            // the pool wouldn't take it so we stay on this thread
+            pool.Terminate();
+            bool scheduled = true;
+            std::thread::id thread = SyncWait([&scheduled, &pool]() -> TTask<std::thread::id>
+                                              {
+                scheduled = co_await ScheduleOn(pool);
+                co_return std::this_thread::get_id(); }());
+            EXPECT_FALSE(scheduled);
+            EXPECT_EQ(std::this_thread::get_id(), thread);
+        }
+
+        TEST(TTaskTest, Delay)
+        {
+            ThreadPoolDelayedQueue pool(2);
+            double start = Time::MonotonicallyIncreasingTimeSeconds();
+            double resumed = SyncWait([&pool]() -> TTask<double>
+                                      {
+                co_await Delay(pool, 0.05);
+                co_return Time::MonotonicallyIncreasingTimeSeconds(); }());
+            EXPECT_GE(resumed - start, 0.05);
+
+            std::thread::id thread = SyncWait([&pool]() -> TTask<std::thread::id>
+                                              {
+                co_await ScheduleOn(pool);
+                co_return std::this_thread::get_id(); }());
+            EXPECT_NE(std::this_thread::get_id(), thread);
+        }
+
+        TEST(TTaskTest, Detach)
+        {
+            ThreadPoolQueue pool(2);
+            std::promise<std::thread::id> promise;
+            std::future<std::thread::id> future = promise.get_future();
+            Detach([](ThreadPoolQueue &inPool, std::promise<std::thread::id> &outPromise) -> TTask<>
+                   {
+                co_await ScheduleOn(inPool);
+                outPromise.set_value(std::this_thread::get_id()); }(pool, promise));
+            EXPECT_NE(std::this_thread::get_id(), future.get());
+
+            // exceptions are logged and dropped
+            Detach(Throws());
+        }
+    } // namespace Threads
+} // namespace v8App
@@ -7,6 +7,8 @@
 #include <future>
 #include <iostream>
 #include <iomanip>
+#include <atomic>
+#include <vector>
 
 #if defined(V8APP_WINDOWS)
 #include <windows.h>
@@ -33,11 +35,23 @@ namespace v8App
             }
         };
 
+        // hands back the ready time the pool stamped on it
+        class ReadyTimeTask : public IThreadPoolTask
+        {
+        public:
+            ReadyTimeTask(std::promise<int64_t> &inReadyTime) : m_ReadyTime(inReadyTime) {}
+            void Run() override { m_ReadyTime.set_value(GetReadyTime()); }
+
+        private:
+            std::promise<int64_t> &m_ReadyTime;
+        };
+
         class TestThreadPoolDelayedQueue : public ThreadPoolDelayedQueue
         {
         public:
             TestThreadPoolDelayedQueue(int inNumberOfWorkers = -1, ThreadPriority inPriority = ThreadPriority::kBestEffort)
                 : ThreadPoolDelayedQueue(inNumberOfWorkers, inPriority) {}
+            explicit TestThreadPoolDelayedQueue(const ElasticPoolOptions &inOptions) : ThreadPoolDelayedQueue(inOptions) {}
             int GetThreadPriority(int inIndex)
             {
                 if (inIndex >= m_Workers.size())
@@ -71,6 +85,8 @@ namespace v8App
                 EXPECT_EQ(THREAD_PRIORITY_NORMAL, pool.GetThreadPriority(0));
 #elif defined(V8APP_MACOS) || defined(V8APP_IOS)
                 EXPECT_EQ(QOS_CLASS_BACKGROUND, pool.GetThreadPriority(0));
+#elif defined(V8APP_LINUX)
+                EXPECT_EQ(kLinuxBestEffortNice, pool.GetThreadPriority(0));
 #endif
             }
 
@@ -85,6 +101,10 @@ namespace v8App
                 EXPECT_EQ(THREAD_PRIORITY_TIME_CRITICAL, pool.GetThreadPriority(0));
 #elif defined(V8APP_MACOS) || defined(V8APP_IOS)
                 EXPECT_EQ(QOS_CLASS_USER_INITIATED, pool.GetThreadPriority(0));
+#elif defined(V8APP_LINUX)
+                // only goes above the default if we have CAP_SYS_NICE
+                EXPECT_LE(pool.GetThreadPriority(0), 0);
+                EXPECT_GE(pool.GetThreadPriority(0), kLinuxUserBlockingNice);
 #endif
             }
             {
@@ -143,6 +163,197 @@ namespace v8App
             EXPECT_EQ(5, task5);
         }
 
+        TEST(ThreadPoolDelayedQueueTest, PostTasks)
+        {
+            std::atomic_int count{0};
+            std::atomic_int delayedCount{0};
+            TestTime::TestTimeSeconds::Clear();
+
+            std::vector<ThreadPoolTaskUniquePtr> tasks;
+            std::vector<ThreadPoolTaskUniquePtr> delayedTasks;
+            for (int x = 0; x < 8; x++)
+            {
+                tasks.push_back(std::make_unique<CallableThreadTask>([&count]()
+                                                                     { count++; }));
+                delayedTasks.push_back(std::make_unique<CallableThreadTask>([&delayedCount]()
+                                                                            { delayedCount++; }));
+            }
+
+            {
+                TestThreadPoolDelayedQueue pool = TestThreadPoolDelayedQueue(2);
+                EXPECT_TRUE(pool.PostDelayedTasks(0.5, std::move(delayedTasks)));
+                EXPECT_TRUE(pool.PostTasks(std::move(tasks)));
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                EXPECT_EQ(8, count);
+                EXPECT_EQ(0, delayedCount);
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                EXPECT_EQ(8, delayedCount);
+
+                pool.Terminate();
+                EXPECT_FALSE(pool.PostTasks({}));
+                EXPECT_FALSE(pool.PostDelayedTasks(1.0, {}));
+            }
+        }
+
+        TEST(ThreadPoolDelayedQueueTest, Metrics)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            std::promise<void> ran;
+            std::promise<void> delayedRan;
+            std::future<void> ranFuture = ran.get_future();
+            std::future<void> delayedFuture = delayedRan.get_future();
+
+            TestThreadPoolDelayedQueue pool = TestThreadPoolDelayedQueue(1);
+            EXPECT_TRUE(pool.PostTask(std::make_unique<CallableThreadTask>([&ran]()
+                                                                           { ran.set_value(); })));
+            EXPECT_TRUE(pool.PostDelayedTask(0.05, std::make_unique<CallableThreadTask>([&delayedRan]()
+                                                                                        { delayedRan.set_value(); })));
+            ranFuture.wait();
+            delayedFuture.wait();
+            // the counters are updated after the task returns
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            PoolMetricsSnapshot metrics = pool.GetMetrics();
+            EXPECT_EQ(1, metrics.m_Posted);
+            EXPECT_EQ(1, metrics.m_DelayedPosted);
+            EXPECT_EQ(2, metrics.m_Started);
+            EXPECT_EQ(0, metrics.GetQueueDepth());
+            EXPECT_EQ(1, metrics.m_WaitTime.m_Count);
+            EXPECT_EQ(1, metrics.m_DelayedLateness.m_Count);
+            EXPECT_EQ(2, metrics.m_RunTime.m_Count);
+            ASSERT_EQ(1, metrics.m_Workers.size());
+            EXPECT_EQ(2, metrics.m_Workers[0].m_TasksRun);
+        }
+
+        TEST(ThreadPoolDelayedQueueTest, DelayedReadyTime)
+        {
+            TestTime::TestTimeSeconds::Enable();
+            TestTime::TestTimeSeconds::Set(10.0);
+            std::promise<int64_t> single;
+            std::promise<int64_t> batched;
+            std::future<int64_t> singleFuture = single.get_future();
+            std::future<int64_t> batchedFuture = batched.get_future();
+
+            TestThreadPoolDelayedQueue pool = TestThreadPoolDelayedQueue(1);
+            EXPECT_TRUE(pool.PostDelayedTask(2.0, std::make_unique<ReadyTimeTask>(single)));
+            std::vector<ThreadPoolTaskUniquePtr> tasks;
+            tasks.push_back(std::make_unique<ReadyTimeTask>(batched));
+            EXPECT_TRUE(pool.PostDelayedTasks(3.0, std::move(tasks)));
+
+            // the ready time is the deadline on the clock the timer went by
+            TestTime::TestTimeSeconds::Set(13.0);
+            ASSERT_EQ(std::future_status::ready, singleFuture.wait_for(std::chrono::seconds(5)));
+            ASSERT_EQ(std::future_status::ready, batchedFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_EQ(static_cast<int64_t>(12.0 * Time::kNanosecondsPerSecond), singleFuture.get());
+            EXPECT_EQ(static_cast<int64_t>(13.0 * Time::kNanosecondsPerSecond), batchedFuture.get());
+            pool.Terminate();
+            TestTime::TestTimeSeconds::Clear();
+        }
+
+        TEST(ThreadPoolDelayedQueueTest, CancelDelayedTask)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            std::atomic_bool canceledRan{false};
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            // tracks when the canceled task is destroyed
+            std::shared_ptr<int> sentinel = std::make_shared<int>(0);
+
+            TestThreadPoolDelayedQueue pool = TestThreadPoolDelayedQueue(1);
+            Queues::TimerId canceled = pool.PostCancelableDelayedTask(0.05, std::make_unique<CallableThreadTask>([&canceledRan, sentinel]()
+                                                                                                                 { canceledRan = true; }));
+            Queues::TimerId kept = pool.PostCancelableDelayedTask(0.05, std::make_unique<CallableThreadTask>([&ran]()
+                                                                                                             { ran.set_value(); }));
+            EXPECT_NE(Queues::kInvalidTimerId, canceled);
+            EXPECT_NE(Queues::kInvalidTimerId, kept);
+            EXPECT_EQ(2, sentinel.use_count());
+
+            EXPECT_TRUE(pool.CancelDelayedTask(canceled));
+            EXPECT_EQ(1, sentinel.use_count());
+            EXPECT_FALSE(pool.CancelDelayedTask(canceled));
+
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            // it's already run
+            EXPECT_FALSE(pool.CancelDelayedTask(kept));
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            EXPECT_FALSE(canceledRan);
+
+            PoolMetricsSnapshot metrics = pool.GetMetrics();
+            EXPECT_EQ(2, metrics.m_DelayedPosted);
+            EXPECT_EQ(1, metrics.m_DelayedCanceled);
+            EXPECT_EQ(1, metrics.m_Started);
+            EXPECT_EQ(0, metrics.GetQueueDepth());
+
+            pool.Terminate();
+            EXPECT_EQ(Queues::kInvalidTimerId, pool.PostCancelableDelayedTask(0.05, std::make_unique<CallableThreadTask>([]() {})));
+        }
+
+        TEST(ThreadPoolDelayedQueueTest, Elastic)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            ElasticPoolOptions options;
+            options.m_MinWorkers = 1;
+            options.m_MaxWorkers = 2;
+            options.m_TargetLatency = 0.01;
+            options.m_IdleTimeout = 0.2;
+            TestThreadPoolDelayedQueue pool(options);
+            EXPECT_TRUE(pool.IsElastic());
+            EXPECT_EQ(2, pool.GetNumberOfWorkers());
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+
+            // a delayed task that comes due while the only worker is blocked gets a new worker
+            std::promise<void> release;
+            std::shared_future<void> releaseFuture = release.get_future().share();
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            pool.PostTask(std::make_unique<CallableThreadTask>([releaseFuture]()
+                                                               { releaseFuture.wait(); }));
+            pool.PostDelayedTask(0.02, std::make_unique<CallableThreadTask>([&ran]()
+                                                                            { ran.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_EQ(2, pool.GetNumberOfActiveWorkers());
+            release.set_value();
+
+            for (int x = 0; x < 100 && pool.GetNumberOfActiveWorkers() > 1; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+        }
+
+        TEST(ThreadPoolDelayedQueueTest, TrimIdleWorkers)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            ElasticPoolOptions options;
+            options.m_MinWorkers = 1;
+            options.m_MaxWorkers = 2;
+            options.m_TargetLatency = 0.01;
+            options.m_IdleTimeout = 60;
+            TestThreadPoolDelayedQueue pool(options);
+
+            std::promise<void> release;
+            std::shared_future<void> releaseFuture = release.get_future().share();
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            pool.PostTask(std::make_unique<CallableThreadTask>([releaseFuture]()
+                                                               { releaseFuture.wait(); }));
+            pool.PostDelayedTask(0.02, std::make_unique<CallableThreadTask>([&ran]()
+                                                                            { ran.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_EQ(2, pool.GetNumberOfActiveWorkers());
+            release.set_value();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // the idle timeout is too long so only the trim retires the extra worker
+            EXPECT_EQ(1, pool.TrimIdleWorkers());
+            for (int x = 0; x < 100 && pool.GetNumberOfActiveWorkers() > 1; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+            EXPECT_EQ(0, pool.TrimIdleWorkers());
+        }
+
         TEST(ThreadPoolDelayedQueueTest, Terminates)
         {
             TestThreadPoolDelayedQueue pool = TestThreadPoolDelayedQueue(1);
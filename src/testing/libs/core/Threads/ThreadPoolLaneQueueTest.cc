@@ -0,0 +1,357 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/ThreadPoolLaneQueue.h"
+#include "Time/Time.h"
+#include "TestTime.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        class TestThreadPoolLaneQueue : public ThreadPoolLaneQueue
+        {
+        public:
+            TestThreadPoolLaneQueue(int inNumberOfWorkers = -1, ThreadPriority inPriority = ThreadPriority::kUserVisible)
+                : ThreadPoolLaneQueue(inNumberOfWorkers, inPriority) {}
+            explicit TestThreadPoolLaneQueue(const ElasticPoolOptions &inOptions) : ThreadPoolLaneQueue(inOptions) {}
+
+            int CallPickLane(double inNow)
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                return PickLane(inNow);
+            }
+            int CallGetLaneIndex(ThreadPriority inLane) { return static_cast<int>(GetLaneIndex(inLane)); }
+            void CallClearLane(int inLane)
+            {
+                std::lock_guard<std::mutex> lock(m_QueueLock);
+                m_Lanes[inLane].m_Tasks.clear();
+            }
+        };
+
+        TEST(ThreadPoolLaneQueueTest, Constructor)
+        {
+            int hardwareThreads = GetHardwareCores();
+            TestThreadPoolLaneQueue pool;
+            EXPECT_EQ(hardwareThreads, pool.GetNumberOfWorkers());
+            EXPECT_EQ(hardwareThreads, pool.GetNumberOfActiveWorkers());
+            EXPECT_FALSE(pool.IsElastic());
+            EXPECT_FALSE(pool.IsExiting());
+            EXPECT_EQ(ThreadPriority::kUserVisible, pool.GetPriority());
+            EXPECT_EQ(std::max(1, hardwareThreads / 2), pool.GetLaneConcurrency(ThreadPriority::kBestEffort));
+            EXPECT_EQ(hardwareThreads, pool.GetLaneConcurrency(ThreadPriority::kUserBlocking));
+            EXPECT_EQ(ThreadPoolLaneQueue::kDefaultAgingThreshold, pool.GetAgingThreshold());
+        }
+
+        TEST(ThreadPoolLaneQueueTest, PriorityOrder)
+        {
+            std::mutex lock;
+            std::vector<int> order;
+            std::promise<void> done;
+            std::future<void> doneFuture = done.get_future();
+            auto record = [&lock, &order, &done](int inValue)
+            {
+                return std::make_unique<CallableThreadTask>([&lock, &order, &done, inValue]()
+                                                            {
+                    std::lock_guard<std::mutex> guard(lock);
+                    order.push_back(inValue);
+                    if (order.size() == 3)
+                    {
+                        done.set_value();
+                    } });
+            };
+
+            TestThreadPoolLaneQueue pool(1);
+            // hold the tasks back so they all queue up before any run
+            pool.SetPaused(true);
+            EXPECT_TRUE(pool.PostTask(ThreadPriority::kBestEffort, record(1)));
+            EXPECT_TRUE(pool.PostTask(ThreadPriority::kUserVisible, record(2)));
+            EXPECT_TRUE(pool.PostTask(ThreadPriority::kUserBlocking, record(3)));
+            EXPECT_EQ(1, pool.GetLaneQueuedCount(ThreadPriority::kBestEffort));
+            pool.SetPaused(false);
+
+            EXPECT_EQ(std::future_status::ready, doneFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_THAT(order, ::testing::ElementsAre(3, 2, 1));
+        }
+
+        TEST(ThreadPoolLaneQueueTest, Aging)
+        {
+            TestTime::TestTimeSeconds::Enable();
+            TestTime::TestTimeSeconds::Set(100.0);
+            TestThreadPoolLaneQueue pool(1);
+            pool.SetPaused(true);
+            pool.SetAgingThreshold(1.0);
+            EXPECT_EQ(1.0, pool.GetAgingThreshold());
+            int bestEffort = pool.CallGetLaneIndex(ThreadPriority::kBestEffort);
+            int userBlocking = pool.CallGetLaneIndex(ThreadPriority::kUserBlocking);
+
+            pool.PostTask(ThreadPriority::kBestEffort, std::make_unique<CallableThreadTask>([]() {}));
+            pool.PostTask(ThreadPriority::kUserBlocking, std::make_unique<CallableThreadTask>([]() {}));
+            EXPECT_EQ(userBlocking, pool.CallPickLane(100.0));
+            // when both have waited past the threshold they age together so the priority order holds
+            EXPECT_EQ(userBlocking, pool.CallPickLane(105.0));
+
+            // a newer user blocking task still goes first till the best effort one has waited a
+            // threshold longer for each lane it's behind
+            TestTime::TestTimeSeconds::Set(102.5);
+            pool.CallClearLane(userBlocking);
+            pool.PostTask(ThreadPriority::kUserBlocking, std::make_unique<CallableThreadTask>([]() {}));
+            EXPECT_EQ(userBlocking, pool.CallPickLane(102.5));
+            EXPECT_EQ(bestEffort, pool.CallPickLane(103.0));
+
+            // 0 turns aging off
+            pool.SetAgingThreshold(0);
+            EXPECT_EQ(userBlocking, pool.CallPickLane(1000.0));
+            pool.Terminate();
+            TestTime::TestTimeSeconds::Clear();
+        }
+
+        TEST(ThreadPoolLaneQueueTest, DefaultSharesUserVisibleLane)
+        {
+            TestThreadPoolLaneQueue pool(1);
+            pool.SetPaused(true);
+            pool.PostTask(ThreadPriority::kDefault, std::make_unique<CallableThreadTask>([]() {}));
+            EXPECT_EQ(1u, pool.GetLaneQueuedCount(ThreadPriority::kUserVisible));
+            EXPECT_EQ(1u, pool.GetLaneQueuedCount(ThreadPriority::kDefault));
+            EXPECT_EQ(0u, pool.GetLaneQueuedCount(ThreadPriority::kBestEffort));
+            EXPECT_EQ(0u, pool.GetLaneQueuedCount(ThreadPriority::kUserBlocking));
+            pool.Terminate();
+        }
+
+        TEST(ThreadPoolLaneQueueTest, LaneConcurrency)
+        {
+            // a fixed 2 workers whatever the number of cores
+            ElasticPoolOptions options;
+            options.m_MinWorkers = 2;
+            options.m_MaxWorkers = 2;
+            TestThreadPoolLaneQueue pool(options);
+            pool.SetLaneConcurrency(ThreadPriority::kBestEffort, 1);
+            EXPECT_EQ(1, pool.GetLaneConcurrency(ThreadPriority::kBestEffort));
+
+            std::promise<void> release;
+            std::shared_future<void> releaseFuture = release.get_future().share();
+            for (int x = 0; x < 2; x++)
+            {
+                pool.PostTask(ThreadPriority::kBestEffort, std::make_unique<CallableThreadTask>([releaseFuture]()
+                                                                                                { releaseFuture.wait(); }));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            // only one runs and the other worker is still free for higher priority work
+            EXPECT_EQ(1, pool.GetLaneRunningCount(ThreadPriority::kBestEffort));
+            EXPECT_EQ(1, pool.GetLaneQueuedCount(ThreadPriority::kBestEffort));
+
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            pool.PostTask(ThreadPriority::kUserBlocking, std::make_unique<CallableThreadTask>([&ran]()
+                                                                                              { ran.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            release.set_value();
+        }
+
+        TEST(ThreadPoolLaneQueueTest, PostTasksAndDelayed)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            std::atomic_int count{0};
+            std::promise<void> delayedRan;
+            std::future<void> delayedFuture = delayedRan.get_future();
+
+            TestThreadPoolLaneQueue pool(2);
+            std::vector<ThreadPoolTaskUniquePtr> tasks;
+            for (int x = 0; x < 8; x++)
+            {
+                tasks.push_back(std::make_unique<CallableThreadTask>([&count]()
+                                                                     { count++; }));
+            }
+            EXPECT_TRUE(pool.PostTasks(ThreadPriority::kUserVisible, std::move(tasks)));
+            double start = Time::MonotonicallyIncreasingTimeSeconds();
+            EXPECT_TRUE(pool.PostDelayedTask(ThreadPriority::kUserBlocking, 0.05, std::make_unique<CallableThreadTask>([&delayedRan]()
+                                                                                                                       { delayedRan.set_value(); })));
+            EXPECT_EQ(std::future_status::ready, delayedFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_GE(Time::MonotonicallyIncreasingTimeSeconds() - start, 0.05);
+            for (int x = 0; x < 100 && count < 8; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            EXPECT_EQ(8, count);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            PoolMetricsSnapshot metrics = pool.GetMetrics();
+            EXPECT_EQ(8, metrics.m_Posted);
+            EXPECT_EQ(1, metrics.m_DelayedPosted);
+            EXPECT_EQ(9, metrics.m_Started);
+
+            pool.Terminate();
+            EXPECT_TRUE(pool.IsExiting());
+            EXPECT_FALSE(pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([]() {})));
+            EXPECT_FALSE(pool.PostTasks(ThreadPriority::kUserVisible, {}));
+            EXPECT_FALSE(pool.PostDelayedTask(ThreadPriority::kUserVisible, 1.0, std::make_unique<CallableThreadTask>([]() {})));
+        }
+
+        TEST(ThreadPoolLaneQueueTest, CancelDelayedTask)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            std::atomic_bool canceledRan{false};
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            // tracks when the canceled task is destroyed
+            std::shared_ptr<int> sentinel = std::make_shared<int>(0);
+
+            TestThreadPoolLaneQueue pool(1);
+            Queues::TimerId canceled = pool.PostCancelableDelayedTask(ThreadPriority::kUserBlocking, 0.05,
+                                                                      std::make_unique<CallableThreadTask>([&canceledRan, sentinel]()
+                                                                                                           { canceledRan = true; }));
+            Queues::TimerId kept = pool.PostCancelableDelayedTask(ThreadPriority::kBestEffort, 0.05,
+                                                                  std::make_unique<CallableThreadTask>([&ran]()
+                                                                                                       { ran.set_value(); }));
+            EXPECT_NE(Queues::kInvalidTimerId, canceled);
+            EXPECT_EQ(2, sentinel.use_count());
+
+            EXPECT_TRUE(pool.CancelDelayedTask(canceled));
+            EXPECT_EQ(1, sentinel.use_count());
+            EXPECT_FALSE(pool.CancelDelayedTask(canceled));
+
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_FALSE(pool.CancelDelayedTask(kept));
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            EXPECT_FALSE(canceledRan);
+
+            PoolMetricsSnapshot metrics = pool.GetMetrics();
+            EXPECT_EQ(1, metrics.m_DelayedCanceled);
+            EXPECT_EQ(0, metrics.GetQueueDepth());
+        }
+
+        TEST(ThreadPoolLaneQueueTest, BlockingCallCompensates)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            std::promise<void> release;
+            std::shared_future<void> releaseFuture = release.get_future().share();
+            std::promise<void> blocking;
+            std::future<void> blockingFuture = blocking.get_future();
+            std::promise<void> otherRan;
+            std::future<void> otherFuture = otherRan.get_future();
+
+            TestThreadPoolLaneQueue pool(1);
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+            pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([&blocking, releaseFuture]()
+                                                                                             {
+                ScopedBlockingCall call(BlockingType::kWillBlock);
+                blocking.set_value();
+                releaseFuture.wait(); }));
+            ASSERT_EQ(std::future_status::ready, blockingFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_EQ(1, pool.GetNumberOfBlockedWorkers());
+
+            // the only worker is blocked so a compensating worker has to run this
+            pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([&otherRan]()
+                                                                                             { otherRan.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, otherFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_EQ(2, pool.GetNumberOfActiveWorkers());
+
+            release.set_value();
+            for (int x = 0; x < 100 && pool.GetNumberOfActiveWorkers() > 1; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            // back down to the pool's size once the call is done
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+            EXPECT_EQ(0, pool.GetNumberOfBlockedWorkers());
+
+            // the pool still runs tasks after stepping down
+            std::promise<void> afterRan;
+            std::future<void> afterFuture = afterRan.get_future();
+            pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([&afterRan]()
+                                                                                             { afterRan.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, afterFuture.wait_for(std::chrono::seconds(5)));
+        }
+
+        TEST(ThreadPoolLaneQueueTest, Elastic)
+        {
+            ElasticPoolOptions options;
+            options.m_MinWorkers = 1;
+            options.m_MaxWorkers = 3;
+            options.m_IdleTimeout = 0.2;
+            TestThreadPoolLaneQueue pool(options);
+            EXPECT_TRUE(pool.IsElastic());
+            EXPECT_EQ(3, pool.GetNumberOfWorkers());
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+
+            std::promise<void> release;
+            std::shared_future<void> releaseFuture = release.get_future().share();
+            pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([releaseFuture]()
+                                                                                             { releaseFuture.wait(); }));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            // no worker is idle so posting adds one
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([&ran]()
+                                                                                             { ran.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_GE(pool.GetNumberOfActiveWorkers(), 2);
+            release.set_value();
+
+            for (int x = 0; x < 100 && pool.GetNumberOfActiveWorkers() > 1; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+        }
+
+        TEST(ThreadPoolLaneQueueTest, TrimIdleWorkers)
+        {
+            ElasticPoolOptions options;
+            options.m_MinWorkers = 1;
+            options.m_MaxWorkers = 3;
+            options.m_TargetLatency = 0.01;
+            // long enough that only the trim retires the idle worker
+            options.m_IdleTimeout = 60;
+            TestThreadPoolLaneQueue pool(options);
+
+            std::promise<void> release;
+            std::shared_future<void> releaseFuture = release.get_future().share();
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([releaseFuture]()
+                                                                                 { releaseFuture.wait(); }));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([&ran]()
+                                                                                 { ran.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_GE(pool.GetNumberOfActiveWorkers(), 2);
+            release.set_value();
+            // let the workers park
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kModerate);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            EXPECT_GE(pool.GetNumberOfActiveWorkers(), 2);
+
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kCritical);
+            for (int x = 0; x < 100 && pool.GetNumberOfActiveWorkers() > 1; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+            // never trims below the min
+            EXPECT_EQ(0, pool.TrimIdleWorkers());
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kNone);
+
+            // still runs work after the trim
+            std::promise<void> ranAgain;
+            std::future<void> ranAgainFuture = ranAgain.get_future();
+            pool.PostTask(ThreadPriority::kUserVisible, std::make_unique<CallableThreadTask>([&ranAgain]()
+                                                                                 { ranAgain.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranAgainFuture.wait_for(std::chrono::seconds(5)));
+
+            pool.Terminate();
+            EXPECT_EQ(0, pool.TrimIdleWorkers());
+        }
+    } // namespace Threads
+} // namespace v8App
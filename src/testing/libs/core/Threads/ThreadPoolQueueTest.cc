@@ -5,6 +5,8 @@
 #include <thread>
 #include <chrono>
 #include <future>
+#include <atomic>
+#include <functional>
 
 #if defined(V8APP_WINDOWS)
 #include <windows.h>
@@ -36,6 +38,7 @@ namespace v8App
         public:
             TestThreadPoolQueue(int inNumberOfWorkers = -1, ThreadPriority inPriority = ThreadPriority::kBestEffort)
                 : ThreadPoolQueue(inNumberOfWorkers, inPriority) {}
+            explicit TestThreadPoolQueue(const ElasticPoolOptions &inOptions) : ThreadPoolQueue(inOptions) {}
             int GetThreadPriority(int inIndex)
             {
                 if (inIndex >= m_Workers.size())
@@ -70,6 +73,8 @@ namespace v8App
                 EXPECT_EQ(THREAD_PRIORITY_NORMAL, pool.GetThreadPriority(0));
 #elif defined(V8APP_MACOS) || defined(V8APP_IOS)
                 EXPECT_EQ(QOS_CLASS_BACKGROUND, pool.GetThreadPriority(0));
+#elif defined(V8APP_LINUX)
+                EXPECT_EQ(kLinuxBestEffortNice, pool.GetThreadPriority(0));
 #endif
             }
 
@@ -84,6 +89,10 @@ namespace v8App
                EXPECT_EQ(THREAD_PRIORITY_TIME_CRITICAL, pool.GetThreadPriority(0));
 #elif defined(V8APP_MACOS) || defined(V8APP_IOS)
                 EXPECT_EQ(QOS_CLASS_USER_INITIATED, pool.GetThreadPriority(0));
+#elif defined(V8APP_LINUX)
+                // only goes above the default if we have CAP_SYS_NICE
+                EXPECT_LE(pool.GetThreadPriority(0), 0);
+                EXPECT_GE(pool.GetThreadPriority(0), kLinuxUserBlockingNice);
 #endif
             }
             {
@@ -139,6 +148,254 @@ namespace v8App
             EXPECT_EQ(5, task5);
         }
 
+        TEST(ThreadPoolQueueTest, PostTaskFromWorker)
+        {
+            std::atomic_int count{0};
+            std::promise<void> done;
+            std::future<void> doneFuture = done.get_future();
+            constexpr int kNumSubTasks = 16;
+
+            TestThreadPoolQueue pool = TestThreadPoolQueue(2);
+            // tasks posted from a worker go into that worker's deque and can be stolen by the others
+            pool.PostTask(std::make_unique<CallableThreadTask>([&pool, &count, &done]()
+                                                               {
+                for (int x = 0; x < kNumSubTasks; x++)
+                {
+                    pool.PostTask(std::make_unique<CallableThreadTask>([&count, &done]()
+                                                                       {
+                        if (++count == kNumSubTasks)
+                        {
+                            done.set_value();
+                        } }));
+                } }));
+            EXPECT_EQ(std::future_status::ready, doneFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_EQ(kNumSubTasks, count);
+        }
+
+        TEST(ThreadPoolQueueTest, WorkerRepostDoesNotStarveInjected)
+        {
+            constexpr int kMaxReposts = 100000;
+            std::atomic_bool injectedRan{false};
+            std::atomic_int reposts{0};
+            std::promise<void> done;
+            std::future<void> doneFuture = done.get_future();
+
+            // with one worker a task that keeps posting itself would be all it ever runs
+            TestThreadPoolQueue pool = TestThreadPoolQueue(1);
+            std::function<void()> repost;
+            repost = [&]()
+            {
+                if (injectedRan || ++reposts == kMaxReposts)
+                {
+                    done.set_value();
+                    return;
+                }
+                pool.PostTask(std::make_unique<CallableThreadTask>(repost));
+            };
+            pool.PostTask(std::make_unique<CallableThreadTask>(repost));
+            pool.PostTask(std::make_unique<CallableThreadTask>([&injectedRan]()
+                                                               { injectedRan = true; }));
+            EXPECT_EQ(std::future_status::ready, doneFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_TRUE(injectedRan);
+            EXPECT_LT(reposts, kMaxReposts);
+        }
+
+        TEST(ThreadPoolQueueTest, PostTasks)
+        {
+            constexpr int kNumTasks = 32;
+            std::atomic_int count{0};
+            std::promise<void> done;
+            std::future<void> doneFuture = done.get_future();
+            auto makeTasks = [&count, &done](int inNumTasks)
+            {
+                std::vector<ThreadPoolTaskUniquePtr> tasks;
+                for (int x = 0; x < inNumTasks; x++)
+                {
+                    tasks.push_back(std::make_unique<CallableThreadTask>([&count, &done]()
+                                                                         {
+                        if (++count == kNumTasks)
+                        {
+                            done.set_value();
+                        } }));
+                }
+                return tasks;
+            };
+
+            TestThreadPoolQueue pool = TestThreadPoolQueue(2);
+            EXPECT_TRUE(pool.PostTasks({}));
+            EXPECT_TRUE(pool.PostTasks(makeTasks(kNumTasks / 2)));
+            // and a batch from one of the workers
+            pool.PostTask(std::make_unique<CallableThreadTask>([&pool, &makeTasks]()
+                                                               { pool.PostTasks(makeTasks(kNumTasks / 2)); }));
+            EXPECT_EQ(std::future_status::ready, doneFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_EQ(kNumTasks, count);
+
+            pool.Terminate();
+            EXPECT_FALSE(pool.PostTasks(makeTasks(1)));
+        }
+
+        TEST(ThreadPoolQueueTest, Metrics)
+        {
+            std::promise<void> done;
+            std::future<void> doneFuture = done.get_future();
+            TestThreadPoolQueue pool = TestThreadPoolQueue(1);
+
+            pool.PostTask(std::make_unique<CallableThreadTask>([]()
+                                                               { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }));
+            std::vector<ThreadPoolTaskUniquePtr> tasks;
+            tasks.push_back(std::make_unique<CallableThreadTask>([]() {}));
+            tasks.push_back(std::make_unique<CallableThreadTask>([&done]()
+                                                                 { done.set_value(); }));
+            pool.PostTasks(std::move(tasks));
+            EXPECT_EQ(std::future_status::ready, doneFuture.wait_for(std::chrono::seconds(5)));
+            // the counters are updated after the task returns
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            PoolMetricsSnapshot metrics = pool.GetMetrics();
+            EXPECT_EQ(3, metrics.m_Posted);
+            EXPECT_EQ(0, metrics.m_DelayedPosted);
+            EXPECT_EQ(3, metrics.m_Started);
+            EXPECT_EQ(0, metrics.GetQueueDepth());
+            EXPECT_GT(metrics.GetEnqueueRate(), 0);
+            EXPECT_EQ(3, metrics.m_WaitTime.m_Count);
+            EXPECT_EQ(3, metrics.m_RunTime.m_Count);
+            EXPECT_GE(metrics.m_RunTime.m_MaxNanoseconds, 20000000);
+            // the batch waited behind the sleeping task
+            EXPECT_GE(metrics.m_WaitTime.m_MaxNanoseconds, 10000000);
+            ASSERT_EQ(1, metrics.m_Workers.size());
+            EXPECT_EQ(3, metrics.m_Workers[0].m_TasksRun);
+            EXPECT_GT(metrics.m_Workers[0].GetBusyRatio(), 0);
+            EXPECT_LE(metrics.m_Workers[0].GetBusyRatio(), 1.0);
+            EXPECT_NE(std::string::npos, metrics.ToString().find("Posted: 3"));
+        }
+
+        TEST(ThreadPoolQueueTest, Elastic)
+        {
+            ElasticPoolOptions options;
+            options.m_MinWorkers = 1;
+            options.m_MaxWorkers = 3;
+            options.m_TargetLatency = 0.01;
+            options.m_IdleTimeout = 0.2;
+            TestThreadPoolQueue pool(options);
+            EXPECT_TRUE(pool.IsElastic());
+            EXPECT_EQ(3, pool.GetNumberOfWorkers());
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+
+            // block the only worker, the backlog behind it should get a new worker
+            std::promise<void> release;
+            std::shared_future<void> releaseFuture = release.get_future().share();
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            pool.PostTask(std::make_unique<CallableThreadTask>([releaseFuture]()
+                                                               { releaseFuture.wait(); }));
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            pool.PostTask(std::make_unique<CallableThreadTask>([&ran]()
+                                                               { ran.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_GE(pool.GetNumberOfActiveWorkers(), 2);
+            EXPECT_LE(pool.GetNumberOfActiveWorkers(), 3);
+            release.set_value();
+
+            // the extra workers retire once they've been idle
+            for (int x = 0; x < 100 && pool.GetNumberOfActiveWorkers() > 1; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+
+            // and come back when needed
+            std::promise<void> ranAgain;
+            std::future<void> ranAgainFuture = ranAgain.get_future();
+            pool.PostTask(std::make_unique<CallableThreadTask>([&ranAgain]()
+                                                               { ranAgain.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranAgainFuture.wait_for(std::chrono::seconds(5)));
+
+            pool.Terminate();
+            EXPECT_FALSE(pool.PostTask(std::make_unique<CallableThreadTask>([]() {})));
+        }
+
+        TEST(ThreadPoolQueueTest, TrimIdleWorkers)
+        {
+            ElasticPoolOptions options;
+            options.m_MinWorkers = 1;
+            options.m_MaxWorkers = 3;
+            options.m_TargetLatency = 0.01;
+            // long enough that only the trim retires the idle worker
+            options.m_IdleTimeout = 60;
+            TestThreadPoolQueue pool(options);
+
+            std::promise<void> release;
+            std::shared_future<void> releaseFuture = release.get_future().share();
+            std::promise<void> ran;
+            std::future<void> ranFuture = ran.get_future();
+            pool.PostTask(std::make_unique<CallableThreadTask>([releaseFuture]()
+                                                   { releaseFuture.wait(); }));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            pool.PostTask(std::make_unique<CallableThreadTask>([&ran]()
+                                                   { ran.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranFuture.wait_for(std::chrono::seconds(5)));
+            EXPECT_GE(pool.GetNumberOfActiveWorkers(), 2);
+            release.set_value();
+            // let the workers park
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kModerate);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            EXPECT_GE(pool.GetNumberOfActiveWorkers(), 2);
+
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kCritical);
+            for (int x = 0; x < 100 && pool.GetNumberOfActiveWorkers() > 1; x++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            EXPECT_EQ(1, pool.GetNumberOfActiveWorkers());
+            // never trims below the min
+            EXPECT_EQ(0, pool.TrimIdleWorkers());
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kNone);
+
+            // still runs work after the trim
+            std::promise<void> ranAgain;
+            std::future<void> ranAgainFuture = ranAgain.get_future();
+            pool.PostTask(std::make_unique<CallableThreadTask>([&ranAgain]()
+                                                   { ranAgain.set_value(); }));
+            EXPECT_EQ(std::future_status::ready, ranAgainFuture.wait_for(std::chrono::seconds(5)));
+
+            pool.Terminate();
+            EXPECT_EQ(0, pool.TrimIdleWorkers());
+        }
+
+        TEST(ThreadPoolQueueTest, TasksRunInParallel)
+        {
+            if (GetHardwareCores() < 2)
+            {
+                GTEST_SKIP() << "Needs at least 2 workers";
+            }
+            std::atomic_int running{0};
+            std::atomic_int sawBoth{0};
+            auto task = [&running, &sawBoth]()
+            {
+                running++;
+                // wait for the other task to start, only possible if they don't run serially
+                auto end = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+                while (running < 2 && std::chrono::steady_clock::now() < end)
+                {
+                    std::this_thread::yield();
+                }
+                if (running >= 2)
+                {
+                    sawBoth++;
+                }
+            };
+
+            {
+                TestThreadPoolQueue pool = TestThreadPoolQueue(2);
+                pool.PostTask(std::make_unique<CallableThreadTask>(task));
+                pool.PostTask(std::make_unique<CallableThreadTask>(task));
+                std::this_thread::sleep_for(std::chrono::seconds(3));
+            }
+            EXPECT_EQ(2, sawBoth);
+        }
+
         TEST(ThreadPoolQueueTest, Terminates)
         {
             TestThreadPoolQueue pool = TestThreadPoolQueue(1);
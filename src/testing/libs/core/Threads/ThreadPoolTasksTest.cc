@@ -0,0 +1,113 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <array>
+#include <future>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Threads/ThreadPoolTasks.h"
+
+namespace v8App
+{
+    namespace Threads
+    {
+        TEST(ThreadPoolTasksTest, InlineStorage)
+        {
+            int value = 0;
+            std::unique_ptr<CallableThreadTask> small = std::make_unique<CallableThreadTask>([&value]()
+                                                                                             { value = 1; });
+            EXPECT_TRUE(small->IsInline());
+            small->Run();
+            EXPECT_EQ(1, value);
+
+            // captures bigger than the inline storage go to the heap
+            std::array<char, kDefaultTaskInlineSize * 2> big{};
+            big[0] = 2;
+            std::unique_ptr<CallableThreadTask> large = std::make_unique<CallableThreadTask>([big, &value]()
+                                                                                             { value = big[0]; });
+            EXPECT_FALSE(large->IsInline());
+            large->Run();
+            EXPECT_EQ(2, value);
+
+            // a bigger task type can keep it inline
+            std::unique_ptr<TCallableThreadTask<256>> largeInline = std::make_unique<TCallableThreadTask<256>>([big, &value]()
+                                                                                                               { value = big[0] + 1; });
+            EXPECT_TRUE(largeInline->IsInline());
+            largeInline->Run();
+            EXPECT_EQ(3, value);
+        }
+
+        TEST(ThreadPoolTasksTest, Arguments)
+        {
+            int value = 0;
+            ThreadPoolTaskUniquePtr task = std::make_unique<CallableThreadTask>([](int *inValue, int inAdd)
+                                                                                { *inValue += inAdd; },
+                                                                                &value, 5);
+            task->Run();
+            task->Run();
+            EXPECT_EQ(10, value);
+
+            std::packaged_task<int()> packaged([]()
+                                               { return 7; });
+            std::future<int> future = packaged.get_future();
+            task = std::make_unique<CallableThreadTask>(std::move(packaged));
+            task->Run();
+            EXPECT_EQ(7, future.get());
+        }
+
+        TEST(ThreadPoolTasksTest, DestroysCallable)
+        {
+            std::shared_ptr<int> shared = std::make_shared<int>(1);
+            ThreadPoolTaskUniquePtr task = std::make_unique<CallableThreadTask>([shared]() {});
+            EXPECT_EQ(2, shared.use_count());
+            task.reset();
+            EXPECT_EQ(1, shared.use_count());
+        }
+
+        TEST(ThreadPoolTasksTest, RecyclesNodes)
+        {
+            using NodePool = CallableTaskNodePool;
+
+            ThreadPoolTaskUniquePtr task = std::make_unique<CallableThreadTask>([]() {});
+            IThreadPoolTask *first = task.get();
+            size_t cached = NodePool::GetThreadCachedCount();
+            task.reset();
+            EXPECT_EQ(cached + 1, NodePool::GetThreadCachedCount());
+
+            // the freed node gets handed straight back
+            task = std::make_unique<CallableThreadTask>([]() {});
+            EXPECT_EQ(first, task.get());
+            EXPECT_EQ(cached, NodePool::GetThreadCachedCount());
+
+            // freed on another thread it goes to that thread's cache and then the shared list when it exits
+            size_t shared = NodePool::GetSharedCachedCount();
+            std::thread worker([&task]()
+                               {
+                task.reset();
+                EXPECT_EQ(1, NodePool::GetThreadCachedCount()); });
+            worker.join();
+            EXPECT_EQ(shared + 1, NodePool::GetSharedCachedCount());
+        }
+
+        TEST(ThreadPoolTasksTest, OverflowsToSharedList)
+        {
+            using NodePool = CallableTaskNodePool;
+            std::thread worker([]()
+                               {
+                std::vector<ThreadPoolTaskUniquePtr> tasks;
+                for (size_t x = 0; x < NodePool::kMaxThreadCachedNodes + 1; x++)
+                {
+                    tasks.push_back(std::make_unique<CallableThreadTask>([]() {}));
+                }
+                size_t shared = NodePool::GetSharedCachedCount();
+                tasks.clear();
+                // going over the max hands a batch to the shared list
+                EXPECT_EQ(NodePool::kMaxThreadCachedNodes + 1 - NodePool::kTransferBatchSize, NodePool::GetThreadCachedCount());
+                EXPECT_EQ(shared + NodePool::kTransferBatchSize, NodePool::GetSharedCachedCount()); });
+            worker.join();
+        }
+    } // namespace Threads
+} // namespace v8App
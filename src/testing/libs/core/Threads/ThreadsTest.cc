@@ -15,6 +15,7 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 #include "Threads/Threads.h"
+#include "Threads/CpuTopology.h"
 
 namespace v8App
 {
@@ -24,6 +25,7 @@ namespace v8App
         {
         public:
             TestThread(std::string inName, ThreadPriority inPriority) : Thread(inName, inPriority) {}
+            std::thread::native_handle_type GetNativeHandle() { return m_Thread->native_handle(); }
 
         protected:
             virtual void RunImpl() override
@@ -47,6 +49,8 @@ namespace v8App
             thread = std::make_unique<TestThread>("test", ThreadPriority::kUserBlocking);
 #elif defined(V8APP_MACOS) || defined(V8APP_IOS)
             thread = std::make_unique<TestThread>("test", ThreadPriority::kBestEffort);
+#elif defined(V8APP_LINUX)
+            thread = std::make_unique<TestThread>("test", ThreadPriority::kBestEffort);
 #endif
             EXPECT_EQ(-1, thread->GetNativePriority());
             thread->Start();
@@ -59,6 +63,9 @@ namespace v8App
 #elif defined(V8APP_MACOS) || defined(V8APP_IOS)
             EXPECT_EQ(ThreadPriority::kBestEffort, thread->GetPriortiy());
             EXPECT_EQ(QOS_CLASS_BACKGROUND, thread->GetNativePriority());
+#elif defined(V8APP_LINUX)
+            EXPECT_EQ(ThreadPriority::kBestEffort, thread->GetPriortiy());
+            EXPECT_EQ(kLinuxBestEffortNice, thread->GetNativePriority());
 #endif
             thread->Join();
 
@@ -69,5 +76,79 @@ namespace v8App
             EXPECT_EQ("", thread->GetNativeName());
             EXPECT_EQ(-1, thread->GetNativePriority());
         }
+
+#if defined(V8APP_LINUX)
+        TEST(ThreadsTest, LinuxNameTruncated)
+        {
+            std::unique_ptr<TestThread> thread = std::make_unique<TestThread>("ThisIsALongThreadName", ThreadPriority::kDefault);
+            thread->Start();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            EXPECT_EQ("ThisIsALongThre", thread->GetNativeName());
+            EXPECT_EQ("ThisIsALongThreadName", thread->GetName());
+            thread->Join();
+        }
+
+        class SpawningThread : public Thread
+        {
+        public:
+            SpawningThread() : Thread("spawner", ThreadPriority::kBestEffort) {}
+
+            int m_ChildPolicy = -1;
+
+        protected:
+            virtual void RunImpl() override
+            {
+                // the child starts out with our SCHED_BATCH policy
+                std::unique_ptr<TestThread> child = std::make_unique<TestThread>("child", ThreadPriority::kUserVisible);
+                child->Start();
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                sched_param param{};
+                pthread_getschedparam(child->GetNativeHandle(), &m_ChildPolicy, &param);
+                child->Join();
+            }
+        };
+
+        TEST(ThreadsTest, LinuxPriorityResetsInheritedPolicy)
+        {
+            SpawningThread thread;
+            thread.Start();
+            thread.Join();
+            EXPECT_EQ(SCHED_OTHER, thread.m_ChildPolicy);
+        }
+#endif
+
+        TEST(ThreadsTest, Affinity)
+        {
+            const CpuTopology &topology = GetCpuTopology();
+            int cpu = topology.m_LogicalCpus.front();
+
+            std::unique_ptr<TestThread> thread = std::make_unique<TestThread>("affinity", ThreadPriority::kDefault);
+            EXPECT_TRUE(thread->GetNativeAffinity().empty());
+#if defined(V8APP_LINUX)
+            // set before it starts gets applied when it runs
+            EXPECT_TRUE(thread->SetAffinity({cpu}));
+            EXPECT_THAT(thread->GetAffinity(), ::testing::ElementsAre(cpu));
+            thread->Start();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            EXPECT_THAT(thread->GetNativeAffinity(), ::testing::ElementsAre(cpu));
+
+            // clearing it lets it run anywhere again
+            EXPECT_TRUE(thread->SetAffinity({}));
+            EXPECT_EQ(topology.m_LogicalCpus, thread->GetNativeAffinity());
+
+            EXPECT_FALSE(thread->SetAffinity({-1}));
+#else
+            EXPECT_FALSE(thread->SetAffinity({cpu}));
+            EXPECT_TRUE(thread->SetAffinity({}));
+            thread->Start();
+#endif
+            thread->Join();
+        }
+
+        TEST(ThreadsTest, GetHardwareCores)
+        {
+            int cores = GetCpuTopology().GetNumberOfLogicalCores();
+            EXPECT_EQ(std::max(1, cores - 1), GetHardwareCores());
+        }
     }
 }
\ No newline at end of file
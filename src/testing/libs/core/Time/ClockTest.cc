@@ -0,0 +1,141 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "Time/Time.h"
+#include "TestTime.h"
+
+namespace v8App
+{
+    namespace Time
+    {
+        class TestClock : public IClock
+        {
+        public:
+            virtual int64_t NowNanoseconds() override { return m_Now; }
+            int64_t m_Now = 0;
+        };
+
+        TEST(ClockTest, SteadyClockIsMonotonic)
+        {
+            SetClock(nullptr);
+            EXPECT_EQ(nullptr, GetClock());
+
+            int64_t last = NowNanoseconds();
+            for (int x = 0; x < 1000; x++)
+            {
+                int64_t now = NowNanoseconds();
+                EXPECT_LE(last, now);
+                last = now;
+            }
+
+            // sub second resolution
+            TestTime::TestTimeSeconds::Clear();
+            double start = MonotonicallyIncreasingTimeSeconds();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            double elapsed = MonotonicallyIncreasingTimeSeconds() - start;
+            EXPECT_GE(elapsed, 0.005);
+            EXPECT_LT(elapsed, 1.0);
+        }
+
+        TEST(ClockTest, SetClock)
+        {
+            TestClock clock;
+            clock.m_Now = 1500000000;
+            SetClock(&clock);
+            EXPECT_EQ(&clock, GetClock());
+
+            TestTime::TestTimeSeconds::Clear();
+            TestTime::TestTimeMilliSeconds::Clear();
+            EXPECT_EQ(1500000000, NowNanoseconds());
+            EXPECT_DOUBLE_EQ(1.5, MonotonicallyIncreasingTimeSeconds());
+            EXPECT_DOUBLE_EQ(1500.0, MonotonicallyIncreasingTimeMilliSeconds());
+
+            // the test time hooks still win over the clock
+            TestTime::TestTimeSeconds::Enable();
+            TestTime::TestTimeSeconds::Set(7);
+            EXPECT_DOUBLE_EQ(7, MonotonicallyIncreasingTimeSeconds());
+            TestTime::TestTimeSeconds::Clear();
+
+            SetClock(nullptr);
+            EXPECT_EQ(nullptr, GetClock());
+        }
+
+        TEST(ClockTest, CachedNow)
+        {
+            TestClock clock;
+            clock.m_Now = 1000;
+            SetClock(&clock);
+
+            EXPECT_EQ(1000, RefreshCachedNowNanoseconds());
+            clock.m_Now = 2000;
+            EXPECT_EQ(1000, CachedNowNanoseconds());
+            EXPECT_EQ(2000, RefreshCachedNowNanoseconds());
+            EXPECT_EQ(2000, CachedNowNanoseconds());
+
+            // the cache is per thread
+            int64_t threadNow = 0;
+            clock.m_Now = 3000;
+            std::thread thread([&threadNow]()
+                               { threadNow = CachedNowNanoseconds(); });
+            thread.join();
+            EXPECT_EQ(3000, threadNow);
+            EXPECT_EQ(2000, CachedNowNanoseconds());
+
+            TestTime::TestTimeSeconds::Clear();
+            clock.m_Now = 4000000000;
+            EXPECT_DOUBLE_EQ(4.0, RefreshCachedTimeSeconds());
+            clock.m_Now = 5000000000;
+            EXPECT_DOUBLE_EQ(4.0, CachedTimeSeconds());
+
+            SetClock(nullptr);
+        }
+
+        TEST(ClockTest, ClockChangedCallback)
+        {
+            int calls = 0;
+            EXPECT_EQ(kInvalidClockChangedCallbackId, AddClockChangedCallback(nullptr));
+            {
+                ScopedClockChangedCallback callback([&calls]()
+                                                    { calls++; });
+                TestClock clock;
+                SetClock(&clock);
+                EXPECT_EQ(1, calls);
+                SetClock(nullptr);
+                EXPECT_EQ(2, calls);
+
+                // moving the test time is a jump too
+                TestTime::TestTimeSeconds::Enable();
+                TestTime::TestTimeSeconds::Set(10);
+                TestTime::TestTimeSeconds::Clear();
+                EXPECT_EQ(5, calls);
+            }
+            NotifyClockChanged();
+            EXPECT_EQ(5, calls);
+
+            ClockChangedCallbackId id = AddClockChangedCallback([&calls]()
+                                                                { calls++; });
+            NotifyClockChanged();
+            EXPECT_EQ(6, calls);
+            EXPECT_TRUE(RemoveClockChangedCallback(id));
+            EXPECT_FALSE(RemoveClockChangedCallback(id));
+        }
+
+        TEST(ClockTest, WallClock)
+        {
+            TestTime::TestTimeMilliSeconds::Clear();
+            double wallClock = CurrentWallClockTimeMilliSeconds();
+            double systemClock = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            EXPECT_NEAR(systemClock, wallClock, 1000);
+
+            TestTime::TestTimeMilliSeconds::Enable();
+            TestTime::TestTimeMilliSeconds::Set(42);
+            EXPECT_DOUBLE_EQ(42, CurrentWallClockTimeMilliSeconds());
+            TestTime::TestTimeMilliSeconds::Clear();
+        }
+    } // namespace Time
+} // namespace v8App
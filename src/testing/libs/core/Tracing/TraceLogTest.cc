@@ -0,0 +1,231 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "Tracing/TraceLog.h"
+#include "Tracing/TraceMacros.h"
+
+namespace v8App
+{
+    namespace Tracing
+    {
+        namespace
+        {
+            // the events recorded on the calling thread
+            std::vector<TraceEvent> GetThreadEvents()
+            {
+                uint32_t threadId = TraceLog::GetCurrentThreadId();
+                for (TraceThreadEvents &thread : TraceLog::GetEvents())
+                {
+                    if (thread.m_ThreadId == threadId)
+                    {
+                        return thread.m_Events;
+                    }
+                }
+                return {};
+            }
+        } // namespace
+
+        TEST(TraceLogTest, CategoryGroups)
+        {
+            TraceLog::StopTracing();
+            const uint8_t *flag = TraceLog::GetCategoryGroupEnabled("traceLogTest.cat1");
+            EXPECT_EQ(flag, TraceLog::GetCategoryGroupEnabled("traceLogTest.cat1"));
+            EXPECT_STREQ("traceLogTest.cat1", TraceLog::GetCategoryGroupName(flag));
+            EXPECT_EQ(0, *flag);
+
+            TraceLog::StartTracing();
+            EXPECT_TRUE(TraceLog::IsTracing());
+            EXPECT_EQ(kCategoryEnabledForRecording, *flag);
+            EXPECT_FALSE(TraceLog::IsCategoryGroupEnabled("disabled-by-default-traceLogTest"));
+            EXPECT_TRUE(TraceLog::IsCategoryGroupEnabled("traceLogTest.cat2,disabled-by-default-traceLogTest"));
+
+            // runtime changes update the flags already handed out
+            TraceLog::DisableCategory("traceLogTest.cat1");
+            EXPECT_EQ(0, *flag);
+            TraceLog::EnableCategory("traceLogTest.cat1");
+            EXPECT_EQ(kCategoryEnabledForRecording, *flag);
+
+            TraceLog::StartTracing({"traceLogTest.p*", "-traceLogTest.pExcluded", "disabled-by-default-traceLogTest"});
+            EXPECT_EQ(0, *flag);
+            EXPECT_TRUE(TraceLog::IsCategoryGroupEnabled("traceLogTest.prefix"));
+            EXPECT_FALSE(TraceLog::IsCategoryGroupEnabled("traceLogTest.pExcluded"));
+            EXPECT_TRUE(TraceLog::IsCategoryGroupEnabled("disabled-by-default-traceLogTest"));
+
+            TraceLog::StopTracing();
+            EXPECT_FALSE(TraceLog::IsTracing());
+            EXPECT_FALSE(TraceLog::IsCategoryGroupEnabled("traceLogTest.prefix"));
+        }
+
+        TEST(TraceLogTest, AddTraceEvent)
+        {
+            TraceLog::StopTracing();
+            TraceLog::Clear();
+            const uint8_t *flag = TraceLog::GetCategoryGroupEnabled("traceLogTest");
+            EXPECT_EQ(0, TraceLog::AddTraceEvent(kPhaseInstant, flag, "notRecording", nullptr, 0, 0, 1));
+
+            TraceLog::StartTracing({"traceLogTest"});
+            std::string copied = "copied";
+            TraceArg args[2];
+            args[0].m_Name = "int";
+            args[0].m_Type = TraceArgType::kInt;
+            args[0].m_Value = static_cast<uint64_t>(-5);
+            args[1].m_Name = "string";
+            args[1].m_Type = TraceArgType::kString;
+            args[1].m_String = "value";
+            uint64_t handle = TraceLog::AddTraceEvent(kPhaseComplete, flag, copied.c_str(), nullptr, 0, kTraceFlagCopy, 100, 2, args);
+            EXPECT_NE(0, handle);
+            copied = "changed";
+            TraceLog::UpdateTraceEventDuration(handle, 150);
+            TraceLog::AddTraceEvent(kPhaseInstant, flag, "instant", nullptr, 0, 0, 200);
+
+            std::vector<TraceEvent> events = GetThreadEvents();
+            ASSERT_EQ(2, events.size());
+            EXPECT_EQ(kPhaseComplete, events[0].m_Phase);
+            EXPECT_STREQ("copied", events[0].GetName());
+            EXPECT_STREQ("traceLogTest", TraceLog::GetCategoryGroupName(events[0].m_CategoryIndex));
+            EXPECT_EQ(100, events[0].m_Timestamp);
+            EXPECT_EQ(50, events[0].m_Duration);
+            ASSERT_EQ(2, events[0].m_NumArgs);
+            EXPECT_STREQ("int", events[0].m_Args[0].GetName());
+            EXPECT_EQ(-5, static_cast<int64_t>(events[0].m_Args[0].m_Value));
+            EXPECT_EQ("value", events[0].m_Args[1].m_String);
+            EXPECT_STREQ("instant", events[1].GetName());
+            EXPECT_EQ(-1, events[1].m_Duration);
+
+            // getting the events doesn't stop the recording
+            EXPECT_TRUE(TraceLog::IsTracing());
+            TraceLog::StopTracing();
+            TraceLog::Clear();
+            EXPECT_TRUE(GetThreadEvents().empty());
+        }
+
+        TEST(TraceLogTest, RingBufferOverwrites)
+        {
+            TraceLog::StopTracing();
+            TraceLog::Clear();
+            size_t bufferSize = TraceLog::GetBufferSize();
+            TraceLog::SetBufferSize(4);
+
+            // the new size only applies to threads that haven't recorded yet
+            std::vector<TraceEvent> events;
+            uint64_t firstHandle = 0;
+            TraceLog::StartTracing({"traceLogTest"});
+            std::thread thread([&events, &firstHandle]()
+                               {
+                                   const uint8_t *flag = TraceLog::GetCategoryGroupEnabled("traceLogTest");
+                                   firstHandle = TraceLog::AddTraceEvent(kPhaseComplete, flag, "first", nullptr, 0, 0, 0);
+                                   for (int idx = 1; idx < 10; idx++)
+                                   {
+                                       TraceLog::AddTraceEvent(kPhaseInstant, flag, "event", nullptr, 0, 0, idx);
+                                   }
+                                   // overwritten so the duration goes nowhere
+                                   TraceLog::UpdateTraceEventDuration(firstHandle, 100);
+                                   events = GetThreadEvents(); });
+            thread.join();
+            TraceLog::SetBufferSize(bufferSize);
+
+            ASSERT_EQ(4, events.size());
+            EXPECT_EQ(6, events[0].m_Timestamp);
+            EXPECT_EQ(9, events[3].m_Timestamp);
+
+            // the buffer of a thread that exited is still there till it's cleared
+            EXPECT_EQ(1, TraceLog::GetEvents().size());
+            TraceLog::Clear();
+            EXPECT_TRUE(TraceLog::GetEvents().empty());
+            TraceLog::StopTracing();
+        }
+
+        TEST(TraceLogTest, DurationAfterPause)
+        {
+            TraceLog::StopTracing();
+            TraceLog::Clear();
+            const uint8_t *flag = TraceLog::GetCategoryGroupEnabled("traceLogTest");
+            TraceLog::StartTracing({"traceLogTest"});
+            uint64_t handle = TraceLog::AddTraceEvent(kPhaseComplete, flag, "spansPause", nullptr, 0, 0, 100);
+            uint64_t stoppedHandle = TraceLog::AddTraceEvent(kPhaseComplete, flag, "endsStopped", nullptr, 0, 0, 120);
+
+            // the events are copied while the first is still open
+            std::vector<TraceEvent> events = GetThreadEvents();
+            ASSERT_EQ(2, events.size());
+            EXPECT_EQ(-1, events[0].m_Duration);
+            TraceLog::UpdateTraceEventDuration(handle, 150);
+            TraceLog::StopTracing();
+            TraceLog::UpdateTraceEventDuration(stoppedHandle, 200);
+
+            events = GetThreadEvents();
+            ASSERT_EQ(2, events.size());
+            EXPECT_EQ(50, events[0].m_Duration);
+            EXPECT_EQ(80, events[1].m_Duration);
+
+            // the handle of a cleared event doesn't land on the next one
+            TraceLog::Clear();
+            TraceLog::StartTracing({"traceLogTest"});
+            TraceLog::AddTraceEvent(kPhaseComplete, flag, "afterClear", nullptr, 0, 0, 300);
+            TraceLog::UpdateTraceEventDuration(handle, 400);
+            events = GetThreadEvents();
+            ASSERT_EQ(1, events.size());
+            EXPECT_STREQ("afterClear", events[0].GetName());
+            EXPECT_EQ(-1, events[0].m_Duration);
+            TraceLog::StopTracing();
+            TraceLog::Clear();
+        }
+
+        TEST(TraceLogTest, StateListeners)
+        {
+            TraceLog::StopTracing();
+            std::vector<bool> states;
+            TraceStateListenerId id = TraceLog::AddStateListener([&states](bool inTracing)
+                                                                 { states.push_back(inTracing); });
+            TraceLog::StartTracing();
+            TraceLog::StopTracing();
+            // already stopped
+            TraceLog::StopTracing();
+            TraceLog::RemoveStateListener(id);
+            TraceLog::StartTracing();
+            TraceLog::StopTracing();
+
+            ASSERT_EQ(2, states.size());
+            EXPECT_TRUE(states[0]);
+            EXPECT_FALSE(states[1]);
+        }
+
+        TEST(TraceLogTest, TraceScope)
+        {
+            TraceLog::StopTracing();
+            TraceLog::Clear();
+            {
+                TRACE_SCOPE("traceLogTest.macros", "notTracing");
+            }
+            TraceLog::StartTracing({"traceLogTest.macros"});
+            {
+                TRACE_SCOPE("traceLogTest.macros", "outer");
+                {
+                    TRACE_SCOPE("traceLogTest.macros", "inner");
+                    TRACE_INSTANT("traceLogTest.macros", "instant");
+                }
+                TRACE_SCOPE("traceLogTest.disabled", "disabled");
+            }
+            TraceLog::StopTracing();
+
+            std::vector<TraceEvent> events = GetThreadEvents();
+            ASSERT_EQ(3, events.size());
+            EXPECT_STREQ("outer", events[0].GetName());
+            EXPECT_STREQ("inner", events[1].GetName());
+            EXPECT_STREQ("instant", events[2].GetName());
+            EXPECT_EQ(kPhaseInstant, events[2].m_Phase);
+            EXPECT_GE(events[0].m_Duration, 0);
+            EXPECT_GE(events[1].m_Duration, 0);
+            EXPECT_LE(events[0].m_Timestamp, events[1].m_Timestamp);
+            EXPECT_GE(events[0].m_Timestamp + events[0].m_Duration, events[1].m_Timestamp + events[1].m_Duration);
+            TraceLog::Clear();
+        }
+    } // namespace Tracing
+} // namespace v8App
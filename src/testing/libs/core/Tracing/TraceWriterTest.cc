@@ -0,0 +1,201 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <bit>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "Tracing/TraceWriter.h"
+
+namespace v8App
+{
+    namespace Tracing
+    {
+        namespace
+        {
+            TraceEvent MakeEvent(char inPhase, const char *inName, int64_t inTimestamp, int64_t inDuration = -1)
+            {
+                TraceEvent event;
+                event.m_Phase = inPhase;
+                event.m_CategoryIndex = TraceLog::GetCategoryGroupIndex(TraceLog::GetCategoryGroupEnabled("traceWriterTest"));
+                event.m_Name = inName;
+                event.m_Timestamp = inTimestamp;
+                event.m_Duration = inDuration;
+                return event;
+            }
+
+            uint64_t ReadVarint(const std::string &inBuffer, size_t &inOffset)
+            {
+                uint64_t value = 0;
+                int shift = 0;
+                while (inOffset < inBuffer.size())
+                {
+                    uint8_t byte = static_cast<uint8_t>(inBuffer[inOffset++]);
+                    value |= uint64_t(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0)
+                    {
+                        break;
+                    }
+                    shift += 7;
+                }
+                return value;
+            }
+
+            struct ProtoField
+            {
+                uint32_t m_Field;
+                uint64_t m_Value;
+                std::string m_Bytes;
+            };
+
+            // splits a message into it's top level fields
+            std::vector<ProtoField> ParseMessage(const std::string &inBuffer)
+            {
+                std::vector<ProtoField> fields;
+                size_t offset = 0;
+                while (offset < inBuffer.size())
+                {
+                    uint64_t tag = ReadVarint(inBuffer, offset);
+                    ProtoField field{static_cast<uint32_t>(tag >> 3), 0, {}};
+                    switch (tag & 0x7)
+                    {
+                    case 0:
+                        field.m_Value = ReadVarint(inBuffer, offset);
+                        break;
+                    case 1:
+                        field.m_Bytes = inBuffer.substr(offset, 8);
+                        offset += 8;
+                        break;
+                    case 2:
+                    {
+                        size_t length = ReadVarint(inBuffer, offset);
+                        field.m_Bytes = inBuffer.substr(offset, length);
+                        offset += length;
+                        break;
+                    }
+                    default:
+                        ADD_FAILURE() << "unexpected wire type";
+                        return fields;
+                    }
+                    fields.push_back(field);
+                }
+                return fields;
+            }
+
+            const ProtoField *FindField(const std::vector<ProtoField> &inFields, uint32_t inField)
+            {
+                for (const ProtoField &field : inFields)
+                {
+                    if (field.m_Field == inField)
+                    {
+                        return &field;
+                    }
+                }
+                return nullptr;
+            }
+        } // namespace
+
+        TEST(TraceWriterTest, WriteChromeJSON)
+        {
+            std::vector<TraceThreadEvents> threads(1);
+            threads[0].m_ThreadId = 42;
+            threads[0].m_ThreadName = "worker\"1";
+            TraceEvent complete = MakeEvent(kPhaseComplete, "complete", 1234567, 2500);
+            complete.m_NumArgs = 2;
+            complete.m_Args[0].m_Name = "double";
+            complete.m_Args[0].m_Type = TraceArgType::kDouble;
+            complete.m_Args[0].m_Value = std::bit_cast<uint64_t>(1.5);
+            complete.m_Args[1].m_Name = "json";
+            complete.m_Args[1].m_Type = TraceArgType::kJSON;
+            complete.m_Args[1].m_String = "{\"a\":1}";
+            threads[0].m_Events.push_back(complete);
+            threads[0].m_Events.push_back(MakeEvent(kPhaseInstant, "in\nstant", 2000000));
+
+            std::stringstream stream;
+            EXPECT_TRUE(TraceWriter::WriteChromeJSON(stream, threads));
+            std::string json = stream.str();
+            std::string pid = std::to_string(TraceLog::GetProcessId());
+
+            EXPECT_THAT(json, ::testing::StartsWith("{\"traceEvents\":["));
+            EXPECT_THAT(json, ::testing::HasSubstr("{\"pid\":" + pid + ",\"tid\":42,\"ts\":0,\"ph\":\"M\",\"cat\":\"__metadata\",\"name\":\"thread_name\",\"args\":{\"name\":\"worker\\\"1\"}}"));
+            EXPECT_THAT(json, ::testing::HasSubstr("{\"pid\":" + pid + ",\"tid\":42,\"ts\":1234.567,\"ph\":\"X\",\"cat\":\"traceWriterTest\",\"name\":\"complete\",\"dur\":2.500,\"args\":{\"double\":1.5,\"json\":{\"a\":1}}}"));
+            EXPECT_THAT(json, ::testing::HasSubstr("\"ts\":2000.000,\"ph\":\"I\",\"cat\":\"traceWriterTest\",\"name\":\"in\\nstant\",\"s\":\"t\",\"args\":{}}"));
+            EXPECT_THAT(json, ::testing::EndsWith("],\"displayTimeUnit\":\"ns\"}"));
+        }
+
+        TEST(TraceWriterTest, WritePerfetto)
+        {
+            std::vector<TraceThreadEvents> threads(1);
+            threads[0].m_ThreadId = 7;
+            threads[0].m_ThreadName = "main";
+            // outer covers inner which ends when outer does
+            threads[0].m_Events.push_back(MakeEvent(kPhaseComplete, "outer", 100, 50));
+            TraceEvent inner = MakeEvent(kPhaseComplete, "inner", 100, 50);
+            inner.m_NumArgs = 1;
+            inner.m_Args[0].m_Name = "count";
+            inner.m_Args[0].m_Type = TraceArgType::kUInt;
+            inner.m_Args[0].m_Value = 3;
+            threads[0].m_Events.push_back(inner);
+            threads[0].m_Events.push_back(MakeEvent(kPhaseInstant, "instant", 150));
+            // counters have no track event form
+            threads[0].m_Events.push_back(MakeEvent(kPhaseCounter, "counter", 160));
+
+            std::stringstream stream;
+            EXPECT_TRUE(TraceWriter::WritePerfetto(stream, threads));
+
+            std::vector<ProtoField> packets = ParseMessage(stream.str());
+            // process and thread descriptors then 2 begins, 2 ends and the instant
+            ASSERT_EQ(7, packets.size());
+            for (const ProtoField &packet : packets)
+            {
+                EXPECT_EQ(1, packet.m_Field);
+            }
+
+            std::vector<ProtoField> process = ParseMessage(FindField(ParseMessage(packets[0].m_Bytes), 60)->m_Bytes);
+            uint64_t processUuid = FindField(process, 1)->m_Value;
+            ASSERT_NE(nullptr, FindField(process, 3));
+            EXPECT_EQ(TraceLog::GetProcessId(), FindField(ParseMessage(FindField(process, 3)->m_Bytes), 1)->m_Value);
+
+            std::vector<ProtoField> track = ParseMessage(FindField(ParseMessage(packets[1].m_Bytes), 60)->m_Bytes);
+            uint64_t threadUuid = FindField(track, 1)->m_Value;
+            EXPECT_EQ(processUuid, FindField(track, 5)->m_Value);
+            std::vector<ProtoField> thread = ParseMessage(FindField(track, 4)->m_Bytes);
+            EXPECT_EQ(7, FindField(thread, 2)->m_Value);
+            EXPECT_EQ("main", FindField(thread, 5)->m_Bytes);
+
+            struct Expected
+            {
+                uint64_t m_Timestamp;
+                uint64_t m_Type;
+                const char *m_Name;
+            };
+            std::vector<Expected> expected = {{100, 1, "outer"}, {100, 1, "inner"}, {150, 2, nullptr}, {150, 2, nullptr}, {150, 3, "instant"}};
+            for (size_t idx = 0; idx < expected.size(); idx++)
+            {
+                std::vector<ProtoField> packet = ParseMessage(packets[idx + 2].m_Bytes);
+                EXPECT_EQ(expected[idx].m_Timestamp, FindField(packet, 8)->m_Value);
+                EXPECT_EQ(3, FindField(packet, 58)->m_Value);
+                std::vector<ProtoField> event = ParseMessage(FindField(packet, 11)->m_Bytes);
+                EXPECT_EQ(expected[idx].m_Type, FindField(event, 9)->m_Value);
+                EXPECT_EQ(threadUuid, FindField(event, 11)->m_Value);
+                if (expected[idx].m_Name == nullptr)
+                {
+                    EXPECT_EQ(nullptr, FindField(event, 23));
+                    continue;
+                }
+                EXPECT_EQ(expected[idx].m_Name, FindField(event, 23)->m_Bytes);
+                EXPECT_EQ("traceWriterTest", FindField(event, 22)->m_Bytes);
+            }
+
+            std::vector<ProtoField> event = ParseMessage(FindField(ParseMessage(packets[3].m_Bytes), 11)->m_Bytes);
+            std::vector<ProtoField> annotation = ParseMessage(FindField(event, 4)->m_Bytes);
+            EXPECT_EQ("count", FindField(annotation, 10)->m_Bytes);
+            EXPECT_EQ(3, FindField(annotation, 3)->m_Value);
+        }
+    } // namespace Tracing
+} // namespace v8App
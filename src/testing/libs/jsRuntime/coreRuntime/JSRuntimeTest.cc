@@ -15,12 +15,14 @@
 #include "TestSnapshotProvider.h"
 #include "TestFiles.h"
 
+#include "Memory/MemoryPressure.h"
 #include "Utils/Environment.h"
 #include "Utils/Format.h"
 
 #include "JSApp.h"
 #include "JSRuntime.h"
 #include "V8AppPlatform.h"
+#include "UVRunLoop.h"
 
 namespace v8App
 {
@@ -221,6 +223,227 @@ namespace v8App
             EXPECT_EQ(40, idleTaskInt2);
         }
 
+        TEST_F(JSRuntimeTest, DrainTasks)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            int taskInts[5] = {0, 0, 0, 0, 0};
+            int nonNestableInt = 0;
+
+            std::string runtimeName = "testJSRuntimeDrainTasks";
+            JSRuntimeSharedPtr runtime = std::make_shared<JSRuntime>();
+            ASSERT_TRUE(runtime->Initialize(m_App, runtimeName));
+
+            TaskDrainStats stats = runtime->DrainTasks();
+            EXPECT_EQ(0, stats.m_TasksRun);
+            EXPECT_FALSE(stats.m_HitLimit);
+
+            V8TaskRunnerSharedPtr runner = runtime->GetForegroundTaskRunner();
+            for (int x = 0; x < 5; x++)
+            {
+                runner->PostTask(std::make_unique<IntTask>(&taskInts[x], x + 1));
+            }
+
+            // stops at the task count with tasks left
+            stats = runtime->DrainTasks(10, 3);
+            EXPECT_EQ(3, stats.m_TasksRun);
+            EXPECT_TRUE(stats.m_HitLimit);
+            EXPECT_GE(stats.m_Seconds, 0);
+            EXPECT_EQ(3, taskInts[2]);
+            EXPECT_EQ(0, taskInts[3]);
+
+            stats = runtime->DrainTasks(10, 10);
+            EXPECT_EQ(2, stats.m_TasksRun);
+            EXPECT_FALSE(stats.m_HitLimit);
+            EXPECT_EQ(5, taskInts[4]);
+
+            // non nestable tasks are skipped when draining from inside a task
+            runner->PostNonNestableTask(std::make_unique<IntTask>(&nonNestableInt, 10));
+            {
+                ForegroundTaskRunner::TaskRunScope scope(std::static_pointer_cast<ForegroundTaskRunner>(runner));
+                stats = runtime->DrainTasks();
+                EXPECT_EQ(0, stats.m_TasksRun);
+                EXPECT_EQ(0, nonNestableInt);
+            }
+            stats = runtime->DrainTasks();
+            EXPECT_EQ(1, stats.m_TasksRun);
+            EXPECT_EQ(10, nonNestableInt);
+
+            runtime->DisposeRuntime();
+            runtime.reset();
+        }
+
+        TEST_F(JSRuntimeTest, RunLoop)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            int taskInt = 0;
+            int delayedInt = 0;
+            int idleInt = 0;
+
+            std::string runtimeName = "testJSRuntimeRunLoop";
+            JSRuntimeSharedPtr runtime = std::make_shared<JSRuntime>();
+            ASSERT_TRUE(runtime->Initialize(m_App, runtimeName));
+            V8TaskRunnerSharedPtr runner = runtime->GetForegroundTaskRunner();
+
+            runner->PostTask(std::make_unique<IntTask>(&taskInt, 10));
+            runner->PostDelayedTask(std::make_unique<IntTask>(&delayedInt, 20), 0.1);
+            runner->PostIdleTask(std::make_unique<IntIdleTask>(&idleInt, 30, 0));
+
+            // posted from another thread once the loop is asleep
+            std::thread poster([runtime]()
+                               {
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                runtime->QuitRunLoop(); });
+            runtime->RunLoop();
+            poster.join();
+
+            EXPECT_EQ(10, taskInt);
+            EXPECT_EQ(20, delayedInt);
+            EXPECT_EQ(30, idleInt);
+
+            // a quit before the loop starts makes it return straight away
+            runtime->QuitRunLoop();
+            runtime->RunLoop();
+
+            runtime->DisposeRuntime();
+            runtime.reset();
+        }
+
+        TEST_F(JSRuntimeTest, UVRunLoop)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            int taskInt = 0;
+            int delayedInt = 0;
+            int idleInt = 0;
+            int timerInt = 0;
+
+            std::string runtimeName = "testJSRuntimeUVRunLoop";
+            JSRuntimeSharedPtr runtime = std::make_shared<JSRuntime>();
+            ASSERT_TRUE(runtime->Initialize(m_App, runtimeName));
+            V8TaskRunnerSharedPtr runner = runtime->GetForegroundTaskRunner();
+
+            UVRunLoop *uvLoop = runtime->GetUVRunLoop();
+            ASSERT_NE(nullptr, uvLoop);
+            EXPECT_EQ(uvLoop, runtime->GetUVRunLoop());
+
+            // a native module's timer on the same loop
+            uv_timer_t timer;
+            uv_timer_init(uvLoop->GetLoop(), &timer);
+            timer.data = &timerInt;
+            uv_timer_start(&timer, [](uv_timer_t *inHandle)
+                           { *static_cast<int *>(inHandle->data) = 40; }, 50, 0);
+
+            runner->PostTask(std::make_unique<IntTask>(&taskInt, 10));
+            runner->PostDelayedTask(std::make_unique<IntTask>(&delayedInt, 20), 0.1);
+            runner->PostIdleTask(std::make_unique<IntIdleTask>(&idleInt, 30, 0));
+
+            // posted from another thread while the loop is blocked in the poll
+            std::thread poster([runner, runtime, &taskInt]()
+                               {
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                runner->PostTask(std::make_unique<IntTask>(&taskInt, 50));
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                runtime->QuitRunLoop(); });
+            runtime->RunLoop();
+            poster.join();
+
+            EXPECT_EQ(50, taskInt);
+            EXPECT_EQ(20, delayedInt);
+            EXPECT_EQ(30, idleInt);
+            EXPECT_EQ(40, timerInt);
+
+            uv_close(reinterpret_cast<uv_handle_t *>(&timer), nullptr);
+            uv_run(uvLoop->GetLoop(), UV_RUN_NOWAIT);
+
+            runtime->DisposeRuntime();
+            runtime.reset();
+        }
+
+        TEST_F(JSRuntimeTest, MoveKeepsUVRunLoop)
+        {
+            int taskInt = 0;
+            std::string runtimeName = "testJSRuntimeMoveKeepsUVRunLoop";
+            JSRuntimeSharedPtr runtime = std::make_shared<JSRuntime>();
+            ASSERT_TRUE(runtime->Initialize(m_App, runtimeName));
+            V8TaskRunnerSharedPtr runner = runtime->GetForegroundTaskRunner();
+            UVRunLoop *uvLoop = runtime->GetUVRunLoop();
+
+            // the moved from runtime going away mustn't take the loop's wake up with it
+            JSRuntimeSharedPtr moved = std::make_shared<JSRuntime>(std::move(*runtime));
+            runtime.reset();
+            EXPECT_EQ(uvLoop, moved->GetUVRunLoop());
+
+            std::thread poster([runner, moved, &taskInt]()
+                               {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                runner->PostTask(std::make_unique<IntTask>(&taskInt, 10));
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                moved->QuitRunLoop(); });
+            moved->RunLoop();
+            poster.join();
+            EXPECT_EQ(10, taskInt);
+
+            moved->DisposeRuntime();
+            moved.reset();
+        }
+
+        TEST_F(JSRuntimeTest, MemoryPressure)
+        {
+            size_t numCallbacks = Memory::MemoryPressure::GetNumberOfCallbacks();
+
+            std::string runtimeName = "testJSRuntimeMemoryPressure";
+            JSRuntimeSharedPtr runtime = std::make_shared<JSRuntime>();
+            ASSERT_TRUE(runtime->Initialize(m_App, runtimeName));
+            EXPECT_EQ(numCallbacks + 1, Memory::MemoryPressure::GetNumberOfCallbacks());
+            std::shared_ptr<ForegroundTaskRunner> runner = std::static_pointer_cast<ForegroundTaskRunner>(runtime->GetForegroundTaskRunner());
+
+            // moderate is only passed on to the isolate
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kModerate);
+            EXPECT_FALSE(runner->MaybeHasTask());
+
+            // critical also posts a full gc to the runtime's thread
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kCritical);
+            EXPECT_TRUE(runner->MaybeHasTask());
+            runtime->ProcessTasks();
+            EXPECT_FALSE(runner->MaybeHasTask());
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kNone);
+            EXPECT_FALSE(runner->MaybeHasTask());
+
+            runtime->DisposeRuntime();
+            EXPECT_EQ(numCallbacks, Memory::MemoryPressure::GetNumberOfCallbacks());
+            runtime.reset();
+        }
+
+        TEST_F(JSRuntimeTest, PageAccount)
+        {
+            std::string runtimeName = "testJSRuntimePageAccount";
+            JSRuntimeSharedPtr runtime = std::make_shared<JSRuntime>();
+            EXPECT_EQ(nullptr, runtime->GetPageAccount());
+            ASSERT_TRUE(runtime->Initialize(m_App, runtimeName));
+            V8AppPageAccountSharedPtr account = runtime->GetPageAccount();
+            ASSERT_NE(nullptr, account);
+            EXPECT_EQ(runtimeName, account->GetName());
+            EXPECT_GE(account->GetPeakReservedBytes(), account->GetReservedBytes());
+            // the heap's pages may come out of the pointer compression cage that was reserved before the
+            // runtime so they're charged to the runtime when they're committed
+            size_t committed = account->GetCommittedBytes();
+            EXPECT_GT(committed, 0);
+
+            {
+                V8AppPageAccountScope accountScope(account);
+                V8IsolateScope isolateScope(runtime->GetIsolate());
+                V8HandleScope scope(runtime->GetIsolate());
+                // big enough to go in it's own large object page
+                std::string big(4 * 1024 * 1024, 'a');
+                V8LString str = V8String::NewFromUtf8(runtime->GetIsolate(), big.data(), v8::NewStringType::kNormal, static_cast<int>(big.size())).ToLocalChecked();
+                EXPECT_FALSE(str.IsEmpty());
+                EXPECT_GE(account->GetCommittedBytes(), committed + big.size());
+            }
+            EXPECT_GE(account->GetPeakCommittedBytes(), committed + 4 * 1024 * 1024);
+
+            runtime->DisposeRuntime();
+            runtime.reset();
+        }
+
         TEST_F(JSRuntimeTest, SetGetClassFunctionTemplate)
         {
             std::string runtimeName = "testJSRuntimeSetGetClassFunctionTemplate";
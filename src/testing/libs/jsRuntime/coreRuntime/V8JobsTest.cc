@@ -2,6 +2,9 @@
 // Use of this source code is governed by a MIT license that can be
 // found in the LICENSE file.
 
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
@@ -65,15 +68,24 @@ namespace v8App
         class TestV8JobState : public V8JobState
         {
         public:
-            TestV8JobState(V8Platform *inPlatform, V8JobTaskUniquePtr inTask, V8TaskPriority inPriority, size_t inNumWorkers)
-                : V8JobState(inPlatform, std::move(inTask), inPriority, inNumWorkers) {}
+            TestV8JobState(V8Platform *inPlatform, V8JobTaskUniquePtr inTask, V8TaskPriority inPriority, size_t inNumWorkers,
+                           V8JobConcurrencyLimiterSharedPtr inLimiter = nullptr)
+                : V8JobState(inPlatform, std::move(inTask), inPriority, inNumWorkers, std::move(inLimiter)) {}
 
-            size_t TestComputeTaskToPost(size_t inMaxConcurrency) { return ComputeTaskToPost(inMaxConcurrency); }
-            size_t TestGetMaxConcurrency(size_t inWorkerCountr) { return GetMaxConcurrency(inWorkerCountr); }
-            const V8JobTaskIdType GetInvalidId() { return kInvalidJobId; }
+            size_t TestComputeTaskToPost(size_t inMaxConcurrency)
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                return ComputeTaskToPost(inMaxConcurrency);
+            }
+            size_t TestGetMaxConcurrency(size_t inWorkerCountr)
+            {
+                std::lock_guard<std::mutex> lock(m_Lock);
+                return GetMaxConcurrency(inWorkerCountr);
+            }
+            uint8_t GetInvalidId() { return kInvalidJobId; }
             void TestPostonWorkerThread(size_t inNumToPost, V8TaskPriority inPriority) { PostonWorkerThread(inNumToPost, inPriority); }
 
-            V8JobTaskIdType GetAssignedTasks() { return m_AssignedTaskIds.load(std::memory_order::relaxed); }
+            size_t GetAssignedTasks() { return m_AssignedTaskIds.GetAssignedCount(); }
             bool GetCancelled() { return m_Canceled.load(std::memory_order::relaxed); }
             V8TaskPriority GetPriority() { return m_Priority; }
             size_t GetActiveTasks() { return m_ActiveTasks; }
@@ -176,16 +188,12 @@ namespace v8App
             TestV8JobState state(platform.get(), std::move(task), V8TaskPriority::kBestEffort, 10);
 
             EXPECT_EQ(0, state.GetAssignedTasks());
-#ifdef PLATFORM_64
-            EXPECT_EQ(64, V8JobTaskBits);
-#else
-            EXPECT_EQ(32, V8JobTaskBits);
-#endif
-            uint8_t i = 0;
-            for (; i < V8JobTaskBits; i++)
+            EXPECT_EQ(255, kV8JobMaxTaskIds);
+            for (size_t i = 0; i < kV8JobMaxTaskIds; i++)
             {
                 EXPECT_EQ(i, state.AcquireTaskId());
             }
+            EXPECT_EQ(kV8JobMaxTaskIds, state.GetAssignedTasks());
             EXPECT_EQ(state.GetInvalidId(), state.AcquireTaskId());
             state.ReleaseTaskID(3);
             state.ReleaseTaskID(10);
@@ -193,6 +201,62 @@ namespace v8App
             EXPECT_EQ(10, state.AcquireTaskId());
         }
 
+        TEST(V8JobTaskIdSetTest, AcquireRelease)
+        {
+            V8JobTaskIdSet ids;
+            // crosses the word boundaries
+            for (size_t i = 0; i < 130; i++)
+            {
+                EXPECT_EQ(i, ids.Acquire());
+            }
+            EXPECT_TRUE(ids.IsAssigned(64));
+            EXPECT_TRUE(ids.Release(64));
+            EXPECT_FALSE(ids.Release(64));
+            EXPECT_FALSE(ids.IsAssigned(64));
+            EXPECT_TRUE(ids.Release(3));
+            EXPECT_EQ(129, ids.GetAssignedCount());
+            // lowest free id first
+            EXPECT_EQ(3, ids.Acquire());
+            EXPECT_EQ(64, ids.Acquire());
+            EXPECT_EQ(130, ids.Acquire());
+            EXPECT_FALSE(ids.Release(V8JobTaskIdSet::kInvalidTaskId));
+        }
+
+        TEST(V8JobTaskIdSetTest, ConcurrentAcquireRelease)
+        {
+            V8JobTaskIdSet ids;
+            std::atomic_int duplicates{0};
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 16; t++)
+            {
+                threads.emplace_back([&ids, &duplicates]()
+                                     {
+                    for (int x = 0; x < 10000; x++)
+                    {
+                        uint8_t held[8];
+                        for (uint8_t &id : held)
+                        {
+                            id = ids.Acquire();
+                            ASSERT_NE(V8JobTaskIdSet::kInvalidTaskId, id);
+                        }
+                        // a release that finds the bit clear means two threads held the same id
+                        for (uint8_t id : held)
+                        {
+                            if (ids.Release(id) == false)
+                            {
+                                duplicates++;
+                            }
+                        }
+                    } });
+            }
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+            EXPECT_EQ(0, duplicates);
+            EXPECT_EQ(0, ids.GetAssignedCount());
+        }
+
         TEST(V8JobsStateTest, ComputeTestToPost)
         {
             std::unique_ptr<V8AppPlatform> platform = std::make_unique<V8AppPlatform>();
@@ -492,6 +556,186 @@ namespace v8App
             state->CancelAndWait();
         }
 
+        TEST(V8JobConcurrencyLimiterTest, Policy)
+        {
+            V8JobConcurrencyLimiter limiter(8);
+            EXPECT_EQ(2, limiter.GetMaxWorkers(V8TaskPriority::kBestEffort));
+            EXPECT_EQ(8, limiter.GetMaxWorkers(V8TaskPriority::kUserVisible));
+            EXPECT_EQ(8, limiter.GetMaxWorkers(V8TaskPriority::kUserBlocking));
+            EXPECT_EQ(8, limiter.GetGlobalMaxWorkers());
+            EXPECT_TRUE(limiter.ReserveJoiningThread());
+
+            V8JobConcurrencyPolicy policy;
+            policy.m_MaxBestEffortWorkers = 0;
+            policy.m_MaxUserVisibleWorkers = 3;
+            policy.m_MaxUserBlockingWorkers = 6;
+            policy.m_ReserveJoiningThread = false;
+            policy.m_GlobalMaxWorkers = 4;
+            limiter.SetPolicy(policy);
+            // always at least one worker
+            EXPECT_EQ(1, limiter.GetMaxWorkers(V8TaskPriority::kBestEffort));
+            EXPECT_EQ(3, limiter.GetMaxWorkers(V8TaskPriority::kUserVisible));
+            EXPECT_EQ(6, limiter.GetMaxWorkers(V8TaskPriority::kUserBlocking));
+            EXPECT_EQ(4, limiter.GetGlobalMaxWorkers());
+            EXPECT_FALSE(limiter.ReserveJoiningThread());
+            EXPECT_EQ(3, limiter.GetPolicy().m_MaxUserVisibleWorkers);
+        }
+
+        TEST(V8JobConcurrencyLimiterTest, GlobalCap)
+        {
+            std::unique_ptr<V8AppPlatform> platform = std::make_unique<V8AppPlatform>();
+            V8JobConcurrencyPolicy policy;
+            policy.m_GlobalMaxWorkers = 1;
+            V8JobConcurrencyLimiterSharedPtr limiter = std::make_shared<V8JobConcurrencyLimiter>(4, policy);
+
+            std::shared_ptr<TestV8JobState> state = std::make_shared<TestV8JobState>(platform.get(), std::make_unique<TestJobsTask>(4),
+                                                                                     V8TaskPriority::kUserBlocking, 4, limiter);
+            // the cap comes from the policy and not the worker count passed in
+            EXPECT_EQ(4, state->TestGetMaxConcurrency(0));
+
+            EXPECT_TRUE(limiter->TryAcquireWorker(state));
+            EXPECT_EQ(1, limiter->GetActiveWorkers());
+            // over the global cap so the job waits and is told when there's room
+            state->SetPendingTasks(1);
+            EXPECT_FALSE(state->CanRunFirstTask());
+            EXPECT_EQ(0, state->GetActiveTasks());
+            EXPECT_FALSE(limiter->TryAcquireWorker(state));
+
+            // cancel it so the notify doesn't post workers to the platform
+            state->SetCancelled(true);
+            limiter->ReleaseWorker();
+            EXPECT_EQ(0, limiter->GetActiveWorkers());
+
+            state->SetCancelled(false);
+            state->SetPendingTasks(1);
+            EXPECT_TRUE(state->CanRunFirstTask());
+            EXPECT_EQ(1, limiter->GetActiveWorkers());
+            state->SetCancelled(true);
+            EXPECT_FALSE(state->DidRunFirstTask());
+            EXPECT_EQ(0, limiter->GetActiveWorkers());
+        }
+
+        TEST(V8JobConcurrencyLimiterTest, WakesWaitersForEveryFreeSlot)
+        {
+            std::unique_ptr<V8AppPlatform> platform = std::make_unique<V8AppPlatform>();
+            // keep the posted workers queued so the pending counts can be checked
+            platform->SetWorkersPaused(true);
+            V8JobConcurrencyPolicy policy;
+            policy.m_GlobalMaxWorkers = 2;
+            V8JobConcurrencyLimiterSharedPtr limiter = std::make_shared<V8JobConcurrencyLimiter>(4, policy);
+
+            auto makeState = [&platform, &limiter]()
+            {
+                return std::make_shared<TestV8JobState>(platform.get(), std::make_unique<TestJobsTask>(1), V8TaskPriority::kUserBlocking, 4, limiter);
+            };
+            std::shared_ptr<TestV8JobState> canceled = makeState();
+            std::shared_ptr<TestV8JobState> state1 = makeState();
+            std::shared_ptr<TestV8JobState> state2 = makeState();
+
+            EXPECT_TRUE(limiter->TryAcquireWorker(canceled));
+            EXPECT_TRUE(limiter->TryAcquireWorker(canceled));
+            EXPECT_FALSE(limiter->TryAcquireWorker(canceled));
+            EXPECT_FALSE(limiter->TryAcquireWorker(state1));
+            EXPECT_FALSE(limiter->TryAcquireWorker(state2));
+            canceled->SetCancelled(true);
+
+            // the canceled job doesn't post so it's slot goes on to the next job
+            limiter->ReleaseWorker();
+            EXPECT_EQ(0, canceled->GetPendingTasks());
+            EXPECT_EQ(1, state1->GetPendingTasks());
+            EXPECT_EQ(0, state2->GetPendingTasks());
+            limiter->ReleaseWorker();
+            EXPECT_EQ(1, state2->GetPendingTasks());
+
+            // raising the cap wakes as many jobs as it frees slots for
+            std::shared_ptr<TestV8JobState> state3 = makeState();
+            std::shared_ptr<TestV8JobState> state4 = makeState();
+            EXPECT_TRUE(limiter->TryAcquireWorker(state1));
+            EXPECT_TRUE(limiter->TryAcquireWorker(state2));
+            EXPECT_FALSE(limiter->TryAcquireWorker(state3));
+            EXPECT_FALSE(limiter->TryAcquireWorker(state4));
+            policy.m_GlobalMaxWorkers = 4;
+            limiter->SetPolicy(policy);
+            EXPECT_EQ(1, state3->GetPendingTasks());
+            EXPECT_EQ(1, state4->GetPendingTasks());
+
+            for (const std::shared_ptr<TestV8JobState> &state : {state1, state2, state3, state4})
+            {
+                state->SetCancelled(true);
+            }
+            platform->SetWorkersPaused(false);
+        }
+
+        class StressJobTask : public v8::JobTask
+        {
+        public:
+            explicit StressJobTask(size_t inItems) : m_Remaining(inItems) {}
+
+            virtual void Run(v8::JobDelegate *delegate) override
+            {
+                uint8_t id = delegate->GetTaskId();
+                if (id >= kV8JobMaxTaskIds)
+                {
+                    m_BadIds++;
+                    return;
+                }
+                if (m_InUse[id].exchange(true))
+                {
+                    m_SharedIds++;
+                }
+                while (delegate->ShouldYield() == false)
+                {
+                    size_t remaining = m_Remaining.load();
+                    if (remaining == 0)
+                    {
+                        break;
+                    }
+                    if (m_Remaining.compare_exchange_weak(remaining, remaining - 1))
+                    {
+                        m_Done++;
+                    }
+                }
+                m_InUse[id] = false;
+            }
+
+            virtual size_t GetMaxConcurrency(size_t worker_count) const override
+            {
+                return std::min<size_t>(m_Remaining.load(), kV8JobMaxTaskIds);
+            }
+
+            std::atomic_size_t m_Remaining;
+            std::atomic_size_t m_Done{0};
+            std::atomic_int m_BadIds{0};
+            std::atomic_int m_SharedIds{0};
+            std::array<std::atomic_bool, kV8JobMaxTaskIds> m_InUse{};
+        };
+
+        TEST(V8JobHandleTest, JoinStress)
+        {
+            const size_t kItems = 200000;
+            const int kJobs = 20;
+            std::unique_ptr<V8AppPlatform> platform = std::make_unique<V8AppPlatform>();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int job = 0; job < kJobs; job++)
+            {
+                std::unique_ptr<StressJobTask> task = std::make_unique<StressJobTask>(kItems);
+                StressJobTask *taskPtr = task.get();
+                V8JobHandleUniquePtr handle = platform->CreateJob(V8TaskPriority::kUserBlocking, std::move(task));
+                handle->NotifyConcurrencyIncrease();
+                handle->Join();
+
+                EXPECT_EQ(kItems, taskPtr->m_Done);
+                EXPECT_EQ(0, taskPtr->m_BadIds);
+                EXPECT_EQ(0, taskPtr->m_SharedIds);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            // shows up in the test's xml output so runs on different machines can be compared
+            ::testing::Test::RecordProperty("JoinStressMillis", static_cast<int>(elapsed));
+            ::testing::Test::RecordProperty("Workers", platform->NumberOfWorkerThreads());
+        }
+
         TEST(V8JobHandleTest, Constrcutor)
         {
             size_t testInt = 0;
@@ -0,0 +1,96 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "V8AppHighAllocationObserver.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        TEST(V8AppHighAllocationObserverTest, SectionsPerIsolate)
+        {
+            V8AppHighAllocationObserver observer;
+            V8Isolate *isolate1 = reinterpret_cast<V8Isolate *>(0x1000);
+            V8Isolate *isolate2 = reinterpret_cast<V8Isolate *>(0x2000);
+            EXPECT_FALSE(observer.IsInSection(isolate1));
+            EXPECT_EQ(0, observer.GetStats(isolate1).m_Sections);
+
+            observer.EnterSection(isolate1);
+            // nested sections are part of the same burst
+            observer.EnterSection(isolate1);
+            EXPECT_TRUE(observer.IsInSection(isolate1));
+            EXPECT_FALSE(observer.IsInSection(isolate2));
+            EXPECT_EQ(1, observer.GetStats(isolate1).m_Sections);
+            EXPECT_EQ(2, observer.GetStats(isolate1).m_ActiveSections);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            observer.LeaveSection(isolate1);
+            EXPECT_TRUE(observer.IsInSection(isolate1));
+            observer.LeaveSection(isolate1);
+            EXPECT_FALSE(observer.IsInSection(isolate1));
+
+            V8AppHighAllocationStats stats = observer.GetStats(isolate1);
+            EXPECT_EQ(0, stats.m_ActiveSections);
+            EXPECT_GE(stats.m_TotalNanoseconds, 2000000);
+            EXPECT_EQ(stats.m_TotalNanoseconds, stats.m_LongestNanoseconds);
+
+            // a leave without an enter is ignored
+            observer.LeaveSection(isolate2);
+            EXPECT_EQ(0, observer.GetStats(isolate2).m_Sections);
+
+            observer.EnterSection(isolate2);
+            observer.LeaveSection(isolate2);
+            V8AppHighAllocationStats total = observer.GetTotalStats();
+            EXPECT_EQ(2, total.m_Sections);
+            EXPECT_EQ(stats.m_TotalNanoseconds + observer.GetStats(isolate2).m_TotalNanoseconds, total.m_TotalNanoseconds);
+
+            // the totals keep a removed isolate's sections
+            observer.RemoveIsolate(isolate1);
+            EXPECT_EQ(0, observer.GetStats(isolate1).m_Sections);
+            EXPECT_EQ(2, observer.GetTotalStats().m_Sections);
+
+            std::stringstream stream;
+            observer.DumpStats(stream);
+            EXPECT_THAT(stream.str(), ::testing::StartsWith("High allocation sections: 2 active=0"));
+        }
+
+        TEST(V8AppHighAllocationObserverTest, Listener)
+        {
+            V8AppHighAllocationObserverOptions options;
+            options.m_PauseIdleTasks = true;
+            V8AppHighAllocationObserver observer(options);
+            EXPECT_TRUE(observer.GetOptions().m_PauseIdleTasks);
+            EXPECT_FALSE(observer.GetOptions().m_BoostWorkers);
+
+            std::vector<bool> bursts;
+            observer.SetListener([&bursts](bool inEntered)
+                                 { bursts.push_back(inEntered); });
+            V8Isolate *isolate1 = reinterpret_cast<V8Isolate *>(0x1000);
+            V8Isolate *isolate2 = reinterpret_cast<V8Isolate *>(0x2000);
+
+            // only told when the first burst starts and the last one ends
+            observer.EnterSection(isolate1);
+            observer.EnterSection(isolate2);
+            EXPECT_TRUE(observer.ShouldPauseIdleTasks(isolate1));
+            EXPECT_TRUE(observer.ShouldPauseIdleTasks(isolate2));
+            observer.LeaveSection(isolate1);
+            EXPECT_FALSE(observer.ShouldPauseIdleTasks(isolate1));
+            ASSERT_EQ(1, bursts.size());
+            EXPECT_TRUE(bursts[0]);
+
+            // an isolate disposed in the middle of a burst ends it
+            observer.RemoveIsolate(isolate2);
+            ASSERT_EQ(2, bursts.size());
+            EXPECT_FALSE(bursts[1]);
+            EXPECT_EQ(0, observer.GetTotalStats().m_ActiveSections);
+        }
+    } // namespace JSRuntime
+} // namespace v8App
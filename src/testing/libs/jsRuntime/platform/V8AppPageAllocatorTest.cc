@@ -0,0 +1,280 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "V8AppPageAllocator.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+#if defined(V8APP_LINUX)
+        TEST(V8AppPageAllocatorTest, PageSizes)
+        {
+            V8AppPageAllocator allocator;
+            EXPECT_GT(allocator.CommitPageSize(), 0);
+            EXPECT_EQ(0, allocator.AllocatePageSize() % allocator.CommitPageSize());
+
+            uintptr_t pageMask = allocator.AllocatePageSize() - 1;
+            EXPECT_EQ(0, reinterpret_cast<uintptr_t>(allocator.GetRandomMmapAddr()) & pageMask);
+
+            // the same seed gives the same hints
+            allocator.SetRandomMmapSeed(10);
+            void *hint1 = allocator.GetRandomMmapAddr();
+            allocator.SetRandomMmapSeed(10);
+            EXPECT_EQ(hint1, allocator.GetRandomMmapAddr());
+        }
+
+        TEST(V8AppPageAllocatorTest, ReserveCommitFree)
+        {
+            V8AppPageAllocator allocator;
+            size_t pageSize = allocator.AllocatePageSize();
+            size_t length = pageSize * 16;
+            size_t alignment = pageSize * 8;
+
+            // reserved but not usable till it's given access
+            uint8_t *address = static_cast<uint8_t *>(allocator.AllocatePages(nullptr, length, alignment, V8PageAllocator::kNoAccess));
+            ASSERT_NE(nullptr, address);
+            EXPECT_EQ(0, reinterpret_cast<uintptr_t>(address) % alignment);
+            EXPECT_EQ(length, allocator.GetStats().m_ReservedBytes);
+
+            ASSERT_TRUE(allocator.SetPermissions(address, pageSize * 2, V8PageAllocator::kReadWrite));
+            address[0] = 1;
+            address[pageSize * 2 - 1] = 2;
+
+            // decommitted pages read back as zero when they're used again
+            ASSERT_TRUE(allocator.DecommitPages(address, pageSize * 2));
+            ASSERT_TRUE(allocator.RecommitPages(address, pageSize * 2, V8PageAllocator::kReadWrite));
+            EXPECT_EQ(0, address[0]);
+            EXPECT_EQ(0, address[pageSize * 2 - 1]);
+            EXPECT_EQ(pageSize * 2, allocator.GetStats().m_DecommittedBytes);
+
+            // giving back the tail keeps the head
+            ASSERT_TRUE(allocator.ReleasePages(address, length, pageSize * 4));
+            EXPECT_EQ(pageSize * 4, allocator.GetStats().m_ReservedBytes);
+            address[1] = 3;
+
+            ASSERT_TRUE(allocator.FreePages(address, pageSize * 4));
+            EXPECT_EQ(0, allocator.GetStats().m_ReservedBytes);
+            EXPECT_EQ(0, allocator.GetSharedAccount()->GetReservedBytes());
+            EXPECT_EQ(length, allocator.GetSharedAccount()->GetPeakReservedBytes());
+        }
+
+        TEST(V8AppPageAllocatorTest, CommitAccounting)
+        {
+            V8AppPageAllocator allocator;
+            size_t pageSize = allocator.AllocatePageSize();
+            V8AppPageAccountSharedPtr reserver = std::make_shared<V8AppPageAccount>("reserver");
+            V8AppPageAccountSharedPtr committer = std::make_shared<V8AppPageAccount>("committer");
+
+            uint8_t *address = nullptr;
+            {
+                V8AppPageAccountScope scope(reserver);
+                address = static_cast<uint8_t *>(allocator.AllocatePages(nullptr, pageSize * 16, 0, V8PageAllocator::kNoAccess));
+            }
+            ASSERT_NE(nullptr, address);
+            EXPECT_EQ(pageSize * 16, reserver->GetReservedBytes());
+            EXPECT_EQ(0, reserver->GetCommittedBytes());
+
+            // like the pointer compression cage, the pages are committed by a different owner than reserved them
+            {
+                V8AppPageAccountScope scope(committer);
+                ASSERT_TRUE(allocator.SetPermissions(address, pageSize * 4, V8PageAllocator::kReadWrite));
+                // changing the permissions again doesn't count them twice
+                ASSERT_TRUE(allocator.SetPermissions(address + pageSize * 2, pageSize * 4, V8PageAllocator::kRead));
+            }
+            EXPECT_EQ(0, committer->GetReservedBytes());
+            EXPECT_EQ(pageSize * 6, committer->GetCommittedBytes());
+            EXPECT_EQ(pageSize * 6, allocator.GetStats().m_CommittedBytes);
+
+            // decommitting the middle credits just those pages
+            ASSERT_TRUE(allocator.SetPermissions(address + pageSize, pageSize * 2, V8PageAllocator::kNoAccess));
+            EXPECT_EQ(pageSize * 4, committer->GetCommittedBytes());
+            ASSERT_TRUE(allocator.DecommitPages(address + pageSize * 5, pageSize));
+            EXPECT_EQ(pageSize * 3, committer->GetCommittedBytes());
+            EXPECT_EQ(pageSize * 6, committer->GetPeakCommittedBytes());
+
+            ASSERT_TRUE(allocator.FreePages(address, pageSize * 16));
+            EXPECT_EQ(0, committer->GetCommittedBytes());
+            EXPECT_EQ(0, reserver->GetReservedBytes());
+            EXPECT_EQ(0, allocator.GetStats().m_CommittedBytes);
+        }
+
+        TEST(V8AppPageAllocatorTest, PermissionFlips)
+        {
+            V8AppPageAllocator allocator;
+            size_t pageSize = allocator.AllocatePageSize();
+            V8AppPageAccountSharedPtr account = std::make_shared<V8AppPageAccount>("account");
+            V8AppPageAccountScope scope(account);
+
+            uint8_t *address = static_cast<uint8_t *>(allocator.AllocatePages(nullptr, pageSize * 16, 0, V8PageAllocator::kNoAccess));
+            ASSERT_NE(nullptr, address);
+            // committed in pieces that end up as one range
+            for (int page = 0; page < 8; page++)
+            {
+                ASSERT_TRUE(allocator.SetPermissions(address + pageSize * page, pageSize, V8PageAllocator::kReadWrite));
+            }
+
+            // like v8's W^X flips on the code space from a few threads at once
+            std::vector<std::thread> threads;
+            for (int thread = 0; thread < 4; thread++)
+            {
+                threads.emplace_back([&allocator, address, pageSize, thread]()
+                                     {
+                    uint8_t *pages = address + pageSize * 2 * thread;
+                    for (int flip = 0; flip < 1000; flip++)
+                    {
+                        allocator.SetPermissions(pages, pageSize * 2, V8PageAllocator::kReadExecute);
+                        allocator.SetPermissions(pages, pageSize * 2, V8PageAllocator::kReadWrite);
+                    } });
+            }
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+            EXPECT_EQ(pageSize * 8, account->GetCommittedBytes());
+            EXPECT_EQ(pageSize * 8, allocator.GetStats().m_CommittedBytes);
+
+            // a range that's only partly committed still charges the rest
+            ASSERT_TRUE(allocator.SetPermissions(address + pageSize * 6, pageSize * 4, V8PageAllocator::kRead));
+            EXPECT_EQ(pageSize * 10, account->GetCommittedBytes());
+            ASSERT_TRUE(allocator.FreePages(address, pageSize * 16));
+            EXPECT_EQ(0, account->GetCommittedBytes());
+        }
+
+        TEST(V8AppPageAllocatorTest, FreeSubRange)
+        {
+            V8AppPageAllocator allocator;
+            size_t pageSize = allocator.AllocatePageSize();
+            V8AppPageAccountSharedPtr account = std::make_shared<V8AppPageAccount>("account");
+            V8AppPageAccountScope scope(account);
+
+            uint8_t *address = static_cast<uint8_t *>(allocator.AllocatePages(nullptr, pageSize * 8, 0, V8PageAllocator::kReadWrite));
+            ASSERT_NE(nullptr, address);
+            EXPECT_EQ(pageSize * 8, account->GetReservedBytes());
+            EXPECT_EQ(pageSize * 8, account->GetCommittedBytes());
+
+            // a hole out of the middle leaves the reservation either side of it
+            ASSERT_TRUE(allocator.FreePages(address + pageSize * 2, pageSize * 2));
+            EXPECT_EQ(pageSize * 6, account->GetReservedBytes());
+            EXPECT_EQ(pageSize * 6, account->GetCommittedBytes());
+            address[pageSize * 5] = 1;
+
+            // releasing from a start that isn't the reservation's still trims the piece it falls in
+            ASSERT_TRUE(allocator.ReleasePages(address + pageSize * 4, pageSize * 4, pageSize));
+            EXPECT_EQ(pageSize * 3, account->GetReservedBytes());
+            EXPECT_EQ(pageSize * 3, allocator.GetStats().m_ReservedBytes);
+
+            ASSERT_TRUE(allocator.FreePages(address, pageSize * 2));
+            ASSERT_TRUE(allocator.FreePages(address + pageSize * 4, pageSize));
+            EXPECT_EQ(0, account->GetReservedBytes());
+            EXPECT_EQ(0, account->GetCommittedBytes());
+            EXPECT_EQ(0, allocator.GetStats().m_ReservedBytes);
+        }
+
+        TEST(V8AppPageAllocatorTest, DiscardPolicies)
+        {
+            for (PageDiscardPolicy policy : {PageDiscardPolicy::kDontNeed, PageDiscardPolicy::kFree})
+            {
+                V8AppPageAllocatorOptions options;
+                options.m_DiscardPolicy = policy;
+                V8AppPageAllocator allocator(options);
+                size_t length = allocator.AllocatePageSize() * 4;
+
+                uint8_t *address = static_cast<uint8_t *>(allocator.AllocatePages(nullptr, length, 0, V8PageAllocator::kReadWrite));
+                ASSERT_NE(nullptr, address);
+                memset(address, 1, length);
+                EXPECT_TRUE(allocator.DiscardSystemPages(address, length));
+                EXPECT_EQ(length, allocator.GetStats().m_DiscardedBytes);
+                if (policy == PageDiscardPolicy::kDontNeed)
+                {
+                    EXPECT_EQ(0, address[0]);
+                }
+                // the pages are still usable
+                address[0] = 2;
+                EXPECT_EQ(2, address[0]);
+                EXPECT_TRUE(allocator.FreePages(address, length));
+            }
+        }
+
+        TEST(V8AppPageAllocatorTest, HugePages)
+        {
+            V8AppPageAllocatorOptions options;
+            options.m_UseHugePages = true;
+            options.m_HugePageThreshold = 2 * 1024 * 1024;
+            V8AppPageAllocator allocator(options);
+
+            // under the threshold stays on normal pages
+            size_t smallLength = allocator.AllocatePageSize() * 4;
+            void *small = allocator.AllocatePages(nullptr, smallLength, 0, V8PageAllocator::kNoAccess);
+            ASSERT_NE(nullptr, small);
+            EXPECT_EQ(0, allocator.GetStats().m_HugePageBytes);
+
+            size_t largeLength = 4 * 1024 * 1024;
+            void *large = allocator.AllocatePages(nullptr, largeLength, 0, V8PageAllocator::kNoAccess);
+            ASSERT_NE(nullptr, large);
+            EXPECT_EQ(0, reinterpret_cast<uintptr_t>(large) % (2 * 1024 * 1024));
+            // the advice is only taken when the kernel has transparent huge pages
+            size_t hugeBytes = allocator.GetStats().m_HugePageBytes;
+            EXPECT_TRUE(hugeBytes == 0 || hugeBytes == largeLength);
+
+            EXPECT_TRUE(allocator.FreePages(large, largeLength));
+            EXPECT_EQ(0, allocator.GetStats().m_HugePageBytes);
+            EXPECT_TRUE(allocator.FreePages(small, smallLength));
+        }
+
+        TEST(V8AppPageAllocatorTest, Accounts)
+        {
+            V8AppPageAllocator allocator;
+            size_t length = allocator.AllocatePageSize() * 4;
+            V8AppPageAccountSharedPtr account1 = std::make_shared<V8AppPageAccount>("account1");
+            V8AppPageAccountSharedPtr account2 = std::make_shared<V8AppPageAccount>("account2");
+            EXPECT_EQ("account1", account1->GetName());
+            EXPECT_EQ(nullptr, V8AppPageAccountScope::GetCurrentAccount());
+
+            void *address1 = nullptr;
+            void *address2 = nullptr;
+            void *shared = nullptr;
+            {
+                V8AppPageAccountScope scope1(account1);
+                EXPECT_EQ(account1, V8AppPageAccountScope::GetCurrentAccount());
+                address1 = allocator.AllocatePages(nullptr, length, 0, V8PageAllocator::kNoAccess);
+                {
+                    V8AppPageAccountScope scope2(account2);
+                    address2 = allocator.AllocatePages(nullptr, length * 2, 0, V8PageAllocator::kNoAccess);
+                }
+                EXPECT_EQ(account1, V8AppPageAccountScope::GetCurrentAccount());
+
+                // other threads aren't in the scope
+                std::thread thread([&allocator, &shared, length]()
+                                   { shared = allocator.AllocatePages(nullptr, length, 0, V8PageAllocator::kNoAccess); });
+                thread.join();
+            }
+            EXPECT_EQ(nullptr, V8AppPageAccountScope::GetCurrentAccount());
+            ASSERT_NE(nullptr, address1);
+            ASSERT_NE(nullptr, address2);
+            ASSERT_NE(nullptr, shared);
+
+            EXPECT_EQ(length, account1->GetReservedBytes());
+            EXPECT_EQ(length * 2, account2->GetReservedBytes());
+            EXPECT_EQ(length, allocator.GetSharedAccount()->GetReservedBytes());
+
+            // freed pages are credited to the account that reserved them whatever thread frees them
+            EXPECT_TRUE(allocator.FreePages(address2, length * 2));
+            EXPECT_EQ(0, account2->GetReservedBytes());
+            EXPECT_EQ(length * 2, account2->GetPeakReservedBytes());
+            EXPECT_TRUE(allocator.FreePages(address1, length));
+            EXPECT_EQ(0, account1->GetReservedBytes());
+            EXPECT_TRUE(allocator.FreePages(shared, length));
+            EXPECT_EQ(0, allocator.GetSharedAccount()->GetReservedBytes());
+        }
+#endif
+    } // namespace JSRuntime
+} // namespace v8App
@@ -45,10 +45,10 @@ namespace v8App
                 V8AppPlatform::InitializeV8(std::move(helper));
                 std::shared_ptr<V8AppPlatform> platform = V8AppPlatform::Get();
 
+                // v8 already has the observer so it can't be changed
                 V8HighAllocationThroughputObserverUniquePtr observer = std::make_unique<V8HighAllocationThroughputObserver>();
                 platform->SetHighAllocatoionObserver(observer.get());
-                EXPECT_EQ(observer.get(), platform->GetHighAllocationThroughputObserver());
-                observer.release();
+                EXPECT_NE(observer.get(), platform->GetHighAllocationThroughputObserver());
                 V8AppPlatform::ShutdownV8();
                 EXPECT_NE(platform, V8AppPlatform::Get());
 
@@ -65,10 +65,10 @@ namespace v8App
                 V8AppPlatform::InitializeV8(std::move(helper));
                 std::shared_ptr<V8AppPlatform> platform = V8AppPlatform::Get();
 
+                // v8 already has the observer so it can't be changed
                 V8HighAllocationThroughputObserverUniquePtr observer = std::make_unique<V8HighAllocationThroughputObserver>();
                 platform->SetHighAllocatoionObserver(observer.get());
-                EXPECT_EQ(observer.get(), platform->GetHighAllocationThroughputObserver());
-                observer.release();
+                EXPECT_NE(observer.get(), platform->GetHighAllocationThroughputObserver());
                 V8AppPlatform::ShutdownV8();
                 EXPECT_NE(platform, V8AppPlatform::Get());
                 //sould just reutrn and thus not cause any issue
@@ -4,10 +4,12 @@
 // found in the LICENSE file.
 
 #include <iostream>
+#include <sstream>
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include "V8AppPageAllocator.h"
 #include "V8AppPlatform.h"
 #include "IJSPlatformRuntimeProvider.h"
 
@@ -85,6 +87,7 @@ namespace v8App
             int TestPriorityToInt(V8TaskPriority inPriority) { return PriorityToInt(inPriority); }
             bool IsInited() { return s_PlatformInited; }
             void SetInited(bool inValue) { s_PlatformInited = inValue; }
+            Threads::ThreadPoolLaneQueue *GetWorkerPool() { return m_WorkerPool.get(); }
         };
 
         class TestPlatformJobTask : public v8::JobTask
@@ -108,7 +111,7 @@ namespace v8App
             TestV8AppPlatform platform;
             EXPECT_EQ(platform.NumberOfWorkerThreads(), cores);
             EXPECT_FALSE(platform.IsInited());
-            EXPECT_EQ(platform.CreateBlockingScope(v8::BlockingType::kMayBlock), nullptr);
+            EXPECT_NE(platform.CreateBlockingScope(v8::BlockingType::kMayBlock), nullptr);
             EXPECT_EQ(platform.GetStackTracePrinter(), nullptr);
         }
 
@@ -139,18 +142,23 @@ namespace v8App
         TEST(V8AppPlatformTest, GetSetPageAllocator)
         {
             TestV8AppPlatform platform;
+#if defined(V8APP_LINUX)
+            EXPECT_NE(nullptr, dynamic_cast<V8AppPageAllocator *>(platform.GetPageAllocator()));
+#else
             EXPECT_EQ(platform.GetPageAllocator(), nullptr);
+#endif
+            V8PageAllocator *constructed = platform.GetPageAllocator();
 
-            platform.SetInited(false);
+            // can't be changed once v8 has it
+            platform.SetInited(true);
             std::unique_ptr<TestPageAllocator> allocator = std::make_unique<TestPageAllocator>();
             platform.SetPageAllocator(allocator.get());
-            EXPECT_EQ(platform.GetPageAllocator(), nullptr);
+            EXPECT_EQ(platform.GetPageAllocator(), constructed);
 
-            platform.SetInited(true);
+            platform.SetInited(false);
             platform.SetPageAllocator(allocator.get());
             EXPECT_EQ(platform.GetPageAllocator(), allocator.get());
 
-            platform.SetInited(false);
             platform.SetPageAllocator(nullptr);
             EXPECT_EQ(platform.GetPageAllocator(), allocator.get());
 
@@ -160,17 +168,17 @@ namespace v8App
         TEST(V8AppPlatformTest, GetSetThreadIsolatedAllocator)
         {
             TestV8AppPlatform platform;
-            EXPECT_EQ(platform.GetPageAllocator(), nullptr);
+            EXPECT_EQ(platform.GetThreadIsolatedAllocator(), nullptr);
 
             std::unique_ptr<TestThreadIsolatedAllocator> allocator = std::make_unique<TestThreadIsolatedAllocator>();
+            platform.SetInited(true);
             platform.SetThreadIsolatatedAllocator(allocator.get());
             EXPECT_EQ(platform.GetThreadIsolatedAllocator(), nullptr);
 
-            platform.SetInited(true);
+            platform.SetInited(false);
             platform.SetThreadIsolatatedAllocator(allocator.get());
             EXPECT_EQ(platform.GetThreadIsolatedAllocator(), allocator.get());
 
-            platform.SetInited(false);
             platform.SetThreadIsolatatedAllocator(nullptr);
             EXPECT_EQ(platform.GetThreadIsolatedAllocator(), allocator.get());
 
@@ -180,19 +188,31 @@ namespace v8App
         TEST(V8AppPlatformTest, MonotonicallyIncreasingTime)
         {
             TestV8AppPlatform platform;
+            TestTime::TestTimeSeconds::Enable();
+            TestTime::TestTimeSeconds::Set(5.25);
+            EXPECT_DOUBLE_EQ(5.25, platform.MonotonicallyIncreasingTime());
+
             // Make sure we're using the normal time function
             TestTime::TestTimeSeconds::Clear();
-            double current = Time::MonotonicallyIncreasingTimeSeconds();
-            EXPECT_DOUBLE_EQ(platform.MonotonicallyIncreasingTime(), current);
+            double before = Time::MonotonicallyIncreasingTimeSeconds();
+            double platformTime = platform.MonotonicallyIncreasingTime();
+            EXPECT_LE(before, platformTime);
+            EXPECT_LE(platformTime, Time::MonotonicallyIncreasingTimeSeconds());
         }
 
         TEST(V8AppPlatformTest, CurrentClockTimeMilliseconds)
         {
             TestV8AppPlatform platform;
-            // Make sure we're using the normal time function
+            TestTime::TestTimeMilliSeconds::Enable();
+            TestTime::TestTimeMilliSeconds::Set(1500);
+            EXPECT_DOUBLE_EQ(1500, platform.CurrentClockTimeMillis());
+
+            // Make sure we're using the wall clock time function
             TestTime::TestTimeMilliSeconds::Clear();
-            double current = Time::MonotonicallyIncreasingTimeMilliSeconds();
-            EXPECT_DOUBLE_EQ(platform.CurrentClockTimeMilliseconds(), current);
+            double before = Time::CurrentWallClockTimeMilliSeconds();
+            double platformTime = platform.CurrentClockTimeMillis();
+            EXPECT_LE(before, platformTime);
+            EXPECT_LE(platformTime, Time::CurrentWallClockTimeMilliSeconds());
         }
 
         TEST(V8AppPlatformTest, GetSetHighAllocationThroughputObserver)
@@ -200,15 +220,18 @@ namespace v8App
             TestV8AppPlatform platform;
             V8HighAllocationThroughputObserver *constrcuted = platform.GetHighAllocationThroughputObserver();
             EXPECT_NE(constrcuted, nullptr);
+            EXPECT_EQ(constrcuted, platform.GetAppHighAllocationObserver());
 
-            platform.SetInited(false);
+            // v8 has it by the time the platform is inited
+            platform.SetInited(true);
             V8HighAllocationThroughputObserverUniquePtr observer = std::make_unique<V8HighAllocationThroughputObserver>();
             platform.SetHighAllocatoionObserver(observer.get());
             EXPECT_EQ(platform.GetHighAllocationThroughputObserver(), constrcuted);
 
-            platform.SetInited(true);
+            platform.SetInited(false);
             platform.SetHighAllocatoionObserver(observer.get());
             EXPECT_EQ(platform.GetHighAllocationThroughputObserver(), observer.get());
+            EXPECT_EQ(nullptr, platform.GetAppHighAllocationObserver());
 
             platform.SetHighAllocatoionObserver(nullptr);
             EXPECT_EQ(platform.GetHighAllocationThroughputObserver(), observer.get());
@@ -216,6 +239,52 @@ namespace v8App
             observer.release();
         }
 
+        TEST(V8AppPlatformTest, HighAllocationBurst)
+        {
+            TestV8AppPlatform platform;
+            platform.SetIsolateHelper(std::make_unique<TestIsolateHelper>());
+            V8Isolate *isolate = reinterpret_cast<V8Isolate *>(0x1000);
+
+            // by default bursts are just recorded
+            V8AppHighAllocationObserver *observer = platform.GetAppHighAllocationObserver();
+            ASSERT_NE(nullptr, observer);
+            observer->EnterSection(isolate);
+            EXPECT_FALSE(platform.AreWorkersBoosted());
+            EXPECT_TRUE(platform.IdleTasksEnabled(isolate));
+            observer->LeaveSection(isolate);
+
+            V8AppHighAllocationObserverOptions options;
+            options.m_BoostWorkers = true;
+            options.m_PauseIdleTasks = true;
+            platform.SetHighAllocatoionObserver(new V8AppHighAllocationObserver(options));
+            observer = platform.GetAppHighAllocationObserver();
+            ASSERT_NE(nullptr, observer);
+
+            observer->EnterSection(isolate);
+            EXPECT_TRUE(platform.AreWorkersBoosted());
+            EXPECT_FALSE(platform.IdleTasksEnabled(isolate));
+            // other isolates keep their idle work
+            EXPECT_TRUE(platform.IdleTasksEnabled(nullptr));
+            std::stringstream during;
+            platform.DumpWorkerMetrics(during);
+            EXPECT_THAT(during.str(), ::testing::HasSubstr("High allocation sections: 1 active=1"));
+            // the best effort lane gets every worker
+            EXPECT_THAT(during.str(), ::testing::HasSubstr("Lane 1: queued=0 running=0 cap=" + std::to_string(platform.NumberOfWorkerThreads())));
+
+            observer->LeaveSection(isolate);
+            EXPECT_FALSE(platform.AreWorkersBoosted());
+            EXPECT_TRUE(platform.IdleTasksEnabled(isolate));
+
+            // a cap set during the burst is kept when it ends
+            Threads::ThreadPoolLaneQueue *pool = platform.GetWorkerPool();
+            int newCap = platform.NumberOfWorkerThreads() + 1;
+            observer->EnterSection(isolate);
+            pool->SetLaneConcurrency(Threads::ThreadPriority::kBestEffort, newCap);
+            observer->LeaveSection(isolate);
+            EXPECT_FALSE(platform.AreWorkersBoosted());
+            EXPECT_EQ(newCap, pool->GetLaneConcurrency(Threads::ThreadPriority::kBestEffort));
+        }
+
         TEST(V8AppPlatformTest, GetForegroundTaskRunner)
         {
             std::shared_ptr<V8AppPlatform> platform = V8AppPlatform::Get();
@@ -269,6 +338,25 @@ namespace v8App
             EXPECT_GE(elapsed, 4);
         }
 
+        TEST(V8AppPlatformTest, JobConcurrencyPolicy)
+        {
+            TestV8AppPlatform platform;
+            V8JobConcurrencyPolicy policy = platform.GetJobConcurrencyPolicy();
+            EXPECT_EQ(2, policy.m_MaxBestEffortWorkers);
+            EXPECT_TRUE(policy.m_ReserveJoiningThread);
+
+            policy.m_MaxBestEffortWorkers = 1;
+            policy.m_GlobalMaxWorkers = 1;
+            platform.SetJobConcurrencyPolicy(policy);
+            EXPECT_EQ(1, platform.GetJobConcurrencyPolicy().m_MaxBestEffortWorkers);
+            EXPECT_EQ(1, platform.GetJobConcurrencyPolicy().m_GlobalMaxWorkers);
+
+            // the job still finishes on the joining thread under the tighter policy
+            V8JobHandleUniquePtr handle = platform.PostJob(V8TaskPriority::kBestEffort, std::make_unique<TestPlatformJobTask>());
+            handle->Join();
+            EXPECT_FALSE(handle->IsValid());
+        }
+
         TEST(V8AppPlatformTest, PostTaskOnWorkerThreadImpl)
         {
             TestV8AppPlatform platform;
@@ -0,0 +1,117 @@
+// Copyright 2020 - 2024 The v8App Authors. All rights reserved.
+// Use of this source code is governed by a MIT license that can be
+// found in the LICENSE file.
+
+#include <bit>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "Tracing/TraceLog.h"
+#include "V8AppTracingController.h"
+
+namespace v8App
+{
+    namespace JSRuntime
+    {
+        namespace
+        {
+            class TestObserver : public V8TracingController::TraceStateObserver
+            {
+            public:
+                void OnTraceEnabled() override { m_States.push_back(true); }
+                void OnTraceDisabled() override { m_States.push_back(false); }
+
+                std::vector<bool> m_States;
+            };
+
+            class TestConvertable : public v8::ConvertableToTraceFormat
+            {
+            public:
+                void AppendAsTraceFormat(std::string *out) const override { out->append("{\"a\":1}"); }
+            };
+
+            std::vector<Tracing::TraceEvent> GetThreadEvents()
+            {
+                uint32_t threadId = Tracing::TraceLog::GetCurrentThreadId();
+                for (Tracing::TraceThreadEvents &thread : Tracing::TraceLog::GetEvents())
+                {
+                    if (thread.m_ThreadId == threadId)
+                    {
+                        return thread.m_Events;
+                    }
+                }
+                return {};
+            }
+        } // namespace
+
+        TEST(V8AppTracingControllerTest, AddTraceEvent)
+        {
+            Tracing::TraceLog::StopTracing();
+            Tracing::TraceLog::Clear();
+            V8AppTracingController controller;
+            const uint8_t *flag = controller.GetCategoryGroupEnabled("v8AppTracingControllerTest");
+            EXPECT_EQ(Tracing::TraceLog::GetCategoryGroupEnabled("v8AppTracingControllerTest"), flag);
+            EXPECT_EQ(0, controller.AddTraceEvent('I', flag, "notTracing", nullptr, 0, 0, 0, nullptr, nullptr, nullptr, nullptr, 0));
+
+            Tracing::TraceLog::StartTracing({"v8AppTracingControllerTest"});
+            EXPECT_EQ(Tracing::kCategoryEnabledForRecording, *flag);
+
+            const char *argNames[] = {"double", "string"};
+            uint8_t argTypes[] = {4, 6};
+            uint64_t argValues[] = {std::bit_cast<uint64_t>(2.5), reinterpret_cast<uint64_t>("value")};
+            uint64_t handle = controller.AddTraceEventWithTimestamp('X', flag, "complete", nullptr, 0, 0, 2, argNames, argTypes, argValues,
+                                                                    nullptr, 0, 10);
+            EXPECT_NE(0, handle);
+            controller.UpdateTraceEventDuration(flag, "complete", handle);
+
+            const char *convertableNames[] = {"convertable"};
+            uint8_t convertableTypes[] = {8};
+            uint64_t convertableValues[] = {0};
+            std::unique_ptr<v8::ConvertableToTraceFormat> convertables[] = {std::make_unique<TestConvertable>()};
+            controller.AddTraceEvent('I', flag, "instant", nullptr, 0, 0, 1, convertableNames, convertableTypes, convertableValues,
+                                     convertables, 0);
+            Tracing::TraceLog::StopTracing();
+
+            std::vector<Tracing::TraceEvent> events = GetThreadEvents();
+            ASSERT_EQ(2, events.size());
+            // v8's microseconds are kept as nanoseconds
+            EXPECT_EQ(10000, events[0].m_Timestamp);
+            EXPECT_GT(events[0].m_Duration, 0);
+            ASSERT_EQ(2, events[0].m_NumArgs);
+            EXPECT_EQ(Tracing::TraceArgType::kDouble, events[0].m_Args[0].m_Type);
+            EXPECT_EQ(2.5, std::bit_cast<double>(events[0].m_Args[0].m_Value));
+            EXPECT_EQ(Tracing::TraceArgType::kString, events[0].m_Args[1].m_Type);
+            EXPECT_EQ("value", events[0].m_Args[1].m_String);
+            EXPECT_STREQ("instant", events[1].GetName());
+            EXPECT_EQ(Tracing::TraceArgType::kJSON, events[1].m_Args[0].m_Type);
+            EXPECT_EQ("{\"a\":1}", events[1].m_Args[0].m_String);
+            Tracing::TraceLog::Clear();
+        }
+
+        TEST(V8AppTracingControllerTest, TraceStateObservers)
+        {
+            Tracing::TraceLog::StopTracing();
+            V8AppTracingController controller;
+            TestObserver observer1;
+            TestObserver observer2;
+            controller.AddTraceStateObserver(&observer1);
+            Tracing::TraceLog::StartTracing();
+
+            // told straight away when tracing is already on
+            controller.AddTraceStateObserver(&observer2);
+            ASSERT_EQ(1, observer2.m_States.size());
+            EXPECT_TRUE(observer2.m_States[0]);
+
+            controller.RemoveTraceStateObserver(&observer2);
+            Tracing::TraceLog::StopTracing();
+            EXPECT_EQ(1, observer2.m_States.size());
+            ASSERT_EQ(2, observer1.m_States.size());
+            EXPECT_TRUE(observer1.m_States[0]);
+            EXPECT_FALSE(observer1.m_States[1]);
+            controller.RemoveTraceStateObserver(&observer1);
+        }
+    } // namespace JSRuntime
+} // namespace v8App
@@ -12,6 +12,7 @@
 #include "Assets/BinaryAsset.h"
 #include "Logging/Log.h"
 #include "Logging/ILogSink.h"
+#include "Memory/MemoryPressure.h"
 #include "Utils/Format.h"
 
 #include "TestLogSink.h"
@@ -109,6 +110,7 @@ namespace v8App
             bool TestReadScriptFile(std::string inFileName, CodeCache::ScriptCacheInfo *inInfo) { return ReadScriptFile(inFileName, inInfo); }
             bool TestWriteCacheDataToFile(std::filesystem::path inCacheFile, const uint8_t *inData, int inDataLength) { return WriteCacheDataToFile(inCacheFile, inData, inDataLength); }
             bool TestReadCachedDataFile(std::filesystem::path inCacheFile, CodeCache::ScriptCacheInfo *inInfo) { return ReadCachedDataFile(inCacheFile, inInfo); }
+            std::mutex &TestGetCacheLock() { return m_CacheLock; }
         };
 
         TEST_F(CodeCacheTest, LoadScriptFileSetCacheData)
@@ -220,6 +222,60 @@ namespace v8App
             EXPECT_EQ(4, CodeCacheTestInternal::ExecuteScript(m_Isolate, source.get(), false));
         }
 
+        TEST_F(CodeCacheTest, PurgeMemory)
+        {
+            TestCodeCache codeCache(m_App);
+
+            std::filesystem::path appRoot = m_Runtime->GetApp()->GetAppRoot()->GetAppRoot();
+            std::filesystem::path testPath = appRoot / std::filesystem::path("js/purgeTest.js");
+            Assets::TextAsset srcFile(testPath);
+            srcFile.SetContent("function f(){return 3;}(function() { globalThis.Result=f(); })()");
+            ASSERT_TRUE(srcFile.WriteAsset());
+
+            V8Isolate::Scope iScope(m_Isolate);
+            V8HandleScope hScope(m_Isolate);
+            V8LContext context = m_Context->GetLocalContext();
+            V8ContextScope cScope(context);
+
+            V8ScriptSourceUniquePtr source = codeCache.LoadScriptFile(testPath, m_Isolate);
+            ASSERT_NE(nullptr, source);
+            V8ScriptCachedData *cache = CodeCacheTestInternal::GenerateCodeCache(m_Isolate, context, source.get());
+            ASSERT_NE(nullptr, cache);
+            ASSERT_TRUE(codeCache.SetCodeCache(testPath, cache));
+            delete cache;
+            EXPECT_EQ(1u, codeCache.GetNumberOfCachedScripts());
+
+            source = codeCache.LoadScriptFile(testPath, m_Isolate);
+            ASSERT_NE(nullptr, source);
+            ASSERT_NE(nullptr, source->GetCachedData());
+
+            // no pressure leaves the cache alone
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kNone);
+            EXPECT_EQ(1u, codeCache.GetNumberOfCachedScripts());
+
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kModerate);
+            EXPECT_EQ(0u, codeCache.GetNumberOfCachedScripts());
+            EXPECT_FALSE(codeCache.HasCodeCache(testPath));
+
+            // the source loaded before the purge owns it's copy of the cache data
+            EXPECT_EQ(3, CodeCacheTestInternal::ExecuteScript(m_Isolate, source.get(), true));
+
+            // reloads the cache data from the file
+            source = codeCache.LoadScriptFile(testPath, m_Isolate);
+            ASSERT_NE(nullptr, source);
+            ASSERT_NE(nullptr, source->GetCachedData());
+            EXPECT_TRUE(codeCache.HasCodeCache(testPath));
+            EXPECT_EQ(3, CodeCacheTestInternal::ExecuteScript(m_Isolate, source.get(), true));
+
+            // pressure reported while the cache is in use on the same thread is skipped instead of deadlocking
+            {
+                std::lock_guard<std::mutex> lock(codeCache.TestGetCacheLock());
+                Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kCritical);
+            }
+            EXPECT_EQ(1u, codeCache.GetNumberOfCachedScripts());
+            Memory::MemoryPressure::NotifyMemoryPressure(Memory::MemoryPressureLevel::kNone);
+        }
+
         TEST_F(CodeCacheTest, CreateCacheInfo)
         {
             TestUtils::TestLogSink *logSink = TestUtils::TestLogSink::GetGlobalSink();
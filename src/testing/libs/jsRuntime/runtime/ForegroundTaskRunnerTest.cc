@@ -116,6 +116,73 @@ namespace v8App
             EXPECT_FALSE(runner->MaybeHasTask());
         }
 
+        TEST(ForegroundTaskRunnerTest, CancelDelayedTasks)
+        {
+            using SharedRunner = std::shared_ptr<MockTaskRunner>;
+            SharedRunner runner = std::make_shared<MockTaskRunner>();
+
+            V8TaskUniquePtr task1 = std::make_unique<RunnerTestTask>();
+            V8TaskUniquePtr task2 = std::make_unique<RunnerTestTask>();
+            V8TaskUniquePtr task3 = std::make_unique<RunnerTestTask>();
+            V8Task *ptask2 = task2.get();
+
+            TestTime::TestTimeSeconds::Enable();
+            TestTime::TestTimeSeconds::Set(0);
+
+            Queues::TimerId id1 = runner->PostCancelableDelayedTask(std::move(task1), 4.0);
+            Queues::TimerId id2 = runner->PostCancelableDelayedTask(std::move(task2), 4.0);
+            Queues::TimerId id3 = runner->PostCancelableNonNestableDelayedTask(std::move(task3), 4.0);
+            EXPECT_NE(Queues::kInvalidTimerId, id1);
+            EXPECT_NE(Queues::kInvalidTimerId, id3);
+
+            EXPECT_TRUE(runner->CancelDelayedTask(id1));
+            EXPECT_FALSE(runner->CancelDelayedTask(id1));
+            EXPECT_TRUE(runner->CancelDelayedTask(id3));
+
+            TestTime::TestTimeSeconds::Set(5);
+            V8TaskUniquePtr opt = runner->GetNextTask();
+            EXPECT_NE(opt, nullptr);
+            EXPECT_EQ(opt.get(), ptask2);
+            // already came due
+            EXPECT_FALSE(runner->CancelDelayedTask(id2));
+            EXPECT_EQ(runner->GetNextTask(), nullptr);
+            TestTime::TestTimeSeconds::Clear();
+        }
+
+        TEST(ForegroundTaskRunnerTest, WaitForWork)
+        {
+            TestTime::TestTimeSeconds::Clear();
+            using SharedRunner = std::shared_ptr<MockTaskRunner>;
+            SharedRunner runner = std::make_shared<MockTaskRunner>();
+
+            // nothing posted so it times out
+            EXPECT_FALSE(runner->WaitForWork(0.01));
+
+            // a task that's already there returns straight away
+            runner->PostTask(std::make_unique<RunnerTestTask>());
+            EXPECT_TRUE(runner->WaitForWork());
+            runner->GetNextTask();
+            EXPECT_FALSE(runner->WaitForWork(0.01));
+
+            // sleeps till the delayed task is due
+            runner->PostDelayedTask(std::make_unique<RunnerTestTask>(), 0.05);
+            EXPECT_TRUE(runner->WaitForWork(0.01));
+            EXPECT_TRUE(runner->WaitForWork(5));
+            EXPECT_TRUE(runner->MaybeHasTask());
+            runner->GetNextTask();
+
+            // woken from another thread
+            std::thread waker([runner]()
+                              {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                runner->Wake(); });
+            EXPECT_TRUE(runner->WaitForWork(5));
+            waker.join();
+
+            runner->Terminate();
+            EXPECT_FALSE(runner->WaitForWork());
+        }
+
         TEST(ForegroundTaskRunnerTest, IdleTasks)
         {
             using SharedRunner = std::shared_ptr<MockTaskRunner>;
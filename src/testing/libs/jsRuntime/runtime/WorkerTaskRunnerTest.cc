@@ -70,6 +70,38 @@ namespace v8App
             EXPECT_EQ(2, task2Int);
         }
 
+        TEST(WorkerTaskRunnerTest, PostTasks)
+        {
+            using SharedRunner = std::shared_ptr<MockWorkerTaskRunner>;
+            SharedRunner runner = std::make_shared<MockWorkerTaskRunner>(2, Threads::ThreadPriority::kBestEffort);
+            int taskInts[4] = {0, 0, 0, 0};
+
+            std::vector<V8TaskUniquePtr> tasks;
+            tasks.push_back(std::make_unique<WorkerRunnerTestTask>(&taskInts[0], 1));
+            tasks.push_back(std::make_unique<WorkerRunnerTestTask>(&taskInts[1], 2));
+            std::vector<V8TaskUniquePtr> delayedTasks;
+            delayedTasks.push_back(std::make_unique<WorkerRunnerTestTask>(&taskInts[2], 3));
+            delayedTasks.push_back(std::make_unique<WorkerRunnerTestTask>(&taskInts[3], 4));
+
+            TestTime::TestTimeSeconds::Enable();
+            TestTime::TestTimeSeconds::Set(0.0);
+
+            runner->PostTasks(std::move(tasks));
+            runner->PostDelayedTasks(std::move(delayedTasks), 4.0);
+
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            EXPECT_EQ(1, taskInts[0]);
+            EXPECT_EQ(2, taskInts[1]);
+            EXPECT_EQ(0, taskInts[2]);
+            EXPECT_EQ(0, taskInts[3]);
+
+            TestTime::TestTimeSeconds::Set(6.0);
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            EXPECT_EQ(3, taskInts[2]);
+            EXPECT_EQ(4, taskInts[3]);
+            TestTime::TestTimeSeconds::Clear();
+        }
+
         TEST(WorkerTaskRunnerTest, Terminates)
         {
             using SharedRunner = std::shared_ptr<MockWorkerTaskRunner>;
@@ -3,10 +3,17 @@
 // found in the LICENSE file.
 #ifndef _TEST_TIME_H_
 #define _TEST_TIME_H_
+
+#include "Time/Clock.h"
+
 namespace v8App
 {
     namespace TestTime
     {
+        /**
+         * Overrides the time returned by the Time functions. Changing the time lets anything
+         * sleeping till a deadline know the time jumped.
+         */
         template <class ClassName>
         class TTestTime
         {
@@ -17,12 +17,14 @@ namespace v8App
         void TTestTime<ClassName>::Enable()
         {
             s_Enabled = true;
+            Time::NotifyClockChanged();
         }
 
         template <class ClassName>
         void TTestTime<ClassName>::Clear()
         {
             s_Enabled = false;
+            Time::NotifyClockChanged();
         }
 
         template <class ClassName>
@@ -35,6 +37,7 @@ namespace v8App
         void TTestTime<ClassName>::Set(double inTime)
         {
             s_Time = inTime;
+            Time::NotifyClockChanged();
         }
 
         template <class ClassName>